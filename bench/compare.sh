@@ -0,0 +1,21 @@
+#!/bin/sh
+# compare.sh <base.tsv> <new.tsv>
+#
+# Median times of two micro runs side by side; negative change = faster.
+
+if [ $# -ne 2 ]; then
+  echo "Usage: $0 <base.tsv> <new.tsv>" >&2
+  exit 1
+fi
+
+awk -F '\t' '
+  FNR == NR { if ($1 !~ /^#/) base[$1] = $3; next }
+  $1 ~ /^#/ { printf "%-32s %12s %12s %9s\n", "benchmark", "base ms", "new ms", "change"; next }
+  {
+    if (!($1 in base) || base[$1] == "-" || $3 == "-") {
+      printf "%-32s %12s %12s %9s\n", $1, ($1 in base) ? base[$1] : "-", $3, "n/a"
+    } else {
+      printf "%-32s %12.4f %12.4f %+8.1f%%\n", $1, base[$1], $3, (base[$1] > 0 ? ($3 - base[$1]) / base[$1] * 100 : 0)
+    }
+  }
+' "$1" "$2"
@@ -0,0 +1,304 @@
+/* iutf-corpus.c
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Corpus version 0.1
+ */
+
+/*
+ * iutf-corpus <kind> <scale> <out.iutf> [seed]
+ *
+ * Synthetic documents for benchmarks. The same kind, scale and seed always
+ * give the same bytes, so results from different machines and commits can be
+ * compared. Every document has `title` and `version`, so it passes the
+ * built-in schema. Scale 0 means the kind's default size.
+ *
+ *   deep        branches nested `scale` levels (2000)
+ *   wide        one branch with `scale` keys (100000)
+ *   numbers     `scale` integers, floats and longs in arrays (300000)
+ *   strings     `scale` quoted strings, some with escapes (100000)
+ *   bigstring   BigString[...] blocks, `scale` bytes of text (4 MB)
+ *   pipestring  |...| blocks, `scale` bytes of text (4 MB)
+ *   comments    `scale` lines, mostly #!, // and block comments (100000)
+ *   imports     imports `scale` extensions written to <dir of out>/inc (200)
+ *   mixed       `scale` service entries like a real config (20000)
+ */
+#define _GNU_SOURCE
+
+#include "../src/includes/iutf-buffer.h"
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+static uint64_t rng_state;
+
+// xorshift64*, fixed so corpora don't depend on the libc
+static uint64_t rng (void)
+{
+  rng_state ^= rng_state >> 12;
+  rng_state ^= rng_state << 25;
+  rng_state ^= rng_state >> 27;
+  return rng_state * 0x2545F4914F6CDD1DULL;
+}
+
+static void put (IutfBuffer* buf, const char* str)
+{
+  iutf_buffer_append (buf, str, strlen (str));
+}
+
+static void header (IutfBuffer* buf, const char* kind)
+{
+  put (buf, "iutf:init:main {\n  title: \"");
+  put (buf, kind);
+  put (buf, "\"\n  version: 1\n");
+}
+
+static void key (IutfBuffer* buf, size_t indent, const char* prefix, size_t i)
+{
+  char name[64];
+  snprintf (name, sizeof (name), "%s%06zu: ", prefix, i);
+  iutf_buffer_indent (buf, indent);
+  put (buf, name);
+}
+
+static const char* words[] = {
+  "alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf", "hotel", "india", "juliet",
+  "kilo", "lima", "mike", "november", "oscar", "papa", "quebec", "romeo", "sierra", "tango",
+};
+
+// `len` bytes of words and newlines, no brackets or pipes
+static void text (IutfBuffer* buf, size_t len)
+{
+  size_t line = 0;
+  for (size_t n = 0; n < len;) {
+    const char* w = words[rng () % 20];
+    size_t wl = strlen (w);
+    iutf_buffer_append (buf, w, wl);
+    line += wl + 1;
+    n += wl + 1;
+    if (line > 72) {
+      iutf_buffer_putc (buf, '\n');
+      line = 0;
+    } else {
+      iutf_buffer_putc (buf, ' ');
+    }
+  }
+}
+
+static void gen_deep (IutfBuffer* buf, size_t depth)
+{
+  for (size_t i = 0; i < depth; i++) {
+    key (buf, 2, "level", i);
+    put (buf, "{\n");
+    iutf_buffer_indent (buf, 4);
+    put (buf, "id: ");
+    iutf_buffer_ll (buf, (long long) i);
+    iutf_buffer_putc (buf, '\n');
+  }
+  for (size_t i = 0; i < depth; i++) put (buf, "  }\n");
+}
+
+static void gen_wide (IutfBuffer* buf, size_t keys)
+{
+  put (buf, "  wide: {\n");
+  for (size_t i = 0; i < keys; i++) {
+    key (buf, 4, "k", i);
+    iutf_buffer_ll (buf, (long long) (rng () % 1000000));
+    iutf_buffer_putc (buf, '\n');
+  }
+  put (buf, "  }\n");
+}
+
+static void gen_numbers (IutfBuffer* buf, size_t count)
+{
+  size_t third = count / 3 + 1;
+  put (buf, "  ints: [");
+  for (size_t i = 0; i < third; i++) {
+    if (i) put (buf, i % 16 ? ", " : ",\n    ");
+    iutf_buffer_ll (buf, (long long) (rng () % 2000001) - 1000000);
+  }
+  put (buf, "]\n  floats: [");
+  for (size_t i = 0; i < third; i++) {
+    if (i) put (buf, i % 16 ? ", " : ",\n    ");
+    iutf_buffer_double (buf, (double) (rng () % 10000000) / 1000.0);
+  }
+  put (buf, "]\n  longs: [");
+  for (size_t i = 0; i < third; i++) {
+    if (i) put (buf, i % 16 ? ", " : ",\n    ");
+    iutf_buffer_ll (buf, (long long) (rng () >> 2));
+    iutf_buffer_putc (buf, 'L');
+  }
+  put (buf, "]\n");
+}
+
+static void gen_strings (IutfBuffer* buf, size_t count)
+{
+  put (buf, "  strings: [\n");
+  for (size_t i = 0; i < count; i++) {
+    put (buf, "    \"");
+    put (buf, words[rng () % 20]);
+    put (buf, i % 4 == 0 ? "\\t" : " ");
+    put (buf, words[rng () % 20]);
+    put (buf, i % 8 == 0 ? "\\n\\\"quoted\\\"" : " plain");
+    put (buf, "\",\n");
+  }
+  put (buf, "  ]\n");
+}
+
+static void gen_blocks (IutfBuffer* buf, size_t bytes, int pipe)
+{
+  size_t block = 64 * 1024;
+  for (size_t i = 0, n = 0; n < bytes; i++, n += block) {
+    key (buf, 2, pipe ? "pipe" : "big", i);
+    put (buf, pipe ? "|" : "BigString[");
+    text (buf, bytes - n < block ? bytes - n : block);
+    put (buf, pipe ? "|\n" : "]\n");
+  }
+}
+
+static void gen_comments (IutfBuffer* buf, size_t lines)
+{
+  for (size_t i = 0; i < lines; i++) {
+    switch (i % 5) {
+      case 0: put (buf, "  #! "); text (buf, 40); put (buf, "\n"); break;
+      case 1: put (buf, "  // "); text (buf, 40); put (buf, "\n"); break;
+      case 2: put (buf, "  /* "); text (buf, 60); put (buf, " */\n"); break;
+      case 3: key (buf, 2, "c", i); put (buf, "true // trailing\n"); break;
+      default: put (buf, "\n"); break;
+    }
+  }
+}
+
+static int write_file (const char* path, IutfBuffer* buf)
+{
+  FILE* fp = fopen (path, "w");
+  if (!fp) {
+    fprintf (stderr, "Cannot open file %s: %s\n", path, strerror (errno));
+    return 0;
+  }
+  int ok = fwrite (buf->data, 1, buf->len, fp) == buf->len;
+  if (fclose (fp) != 0) ok = 0;
+  return ok;
+}
+
+// inc/extNNNN/extNNNN.utext next to the document, found via IUTF_INCLUDE_PATH
+static int gen_imports (IutfBuffer* buf, size_t count, const char* out)
+{
+  char* dir = strdup (out);
+  if (!dir) return 0;
+  char* slash = strrchr (dir, '/');
+  if (slash) *slash = '\0';
+  else strcpy (dir, ".");
+
+  char path[4096];
+  snprintf (path, sizeof (path), "%s/inc", dir);
+  mkdir (path, 0755);
+
+  int ok = 1;
+  for (size_t i = 0; ok && i < count; i++) {
+    char name[32];
+    snprintf (name, sizeof (name), "ext%04zu", i);
+    snprintf (path, sizeof (path), "%s/inc/%s", dir, name);
+    mkdir (path, 0755);
+    snprintf (path, sizeof (path), "%s/inc/%s/%s.utext", dir, name, name);
+
+    IutfBuffer ext;
+    iutf_buffer_init (&ext);
+    put (&ext, "iutf:extension:");
+    put (&ext, name);
+    put (&ext, " {\n");
+    for (size_t k = 0; k < 20; k++) {
+      key (&ext, 2, "setting", k);
+      iutf_buffer_ll (&ext, (long long) (rng () % 1000));
+      iutf_buffer_putc (&ext, '\n');
+    }
+    put (&ext, "}\n");
+    ok = !ext.error && write_file (path, &ext);
+    iutf_buffer_free (&ext);
+
+    put (buf, "  @import<");
+    put (buf, name);
+    put (buf, ">\n");
+  }
+  free (dir);
+  return ok;
+}
+
+static void gen_mixed (IutfBuffer* buf, size_t services)
+{
+  put (buf, "  services: [\n");
+  for (size_t i = 0; i < services; i++) {
+    put (buf, "    {\n      name: \"svc-");
+    iutf_buffer_ll (buf, (long long) i);
+    put (buf, "\"\n      port: ");
+    iutf_buffer_ll (buf, (long long) (1024 + rng () % 60000));
+    put (buf, "\n      ratio: ");
+    iutf_buffer_double (buf, (double) (rng () % 1000) / 1000.0);
+    put (buf, "\n      enabled: ");
+    put (buf, rng () % 2 ? "true" : "false");
+    put (buf, "\n      mode: '");
+    iutf_buffer_putc (buf, "fsx"[rng () % 3]);
+    put (buf, "'\n      // owner team\n      tags: [\"");
+    put (buf, words[rng () % 20]);
+    put (buf, "\", \"");
+    put (buf, words[rng () % 20]);
+    put (buf, "\"]\n      limits: { rps: ");
+    iutf_buffer_ll (buf, (long long) (rng () % 10000));
+    put (buf, ", burst: null }\n    },\n");
+  }
+  put (buf, "  ]\n");
+}
+
+int main (int argc, char* argv[])
+{
+  if (argc != 4 && argc != 5) {
+    fprintf (stderr, "Usage: %s <deep|wide|numbers|strings|bigstring|pipestring|comments|imports|mixed> <scale> <out.iutf> [seed]\n", argv[0]);
+    return 1;
+  }
+  const char* kind = argv[1];
+  size_t scale = strtoull (argv[2], NULL, 10);
+  const char* out = argv[3];
+  rng_state = argc == 5 ? strtoull (argv[4], NULL, 10) : 0;
+  rng_state ^= 0x9E3779B97F4A7C15ULL; // never 0
+
+  IutfBuffer buf;
+  iutf_buffer_init (&buf);
+  header (&buf, kind);
+
+  int ok = 1;
+  if (strcmp (kind, "deep") == 0) gen_deep (&buf, scale ? scale : 2000);
+  else if (strcmp (kind, "wide") == 0) gen_wide (&buf, scale ? scale : 100000);
+  else if (strcmp (kind, "numbers") == 0) gen_numbers (&buf, scale ? scale : 300000);
+  else if (strcmp (kind, "strings") == 0) gen_strings (&buf, scale ? scale : 100000);
+  else if (strcmp (kind, "bigstring") == 0) gen_blocks (&buf, scale ? scale : 4 << 20, 0);
+  else if (strcmp (kind, "pipestring") == 0) gen_blocks (&buf, scale ? scale : 4 << 20, 1);
+  else if (strcmp (kind, "comments") == 0) gen_comments (&buf, scale ? scale : 100000);
+  else if (strcmp (kind, "imports") == 0) ok = gen_imports (&buf, scale ? scale : 200, out);
+  else if (strcmp (kind, "mixed") == 0) gen_mixed (&buf, scale ? scale : 20000);
+  else {
+    fprintf (stderr, "Unknown corpus kind '%s'\n", kind);
+    iutf_buffer_free (&buf);
+    return 1;
+  }
+  put (&buf, "}\n");
+
+  ok = ok && !buf.error && write_file (out, &buf);
+  iutf_buffer_free (&buf);
+  return ok ? 0 : 1;
+}
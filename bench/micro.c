@@ -0,0 +1,221 @@
+/* micro.c
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Micro version 0.1
+ */
+
+/*
+ * micro [corpus_dir] > results.tsv
+ *
+ * lex.*   one token class repeated, iutf_lexer_next loop only
+ * parse.* one value kind repeated inside an array (or the branch/nesting
+ *         routines), iutf_parse only, the tree is freed outside the timing
+ * file.*  the lexer and the parser on each corpus file from iutf-corpus
+ *
+ * Output is tab-separated, one line per benchmark, same names and order on
+ * every run, so two result files can be compared with bench/compare.sh.
+ */
+#define _GNU_SOURCE
+
+#include "../src/includes/iutf-parser.h"
+#include "../src/includes/iutf-buffer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MIN_REPS 5
+#define MIN_SECONDS 0.2
+#define MAX_REPS 1000
+
+static double now_s (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int compare_double (const void* a, const void* b)
+{
+  double x = *(const double*) a, y = *(const double*) b;
+  return (x > y) - (x < y);
+}
+
+static size_t lex_once (const char* input, size_t len)
+{
+  IutfLexer* lexer = iutf_lexer_new_len (input, len);
+  if (!lexer) return 0;
+  lexer->quiet = 1;
+  size_t tokens = 0;
+  for (;;) {
+    IutfToken tok = iutf_lexer_next (lexer);
+    if (tok.type == IUTF_TOK_EOF || tok.type == IUTF_TOK_ERROR) break;
+    tokens++;
+  }
+  iutf_lexer_corrupt (lexer);
+  return tokens;
+}
+
+// 1 if the document parsed; only iutf_parse is inside `seconds`
+static int parse_once (const char* input, const char* filename, double* seconds)
+{
+  IutfParser* parser = iutf_parser_new (input);
+  if (!parser) return 0;
+  parser->filename = filename;
+  double t = now_s ();
+  IutfNode* ast = iutf_parse (parser);
+  *seconds = now_s () - t;
+  iutf_node_free (ast);
+  iutf_parser_free (parser);
+  return ast != NULL;
+}
+
+// name, reps, median ms, MB/s, ns per token
+static void run (const char* name, const char* input, size_t len, const char* filename, int parse)
+{
+  size_t tokens = lex_once (input, len);
+  double samples[MAX_REPS];
+  int reps = 0;
+  double total = 0;
+
+  while (reps < MAX_REPS && (reps < MIN_REPS || total < MIN_SECONDS)) {
+    double seconds;
+    if (parse) {
+      if (!parse_once (input, filename, &seconds)) {
+        printf ("%s\tfailed\t-\t-\t-\n", name);
+        fflush (stdout);
+        return;
+      }
+    } else {
+      double t = now_s ();
+      lex_once (input, len);
+      seconds = now_s () - t;
+    }
+    samples[reps++] = seconds;
+    total += seconds;
+  }
+
+  qsort (samples, reps, sizeof (double), compare_double);
+  double median = samples[reps / 2];
+  printf ("%s\t%d\t%.4f\t%.1f\t%.2f\n", name, reps, median * 1e3, len / 1e6 / median, tokens ? median * 1e9 / tokens : 0);
+  fflush (stdout);
+}
+
+// `count` copies of `item` (separated by `sep`) between `before` and `after`, in a document
+static char* build (const char* before, const char* item, const char* sep, const char* after, size_t count, size_t* len)
+{
+  IutfBuffer buf;
+  iutf_buffer_init (&buf);
+  const char* head = "iutf:init:main {\n  title: \"micro\"\n  version: 1\n";
+  iutf_buffer_append (&buf, head, strlen (head));
+  iutf_buffer_append (&buf, before, strlen (before));
+  for (size_t i = 0; i < count; i++) {
+    if (i) iutf_buffer_append (&buf, sep, strlen (sep));
+    iutf_buffer_append (&buf, item, strlen (item));
+  }
+  iutf_buffer_append (&buf, after, strlen (after));
+  iutf_buffer_append (&buf, "}\n", 2);
+  return iutf_buffer_steal (&buf, len);
+}
+
+static void run_built (const char* name, const char* before, const char* item, const char* sep, const char* after, size_t count, int parse)
+{
+  size_t len;
+  char* input = build (before, item, sep, after, count, &len);
+  if (!input) return;
+  run (name, input, len, NULL, parse);
+  free (input);
+}
+
+static char* read_file (const char* path, size_t* len)
+{
+  FILE* fp = fopen (path, "rb");
+  if (!fp) return NULL;
+  char* data = NULL;
+  if (fseek (fp, 0, SEEK_END) == 0) {
+    long size = ftell (fp);
+    if (size >= 0 && fseek (fp, 0, SEEK_SET) == 0 && (data = malloc (size + 1))) {
+      if (fread (data, 1, size, fp) == (size_t) size) {
+        data[size] = '\0';
+        *len = size;
+      } else {
+        free (data);
+        data = NULL;
+      }
+    }
+  }
+  fclose (fp);
+  return data;
+}
+
+int main (int argc, char* argv[])
+{
+  const char* corpus = argc > 1 ? argv[1] : "bench/out/corpus";
+  const size_t n = 100000;
+
+  printf ("# benchmark\treps\tmedian_ms\tmb_per_s\tns_per_token\n");
+
+  // lexer, one token class each
+  run_built ("lex.identifier", "  x: [\n", "some_identifier_name", ", ", "]\n", n, 0);
+  run_built ("lex.integer", "  x: [\n", "-1234567", ", ", "]\n", n, 0);
+  run_built ("lex.float", "  x: [\n", "3.1415926", ", ", "]\n", n, 0);
+  run_built ("lex.long", "  x: [\n", "9007199254740993L", ", ", "]\n", n, 0);
+  run_built ("lex.string", "  x: [\n", "\"plain string value\"", ", ", "]\n", n, 0);
+  run_built ("lex.string_escaped", "  x: [\n", "\"tab\\there \\\"quoted\\\"\\n\"", ", ", "]\n", n, 0);
+  run_built ("lex.character", "  x: [\n", "'c'", ", ", "]\n", n, 0);
+  run_built ("lex.keyword", "  x: [\n", "true, false, null", ", ", "]\n", n / 3, 0);
+  run_built ("lex.punctuation", "  x: [\n", "{}", ", ", "]\n", n, 0);
+  run_built ("lex.comment_line", "", "  #! a line comment with some words in it", "\n", "\n", n, 0);
+  run_built ("lex.comment_cpp", "", "  // a c++ comment with some words in it", "\n", "\n", n, 0);
+  run_built ("lex.comment_block", "", "  /* a block comment with some words in it */", "\n", "\n", n, 0);
+  run_built ("lex.pipestring", "  x: [\n", "|pipe string text with words|", ", ", "]\n", n, 0);
+  run_built ("lex.bigstring", "  x: [\n", "BigString[big string text with words]", ", ", "]\n", n, 0);
+
+  // parser routines
+  run_built ("parse.value_int", "  x: [\n", "-1234567", ", ", "]\n", n, 1);
+  run_built ("parse.value_float", "  x: [\n", "3.1415926", ", ", "]\n", n, 1);
+  run_built ("parse.value_long", "  x: [\n", "9007199254740993L", ", ", "]\n", n, 1);
+  run_built ("parse.value_string", "  x: [\n", "\"plain string value\"", ", ", "]\n", n, 1);
+  run_built ("parse.value_string_escaped", "  x: [\n", "\"tab\\there \\\"quoted\\\"\\n\"", ", ", "]\n", n, 1);
+  run_built ("parse.value_char", "  x: [\n", "'c'", ", ", "]\n", n, 1);
+  run_built ("parse.value_keyword", "  x: [\n", "true, false, null", ", ", "]\n", n / 3, 1);
+  run_built ("parse.value_pipestring", "  x: [\n", "|pipe string text with words|", ", ", "]\n", n, 1);
+  run_built ("parse.value_bigstring", "  x: [\n", "BigString[big string text with words]", ", ", "]\n", n, 1);
+  run_built ("parse.array_nested", "  x: [\n", "[1, 2, 3]", ", ", "]\n", n, 1);
+  run_built ("parse.branch_empty", "  x: [\n", "{}", ", ", "]\n", n, 1);
+  run_built ("parse.branch_entries", "  x: [\n", "{ a: 1, b: \"s\", c: true }", ", ", "]\n", n / 3, 1);
+  run_built ("parse.comments", "", "  #! a line comment with some words in it", "\n", "\n", n, 1);
+
+  // whole corpus files
+  static const char* kinds[] = { "deep", "wide", "numbers", "strings", "bigstring", "pipestring", "comments", "imports", "mixed" };
+  for (size_t i = 0; i < sizeof (kinds) / sizeof (kinds[0]); i++) {
+    char path[4096], name[64];
+    snprintf (path, sizeof (path), "%s/%s.iutf", corpus, kinds[i]);
+    size_t len;
+    char* input = read_file (path, &len);
+    if (!input) {
+      fprintf (stderr, "missing %s, run iutf-corpus first (make bench does)\n", path);
+      continue;
+    }
+    snprintf (name, sizeof (name), "file.lex.%s", kinds[i]);
+    run (name, input, len, path, 0);
+    snprintf (name, sizeof (name), "file.parse.%s", kinds[i]);
+    run (name, input, len, path, 1);
+    free (input);
+  }
+  return 0;
+}
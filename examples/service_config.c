@@ -0,0 +1,40 @@
+/* service_config.c
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * License under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// service.h and service.c come from: iutf-gen examples/service.schema.iutf service gen
+#include "service.h"
+#include <stdio.h>
+
+int main (int argc, char* argv[])
+{
+  const char* path = argc > 1 ? argv[1] : "examples/service.iutf";
+
+  service cfg;
+  if (!service_load (path, &cfg)) return 1;
+
+  printf ("%s listens on %lld (%s)\n", cfg.name, cfg.port, cfg.has_mode ? cfg.mode : "default");
+  for (size_t i = 0; i < cfg.hosts.count; i++) printf ("  host %s\n", cfg.hosts.items[i]);
+  if (cfg.has_limits) printf ("  rps %lld, burst %s\n", cfg.limits.rps, cfg.limits.has_burst ? "set" : "none");
+  for (size_t i = 0; i < cfg.routes.count; i++) {
+    printf ("  route %s weight %lld\n", cfg.routes.items[i].path, cfg.routes.items[i].has_weight ? cfg.routes.items[i].weight : 1);
+  }
+
+  service_free (&cfg);
+  return 0;
+}
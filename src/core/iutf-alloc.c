@@ -0,0 +1,76 @@
+/* iutf-alloc.c
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Alloc version 0.1
+ */
+#define _GNU_SOURCE
+
+#include "../includes/iutf-alloc.h"
+#include <malloc.h>
+
+static void* libc_alloc (void* ctx, size_t size)
+{
+  (void) ctx;
+  return malloc (size);
+}
+
+static void* libc_realloc (void* ctx, void* ptr, size_t size)
+{
+  (void) ctx;
+  return realloc (ptr, size);
+}
+
+static void libc_free (void* ctx, void* ptr)
+{
+  (void) ctx;
+  free (ptr);
+}
+
+static size_t libc_size (void* ctx, const void* ptr)
+{
+  (void) ctx;
+  return malloc_usable_size ((void*) ptr);
+}
+
+const IutfAllocator iutf_allocator_libc = { libc_alloc, libc_realloc, libc_free, NULL, libc_size };
+
+const IutfAllocator* iutf_allocator_default;
+__thread const IutfAllocator* iutf_allocator_tls;
+
+void iutf_allocator_set_default (const IutfAllocator* allocator)
+{
+  iutf_allocator_default = allocator;
+}
+
+const IutfAllocator* iutf_allocator_use (const IutfAllocator* allocator)
+{
+  const IutfAllocator* previous = iutf_allocator_tls;
+  iutf_allocator_tls = allocator;
+  return previous;
+}
+
+const IutfAllocator* iutf_allocator_current (void)
+{
+  return iutf_allocator_active ();
+}
+
+void iutf_node_free_with (IutfNode* node, const IutfAllocator* allocator)
+{
+  const IutfAllocator* previous = iutf_allocator_use (allocator);
+  iutf_node_free (node);
+  iutf_allocator_use (previous);
+}
@@ -19,32 +19,12 @@
 #define _GNU_SOURCE
 
 #include "../includes/iutf-api.h"
+#include "../includes/iutf-alloc.h"
+#include "../includes/iutf-buffer.h"
+#include "../includes/iutf-lexer.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <stdarg.h>
-
-static void append_to_buf (char** buf, size_t* size, const char* format, ...)
-{
-  va_list args;
-  va_start (args, format);
-
-  // determine the required size
-  va_list args_copy;
-  va_copy (args_copy, args);
-  int len = vsnprintf (NULL, 0, format, args_copy);
-  va_end (args_copy);
-
-  if (len < 0) return;
-
-  char* new_buf = realloc (*buf, *size + len + 1);
-  if (!new_buf) return;
-
-  *buf = new_buf;
-  vsprintf (*buf + *size, format, args);
-  *size += len;
-  va_end (args);
-}
 
 IutfNode* iutf_new_branch (void)
 {
@@ -59,20 +39,55 @@ void to_branch (IutfNode* branch, const char* key, IutfNode* value)
 {
   if (!branch || !key || !value) return;
 
-  struct IutfNode** temp = realloc (branch->data.branch.items, (branch->data.branch.size + 1) * sizeof (struct IutfNode*));
-  if (!temp) return;
+  char* copy = iutf_strdup (key);
+  if (!copy) return;
+  if (!iutf_node_append (branch, value)) {
+    iutf_free (copy);
+    return;
+  }
+  iutf_node_set_key (value, copy, 1);
+}
 
-  branch->data.branch.items = temp;
-  branch->data.branch.items[branch->data.branch.size] = value;
-  value->key = strdup (key);
-  branch->data.branch.size++;
+void to_branch_static (IutfNode* branch, const char* key, IutfNode* value)
+{
+  if (!branch || !key || !value) return;
+  if (iutf_node_append (branch, value)) iutf_node_set_key (value, (char*) key, 0);
+}
+
+void to_branch_take (IutfNode* branch, char* key, IutfNode* value)
+{
+  if (!branch || !key || !value || !iutf_node_append (branch, value)) {
+    iutf_free (key);
+    return;
+  }
+  iutf_node_set_key (value, key, 1);
 }
 
 IutfNode* iutf_new_str (const char* value)
 {
   IutfNode* node = iutf_node_new (IUTF_NODE_STRING);
   if (!node) return NULL;
-  node->data.str_value = value ? strdup(value) : NULL;
+  node->data.str_value = value ? iutf_strdup(value) : NULL;
+  return node;
+}
+
+IutfNode* iutf_new_str_take (char* value)
+{
+  IutfNode* node = iutf_node_new (IUTF_NODE_STRING);
+  if (!node) {
+    iutf_free (value);
+    return NULL;
+  }
+  node->data.str_value = value;
+  return node;
+}
+
+IutfNode* iutf_new_str_static (const char* value)
+{
+  IutfNode* node = iutf_node_new (IUTF_NODE_STRING);
+  if (!node) return NULL;
+  node->data.str_value = (char*) value;
+  node->flags |= IUTF_NODE_FLAG_STR_BORROWED;
   return node;
 }
 
@@ -133,20 +148,56 @@ IutfNode* iutf_new_array (void)
 void add_to_array (IutfNode* array, IutfNode* item)
 {
   if (!array || !item) return;
+  iutf_node_append (array, item);
+}
+
+int iutf_reserve (IutfNode* node, size_t count)
+{
+  return iutf_node_reserve (node, count);
+}
+
+// nodes are created first, so a failed bulk append leaves the array unchanged
+#define APPEND_BULK(array, count, make)                                   \
+  do {                                                                    \
+    if (!array || array->type != IUTF_NODE_ARRAY) return 0;              \
+    if (!iutf_node_reserve (array, count)) return 0;                      \
+    IutfNode** dst = array->data.array.items + array->data.array.size;    \
+    for (size_t i = 0; i < count; i++) {                                  \
+      if (!(dst[i] = (make))) {                                           \
+        while (i-- > 0) iutf_node_free (dst[i]);                          \
+        return 0;                                                         \
+      }                                                                   \
+    }                                                                     \
+    array->data.array.size += count;                                      \
+    array->hash = 0;                                                      \
+    return 1;                                                             \
+  } while (0)
+
+int iutf_array_append_ints (IutfNode* array, const long long* values, size_t count)
+{
+  APPEND_BULK (array, count, iutf_new_int (values[i]));
+}
 
-  struct IutfNode** temp = realloc (array->data.array.items, (array->data.array.size + 1) * sizeof(struct IutfNode*));
-  if (!temp) return;
+int iutf_array_append_floats (IutfNode* array, const double* values, size_t count)
+{
+  APPEND_BULK (array, count, iutf_new_float (values[i]));
+}
+
+int iutf_array_append_strs (IutfNode* array, const char** values, size_t count)
+{
+  APPEND_BULK (array, count, iutf_new_str (values[i]));
+}
 
-  array->data.array.items = temp;
-  array->data.array.items[array->data.array.size] = item;
-  array->data.array.size++;
+int iutf_array_append_strs_static (IutfNode* array, const char** values, size_t count)
+{
+  APPEND_BULK (array, count, iutf_new_str_static (values[i]));
 }
 
 IutfNode* iutf_new_BigString (const char* value)
 {
   IutfNode* node = iutf_node_new (IUTF_NODE_BIGSTRING);
   if (!node) return NULL;
-  node->data.str_value = value ? strdup (value) : NULL;
+  node->data.str_value = value ? iutf_strdup (value) : NULL;
   return node;
 }
 
@@ -154,66 +205,84 @@ IutfNode* iutf_new_PipeStr (const char* value)
 {
   IutfNode* node = iutf_node_new (IUTF_NODE_PIPESTRING);
   if (!node) return NULL;
-  node->data.str_value = value ? strdup (value) : NULL;
+  node->data.str_value = value ? iutf_strdup (value) : NULL;
   return node;
 }
 
-static void debug_print_recursive (IutfNode* node, char** buf, size_t* size, int indent)
+char* iutf_get_block (const IutfNode* node, int flags)
+{
+  if (!node || (node->type != IUTF_NODE_BIGSTRING && node->type != IUTF_NODE_PIPESTRING)) return NULL;
+  const char* str = node->data.str_value ? node->data.str_value : "";
+  size_t len = strlen (str);
+  char* text = malloc (len + 1);
+  if (!text) return NULL;
+  iutf_block_text (str, len, flags, text);
+  return text;
+}
+
+static void debug_print_recursive (IutfNode* node, IutfBuffer* buf, int indent)
 {
   if (!node) return;
 
   // spacing
-  for (int i = 0; i < indent; i++) append_to_buf (buf, size, "  ");
+  iutf_buffer_indent (buf, (size_t) indent * 2);
 
   //If the node has a key (for branches)
-  if (node->key) append_to_buf (buf, size, "\"%s\": ", node->key);
+  if (node->key) {
+    iutf_buffer_quoted (buf, node->key, strlen (node->key));
+    iutf_buffer_append (buf, ": ", 2);
+  }
 
   switch (node->type) {
     case IUTF_NODE_BRANCH:
-      append_to_buf (buf, size, "{\n");
+      iutf_buffer_append (buf, "{\n", 2);
       for (size_t i = 0; i < node->data.branch.size; i++) {
-        debug_print_recursive (node->data.branch.items[i], buf, size, indent + 1);
-        append_to_buf (buf, size, (i == node->data.branch.size - 1) ? "\n" : ",\n");
+        debug_print_recursive (node->data.branch.items[i], buf, indent + 1);
+        iutf_buffer_puts (buf, (i == node->data.branch.size - 1) ? "\n" : ",\n");
       }
-      for (int i = 0; i < indent; i++) append_to_buf (buf, size, "  ");
-      append_to_buf (buf, size, "}");
+      iutf_buffer_indent (buf, (size_t) indent * 2);
+      iutf_buffer_putc (buf, '}');
       break;
 
     case IUTF_NODE_ARRAY:
-      append_to_buf (buf, size, "[\n");
+      iutf_buffer_append (buf, "[\n", 2);
       for (size_t i = 0; i < node->data.array.size; i++) {
-        debug_print_recursive (node->data.array.items[i], buf, size, indent + 1);
-        append_to_buf (buf, size, (i == node->data.array.size - 1) ? "\n" : ",\n");
+        debug_print_recursive (node->data.array.items[i], buf, indent + 1);
+        iutf_buffer_puts (buf, (i == node->data.array.size - 1) ? "\n" : ",\n");
       }
-      for (int i = 0; i < indent; i++) append_to_buf (buf, size, "  ");
-      append_to_buf (buf, size, "]");
+      iutf_buffer_indent (buf, (size_t) indent * 2);
+      iutf_buffer_putc (buf, ']');
       break;
 
     case IUTF_NODE_STRING:
     case IUTF_NODE_BIGSTRING:
     case IUTF_NODE_PIPESTRING:
-      append_to_buf (buf, size, "\"%s\"", node->data.str_value ? node->data.str_value : "null");
+      if (node->data.str_value) iutf_buffer_quoted (buf, node->data.str_value, strlen (node->data.str_value));
+      else iutf_buffer_append (buf, "null", 4);
       break;
 
     case IUTF_NODE_INTEGER:
     case IUTF_NODE_LONG:
-      append_to_buf (buf, size, "%lld", node->data.int_value);
+      iutf_buffer_ll (buf, node->data.int_value);
       break;
 
     case IUTF_NODE_FLOAT:
-      append_to_buf(buf, size, "%f", node->data.float_value);
+      iutf_buffer_double (buf, node->data.float_value);
       break;
 
     case IUTF_NODE_CHARACTER:
-      append_to_buf(buf, size, "'%c'", node->data.char_value);
+      iutf_buffer_putc (buf, '\'');
+      iutf_buffer_putc (buf, node->data.char_value);
+      iutf_buffer_putc (buf, '\'');
       break;
 
     case IUTF_NODE_BOOLEAN:
-      append_to_buf(buf, size, node->data.bool_value ? "true" : "false");
+      iutf_buffer_puts (buf, node->data.bool_value ? "true" : "false");
       break;
 
     case IUTF_NODE_NULL:
-      append_to_buf(buf, size, "null");
+    default:
+      iutf_buffer_append (buf, "null", 4);
       break;
   }
 }
@@ -223,12 +292,9 @@ char* debug_print_string (IutfNode* node)
 {
   if (!node) return NULL;
 
-  size_t size = 0;
-  char* buf = malloc(1);
-  if (!buf) return NULL;
-  buf[0] = '\0';
-
-  debug_print_recursive (node, &buf, &size, 0);
+  IutfBuffer buf;
+  iutf_buffer_init (&buf);
+  debug_print_recursive (node, &buf, 0);
 
-  return buf;
+  return iutf_buffer_steal (&buf, NULL);
 }
@@ -18,10 +18,12 @@
  */
 
 #include "../includes/iutf-ast.h"
+#include "../includes/iutf-alloc.h"
 
 IutfNode* iutf_node_new(IutfNodeType type) {
-    IutfNode* node = calloc(1, sizeof(IutfNode));
+    IutfNode* node = iutf_calloc(1, sizeof(IutfNode));
     if (!node) return NULL;
+    if ((unsigned) type < IUTF_STATS_NODE_TYPES) IUTF_STAT_ADD(nodes[type], 1);
     node->type = type;
     node->key = NULL;
     return node;
@@ -30,29 +32,64 @@ IutfNode* iutf_node_new(IutfNodeType type) {
 void iutf_node_free(IutfNode* node) {
     if (!node) return;
 
-    free(node->key);
+    // frozen nodes may be shared between several documents, drop one reference
+    if (node->refcount > 0 && __atomic_sub_fetch(&node->refcount, 1, __ATOMIC_ACQ_REL) > 0) return;
+
+    if (!(node->flags & IUTF_NODE_FLAG_KEY_BORROWED)) iutf_free(node->key);
 
     switch (node->type) {
         case IUTF_NODE_STRING:
         case IUTF_NODE_BIGSTRING:
         case IUTF_NODE_PIPESTRING:
-            free(node->data.str_value);
+            if (!(node->flags & IUTF_NODE_FLAG_STR_BORROWED)) iutf_free(node->data.str_value);
             break;
         case IUTF_NODE_ARRAY:
             for (size_t i = 0; i < node->data.array.size; i++) {
                 iutf_node_free(node->data.array.items[i]);
             }
-            free(node->data.array.items);
+            iutf_free(node->data.array.items);
             break;
         case IUTF_NODE_BRANCH:
             for (size_t i = 0; i < node->data.branch.size; i++) {
                 iutf_node_free(node->data.branch.items[i]);
             }
-            free(node->data.branch.items);
+            iutf_free(node->data.branch.items);
             break;
         default:
             break;
     }
 
-    free(node);
+    iutf_free(node);
+}
+
+int iutf_node_reserve(IutfNode* node, size_t extra) {
+    if (!node || (node->type != IUTF_NODE_ARRAY && node->type != IUTF_NODE_BRANCH)) return 0;
+
+    // arrays and branches share the layout
+    size_t size = node->data.array.size;
+    size_t cap = node->data.array.capacity > size ? node->data.array.capacity : size;
+    if (size + extra <= cap) return 1;
+
+    size_t cap_new = cap ? cap * 2 : 4;
+    while (cap_new < size + extra) cap_new *= 2;
+
+    struct IutfNode** temp = iutf_realloc(node->data.array.items, cap_new * sizeof(struct IutfNode*));
+    if (!temp) return 0;
+    node->data.array.items = temp;
+    node->data.array.capacity = cap_new;
+    return 1;
+}
+
+int iutf_node_append(IutfNode* node, IutfNode* item) {
+    if (!item || !iutf_node_reserve(node, 1)) return 0;
+    node->data.array.items[node->data.array.size++] = item;
+    node->hash = 0;
+    return 1;
+}
+
+void iutf_node_set_key(IutfNode* node, char* key, int owned) {
+    if (!(node->flags & IUTF_NODE_FLAG_KEY_BORROWED)) iutf_free(node->key);
+    node->key = key;
+    if (owned) node->flags &= ~IUTF_NODE_FLAG_KEY_BORROWED;
+    else node->flags |= IUTF_NODE_FLAG_KEY_BORROWED;
 }
@@ -0,0 +1,265 @@
+/* iutf-bench.c
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Bench version 0.1
+ */
+#define _GNU_SOURCE
+
+#include "../includes/iutf-bench.h"
+#include "../includes/iutf-parser.h"
+#include "../includes/iutf-serialize.h"
+#include "../includes/iutf-stats.h"
+#include "../includes/iutf-writer.h"
+#include "../includes/colors.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+static const char* phase_names[IUTF_BENCH_PHASES] = { "lex", "parse", "validate", "serialize", "free" };
+
+const char* iutf_bench_phase_name (IutfBenchPhase phase)
+{
+  return phase < IUTF_BENCH_PHASES ? phase_names[phase] : "?";
+}
+
+static double now_ms (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static char* read_file (const char* filename, size_t* len)
+{
+  FILE* fp = fopen (filename, "rb");
+  if (!fp) {
+    fprintf (stderr, COL_RED "Cannot open file: " COL_DEF COL_CYAN "%s" COL_DEF "\n", filename);
+    return NULL;
+  }
+
+  char* data = NULL;
+  long size = -1;
+  if (fseek (fp, 0, SEEK_END) == 0) size = ftell (fp);
+  if (size >= 0 && fseek (fp, 0, SEEK_SET) == 0) data = malloc ((size_t) size + 1);
+  if (data && fread (data, 1, (size_t) size, fp) != (size_t) size) {
+    free (data);
+    data = NULL;
+  }
+  fclose (fp);
+
+  if (!data) {
+    fprintf (stderr, COL_RED "Cannot read file: " COL_DEF COL_CYAN "%s" COL_DEF "\n", filename);
+    return NULL;
+  }
+  data[size] = '\0';
+  *len = (size_t) size;
+  return data;
+}
+
+static int compare_double (const void* a, const void* b)
+{
+  double x = *(const double*) a, y = *(const double*) b;
+  return (x > y) - (x < y);
+}
+
+// nearest-rank percentile of sorted samples
+static double percentile (const double* sorted, int n, int p)
+{
+  int rank = (p * n + 99) / 100;
+  if (rank < 1) rank = 1;
+  return sorted[rank - 1];
+}
+
+static void summarize (double* samples, int n, const IutfBenchResult* r, IutfBenchStats* s)
+{
+  qsort (samples, n, sizeof (double), compare_double);
+  double sum = 0;
+  for (int i = 0; i < n; i++) sum += samples[i];
+
+  s->timed = 1;
+  s->min_ms = samples[0];
+  s->max_ms = samples[n - 1];
+  s->mean_ms = sum / n;
+  s->p50_ms = percentile (samples, n, 50);
+  s->p90_ms = percentile (samples, n, 90);
+  s->p99_ms = percentile (samples, n, 99);
+  double seconds = s->mean_ms / 1e3;
+  s->mb_per_s = seconds > 0 ? r->bytes / 1e6 / seconds : 0;
+  s->tokens_per_s = seconds > 0 ? r->tokens / seconds : 0;
+}
+
+// one pass over all phases, each timed into times[phase]
+static int run_once (const char* filename, const char* input, size_t len, const IutfSchema* schema, int validate, double* times, size_t* tokens)
+{
+  double t = now_ms ();
+  IutfLexer* lexer = iutf_lexer_new_len (input, len);
+  if (!lexer) return 0;
+  lexer->quiet = 1;
+  size_t count = 0;
+  for (;;) {
+    IutfToken tok = iutf_lexer_next (lexer);
+    if (tok.type == IUTF_TOK_EOF || tok.type == IUTF_TOK_ERROR) break;
+    count++;
+  }
+  iutf_lexer_corrupt (lexer);
+  times[IUTF_BENCH_LEX] = now_ms () - t;
+  *tokens = count;
+
+  t = now_ms ();
+  IutfParser* parser = iutf_parser_new (input);
+  if (parser) parser->filename = filename; // imports resolve next to the file
+  IutfNode* ast = parser ? iutf_parse (parser) : NULL;
+  times[IUTF_BENCH_PARSE] = now_ms () - t;
+  if (!ast) {
+    iutf_parser_free (parser);
+    return 0;
+  }
+
+  t = now_ms ();
+  if (validate) iutf_schema_validate (schema, ast);
+  times[IUTF_BENCH_VALIDATE] = now_ms () - t;
+
+  t = now_ms ();
+  size_t out_len;
+  char* out = iutf_serialize (ast, IUTF_WRITE_COMPACT, &out_len);
+  times[IUTF_BENCH_SERIALIZE] = now_ms () - t;
+  free (out);
+
+  t = now_ms ();
+  iutf_node_free (ast);
+  iutf_parser_free (parser);
+  times[IUTF_BENCH_FREE] = now_ms () - t;
+  return 1;
+}
+
+int iutf_bench_file (const char* filename, const IutfBenchOptions* options, IutfBenchResult* result)
+{
+  memset (result, 0, sizeof (*result));
+  result->file = filename;
+  int iterations = options && options->iterations > 0 ? options->iterations : 20;
+  int warmup = options && options->warmup >= 0 ? options->warmup : 3;
+  const IutfSchema* schema = options && options->schema ? options->schema : iutf_schema_default ();
+
+  size_t len;
+  char* input = read_file (filename, &len);
+  if (!input) return 0;
+  result->bytes = len;
+
+  // untimed first pass: sizes, and whether validation can be timed without errors
+  IutfParser* parser = iutf_parser_new (input);
+  if (parser) parser->filename = filename;
+  IutfNode* ast = parser ? iutf_parse (parser) : NULL;
+  if (!ast) {
+    fprintf (stderr, COL_RED "Cannot parse " COL_CYAN "%s" COL_RED ", skipped" COL_DEF "\n", filename);
+    iutf_parser_free (parser);
+    free (input);
+    return 0;
+  }
+  IutfMemoryUsage usage;
+  iutf_doc_memory_usage (ast, &usage);
+  result->nodes = usage.nodes;
+  result->allocations = usage.blocks;
+  result->tree_bytes = usage.bytes;
+  result->valid = schema && iutf_schema_validate (schema, ast);
+  iutf_node_free (ast);
+  iutf_parser_free (parser);
+
+  double* samples = malloc ((size_t) iterations * IUTF_BENCH_PHASES * sizeof (double));
+  if (!samples) {
+    free (input);
+    return 0;
+  }
+
+  int ok = 1;
+  double times[IUTF_BENCH_PHASES];
+  for (int i = 0; ok && i < warmup; i++) ok = run_once (filename, input, len, schema, result->valid, times, &result->tokens);
+  for (int i = 0; ok && i < iterations; i++) {
+    ok = run_once (filename, input, len, schema, result->valid, times, &result->tokens);
+    for (int p = 0; p < IUTF_BENCH_PHASES; p++) samples[p * iterations + i] = times[p];
+  }
+
+  if (ok) {
+    result->iterations = iterations;
+    for (int p = 0; p < IUTF_BENCH_PHASES; p++) {
+      if (p == IUTF_BENCH_VALIDATE && !result->valid) continue;
+      summarize (samples + p * iterations, iterations, result, &result->phases[p]);
+    }
+  }
+  free (samples);
+  free (input);
+  return ok;
+}
+
+static long peak_rss_kb (void)
+{
+  struct rusage usage;
+  return getrusage (RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss : 0;
+}
+
+void iutf_bench_report (FILE* fp, const IutfBenchResult* results, size_t count)
+{
+  for (size_t i = 0; i < count; i++) {
+    const IutfBenchResult* r = &results[i];
+    fprintf (fp, COL_CYAN "%s" COL_DEF ": %zu bytes, %zu tokens, %zu nodes, %zu allocations (%zu bytes), %d iterations\n",
+             r->file, r->bytes, r->tokens, r->nodes, r->allocations, r->tree_bytes, r->iterations);
+    fprintf (fp, "  %-10s %10s %10s %10s %10s %10s %10s %12s\n", "phase", "min ms", "p50 ms", "p90 ms", "p99 ms", "max ms", "MB/s", "tokens/s");
+    for (int p = 0; p < IUTF_BENCH_PHASES; p++) {
+      const IutfBenchStats* s = &r->phases[p];
+      if (!s->timed) {
+        fprintf (fp, "  %-10s %10s\n", phase_names[p], p == IUTF_BENCH_VALIDATE && !r->valid ? "(invalid)" : "-");
+        continue;
+      }
+      fprintf (fp, "  %-10s %10.3f %10.3f %10.3f %10.3f %10.3f %10.1f %12.0f\n",
+               phase_names[p], s->min_ms, s->p50_ms, s->p90_ms, s->p99_ms, s->max_ms, s->mb_per_s, s->tokens_per_s);
+    }
+  }
+  fprintf (fp, "peak RSS: %ld KB\n", peak_rss_kb ());
+}
+
+static void json_string (FILE* fp, const char* str)
+{
+  fputc ('"', fp);
+  for (const unsigned char* p = (const unsigned char*) str; *p; p++) {
+    if (*p == '"' || *p == '\\') fprintf (fp, "\\%c", *p);
+    else if (*p < 0x20) fprintf (fp, "\\u%04x", *p);
+    else fputc (*p, fp);
+  }
+  fputc ('"', fp);
+}
+
+void iutf_bench_report_json (FILE* fp, const IutfBenchResult* results, size_t count)
+{
+  fprintf (fp, "{\"peak_rss_kb\":%ld,\"files\":[", peak_rss_kb ());
+  for (size_t i = 0; i < count; i++) {
+    const IutfBenchResult* r = &results[i];
+    fputs (i ? ",{\"file\":" : "{\"file\":", fp);
+    json_string (fp, r->file);
+    fprintf (fp, ",\"bytes\":%zu,\"tokens\":%zu,\"nodes\":%zu,\"allocations\":%zu,\"tree_bytes\":%zu,\"valid\":%s,\"iterations\":%d,\"phases\":{",
+             r->bytes, r->tokens, r->nodes, r->allocations, r->tree_bytes, r->valid ? "true" : "false", r->iterations);
+    int first = 1;
+    for (int p = 0; p < IUTF_BENCH_PHASES; p++) {
+      const IutfBenchStats* s = &r->phases[p];
+      if (!s->timed) continue;
+      fprintf (fp, "%s\"%s\":{\"min_ms\":%.4f,\"mean_ms\":%.4f,\"p50_ms\":%.4f,\"p90_ms\":%.4f,\"p99_ms\":%.4f,\"max_ms\":%.4f,\"mb_per_s\":%.2f,\"tokens_per_s\":%.0f}",
+               first ? "" : ",", phase_names[p], s->min_ms, s->mean_ms, s->p50_ms, s->p90_ms, s->p99_ms, s->max_ms, s->mb_per_s, s->tokens_per_s);
+      first = 0;
+    }
+    fputs ("}}", fp);
+  }
+  fputs ("]}\n", fp);
+}
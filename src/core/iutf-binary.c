@@ -0,0 +1,506 @@
+/* iutf-binary.c
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Binary version 0.1
+ */
+#define _GNU_SOURCE
+
+#include "../includes/iutf-binary.h"
+#include "../includes/iutf-alloc.h"
+#include "../includes/iutf-hash.h"
+#include "../includes/colors.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define BIN_BYTE_ORDER 0x01020304u
+
+/* ---- writing ---- */
+
+// interned string: offset into the pool, shared by keys and values
+typedef struct {
+  uint64_t hash;
+  uint32_t offset;
+  uint32_t len;
+  uint32_t key_id; // IUTF_BIN_NO_KEY until the string is used as a key
+} PoolEntry;
+
+typedef struct {
+  IutfNode** order; // breadth-first, index = record index
+  size_t count;
+  size_t cap;
+
+  char* pool;
+  size_t pool_len;
+  size_t pool_cap;
+
+  PoolEntry* table;
+  size_t table_cap; // power of two
+  size_t table_used;
+
+  uint32_t* key_entries; // table slots of strings used as keys
+  size_t key_count;
+  size_t key_cap;
+} BinBuilder;
+
+static int grow (void** ptr, size_t* cap, size_t need, size_t elem)
+{
+  if (need <= *cap) return 1;
+  size_t cap_new = *cap ? *cap * 2 : 64;
+  while (cap_new < need) cap_new *= 2;
+  void* temp = realloc (*ptr, cap_new * elem);
+  if (!temp) return 0;
+  *ptr = temp;
+  *cap = cap_new;
+  return 1;
+}
+
+static int table_rehash (BinBuilder* b)
+{
+  size_t cap = b->table_cap ? b->table_cap * 2 : 256;
+  PoolEntry* table = calloc (cap, sizeof (PoolEntry));
+  if (!table) return 0;
+
+  for (size_t i = 0; i < b->table_cap; i++) {
+    PoolEntry* e = &b->table[i];
+    if (!e->hash) continue;
+    size_t slot = (size_t) e->hash & (cap - 1);
+    while (table[slot].hash) slot = (slot + 1) & (cap - 1);
+    table[slot] = *e;
+  }
+  free (b->table);
+  b->table = table;
+  b->table_cap = cap;
+  return 1;
+}
+
+// returns the table slot of `str`, adding it to the pool when new; -1 on error
+static long intern (BinBuilder* b, const char* str)
+{
+  size_t len = strlen (str);
+  if (len >= UINT32_MAX || b->pool_len + len + 1 >= UINT32_MAX) return -1;
+
+  // a hash of 0 marks empty slots
+  uint64_t h = iutf_hash_bytes (str, len, 0) | 1;
+  if ((b->table_used + 1) * 2 > b->table_cap && !table_rehash (b)) return -1;
+
+  size_t slot = (size_t) h & (b->table_cap - 1);
+  while (b->table[slot].hash) {
+    PoolEntry* e = &b->table[slot];
+    if (e->hash == h && e->len == len && memcmp (b->pool + e->offset, str, len) == 0) return (long) slot;
+    slot = (slot + 1) & (b->table_cap - 1);
+  }
+
+  if (!grow ((void**) &b->pool, &b->pool_cap, b->pool_len + len + 1, 1)) return -1;
+  memcpy (b->pool + b->pool_len, str, len + 1);
+
+  PoolEntry* e = &b->table[slot];
+  e->hash = h;
+  e->offset = (uint32_t) b->pool_len;
+  e->len = (uint32_t) len;
+  e->key_id = IUTF_BIN_NO_KEY;
+  b->pool_len += len + 1;
+  b->table_used++;
+  return (long) slot;
+}
+
+static int push_node (BinBuilder* b, IutfNode* node)
+{
+  if (b->count >= UINT32_MAX - 1) return 0;
+  if (!grow ((void**) &b->order, &b->cap, b->count + 1, sizeof (IutfNode*))) return 0;
+  b->order[b->count++] = node;
+  return 1;
+}
+
+static int compare_keys (const void* a, const void* b, void* ctx)
+{
+  const BinBuilder* builder = ctx;
+  const PoolEntry* ea = &builder->table[*(const uint32_t*) a];
+  const PoolEntry* eb = &builder->table[*(const uint32_t*) b];
+  return strcmp (builder->pool + ea->offset, builder->pool + eb->offset);
+}
+
+static const char* node_str (const IutfNode* node)
+{
+  return node->data.str_value ? node->data.str_value : "";
+}
+
+static void builder_free (BinBuilder* b)
+{
+  free (b->order);
+  free (b->pool);
+  free (b->table);
+  free (b->key_entries);
+}
+
+// lay the tree out breadth-first and intern every string
+static int build (BinBuilder* b, IutfNode* root)
+{
+  if (!push_node (b, root)) return 0;
+
+  for (size_t i = 0; i < b->count; i++) {
+    IutfNode* node = b->order[i];
+    if (i > 0 && node->key) {
+      long slot = intern (b, node->key);
+      if (slot < 0) return 0;
+      if (b->table[slot].key_id == IUTF_BIN_NO_KEY) {
+        if (!grow ((void**) &b->key_entries, &b->key_cap, b->key_count + 1, sizeof (uint32_t))) return 0;
+        b->table[slot].key_id = 0;
+        b->key_entries[b->key_count++] = (uint32_t) slot;
+      }
+    }
+
+    switch (node->type) {
+      case IUTF_NODE_STRING:
+      case IUTF_NODE_BIGSTRING:
+      case IUTF_NODE_PIPESTRING:
+        if (intern (b, node_str (node)) < 0) return 0;
+        break;
+      case IUTF_NODE_ARRAY:
+      case IUTF_NODE_BRANCH:
+        for (size_t j = 0; j < node->data.branch.size; j++) {
+          if (!push_node (b, node->data.branch.items[j])) return 0;
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  // ids follow the sorted order so readers can binary search names
+  qsort_r (b->key_entries, b->key_count, sizeof (uint32_t), compare_keys, b);
+  for (size_t i = 0; i < b->key_count; i++) b->table[b->key_entries[i]].key_id = (uint32_t) i;
+  return 1;
+}
+
+static PoolEntry* lookup (BinBuilder* b, const char* str)
+{
+  size_t len = strlen (str);
+  uint64_t h = iutf_hash_bytes (str, len, 0) | 1;
+  size_t slot = (size_t) h & (b->table_cap - 1);
+  while (b->table[slot].hash) {
+    PoolEntry* e = &b->table[slot];
+    if (e->hash == h && e->len == len && memcmp (b->pool + e->offset, str, len) == 0) return e;
+    slot = (slot + 1) & (b->table_cap - 1);
+  }
+  return NULL;
+}
+
+int iutf_bin_write (IutfNode* root, IutfBuffer* buf)
+{
+  if (!root || !buf) return 0;
+
+  BinBuilder b;
+  memset (&b, 0, sizeof (b));
+  if (!build (&b, root)) {
+    fprintf (stderr, COL_RED "Cannot encode IUTF binary: document too large or out of memory" COL_DEF "\n");
+    builder_free (&b);
+    return 0;
+  }
+
+  IutfBinHeader header;
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, IUTF_BIN_MAGIC, 4);
+  header.version = IUTF_BIN_VERSION;
+  header.header_size = sizeof (IutfBinHeader);
+  header.byte_order = BIN_BYTE_ORDER;
+  header.node_count = (uint32_t) b.count;
+  header.key_count = (uint32_t) b.key_count;
+  header.nodes_offset = sizeof (IutfBinHeader);
+  header.keys_offset = header.nodes_offset + b.count * sizeof (IutfBinNode);
+  header.strings_offset = header.keys_offset + b.key_count * sizeof (IutfBinKey);
+  // a document without keys or strings still gets a pool, one NUL
+  size_t pool_len = b.pool_len ? b.pool_len : 1;
+  header.strings_size = pool_len;
+  header.file_size = header.strings_offset + pool_len;
+  iutf_buffer_append (buf, (const char*) &header, sizeof (header));
+
+  // children are numbered in the same breadth-first order they were queued
+  uint32_t next_child = 1;
+  for (size_t i = 0; i < b.count; i++) {
+    IutfNode* node = b.order[i];
+    IutfBinNode rec;
+    memset (&rec, 0, sizeof (rec));
+    rec.type = (uint8_t) node->type;
+    rec.key = (i > 0 && node->key) ? lookup (&b, node->key)->key_id : IUTF_BIN_NO_KEY;
+
+    switch (node->type) {
+      case IUTF_NODE_STRING:
+      case IUTF_NODE_BIGSTRING:
+      case IUTF_NODE_PIPESTRING: {
+        PoolEntry* e = lookup (&b, node_str (node));
+        rec.v.str.offset = e->offset;
+        rec.v.str.len = e->len;
+        break;
+      }
+      case IUTF_NODE_ARRAY:
+      case IUTF_NODE_BRANCH:
+        rec.v.children.first = next_child;
+        rec.v.children.count = (uint32_t) node->data.branch.size;
+        next_child += (uint32_t) node->data.branch.size;
+        break;
+      case IUTF_NODE_INTEGER: rec.v.i = node->data.int_value; break;
+      case IUTF_NODE_LONG: rec.v.i = node->data.long_value; break;
+      case IUTF_NODE_FLOAT: rec.v.f = node->data.float_value; break;
+      case IUTF_NODE_CHARACTER: rec.v.i = node->data.char_value; break;
+      case IUTF_NODE_BOOLEAN: rec.v.i = node->data.bool_value; break;
+      default: break;
+    }
+    iutf_buffer_append (buf, (const char*) &rec, sizeof (rec));
+  }
+
+  for (size_t i = 0; i < b.key_count; i++) {
+    PoolEntry* e = &b.table[b.key_entries[i]];
+    IutfBinKey key = { e->offset, e->len };
+    iutf_buffer_append (buf, (const char*) &key, sizeof (key));
+  }
+  if (b.pool_len) iutf_buffer_append (buf, b.pool, b.pool_len);
+  else iutf_buffer_putc (buf, '\0');
+
+  builder_free (&b);
+  return !buf->error;
+}
+
+int iutf_bin_write_file (IutfNode* root, const char* path)
+{
+  FILE* fp = fopen (path, "wb");
+  if (!fp) {
+    fprintf (stderr, COL_RED "Cannot open file: " COL_DEF COL_CYAN "%s" COL_DEF "\n", path);
+    return 0;
+  }
+
+  IutfBuffer buf;
+  iutf_buffer_init_file (&buf, fp);
+  int ok = iutf_bin_write (root, &buf) && iutf_buffer_flush (&buf);
+  iutf_buffer_free (&buf);
+  if (fclose (fp) != 0) ok = 0;
+  return ok;
+}
+
+/* ---- reading ---- */
+
+static int bin_fail (const char* what)
+{
+  fprintf (stderr, COL_RED "Invalid IUTF binary: %s" COL_DEF "\n", what);
+  return 0;
+}
+
+int iutf_bin_open_mem (IutfBinary* bin, const void* data, size_t size)
+{
+  memset (bin, 0, sizeof (IutfBinary));
+  const IutfBinHeader* h = data;
+
+  if (!data || size < sizeof (IutfBinHeader)) return bin_fail ("file too small");
+  if (((uintptr_t) data & 7) != 0) return bin_fail ("data is not 8-byte aligned");
+  if (memcmp (h->magic, IUTF_BIN_MAGIC, 4) != 0) return bin_fail ("bad magic");
+  if (h->byte_order != BIN_BYTE_ORDER) return bin_fail ("written with a different byte order");
+  if (h->version != IUTF_BIN_VERSION || h->header_size != sizeof (IutfBinHeader)) return bin_fail ("unsupported version");
+  if (h->file_size != size || h->node_count == 0) return bin_fail ("truncated");
+
+  // sections must follow each other exactly, which also rules out overflow
+  if (h->nodes_offset != sizeof (IutfBinHeader)
+      || h->keys_offset != h->nodes_offset + (uint64_t) h->node_count * sizeof (IutfBinNode)
+      || h->strings_offset != h->keys_offset + (uint64_t) h->key_count * sizeof (IutfBinKey)
+      || h->strings_offset + h->strings_size != size
+      || h->strings_size == 0
+      || ((const char*) data)[size - 1] != '\0') {
+    return bin_fail ("corrupt section table");
+  }
+
+  bin->data = data;
+  bin->size = size;
+  bin->header = h;
+  bin->nodes = (const IutfBinNode*) ((const uint8_t*) data + h->nodes_offset);
+  bin->keys = (const IutfBinKey*) ((const uint8_t*) data + h->keys_offset);
+  bin->strings = (const char*) data + h->strings_offset;
+  return 1;
+}
+
+int iutf_bin_open (IutfBinary* bin, const char* path)
+{
+  memset (bin, 0, sizeof (IutfBinary));
+  int fd = open (path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    fprintf (stderr, COL_RED "Cannot open file: " COL_DEF COL_CYAN "%s" COL_DEF "\n", path);
+    return 0;
+  }
+
+  struct stat st;
+  if (fstat (fd, &st) != 0 || st.st_size < (off_t) sizeof (IutfBinHeader)) {
+    close (fd);
+    return bin_fail ("file too small");
+  }
+
+  void* data = mmap (NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (data == MAP_FAILED) {
+    fprintf (stderr, COL_RED "Cannot map file: " COL_DEF COL_CYAN "%s" COL_DEF "\n", path);
+    return 0;
+  }
+
+  if (!iutf_bin_open_mem (bin, data, (size_t) st.st_size)) {
+    munmap (data, (size_t) st.st_size);
+    return 0;
+  }
+  bin->map = data;
+  bin->map_size = (size_t) st.st_size;
+  return 1;
+}
+
+void iutf_bin_close (IutfBinary* bin)
+{
+  if (!bin) return;
+  if (bin->map) munmap (bin->map, bin->map_size);
+  memset (bin, 0, sizeof (IutfBinary));
+}
+
+const IutfBinNode* iutf_bin_root (const IutfBinary* bin)
+{
+  return bin->header ? &bin->nodes[0] : NULL;
+}
+
+static inline const char* pool_str (const IutfBinary* bin, uint32_t offset, uint32_t len)
+{
+  // the terminator must be inside the pool as well
+  if ((uint64_t) offset + len >= bin->header->strings_size) return NULL;
+  return bin->strings + offset;
+}
+
+const char* iutf_bin_key (const IutfBinary* bin, const IutfBinNode* node)
+{
+  if (!node || node->key >= bin->header->key_count) return NULL;
+  return pool_str (bin, bin->keys[node->key].offset, bin->keys[node->key].len);
+}
+
+size_t iutf_bin_size (const IutfBinNode* node)
+{
+  if (!node || (node->type != IUTF_NODE_ARRAY && node->type != IUTF_NODE_BRANCH)) return 0;
+  return node->v.children.count;
+}
+
+const IutfBinNode* iutf_bin_child (const IutfBinary* bin, const IutfBinNode* node, size_t index)
+{
+  if (index >= iutf_bin_size (node)) return NULL;
+  uint64_t pos = (uint64_t) node->v.children.first + index;
+  if (pos >= bin->header->node_count) return NULL;
+  return &bin->nodes[pos];
+}
+
+uint32_t iutf_bin_key_id (const IutfBinary* bin, const char* key)
+{
+  if (!bin->header || !key) return IUTF_BIN_NO_KEY;
+
+  size_t lo = 0, hi = bin->header->key_count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    const char* name = pool_str (bin, bin->keys[mid].offset, bin->keys[mid].len);
+    if (!name) return IUTF_BIN_NO_KEY;
+    int cmp = strcmp (key, name);
+    if (cmp == 0) return (uint32_t) mid;
+    if (cmp < 0) hi = mid;
+    else lo = mid + 1;
+  }
+  return IUTF_BIN_NO_KEY;
+}
+
+const IutfBinNode* iutf_bin_get_id (const IutfBinary* bin, const IutfBinNode* branch, uint32_t key_id)
+{
+  if (!branch || branch->type != IUTF_NODE_BRANCH || key_id == IUTF_BIN_NO_KEY) return NULL;
+
+  size_t size = branch->v.children.count;
+  if ((uint64_t) branch->v.children.first + size > bin->header->node_count) return NULL;
+
+  // later duplicates win, like in the parsed tree
+  const IutfBinNode* items = &bin->nodes[branch->v.children.first];
+  for (size_t i = size; i-- > 0;) {
+    if (items[i].key == key_id) return &items[i];
+  }
+  return NULL;
+}
+
+const IutfBinNode* iutf_bin_get (const IutfBinary* bin, const IutfBinNode* branch, const char* key)
+{
+  return iutf_bin_get_id (bin, branch, iutf_bin_key_id (bin, key));
+}
+
+const char* iutf_bin_str (const IutfBinary* bin, const IutfBinNode* node, size_t* len)
+{
+  if (!node || (node->type != IUTF_NODE_STRING && node->type != IUTF_NODE_BIGSTRING && node->type != IUTF_NODE_PIPESTRING)) {
+    return NULL;
+  }
+  const char* str = pool_str (bin, node->v.str.offset, node->v.str.len);
+  if (str && len) *len = node->v.str.len;
+  return str;
+}
+
+IutfNode* iutf_bin_to_node (const IutfBinary* bin, const IutfBinNode* rec)
+{
+  if (!bin->header || !rec) return NULL;
+
+  IutfNode* node = iutf_node_new ((IutfNodeType) rec->type);
+  if (!node) return NULL;
+
+  if (rec->key != IUTF_BIN_NO_KEY) {
+    const char* key = iutf_bin_key (bin, rec);
+    if (!key || !(node->key = iutf_strdup (key))) goto fail;
+  }
+
+  switch (rec->type) {
+    case IUTF_NODE_STRING:
+    case IUTF_NODE_BIGSTRING:
+    case IUTF_NODE_PIPESTRING: {
+      const char* str = iutf_bin_str (bin, rec, NULL);
+      if (!str || !(node->data.str_value = iutf_strdup (str))) goto fail;
+      break;
+    }
+    case IUTF_NODE_ARRAY:
+    case IUTF_NODE_BRANCH: {
+      size_t size = iutf_bin_size (rec);
+      if (size == 0) break;
+      node->data.branch.items = iutf_malloc (size * sizeof (IutfNode*));
+      if (!node->data.branch.items) goto fail;
+      for (size_t i = 0; i < size; i++) {
+        const IutfBinNode* child = iutf_bin_child (bin, rec, i);
+        // children always come after their parent, so corrupt files can't loop
+        IutfNode* item = child > rec ? iutf_bin_to_node (bin, child) : NULL;
+        if (!item) goto fail;
+        node->data.branch.items[node->data.branch.size++] = item;
+      }
+      break;
+    }
+    case IUTF_NODE_INTEGER: node->data.int_value = rec->v.i; break;
+    case IUTF_NODE_LONG: node->data.long_value = rec->v.i; break;
+    case IUTF_NODE_FLOAT: node->data.float_value = rec->v.f; break;
+    case IUTF_NODE_CHARACTER: node->data.char_value = (char) rec->v.i; break;
+    case IUTF_NODE_BOOLEAN: node->data.bool_value = rec->v.i != 0; break;
+    case IUTF_NODE_NULL:
+    case IUTF_NODE_KEY_VALUE:
+      break;
+    default:
+      bin_fail ("unknown node type");
+      goto fail;
+  }
+  return node;
+
+fail:
+  iutf_node_free (node);
+  return NULL;
+}
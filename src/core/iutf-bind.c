@@ -0,0 +1,474 @@
+/* iutf-bind.c
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Bind version 0.1
+ */
+#define _GNU_SOURCE
+
+#include "../includes/iutf-bind.h"
+#include "../includes/iutf-decode.h"
+#include "../includes/iutf-hash.h"
+#include "../includes/colors.h"
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NO_BIT 0xFF
+
+typedef struct Compiled {
+  const IutfBindDesc* desc;
+  uint32_t* slots; // field index + 1, 0 = empty
+  uint32_t mask;
+  uint64_t* hashes; // per field
+  size_t* key_lens;
+  unsigned char* bits; // required bit per field or NO_BIT
+  struct Compiled** nested; // per field
+  uint64_t required; // all required bits
+  struct Compiled* next;
+} Compiled;
+
+// compiled descriptors live as long as the process, like registered types
+static Compiled* compiled;
+static pthread_mutex_t compiled_lock = PTHREAD_MUTEX_INITIALIZER;
+
+typedef struct {
+  IutfDecoder* d;
+  Compiled* root;
+  void* out;
+  int no_span;
+} Job;
+
+/* ---- compiling ---- */
+
+static int desc_error (const IutfBindDesc* desc, size_t i, const char* msg)
+{
+  fprintf (stderr, COL_RED "Bad bind descriptor: field '" COL_CYAN "%s" COL_RED "' %s" COL_DEF "\n",
+           i < desc->count && desc->fields[i].key ? desc->fields[i].key : "?", msg);
+  return 0;
+}
+
+static void compiled_free (Compiled* c)
+{
+  free (c->slots);
+  free (c->hashes);
+  free (c->key_lens);
+  free (c->bits);
+  free (c->nested);
+  free (c);
+}
+
+static int check_value (const IutfBindDesc* desc, size_t i, IutfBindType type)
+{
+  const IutfBindField* f = &desc->fields[i];
+  if (type == IUTF_BIND_STRUCT && !f->nested) return desc_error (desc, i, "is a struct without a nested descriptor");
+  if (type == IUTF_BIND_STRING && f->mode == IUTF_BIND_FIXED && f->size == 0) return desc_error (desc, i, "is a fixed string without a size");
+  if (type == IUTF_BIND_ARRAY) return desc_error (desc, i, "is an array of arrays");
+  return 1;
+}
+
+static Compiled* find_locked (const IutfBindDesc* desc, Compiled* list)
+{
+  for (Compiled* c = list; c; c = c->next) {
+    if (c->desc == desc) return c;
+  }
+  return NULL;
+}
+
+// hashed field table of one descriptor, nested ones are linked later
+static Compiled* build (const IutfBindDesc* desc)
+{
+  if (desc->size == 0) {
+    fprintf (stderr, COL_RED "Bad bind descriptor: size is 0" COL_DEF "\n");
+    return NULL;
+  }
+
+  Compiled* c = calloc (1, sizeof (Compiled));
+  if (!c) return NULL;
+  c->desc = desc;
+
+  size_t n = desc->count;
+  uint32_t size = 4;
+  while (size < n * 2) size <<= 1;
+  c->mask = size - 1;
+  c->slots = calloc (size, sizeof (uint32_t));
+  c->hashes = calloc (n ? n : 1, sizeof (uint64_t));
+  c->key_lens = calloc (n ? n : 1, sizeof (size_t));
+  c->bits = calloc (n ? n : 1, 1);
+  c->nested = calloc (n ? n : 1, sizeof (Compiled*));
+  if (!c->slots || !c->hashes || !c->key_lens || !c->bits || !c->nested) {
+    compiled_free (c);
+    return NULL;
+  }
+
+  unsigned required = 0;
+  for (size_t i = 0; i < n; i++) {
+    const IutfBindField* f = &desc->fields[i];
+    if (!f->key) {
+      desc_error (desc, i, "has no key");
+      compiled_free (c);
+      return NULL;
+    }
+    if (!(f->type == IUTF_BIND_ARRAY ? check_value (desc, i, f->item) : check_value (desc, i, f->type))) {
+      compiled_free (c);
+      return NULL;
+    }
+
+    c->key_lens[i] = strlen (f->key);
+    c->hashes[i] = iutf_hash_bytes (f->key, c->key_lens[i], 0);
+    c->bits[i] = NO_BIT;
+    if (f->flags & IUTF_BIND_REQUIRED) {
+      if (required == 64) {
+        desc_error (desc, i, "is one of more than 64 required fields");
+        compiled_free (c);
+        return NULL;
+      }
+      c->bits[i] = (unsigned char) required;
+      c->required |= 1ULL << required++;
+    }
+
+    uint32_t slot = (uint32_t) c->hashes[i] & c->mask;
+    while (c->slots[slot]) {
+      uint32_t other = c->slots[slot] - 1;
+      if (c->hashes[other] == c->hashes[i] && strcmp (desc->fields[other].key, f->key) == 0) {
+        desc_error (desc, i, "is declared twice");
+        compiled_free (c);
+        return NULL;
+      }
+      slot = (slot + 1) & c->mask;
+    }
+    c->slots[slot] = (uint32_t) i + 1;
+  }
+  return c;
+}
+
+static const IutfBindDesc* nested_of (const IutfBindField* f)
+{
+  return f->type == IUTF_BIND_STRUCT || (f->type == IUTF_BIND_ARRAY && f->item == IUTF_BIND_STRUCT) ? f->nested : NULL;
+}
+
+// builds `desc` and every descriptor reachable from it, then publishes them
+// together: nothing half-built is ever cached, recursive descriptors work
+static Compiled* compile_locked (const IutfBindDesc* desc)
+{
+  Compiled* c = find_locked (desc, compiled);
+  if (c) return c;
+
+  Compiled* pending = build (desc);
+  if (!pending) return NULL;
+
+  // pending is a queue: walk it while appending what it references
+  Compiled* tail = pending;
+  for (Compiled* p = pending; p; p = p->next) {
+    for (size_t i = 0; i < p->desc->count; i++) {
+      const IutfBindDesc* child = nested_of (&p->desc->fields[i]);
+      if (!child || find_locked (child, compiled) || find_locked (child, pending)) continue;
+      tail->next = build (child);
+      if (!tail->next) {
+        while (pending) {
+          Compiled* next = pending->next;
+          compiled_free (pending);
+          pending = next;
+        }
+        return NULL;
+      }
+      tail = tail->next;
+    }
+  }
+
+  for (Compiled* p = pending; p; p = p->next) {
+    for (size_t i = 0; i < p->desc->count; i++) {
+      const IutfBindDesc* child = nested_of (&p->desc->fields[i]);
+      if (!child) continue;
+      p->nested[i] = find_locked (child, pending);
+      if (!p->nested[i]) p->nested[i] = find_locked (child, compiled);
+    }
+  }
+  tail->next = compiled;
+  compiled = pending;
+  return pending;
+}
+
+static Compiled* compile (const IutfBindDesc* desc)
+{
+  if (!desc) return NULL;
+  pthread_mutex_lock (&compiled_lock);
+  Compiled* c = compile_locked (desc);
+  pthread_mutex_unlock (&compiled_lock);
+  return c;
+}
+
+/* ---- freeing ---- */
+
+static void free_struct (const Compiled* c, char* base);
+
+static size_t item_size (const IutfBindField* f, const Compiled* nested)
+{
+  switch (f->item) {
+    case IUTF_BIND_INT: return sizeof (long long);
+    case IUTF_BIND_INT32:
+    case IUTF_BIND_BOOL: return sizeof (int);
+    case IUTF_BIND_DOUBLE: return sizeof (double);
+    case IUTF_BIND_CHAR: return sizeof (char);
+    case IUTF_BIND_STRING:
+      if (f->mode == IUTF_BIND_DUP) return sizeof (char*);
+      if (f->mode == IUTF_BIND_SPAN) return sizeof (IutfBindSpan);
+      return f->size;
+    case IUTF_BIND_STRUCT: return nested->desc->size;
+    default: return 0;
+  }
+}
+
+// what a value owns, not the value itself
+static void free_value (IutfBindType type, const IutfBindField* f, const Compiled* nested, char* dst)
+{
+  if (type == IUTF_BIND_STRING && f->mode == IUTF_BIND_DUP) {
+    free (*(char**) dst);
+    *(char**) dst = NULL;
+  } else if (type == IUTF_BIND_STRUCT) {
+    free_struct (nested, dst);
+  }
+}
+
+static void free_array (const IutfBindField* f, const Compiled* nested, char* base)
+{
+  size_t size = item_size (f, nested);
+  int owns = f->item == IUTF_BIND_STRUCT || (f->item == IUTF_BIND_STRING && f->mode == IUTF_BIND_DUP);
+
+  if (f->capacity == 0) {
+    IutfBindArray* array = (IutfBindArray*) (base + f->offset);
+    for (size_t i = 0; owns && i < array->count; i++) free_value (f->item, f, nested, (char*) array->items + i * size);
+    free (array->items);
+    array->items = NULL;
+    array->count = 0;
+  } else {
+    size_t* count = (size_t*) (base + f->count_offset);
+    for (size_t i = 0; owns && i < *count && i < f->capacity; i++) free_value (f->item, f, nested, base + f->offset + i * size);
+    *count = 0;
+  }
+}
+
+static void free_struct (const Compiled* c, char* base)
+{
+  for (size_t i = 0; i < c->desc->count; i++) {
+    const IutfBindField* f = &c->desc->fields[i];
+    if (f->type == IUTF_BIND_ARRAY) free_array (f, c->nested[i], base);
+    else free_value (f->type, f, c->nested[i], base + f->offset);
+  }
+}
+
+/* ---- binding ---- */
+
+static int bind_struct (Job* job, const Compiled* c, char* base);
+
+static int bind_string (Job* job, const IutfBindField* f, char* dst)
+{
+  IutfDecoder* d = job->d;
+
+  if (f->mode == IUTF_BIND_DUP) {
+    char** str = (char**) dst;
+    free (*str);
+    *str = NULL;
+    return iutf_dec_string (d, str);
+  }
+
+  if (f->mode == IUTF_BIND_SPAN) {
+    if (job->no_span) return iutf_dec_fail (d, "'%s' is a span, bind from memory with iutf_bind", f->key);
+    IutfBindSpan* span = (IutfBindSpan*) dst;
+    return iutf_dec_span (d, &span->ptr, &span->len);
+  }
+
+  // fixed buffer: in place when possible, escaped strings need decoding
+  const char* start;
+  size_t len;
+  char* decoded = NULL;
+  if (d->tok.type == IUTF_TOK_STRING && memchr (d->tok.start + 1, '\\', d->tok.length - 2)) {
+    if (!iutf_dec_string (d, &decoded)) return 0;
+    start = decoded;
+    len = strlen (decoded);
+  } else if (!iutf_dec_span (d, &start, &len)) {
+    return 0;
+  }
+
+  int ok = len < f->size;
+  if (ok) {
+    memcpy (dst, start, len);
+    dst[len] = '\0';
+  }
+  free (decoded);
+  return ok ? 1 : iutf_dec_fail (d, "'%s' is longer than %zu bytes", f->key, f->size - 1);
+}
+
+static int bind_value (Job* job, IutfBindType type, const IutfBindField* f, const Compiled* nested, char* dst)
+{
+  IutfDecoder* d = job->d;
+
+  switch (type) {
+    case IUTF_BIND_INT:
+      return iutf_dec_int (d, (long long*) dst);
+    case IUTF_BIND_INT32: {
+      long long value;
+      if (!iutf_dec_int (d, &value)) return 0;
+      if (value < INT_MIN || value > INT_MAX) return iutf_dec_fail (d, "'%s' doesn't fit in an int", f->key);
+      *(int*) dst = (int) value;
+      return 1;
+    }
+    case IUTF_BIND_DOUBLE:
+      return iutf_dec_float (d, (double*) dst);
+    case IUTF_BIND_BOOL:
+      return iutf_dec_bool (d, (int*) dst);
+    case IUTF_BIND_CHAR:
+      return iutf_dec_char (d, dst);
+    case IUTF_BIND_STRING:
+      return bind_string (job, f, dst);
+    case IUTF_BIND_STRUCT:
+      free_struct (nested, dst);
+      memset (dst, 0, nested->desc->size);
+      return iutf_dec_begin_branch (d) && bind_struct (job, nested, dst);
+    default:
+      return iutf_dec_fail (d, "'%s' has an unknown bind type", f->key);
+  }
+}
+
+static int bind_array (Job* job, const IutfBindField* f, const Compiled* nested, char* base)
+{
+  IutfDecoder* d = job->d;
+  size_t size = item_size (f, nested);
+
+  // a repeated key replaces the earlier value
+  free_array (f, nested, base);
+  if (!iutf_dec_begin_array (d)) return 0;
+
+  if (f->capacity == 0) {
+    IutfBindArray* array = (IutfBindArray*) (base + f->offset);
+    size_t cap = 0;
+    while (iutf_dec_item (d)) {
+      if (array->count == cap) {
+        cap = cap ? cap * 2 : 8;
+        void* temp = realloc (array->items, cap * size);
+        if (!temp) return iutf_dec_fail (d, "out of memory");
+        array->items = temp;
+      }
+      // counted first so a half-read item is still freed
+      char* item = (char*) array->items + array->count++ * size;
+      memset (item, 0, size);
+      if (!bind_value (job, f->item, f, nested, item)) return 0;
+    }
+  } else {
+    size_t* count = (size_t*) (base + f->count_offset);
+    while (iutf_dec_item (d)) {
+      if (*count == f->capacity) return iutf_dec_fail (d, "'%s' has more than %zu items", f->key, f->capacity);
+      char* item = base + f->offset + (*count)++ * size;
+      memset (item, 0, size);
+      if (!bind_value (job, f->item, f, nested, item)) return 0;
+    }
+  }
+  return !d->error;
+}
+
+static int bind_struct (Job* job, const Compiled* c, char* base)
+{
+  IutfDecoder* d = job->d;
+  const IutfBindDesc* desc = c->desc;
+  uint64_t seen = 0;
+  const char* key;
+  size_t len;
+
+  while (iutf_dec_key (d, &key, &len)) {
+    uint64_t h = iutf_hash_bytes (key, len, 0);
+    uint32_t slot = (uint32_t) h & c->mask;
+    const IutfBindField* f = NULL;
+    size_t i = 0;
+    for (; c->slots[slot]; slot = (slot + 1) & c->mask) {
+      i = c->slots[slot] - 1;
+      if (c->hashes[i] == h && c->key_lens[i] == len && memcmp (desc->fields[i].key, key, len) == 0) {
+        f = &desc->fields[i];
+        break;
+      }
+    }
+
+    if (!f) {
+      if (desc->strict) return iutf_dec_fail (d, "unknown key '%.*s'", (int) len, key);
+      if (!iutf_dec_skip (d)) return 0;
+      continue;
+    }
+    if (d->tok.type == IUTF_TOK_NULL) {
+      // null leaves the member as it is
+      if (!iutf_dec_skip (d)) return 0;
+      continue;
+    }
+
+    int ok = f->type == IUTF_BIND_ARRAY ? bind_array (job, f, c->nested[i], base)
+                                        : bind_value (job, f->type, f, c->nested[i], base + f->offset);
+    if (!ok) return 0;
+    if (c->bits[i] != NO_BIT) seen |= 1ULL << c->bits[i];
+  }
+  if (d->error) return 0;
+
+  if (seen != c->required) {
+    for (size_t i = 0; i < desc->count; i++) {
+      if (c->bits[i] != NO_BIT && !(seen & (1ULL << c->bits[i]))) {
+        return iutf_dec_fail (d, "missing required field '%s'", desc->fields[i].key);
+      }
+    }
+  }
+  return 1;
+}
+
+static int bind_root (IutfDecoder* d, void* data)
+{
+  Job* job = data;
+  job->d = d;
+  return bind_struct (job, job->root, job->out);
+}
+
+static int bind_job (const char* input, size_t len, const char* filename, const IutfBindDesc* desc, void* out)
+{
+  Compiled* c = compile (desc);
+  if (!c) return 0;
+  memset (out, 0, desc->size);
+
+  Job job = { NULL, c, out, filename != NULL };
+  int ok = filename ? iutf_dec_run_file (filename, bind_root, &job) : iutf_dec_run (input, len, bind_root, &job);
+  if (!ok) {
+    free_struct (c, out);
+    memset (out, 0, desc->size);
+  }
+  return ok;
+}
+
+int iutf_bind (const char* input, size_t len, const IutfBindDesc* desc, void* out)
+{
+  if (!input || !out) return 0;
+  return bind_job (input, len, NULL, desc, out);
+}
+
+int iutf_bind_file (const char* filename, const IutfBindDesc* desc, void* out)
+{
+  if (!filename || !out) return 0;
+  return bind_job (NULL, 0, filename, desc, out);
+}
+
+void iutf_bind_free (const IutfBindDesc* desc, void* out)
+{
+  Compiled* c = compile (desc);
+  if (!c || !out) return;
+  free_struct (c, out);
+  memset (out, 0, desc->size);
+}
@@ -0,0 +1,253 @@
+/* iutf-buffer.c
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Buffer version 0.1
+ */
+#define _GNU_SOURCE
+
+#include "../includes/iutf-buffer.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+
+static const char digit_pairs[] =
+  "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+  "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+static const unsigned long long pow10_table[] = {
+  1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+  100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+  10000000000000ULL, 100000000000000ULL, 1000000000000000ULL
+};
+
+int iutf_buffer_fd_sink (void* ctx, const char* data, size_t len)
+{
+  int fd = (int)(intptr_t) ctx;
+  while (len > 0) {
+    ssize_t n = write (fd, data, len);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    data += n;
+    len -= (size_t) n;
+  }
+  return 0;
+}
+
+static int file_sink (void* ctx, const char* data, size_t len)
+{
+  return fwrite (data, 1, len, (FILE*) ctx) == len ? 0 : -1;
+}
+
+void iutf_buffer_init (IutfBuffer* buf)
+{
+  buf->data = NULL;
+  buf->len = 0;
+  buf->cap = 0;
+  buf->sink = NULL;
+  buf->sink_ctx = NULL;
+  buf->error = 0;
+}
+
+void iutf_buffer_init_sink (IutfBuffer* buf, IutfSinkFunc sink, void* ctx)
+{
+  iutf_buffer_init (buf);
+  buf->sink = sink;
+  buf->sink_ctx = ctx;
+}
+
+void iutf_buffer_init_fd (IutfBuffer* buf, int fd)
+{
+  iutf_buffer_init_sink (buf, iutf_buffer_fd_sink, (void*)(intptr_t) fd);
+}
+
+void iutf_buffer_init_file (IutfBuffer* buf, FILE* fp)
+{
+  iutf_buffer_init_sink (buf, file_sink, fp);
+}
+
+int iutf_buffer_flush (IutfBuffer* buf)
+{
+  if (!buf->sink || buf->len == 0 || buf->error) return !buf->error;
+  if (buf->sink (buf->sink_ctx, buf->data, buf->len) != 0) buf->error = 1;
+  buf->len = 0;
+  return !buf->error;
+}
+
+int iutf_buffer_reserve (IutfBuffer* buf, size_t extra)
+{
+  if (buf->error) return 0;
+  if (buf->len + extra + 1 <= buf->cap) return 1;
+
+  if (buf->sink && buf->len > 0) {
+    if (!iutf_buffer_flush (buf)) return 0;
+    if (extra + 1 <= buf->cap) return 1;
+  }
+
+  size_t cap = buf->cap ? buf->cap : (buf->sink ? IUTF_BUFFER_SINK_SIZE : 256);
+  while (cap < buf->len + extra + 1) cap *= 2;
+
+  char* temp = realloc (buf->data, cap);
+  if (!temp) {
+    buf->error = 1;
+    return 0;
+  }
+  buf->data = temp;
+  buf->cap = cap;
+  return 1;
+}
+
+char* iutf_buffer_steal (IutfBuffer* buf, size_t* len)
+{
+  if (buf->error || !iutf_buffer_reserve (buf, 0)) {
+    iutf_buffer_free (buf);
+    return NULL;
+  }
+  buf->data[buf->len] = '\0';
+  if (len) *len = buf->len;
+
+  char* data = buf->data;
+  buf->data = NULL;
+  buf->len = buf->cap = 0;
+  return data;
+}
+
+void iutf_buffer_free (IutfBuffer* buf)
+{
+  free (buf->data);
+  buf->data = NULL;
+  buf->len = buf->cap = 0;
+}
+
+void iutf_buffer_append (IutfBuffer* buf, const char* data, size_t len)
+{
+  if (!iutf_buffer_reserve (buf, len)) return;
+  memcpy (buf->data + buf->len, data, len);
+  buf->len += len;
+}
+
+void iutf_buffer_indent (IutfBuffer* buf, size_t spaces)
+{
+  if (!iutf_buffer_reserve (buf, spaces)) return;
+  memset (buf->data + buf->len, ' ', spaces);
+  buf->len += spaces;
+}
+
+// digits of `value` right-aligned into the end of `out`, returns the start
+static char* format_ull (unsigned long long value, char* end)
+{
+  char* p = end;
+  while (value >= 100) {
+    unsigned idx = (unsigned)(value % 100) * 2;
+    value /= 100;
+    *--p = digit_pairs[idx + 1];
+    *--p = digit_pairs[idx];
+  }
+  if (value >= 10) {
+    unsigned idx = (unsigned) value * 2;
+    *--p = digit_pairs[idx + 1];
+    *--p = digit_pairs[idx];
+  } else {
+    *--p = (char)('0' + value);
+  }
+  return p;
+}
+
+void iutf_buffer_ll (IutfBuffer* buf, long long value)
+{
+  char tmp[24];
+  unsigned long long u = value < 0 ? 0ULL - (unsigned long long) value : (unsigned long long) value;
+  char* p = format_ull (u, tmp + sizeof (tmp));
+  if (value < 0) *--p = '-';
+  iutf_buffer_append (buf, p, (size_t)(tmp + sizeof (tmp) - p));
+}
+
+void iutf_buffer_double (IutfBuffer* buf, double value)
+{
+  // IUTF has no literal for NaN or infinity
+  if (value != value || value - value != 0) {
+    iutf_buffer_append (buf, "null", 4);
+    return;
+  }
+
+  double a = value < 0 ? -value : value;
+  if (a < 1e15) {
+    // shortest k decimals that read back to the same double
+    double scale = 1.0;
+    for (int k = 0; k <= 15; k++, scale *= 10.0) {
+      double scaled = a * scale;
+      if (scaled >= 9007199254740992.0) break;
+      unsigned long long m = (unsigned long long)(scaled + 0.5);
+      if ((double) m / scale != a) continue;
+
+      char tmp[48];
+      char* end = tmp + sizeof (tmp);
+      char* p = end;
+      unsigned long long frac = m % pow10_table[k];
+      if (k == 0) {
+        *--p = '0';
+      } else {
+        char* digits = format_ull (frac, p);
+        while (p - digits < k) *--digits = '0';
+        p = digits;
+      }
+      *--p = '.';
+      p = format_ull (m / pow10_table[k], p);
+      if (value < 0) *--p = '-';
+      iutf_buffer_append (buf, p, (size_t)(end - p));
+      return;
+    }
+  }
+
+  // very large, very small or long mantissas
+  char tmp[40];
+  int len = snprintf (tmp, sizeof (tmp), "%.17g", value);
+  iutf_buffer_append (buf, tmp, (size_t) len);
+  if (!memchr (tmp, '.', (size_t) len) && !memchr (tmp, 'e', (size_t) len)) iutf_buffer_append (buf, ".0", 2);
+}
+
+void iutf_buffer_quoted (IutfBuffer* buf, const char* str, size_t len)
+{
+  static const char hex[] = "0123456789abcdef";
+  iutf_buffer_putc (buf, '"');
+
+  size_t run = 0;
+  for (size_t i = 0; i < len; i++) {
+    unsigned char c = (unsigned char) str[i];
+    if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+    iutf_buffer_append (buf, str + run, i - run);
+    run = i + 1;
+    switch (c) {
+      case '"': iutf_buffer_append (buf, "\\\"", 2); break;
+      case '\\': iutf_buffer_append (buf, "\\\\", 2); break;
+      case '\n': iutf_buffer_append (buf, "\\n", 2); break;
+      case '\t': iutf_buffer_append (buf, "\\t", 2); break;
+      case '\r': iutf_buffer_append (buf, "\\r", 2); break;
+      default: {
+        char esc[4] = { '\\', 'x', hex[c >> 4], hex[c & 15] };
+        iutf_buffer_append (buf, esc, 4);
+        break;
+      }
+    }
+  }
+  iutf_buffer_append (buf, str + run, len - run);
+  iutf_buffer_putc (buf, '"');
+}
@@ -0,0 +1,367 @@
+/* iutf-cache.c
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Cache version 0.1
+ */
+#define _GNU_SOURCE
+
+#include "../includes/iutf-cache.h"
+#include "../includes/iutf-parser.h"
+#include "../includes/iutf-hash.h"
+#include "../includes/iutf-stats.h"
+#include "../includes/colors.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define CACHE_MAGIC   "IUTC"
+#define CACHE_VERSION 1
+
+typedef struct {
+  char magic[4];
+  uint32_t version;
+  uint64_t source_hash;
+  uint64_t source_size;
+  uint32_t dep_count;
+  uint32_t reserved;
+  uint64_t bin_offset; // 8-byte aligned start of the .iutb data
+} CacheHeader;
+
+// one @import file, followed by its path padded to 8 bytes
+typedef struct {
+  int64_t mtime_sec;
+  int64_t mtime_nsec;
+  uint64_t size;
+  uint32_t path_len;
+  uint32_t reserved;
+} CacheDep;
+
+static int cache_state = -1; // -1 = not read from the environment yet
+
+int iutf_cache_enabled (void)
+{
+  int state = __atomic_load_n (&cache_state, __ATOMIC_RELAXED);
+  if (state < 0) {
+    const char* env = getenv ("IUTF_CACHE");
+    state = env && *env && strcmp (env, "0") != 0;
+    __atomic_store_n (&cache_state, state, __ATOMIC_RELAXED);
+  }
+  return state;
+}
+
+void iutf_cache_set_enabled (int enabled)
+{
+  __atomic_store_n (&cache_state, enabled ? 1 : 0, __ATOMIC_RELAXED);
+}
+
+static int mkdir_p (char* path)
+{
+  for (char* p = path + 1; *p; p++) {
+    if (*p != '/') continue;
+    *p = '\0';
+    int rc = mkdir (path, 0755);
+    *p = '/';
+    if (rc != 0 && errno != EEXIST) return 0;
+  }
+  return mkdir (path, 0755) == 0 || errno == EEXIST;
+}
+
+char* iutf_cache_dir (void)
+{
+  const char* env;
+  char* dir = NULL;
+
+  if ((env = getenv ("IUTF_CACHE_DIR")) && *env) {
+    dir = strdup (env);
+  } else if ((env = getenv ("XDG_CACHE_HOME")) && *env) {
+    if (asprintf (&dir, "%s/iutf", env) < 0) dir = NULL;
+  } else if ((env = getenv ("HOME")) && *env) {
+    if (asprintf (&dir, "%s/.cache/iutf", env) < 0) dir = NULL;
+  }
+
+  if (dir && !mkdir_p (dir)) {
+    free (dir);
+    return NULL;
+  }
+  return dir;
+}
+
+// <cache dir>/<hash of the absolute path and include path>.iutc
+static char* entry_path (const char* filename)
+{
+  char* real = realpath (filename, NULL);
+  if (!real) return NULL;
+
+  // imports resolve through IUTF_INCLUDE_PATH, so it is part of the key
+  const char* include = getenv ("IUTF_INCLUDE_PATH");
+  uint64_t h = iutf_hash_str (real);
+  h = iutf_hash_mix (h, iutf_hash_str (include ? include : ""));
+  free (real);
+
+  char* dir = iutf_cache_dir ();
+  if (!dir) return NULL;
+
+  char* path = NULL;
+  if (asprintf (&path, "%s/%016llx.iutc", dir, (unsigned long long) h) < 0) path = NULL;
+  free (dir);
+  return path;
+}
+
+// content hash of a file through a temporary mapping
+static int hash_file (const char* filename, uint64_t* hash, uint64_t* size)
+{
+  int fd = open (filename, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return 0;
+
+  struct stat st;
+  if (fstat (fd, &st) != 0) {
+    close (fd);
+    return 0;
+  }
+
+  *size = (uint64_t) st.st_size;
+  if (st.st_size == 0) {
+    close (fd);
+    *hash = iutf_hash_bytes ("", 0, 0);
+    return 1;
+  }
+
+  void* data = mmap (NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (data == MAP_FAILED) return 0;
+  *hash = iutf_hash_bytes (data, (size_t) st.st_size, 0);
+  munmap (data, (size_t) st.st_size);
+  return 1;
+}
+
+static inline size_t pad8 (size_t n)
+{
+  return (n + 7) & ~(size_t) 7;
+}
+
+// walks the dependency list, every import must still match its recorded stat
+static int deps_valid (const uint8_t* data, size_t size, const CacheHeader* h)
+{
+  size_t pos = sizeof (CacheHeader);
+  char path[4096];
+
+  for (uint32_t i = 0; i < h->dep_count; i++) {
+    if (pos + sizeof (CacheDep) > h->bin_offset) return 0;
+    const CacheDep* dep = (const CacheDep*) (data + pos);
+    pos += sizeof (CacheDep);
+    if (dep->path_len >= sizeof (path) || pos + dep->path_len > h->bin_offset) return 0;
+
+    memcpy (path, data + pos, dep->path_len);
+    path[dep->path_len] = '\0';
+    pos += pad8 (dep->path_len);
+
+    struct stat st;
+    if (stat (path, &st) != 0) return 0;
+    if ((uint64_t) st.st_size != dep->size || st.st_mtim.tv_sec != dep->mtime_sec || st.st_mtim.tv_nsec != dep->mtime_nsec) {
+      return 0;
+    }
+  }
+  return pos == h->bin_offset && h->bin_offset < size;
+}
+
+// 1 if the entry matches the source, 0 if it is missing or stale, -1 if it matches but won't load
+static int map_entry (const char* entry, uint64_t source_hash, uint64_t source_size, IutfBinary* bin)
+{
+  int fd = open (entry, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return 0;
+
+  struct stat st;
+  if (fstat (fd, &st) != 0 || st.st_size < (off_t) sizeof (CacheHeader)) {
+    close (fd);
+    return 0;
+  }
+
+  size_t size = (size_t) st.st_size;
+  uint8_t* data = mmap (NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (data == MAP_FAILED) return 0;
+
+  const CacheHeader* h = (const CacheHeader*) data;
+  int fresh = memcmp (h->magic, CACHE_MAGIC, 4) == 0
+              && h->version == CACHE_VERSION
+              && h->source_hash == source_hash
+              && h->source_size == source_size
+              && (h->bin_offset & 7) == 0
+              && deps_valid (data, size, h);
+  int ok = fresh && iutf_bin_open_mem (bin, data + h->bin_offset, size - h->bin_offset);
+
+  if (!ok) {
+    munmap (data, size);
+    return fresh ? -1 : 0;
+  }
+  bin->map = data;
+  bin->map_size = size;
+  return 1;
+}
+
+static int open_entry (const char* entry, uint64_t source_hash, uint64_t source_size, IutfBinary* bin)
+{
+  int hit = map_entry (entry, source_hash, source_size, bin);
+  if (hit > 0) IUTF_STAT_ADD (cache_hits, 1);
+  else IUTF_STAT_ADD (cache_misses, 1);
+  // storing it again would give the same entry: drop it instead
+  if (hit < 0) unlink (entry);
+  return hit;
+}
+
+int iutf_cache_open (const char* filename, IutfBinary* bin)
+{
+  memset (bin, 0, sizeof (IutfBinary));
+
+  uint64_t hash, size;
+  if (!hash_file (filename, &hash, &size)) return 0;
+
+  char* entry = entry_path (filename);
+  if (!entry) return 0;
+  int hit = open_entry (entry, hash, size, bin);
+  free (entry);
+  return hit > 0;
+}
+
+// `since` > 0 skips imports modified after that moment: they may have changed mid-parse
+static int store_entry (const char* filename, IutfNode* root, const IutfImportList* imports,
+                        uint64_t source_hash, uint64_t source_size, const struct timespec* since)
+{
+  CacheHeader header;
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, CACHE_MAGIC, 4);
+  header.version = CACHE_VERSION;
+  header.source_hash = source_hash;
+  header.source_size = source_size;
+  header.dep_count = imports ? (uint32_t) imports->size : 0;
+  header.bin_offset = sizeof (CacheHeader);
+
+  CacheDep* deps = header.dep_count ? calloc (header.dep_count, sizeof (CacheDep)) : NULL;
+  if (header.dep_count && !deps) return 0;
+
+  for (uint32_t i = 0; i < header.dep_count; i++) {
+    struct stat st;
+    size_t len = strlen (imports->paths[i]);
+    if (stat (imports->paths[i], &st) != 0 || len >= 4096) goto skip;
+    if (since && (st.st_mtim.tv_sec > since->tv_sec
+                  || (st.st_mtim.tv_sec == since->tv_sec && st.st_mtim.tv_nsec >= since->tv_nsec))) {
+      goto skip;
+    }
+    deps[i].mtime_sec = st.st_mtim.tv_sec;
+    deps[i].mtime_nsec = st.st_mtim.tv_nsec;
+    deps[i].size = (uint64_t) st.st_size;
+    deps[i].path_len = (uint32_t) len;
+    header.bin_offset += sizeof (CacheDep) + pad8 (len);
+  }
+
+  char* entry = entry_path (filename);
+  if (!entry) goto skip;
+
+  char* temp_path = NULL;
+  if (asprintf (&temp_path, "%s.XXXXXX", entry) < 0) {
+    free (entry);
+    goto skip;
+  }
+
+  int fd = mkstemp (temp_path);
+  int ok = 0;
+  if (fd >= 0) {
+    static const char zeros[8] = { 0 };
+    IutfBuffer buf;
+    iutf_buffer_init_fd (&buf, fd);
+    iutf_buffer_append (&buf, (const char*) &header, sizeof (header));
+    for (uint32_t i = 0; i < header.dep_count; i++) {
+      iutf_buffer_append (&buf, (const char*) &deps[i], sizeof (CacheDep));
+      iutf_buffer_append (&buf, imports->paths[i], deps[i].path_len);
+      iutf_buffer_append (&buf, zeros, pad8 (deps[i].path_len) - deps[i].path_len);
+    }
+    ok = iutf_bin_write (root, &buf) && iutf_buffer_flush (&buf);
+    iutf_buffer_free (&buf);
+    fchmod (fd, 0644);
+    if (close (fd) != 0) ok = 0;
+
+    // an entry that won't load would only be rewritten on every miss
+    IutfBinary check;
+    if (ok && map_entry (temp_path, source_hash, source_size, &check) > 0) iutf_bin_close (&check);
+    else ok = 0;
+
+    // rename is atomic: readers see the old entry or the complete new one
+    if (!ok || rename (temp_path, entry) != 0) {
+      unlink (temp_path);
+      ok = 0;
+    }
+  }
+
+  free (temp_path);
+  free (entry);
+  free (deps);
+  return ok;
+
+skip:
+  free (deps);
+  return 0;
+}
+
+int iutf_cache_store (const char* filename, IutfNode* root, const IutfImportList* imports)
+{
+  uint64_t hash, size;
+  if (!root || !hash_file (filename, &hash, &size)) return 0;
+  return store_entry (filename, root, imports, hash, size, NULL);
+}
+
+IutfNode* iutf_cache_parse (const char* filename)
+{
+  uint64_t hash = 0, size = 0;
+  int hashed = hash_file (filename, &hash, &size);
+
+  if (hashed) {
+    char* entry = entry_path (filename);
+    if (entry) {
+      IutfBinary bin;
+      if (open_entry (entry, hash, size, &bin) > 0) {
+        IutfNode* root = iutf_bin_to_node (&bin, iutf_bin_root (&bin));
+        iutf_bin_close (&bin);
+        if (root) {
+          free (entry);
+          return root;
+        }
+        unlink (entry); // out of memory or a bad tree: parse and store a new one
+      }
+      free (entry);
+    }
+  }
+
+  struct timespec start;
+  clock_gettime (CLOCK_REALTIME, &start);
+
+  IutfImportList imports = { NULL, 0 };
+  IutfNode* root = iutf_parse_from_file_imports (filename, &imports);
+
+  // only store what was parsed from the content we hashed
+  uint64_t after_hash, after_size;
+  if (root && hashed && hash_file (filename, &after_hash, &after_size) && after_hash == hash && after_size == size) {
+    store_entry (filename, root, &imports, hash, size, &start);
+  }
+  iutf_import_list_clear (&imports);
+  return root;
+}
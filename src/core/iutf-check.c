@@ -0,0 +1,590 @@
+/* iutf-check.c
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Check version 0.1
+ */
+#define _GNU_SOURCE
+
+#include "../includes/iutf-check.h"
+#include "../includes/iutf-decompress.h"
+#include "../includes/iutf-lexer.h"
+#include "../includes/iutf-stats.h"
+#include "../includes/colors.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// how a value is reached from its parent
+typedef struct {
+  const char* key; // NULL in arrays
+  size_t key_len;
+  size_t index;
+} Step;
+
+typedef struct {
+  char kind; // 'b' branch, 'a' array
+  char separator; // one ',' may follow: set by an item, cleared by the comma
+  uint32_t rule; // IUTF_SCHEMA_NO_RULE when unchecked
+  size_t count;
+  size_t bits; // required-field bitset, offset in Checker.bits
+  Step at;
+} Frame;
+
+typedef struct {
+  IutfLexer* lexer;
+  IutfLexWindow* window; // compressed input, NULL when the text is in memory
+  IutfToken tok;
+  const IutfSchema* schema;
+  IutfCheckResult* result;
+  Frame* stack;
+  size_t depth;
+  size_t stack_cap;
+  uint64_t* bits;
+  size_t bits_len;
+  size_t bits_cap;
+  char* scratch; // decoded strings and long numbers, reused
+  size_t scratch_cap;
+  Step cur; // the value being checked
+  char* keys; // keys of the steps once the window has moved past them
+} Checker;
+
+static void append_path (IutfCheckResult* result, size_t* n, const Step* step)
+{
+  size_t cap = sizeof (result->path);
+  if (*n >= cap - 1) return;
+
+  int w;
+  if (step->key) {
+    int len = step->key_len > 128 ? 128 : (int) step->key_len;
+    w = snprintf (result->path + *n, cap - *n, "%s%.*s", *n ? "." : "", len, step->key);
+  } else {
+    w = snprintf (result->path + *n, cap - *n, "[%zu]", step->index);
+  }
+  if (w > 0) *n += (size_t) w;
+  if (*n >= cap) *n = cap - 1;
+}
+
+// `at_value`: the error is about the current value, not the innermost open container
+static int fail (Checker* c, int at_value, const char* msg, const char* detail, size_t detail_len)
+{
+  IutfCheckResult* result = c->result;
+  result->line = c->tok.line;
+  result->col = c->tok.col;
+  if (detail) snprintf (result->message, sizeof (result->message), "%s '%.*s'", msg, (int) detail_len, detail);
+  else snprintf (result->message, sizeof (result->message), "%s", msg);
+
+  size_t n = 0;
+  result->path[0] = '\0';
+  for (size_t i = 1; i < c->depth; i++) append_path (result, &n, &c->stack[i].at);
+  if (at_value && c->depth > 0) append_path (result, &n, &c->cur);
+  return 0;
+}
+
+// a token that doesn't fit, or whatever the lexer complained about
+static int unexpected (Checker* c, int at_value, const char* msg)
+{
+  if (c->lexer->error) return fail (c, at_value, c->lexer->error, NULL, 0);
+  const char* got = iutf_token_type_to_string (c->tok.type);
+  return fail (c, at_value, msg, got, strlen (got));
+}
+
+static inline void next (Checker* c)
+{
+  if (c->window) iutf_lex_window_next (c->window, c->lexer, &c->tok);
+  else c->tok = iutf_lexer_next (c->lexer);
+}
+
+static void keep_key (Step* step, char** p)
+{
+  if (!step->key) return;
+  if (!*p) {
+    step->key = "?";
+    step->key_len = 1;
+    return;
+  }
+  memcpy (*p, step->key, step->key_len);
+  step->key = *p;
+  *p += step->key_len;
+}
+
+// the window is about to move: the keys an error path needs get a copy of their own
+static void keep_keys (void* ctx)
+{
+  Checker* c = ctx;
+  size_t need = c->cur.key ? c->cur.key_len : 0;
+  for (size_t i = 0; i < c->depth; i++) {
+    if (c->stack[i].at.key) need += c->stack[i].at.key_len;
+  }
+
+  char* keys = malloc (need ? need : 1);
+  char* p = keys;
+  keep_key (&c->cur, &p);
+  for (size_t i = 0; i < c->depth; i++) keep_key (&c->stack[i].at, &p);
+  free (c->keys);
+  c->keys = keys;
+}
+
+static int scratch_reserve (Checker* c, size_t need)
+{
+  if (need <= c->scratch_cap) return 1;
+  size_t cap = c->scratch_cap ? c->scratch_cap * 2 : 256;
+  while (cap < need) cap *= 2;
+  char* temp = realloc (c->scratch, cap);
+  if (!temp) return 0;
+  c->scratch = temp;
+  c->scratch_cap = cap;
+  return 1;
+}
+
+static int push (Checker* c, char kind, uint32_t rule)
+{
+  if (c->depth == c->stack_cap) {
+    size_t cap = c->stack_cap ? c->stack_cap * 2 : 16;
+    Frame* temp = realloc (c->stack, cap * sizeof (Frame));
+    if (!temp) return fail (c, 1, "out of memory", NULL, 0);
+    c->stack = temp;
+    c->stack_cap = cap;
+  }
+
+  size_t words = 0;
+  if (kind == 'b' && rule != IUTF_SCHEMA_NO_RULE) words = (c->schema->rules[rule].required + 63) / 64;
+  if (c->bits_len + words > c->bits_cap) {
+    size_t cap = c->bits_cap ? c->bits_cap * 2 : 16;
+    while (cap < c->bits_len + words) cap *= 2;
+    uint64_t* temp = realloc (c->bits, cap * sizeof (uint64_t));
+    if (!temp) return fail (c, 1, "out of memory", NULL, 0);
+    c->bits = temp;
+    c->bits_cap = cap;
+  }
+  memset (c->bits + c->bits_len, 0, words * sizeof (uint64_t));
+
+  Frame* f = &c->stack[c->depth++];
+  f->kind = kind;
+  f->separator = 0;
+  f->rule = rule;
+  f->count = 0;
+  f->bits = c->bits_len;
+  f->at = c->cur;
+  c->bits_len += words;
+
+  if (c->depth > c->result->max_depth) c->result->max_depth = c->depth;
+  return 1;
+}
+
+static int pop (Checker* c)
+{
+  Frame* f = &c->stack[c->depth - 1];
+
+  if (f->rule != IUTF_SCHEMA_NO_RULE) {
+    const IutfSchemaRule* rule = &c->schema->rules[f->rule];
+
+    if (f->kind == 'b' && rule->required) {
+      const IutfSchemaField* table = c->schema->fields + rule->fields;
+      const uint64_t* seen = c->bits + f->bits;
+      for (uint32_t i = 0; i <= rule->field_mask; i++) {
+        uint32_t bit = table[i].required_bit;
+        if (table[i].hash && bit != IUTF_SCHEMA_NO_RULE && !(seen[bit / 64] & (1ULL << (bit % 64)))) {
+          return fail (c, 0, "missing required field", c->schema->pool + table[i].key, table[i].key_len);
+        }
+      }
+    }
+
+    IutfSchemaValue value;
+    memset (&value, 0, sizeof (value));
+    value.type = f->kind == 'b' ? IUTF_SCHEMA_T_BRANCH : IUTF_SCHEMA_T_ARRAY;
+    value.integer = (long long) f->count;
+    const char* error = iutf_schema_check_value (c->schema, rule, &value);
+    if (error) return fail (c, 0, error, NULL, 0);
+  }
+
+  c->bits_len = f->bits;
+  c->depth--;
+  return 1;
+}
+
+// the value of a CHARACTER token, decoded the way the parser does it
+static char char_value (const IutfToken* t)
+{
+  const char* p = t->start;
+  if (p[1] != '\\') return p[1];
+
+  switch (p[2]) {
+    case 'n': return '\n';
+    case 't': return '\t';
+    case 'r': return '\r';
+    case '0': return '\0';
+    case 'x': {
+      char decoded[8];
+      iutf_unescape (p + 1, t->length - 2, decoded);
+      return decoded[0];
+    }
+    default: return p[2];
+  }
+}
+
+// numbers are only converted when a rule looks at them
+static int number_value (Checker* c, IutfSchemaValue* v)
+{
+  char local[64];
+  char* text = local;
+  if (c->tok.length >= sizeof (local)) {
+    if (!scratch_reserve (c, c->tok.length + 1)) return fail (c, 1, "out of memory", NULL, 0);
+    text = c->scratch;
+  }
+  memcpy (text, c->tok.start, c->tok.length);
+  text[c->tok.length] = '\0';
+
+  if (c->tok.type == IUTF_TOK_FLOAT) {
+    v->type = IUTF_SCHEMA_T_FLOAT;
+    v->number = atof (text);
+  } else {
+    v->type = IUTF_SCHEMA_T_INT;
+    v->integer = atoll (text);
+    v->number = (double) v->integer;
+  }
+  return 1;
+}
+
+static int check_value (Checker* c, uint32_t r)
+{
+  const IutfSchemaRule* rule = r != IUTF_SCHEMA_NO_RULE ? &c->schema->rules[r] : NULL;
+  int measure = rule && ((rule->flags & (IUTF_SCHEMA_F_MIN | IUTF_SCHEMA_F_MAX)) || rule->enum_count);
+  IutfSchemaValue v;
+  memset (&v, 0, sizeof (v));
+
+  switch (c->tok.type) {
+    case IUTF_TOK_BRANCH_OPEN:
+    case IUTF_TOK_LBRACKET: {
+      uint32_t bit = c->tok.type == IUTF_TOK_BRANCH_OPEN ? IUTF_SCHEMA_T_BRANCH : IUTF_SCHEMA_T_ARRAY;
+      if (rule && !(rule->types & bit)) return fail (c, 1, "unexpected type", iutf_schema_type_name (bit), strlen (iutf_schema_type_name (bit)));
+      c->result->values++;
+      if (!push (c, bit == IUTF_SCHEMA_T_BRANCH ? 'b' : 'a', r)) return 0;
+      next (c);
+      return 1;
+    }
+    case IUTF_TOK_STRING:
+      v.type = IUTF_SCHEMA_T_STRING;
+      v.str = c->tok.start + 1;
+      v.len = c->tok.length - 2;
+      if (measure && memchr (v.str, '\\', v.len)) {
+        if (!scratch_reserve (c, v.len + 1)) return fail (c, 1, "out of memory", NULL, 0);
+        v.len = iutf_unescape (v.str, v.len, c->scratch);
+        v.str = c->scratch;
+      }
+      break;
+    case IUTF_TOK_INTEGER:
+    case IUTF_TOK_LONG:
+    case IUTF_TOK_FLOAT:
+      if (measure) {
+        if (!number_value (c, &v)) return 0;
+      } else {
+        v.type = c->tok.type == IUTF_TOK_FLOAT ? IUTF_SCHEMA_T_FLOAT : IUTF_SCHEMA_T_INT;
+      }
+      break;
+    case IUTF_TOK_CHARACTER:
+      v.type = IUTF_SCHEMA_T_CHAR;
+      v.integer = char_value (&c->tok);
+      break;
+    case IUTF_TOK_TRUE:
+    case IUTF_TOK_FALSE:
+      v.type = IUTF_SCHEMA_T_BOOL;
+      v.integer = c->tok.type == IUTF_TOK_TRUE;
+      break;
+    case IUTF_TOK_NULL:
+      v.type = IUTF_SCHEMA_T_NULL;
+      break;
+    case IUTF_TOK_BIGSTRING_START:
+    case IUTF_TOK_PIPE:
+      v.type = IUTF_SCHEMA_T_STRING;
+      v.str = iutf_token_block (&c->tok, &v.len);
+      break;
+    default:
+      return unexpected (c, 1, "expected a value, got");
+  }
+
+  if (rule) {
+    const char* error = iutf_schema_check_value (c->schema, rule, &v);
+    if (error) {
+      const char* name = (rule->types & v.type) ? NULL : iutf_schema_type_name (v.type);
+      return fail (c, 1, error, name, name ? strlen (name) : 0);
+    }
+  }
+  c->result->values++;
+  next (c);
+  return 1;
+}
+
+// one key of a branch, returns the rule of its value
+static int check_key (Checker* c, Frame* top, uint32_t* child)
+{
+  c->cur.key = c->tok.start;
+  c->cur.key_len = c->tok.length;
+  *child = IUTF_SCHEMA_NO_RULE;
+  if (top->rule == IUTF_SCHEMA_NO_RULE) return 1;
+
+  const IutfSchemaRule* rule = &c->schema->rules[top->rule];
+  const IutfSchemaField* f = iutf_schema_field (c->schema, rule, c->tok.start, c->tok.length);
+  if (!f) {
+    if (rule->flags & IUTF_SCHEMA_F_STRICT) return fail (c, 1, "unknown key", NULL, 0);
+    return 1;
+  }
+  if (f->required_bit != IUTF_SCHEMA_NO_RULE) c->bits[top->bits + f->required_bit / 64] |= 1ULL << (f->required_bit % 64);
+  *child = f->rule;
+  return 1;
+}
+
+// `type NAME {` starts a declaration, a key named `type` is followed by ':' or '['
+static int type_decl_ahead (Checker* c)
+{
+  if (c->tok.length != 4 || memcmp (c->tok.start, "type", 4) != 0) return 0;
+  if (c->window) return iutf_lex_window_peek (c->window, c->lexer, &c->tok) == IUTF_TOK_IDENTIFIER;
+  IutfLexer ahead = *c->lexer;
+  ahead.quiet = 1;
+  return iutf_lexer_scan (&ahead).type == IUTF_TOK_IDENTIFIER;
+}
+
+// declarations belong to the parser (iutf-types.h), the branch is skipped whole
+static int skip_type_decl (Checker* c)
+{
+  next (c); // the name
+  next (c);
+  if (c->tok.type != IUTF_TOK_BRANCH_OPEN) return unexpected (c, 0, "expected '{' after a type name, got");
+
+  size_t depth = 0;
+  do {
+    switch (c->tok.type) {
+      case IUTF_TOK_BRANCH_OPEN:
+      case IUTF_TOK_LBRACKET:
+        depth++;
+        break;
+      case IUTF_TOK_BRANCH_CLOSE:
+      case IUTF_TOK_RBRACKET:
+        depth--;
+        break;
+      case IUTF_TOK_EOF:
+      case IUTF_TOK_ERROR:
+        return unexpected (c, 0, "expected '}', got");
+      default:
+        break;
+    }
+    next (c);
+  } while (depth > 0);
+  return 1;
+}
+
+static int check_run (Checker* c)
+{
+  // iutf:init:main {
+  static const IutfTokenType header[] = {
+    IUTF_TOK_IDENTIFIER, IUTF_TOK_COLON, IUTF_TOK_IDENTIFIER, IUTF_TOK_COLON, IUTF_TOK_IDENTIFIER
+  };
+  next (c);
+  for (size_t i = 0; i < sizeof (header) / sizeof (header[0]); i++) {
+    if (c->tok.type != header[i]) return unexpected (c, 1, "expected the iutf:init:main header, got");
+    next (c);
+  }
+  if (c->tok.type != IUTF_TOK_BRANCH_OPEN) return unexpected (c, 1, "expected '{', got");
+  if (!check_value (c, c->schema ? 0 : IUTF_SCHEMA_NO_RULE)) return 0;
+
+  while (c->depth > 0) {
+    Frame* top = &c->stack[c->depth - 1];
+    uint32_t child;
+
+    // like the parser: at most one ',' after each item, none before the first
+    if (c->tok.type == IUTF_TOK_COMMA) {
+      if (!top->separator) return unexpected (c, 0, top->kind == 'b' ? "expected a key, got" : "expected a value, got");
+      top->separator = 0;
+      next (c);
+      continue;
+    }
+
+    if (top->kind == 'b') {
+      if (c->tok.type == IUTF_TOK_BRANCH_CLOSE) {
+        if (!pop (c)) return 0;
+        if (c->depth > 0) next (c);
+        continue;
+      }
+      if (c->tok.type == IUTF_TOK_IMPORT) {
+        // the extension only brings types, which the checker does not resolve
+        c->result->unresolved++;
+        next (c);
+        if (c->tok.type == IUTF_TOK_IDENTIFIER && c->tok.length == 4 && memcmp (c->tok.start, "from", 4) == 0) {
+          next (c);
+          if (c->tok.type == IUTF_TOK_STRING || c->tok.type == IUTF_TOK_IDENTIFIER) next (c);
+        }
+        top->separator = 1;
+        continue;
+      }
+      if (c->tok.type == IUTF_TOK_EOF) return unexpected (c, 0, "expected '}', got");
+      if (c->tok.type != IUTF_TOK_IDENTIFIER) return unexpected (c, 0, "expected a key, got");
+      if (type_decl_ahead (c)) {
+        c->result->unresolved++;
+        if (!skip_type_decl (c)) return 0;
+        top->separator = 1;
+        continue;
+      }
+      if (!check_key (c, top, &child)) return 0;
+      next (c);
+      if (c->tok.type == IUTF_TOK_LBRACKET) {
+        // key[type]: types come from declarations and imports, which are not resolved here
+        c->result->unresolved++;
+        next (c);
+        if (c->tok.type != IUTF_TOK_IDENTIFIER) return unexpected (c, 1, "expected a type name, got");
+        next (c);
+        if (c->tok.type != IUTF_TOK_RBRACKET) return unexpected (c, 1, "expected ']', got");
+        next (c);
+      }
+      if (c->tok.type != IUTF_TOK_COLON) return unexpected (c, 1, "expected ':', got");
+      next (c);
+    } else {
+      if (c->tok.type == IUTF_TOK_RBRACKET) {
+        if (!pop (c)) return 0;
+        next (c);
+        continue;
+      }
+      if (c->tok.type == IUTF_TOK_EOF) return unexpected (c, 0, "expected ']', got");
+      c->cur.key = NULL;
+      c->cur.index = top->count;
+      child = top->rule != IUTF_SCHEMA_NO_RULE ? c->schema->rules[top->rule].items : IUTF_SCHEMA_NO_RULE;
+    }
+
+    // before check_value: a branch or array value may move the stack
+    top->count++;
+    top->separator = 1;
+    if (!check_value (c, child)) return 0;
+  }
+  return 1;
+}
+
+// the text in memory, or through `window` when it is NULL
+static int check_input (const char* input, size_t len, IutfLexWindow* window, const IutfSchema* schema, IutfCheckResult* result)
+{
+  IutfCheckResult local;
+  if (!result) result = &local;
+  memset (result, 0, sizeof (*result));
+  if (!input && !window) return 0;
+
+  Checker c;
+  memset (&c, 0, sizeof (c));
+  c.schema = schema;
+  c.result = result;
+  c.window = window;
+  c.lexer = iutf_lexer_new_len (input ? input : "", len);
+  if (!c.lexer) {
+    snprintf (result->message, sizeof (result->message), "out of memory");
+    return 0;
+  }
+  c.lexer->quiet = 1;
+  if (window) {
+    window->moving = keep_keys;
+    window->ctx = &c;
+  }
+
+  int ok = check_run (&c);
+  if (window && window->failed) {
+    ok = 0;
+    result->line = 0;
+    snprintf (result->message, sizeof (result->message), "cannot decompress file");
+  }
+
+  iutf_lexer_corrupt (c.lexer);
+  free (c.stack);
+  free (c.bits);
+  free (c.scratch);
+  free (c.keys);
+  return ok;
+}
+
+static int check_timed (const char* input, size_t len, IutfLexWindow* window, const IutfSchema* schema, IutfCheckResult* result)
+{
+  uint64_t started = iutf_stats_phase_begin ();
+  int ok = check_input (input, len, window, schema, result);
+  iutf_stats_phase_end (IUTF_PHASE_CHECK, started);
+  return ok;
+}
+
+int iutf_check (const char* input, size_t len, const IutfSchema* schema, IutfCheckResult* result)
+{
+  return check_timed (input, len, NULL, schema, result);
+}
+
+int iutf_check_file (const char* filename, const IutfSchema* schema, IutfCheckResult* result)
+{
+  IutfCheckResult local;
+  if (!result) result = &local;
+
+  int fd = open (filename, O_RDONLY | O_CLOEXEC);
+  struct stat st;
+  if (fd < 0 || fstat (fd, &st) != 0) {
+    if (fd >= 0) close (fd);
+    memset (result, 0, sizeof (*result));
+    snprintf (result->message, sizeof (result->message), "cannot open file");
+    return 0;
+  }
+
+  // a compressed file is checked block by block, only the window is in memory
+  IutfCompression compression = iutf_compression_of_fd (fd);
+  if (compression != IUTF_COMPRESSION_NONE) {
+    IutfDecompressor* d = iutf_decompress_open (fd, compression, filename);
+    IutfLexWindow window;
+    iutf_lex_window_init (&window, d);
+    int ok = d && check_timed (NULL, 0, &window, schema, result);
+    if (!d) {
+      memset (result, 0, sizeof (*result));
+      snprintf (result->message, sizeof (result->message), "cannot decompress file");
+    }
+    iutf_lex_window_free (&window);
+    iutf_decompress_close (d);
+    close (fd);
+    return ok;
+  }
+
+  size_t size = (size_t) st.st_size;
+  const char* data = "";
+  if (size > 0) {
+    data = mmap (NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      close (fd);
+      memset (result, 0, sizeof (*result));
+      snprintf (result->message, sizeof (result->message), "cannot map file");
+      return 0;
+    }
+    madvise ((void*) data, size, MADV_SEQUENTIAL);
+  }
+  close (fd);
+
+  int ok = iutf_check (data, size, schema, result);
+  if (size > 0) munmap ((void*) data, size);
+  return ok;
+}
+
+void iutf_check_report (FILE* fp, const char* filename, int ok, const IutfCheckResult* result)
+{
+  if (ok) {
+    fprintf (fp, "%s: " COL_GRN "OK" COL_DEF "\n", filename);
+  } else if (result->line > 0) {
+    fprintf (fp, "%s:%d:%d: " COL_RED "%s" COL_DEF, filename, result->line, result->col, result->message);
+    if (result->path[0]) fprintf (fp, " (at " COL_CYAN "%s" COL_DEF ")", result->path);
+    fputc ('\n', fp);
+  } else {
+    fprintf (fp, "%s: " COL_RED "%s" COL_DEF "\n", filename, result->message);
+  }
+}
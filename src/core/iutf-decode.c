@@ -0,0 +1,359 @@
+/* iutf-decode.c
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Decode version 0.1
+ */
+#define _GNU_SOURCE
+
+#include "../includes/iutf-decode.h"
+#include "../includes/colors.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static inline void next (IutfDecoder* d)
+{
+  d->tok = iutf_lexer_next (d->lexer);
+}
+
+int iutf_dec_fail (IutfDecoder* d, const char* fmt, ...)
+{
+  if (d->error) return 0;
+  d->error = 1;
+  d->line = d->tok.line;
+  d->col = d->tok.col;
+
+  va_list ap;
+  va_start (ap, fmt);
+  vsnprintf (d->message, sizeof (d->message), fmt, ap);
+  va_end (ap);
+
+  fprintf (stderr, COL_RED "Decode error at line %d, column %d: %s" COL_DEF "\n", d->line, d->col, d->message);
+  return 0;
+}
+
+// the token doesn't fit, unless the lexer already knows why
+static int unexpected (IutfDecoder* d, const char* what)
+{
+  if (d->lexer->error) return iutf_dec_fail (d, "%s", d->lexer->error);
+  return iutf_dec_fail (d, "expected %s, got %s", what, iutf_token_type_to_string (d->tok.type));
+}
+
+int iutf_dec_open (IutfDecoder* d, const char* input, size_t len)
+{
+  memset (d, 0, sizeof (*d));
+  d->lexer = iutf_lexer_new_len (input, len);
+  if (!d->lexer) return 0;
+  d->lexer->quiet = 1;
+
+  // iutf:init:main {
+  static const IutfTokenType header[] = {
+    IUTF_TOK_IDENTIFIER, IUTF_TOK_COLON, IUTF_TOK_IDENTIFIER, IUTF_TOK_COLON, IUTF_TOK_IDENTIFIER
+  };
+  next (d);
+  for (size_t i = 0; i < sizeof (header) / sizeof (header[0]); i++) {
+    if (d->tok.type != header[i]) return unexpected (d, "the iutf:init:main header");
+    next (d);
+  }
+  return iutf_dec_begin_branch (d);
+}
+
+void iutf_dec_close (IutfDecoder* d)
+{
+  iutf_lexer_corrupt (d->lexer);
+  d->lexer = NULL;
+}
+
+int iutf_dec_run (const char* input, size_t len, IutfDecodeFunc func, void* out)
+{
+  IutfDecoder d;
+  int ok = iutf_dec_open (&d, input, len) && func (&d, out) && !d.error;
+  iutf_dec_close (&d);
+  return ok;
+}
+
+int iutf_dec_run_file (const char* filename, IutfDecodeFunc func, void* out)
+{
+  int fd = open (filename, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    fprintf (stderr, COL_RED "Cannot open file: " COL_DEF COL_CYAN "%s" COL_DEF "\n", filename);
+    return 0;
+  }
+
+  struct stat st;
+  if (fstat (fd, &st) != 0) {
+    close (fd);
+    return 0;
+  }
+
+  size_t size = (size_t) st.st_size;
+  const char* data = "";
+  if (size > 0) {
+    data = mmap (NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      close (fd);
+      fprintf (stderr, COL_RED "Cannot map file: " COL_DEF COL_CYAN "%s" COL_DEF "\n", filename);
+      return 0;
+    }
+  }
+  close (fd);
+
+  int ok = iutf_dec_run (data, size, func, out);
+  if (size > 0) munmap ((void*) data, size);
+  return ok;
+}
+
+int iutf_dec_begin_branch (IutfDecoder* d)
+{
+  if (d->error) return 0;
+  if (d->tok.type != IUTF_TOK_BRANCH_OPEN) return unexpected (d, "'{'");
+  next (d);
+  return 1;
+}
+
+int iutf_dec_begin_array (IutfDecoder* d)
+{
+  if (d->error) return 0;
+  if (d->tok.type != IUTF_TOK_LBRACKET) return unexpected (d, "'['");
+  next (d);
+  return 1;
+}
+
+int iutf_dec_key (IutfDecoder* d, const char** key, size_t* len)
+{
+  while (!d->error) {
+    switch (d->tok.type) {
+      case IUTF_TOK_COMMA:
+        next (d);
+        continue;
+      case IUTF_TOK_BRANCH_CLOSE:
+        next (d);
+        return 0;
+      case IUTF_TOK_IMPORT:
+        // extensions only matter to the tree parser
+        next (d);
+        if (d->tok.type == IUTF_TOK_IDENTIFIER && d->tok.length == 4 && memcmp (d->tok.start, "from", 4) == 0) {
+          next (d);
+          if (d->tok.type == IUTF_TOK_STRING || d->tok.type == IUTF_TOK_IDENTIFIER) next (d);
+        }
+        continue;
+      case IUTF_TOK_IDENTIFIER:
+        break;
+      default:
+        return unexpected (d, "a key or '}'");
+    }
+
+    *key = d->tok.start;
+    *len = d->tok.length;
+    next (d);
+    if (d->tok.type == IUTF_TOK_LBRACKET) {
+      next (d);
+      if (d->tok.type != IUTF_TOK_IDENTIFIER) return unexpected (d, "a type name");
+      next (d);
+      if (d->tok.type != IUTF_TOK_RBRACKET) return unexpected (d, "']'");
+      next (d);
+    }
+    if (d->tok.type != IUTF_TOK_COLON) return unexpected (d, "':'");
+    next (d);
+    return 1;
+  }
+  return 0;
+}
+
+int iutf_dec_item (IutfDecoder* d)
+{
+  if (d->error) return 0;
+  if (d->tok.type == IUTF_TOK_COMMA) next (d);
+  if (d->tok.type == IUTF_TOK_RBRACKET) {
+    next (d);
+    return 0;
+  }
+  if (d->tok.type == IUTF_TOK_EOF || d->tok.type == IUTF_TOK_ERROR) return unexpected (d, "a value or ']'");
+  return 1;
+}
+
+int iutf_dec_int (IutfDecoder* d, long long* out)
+{
+  if (d->error) return 0;
+  if (d->tok.type != IUTF_TOK_INTEGER && d->tok.type != IUTF_TOK_LONG) return unexpected (d, "an integer");
+
+  const char* p = d->tok.start;
+  const char* end = p + d->tok.length - (d->tok.type == IUTF_TOK_LONG);
+  int negative = *p == '-';
+  if (negative) p++;
+
+  // accumulate negatively so LLONG_MIN fits
+  long long value = 0;
+  for (; p < end; p++) {
+    int digit = *p - '0';
+    if (value < (LLONG_MIN + digit) / 10) return iutf_dec_fail (d, "integer out of range");
+    value = value * 10 - digit;
+  }
+  if (!negative) {
+    if (value == LLONG_MIN) return iutf_dec_fail (d, "integer out of range");
+    value = -value;
+  }
+  *out = value;
+  next (d);
+  return 1;
+}
+
+int iutf_dec_float (IutfDecoder* d, double* out)
+{
+  if (d->error) return 0;
+  if (d->tok.type != IUTF_TOK_FLOAT && d->tok.type != IUTF_TOK_INTEGER && d->tok.type != IUTF_TOK_LONG) return unexpected (d, "a number");
+
+  char buf[128];
+  size_t len = d->tok.length - (d->tok.type == IUTF_TOK_LONG);
+  if (len >= sizeof (buf)) return iutf_dec_fail (d, "number too long");
+  memcpy (buf, d->tok.start, len);
+  buf[len] = '\0';
+  *out = strtod (buf, NULL);
+  next (d);
+  return 1;
+}
+
+int iutf_dec_bool (IutfDecoder* d, int* out)
+{
+  if (d->error) return 0;
+  if (d->tok.type != IUTF_TOK_TRUE && d->tok.type != IUTF_TOK_FALSE) return unexpected (d, "true or false");
+  *out = d->tok.type == IUTF_TOK_TRUE;
+  next (d);
+  return 1;
+}
+
+int iutf_dec_char (IutfDecoder* d, char* out)
+{
+  if (d->error) return 0;
+  if (d->tok.type != IUTF_TOK_CHARACTER) return unexpected (d, "a character");
+
+  // same decoding as the parser: 'c', '\n', '\x1b', anything else escaped is literal
+  const char* p = d->tok.start;
+  if (p[1] != '\\') {
+    *out = p[1];
+  } else {
+    switch (p[2]) {
+      case 'n': *out = '\n'; break;
+      case 't': *out = '\t'; break;
+      case 'r': *out = '\r'; break;
+      case '0': *out = '\0'; break;
+      case 'x': {
+        char decoded[8];
+        iutf_unescape (p + 1, d->tok.length - 2, decoded);
+        *out = decoded[0];
+        break;
+      }
+      default: *out = p[2]; break;
+    }
+  }
+  next (d);
+  return 1;
+}
+
+// raw text of BigString[...] or |...|, `what` names the expected value otherwise
+static int raw_string (IutfDecoder* d, const char** start, size_t* len, const char* what)
+{
+  if (d->tok.type == IUTF_TOK_BIGSTRING_START || d->tok.type == IUTF_TOK_PIPE) {
+    *start = iutf_token_block (&d->tok, len);
+    return 1;
+  }
+  return unexpected (d, what);
+}
+
+int iutf_dec_string (IutfDecoder* d, char** out)
+{
+  if (d->error) return 0;
+
+  if (d->tok.type == IUTF_TOK_STRING) {
+    // plain malloc, not iutf_token_string: the caller owns it and uses free ()
+    size_t len = d->tok.length - 2;
+    *out = malloc (len + 1);
+    if (!*out) return iutf_dec_fail (d, "out of memory");
+    iutf_unescape (d->tok.start + 1, len, *out);
+    next (d);
+    return 1;
+  }
+
+  const char* start = NULL;
+  size_t len = 0;
+  if (!raw_string (d, &start, &len, "a string")) return 0;
+  *out = strndup (start, len);
+  if (!*out) return iutf_dec_fail (d, "out of memory");
+  next (d);
+  return 1;
+}
+
+int iutf_dec_span (IutfDecoder* d, const char** start, size_t* len)
+{
+  if (d->error) return 0;
+
+  if (d->tok.type == IUTF_TOK_STRING) {
+    if (memchr (d->tok.start + 1, '\\', d->tok.length - 2)) return iutf_dec_fail (d, "escaped string can't be used in place");
+    *start = d->tok.start + 1;
+    *len = d->tok.length - 2;
+  } else if (!raw_string (d, start, len, "a string")) {
+    return 0;
+  }
+  next (d);
+  return 1;
+}
+
+int iutf_dec_skip (IutfDecoder* d)
+{
+  if (d->error) return 0;
+
+  switch (d->tok.type) {
+    case IUTF_TOK_BRANCH_OPEN: {
+      const char* key;
+      size_t len;
+      next (d);
+      while (iutf_dec_key (d, &key, &len)) {
+        if (!iutf_dec_skip (d)) return 0;
+      }
+      return !d->error;
+    }
+    case IUTF_TOK_LBRACKET:
+      next (d);
+      while (iutf_dec_item (d)) {
+        if (!iutf_dec_skip (d)) return 0;
+      }
+      return !d->error;
+    case IUTF_TOK_STRING:
+    case IUTF_TOK_INTEGER:
+    case IUTF_TOK_LONG:
+    case IUTF_TOK_FLOAT:
+    case IUTF_TOK_CHARACTER:
+    case IUTF_TOK_TRUE:
+    case IUTF_TOK_FALSE:
+    case IUTF_TOK_NULL:
+      next (d);
+      return 1;
+    default: {
+      const char* start;
+      size_t len;
+      if (!raw_string (d, &start, &len, "a value")) return 0;
+      next (d);
+      return 1;
+    }
+  }
+}
@@ -0,0 +1,427 @@
+/* iutf-decompress.c
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Decompress version 0.1
+ */
+#define _GNU_SOURCE
+
+#include "../includes/iutf-decompress.h"
+#include "../includes/iutf-stats.h"
+#include "../includes/colors.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+#ifdef IUTF_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+#define INPUT_SIZE (64 * 1024)
+
+struct IutfDecompressor {
+  int fd;
+  IutfCompression kind;
+  char* filename;
+  unsigned char* input; // compressed bytes, INPUT_SIZE
+
+  z_stream z;
+  int member_done; // the last gzip member ended, EOF here is clean
+#ifdef IUTF_WITH_ZSTD
+  ZSTD_DCtx* zstd;
+  ZSTD_inBuffer zin;
+  int frame_open; // EOF here means a truncated frame
+#endif
+
+  // ring: the producer fills blocks [tail, head), the consumer holds `tail` between calls
+  char* blocks[IUTF_DECOMPRESS_BUFFERS];
+  size_t lens[IUTF_DECOMPRESS_BUFFERS];
+  size_t head;
+  size_t tail;
+  int holding;
+  int finished; // the producer is done, `error` tells how
+  int error;
+  int stop;
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t ready; // a block is filled or the producer finished
+  pthread_cond_t space; // a block was released or stop
+};
+
+IutfCompression iutf_compression_detect (const void* data, size_t len)
+{
+  const unsigned char* p = data;
+  if (len >= 2 && p[0] == 0x1f && p[1] == 0x8b) return IUTF_COMPRESSION_GZIP;
+  if (len >= 4 && p[0] == 0x28 && p[1] == 0xb5 && p[2] == 0x2f && p[3] == 0xfd) return IUTF_COMPRESSION_ZSTD;
+  return IUTF_COMPRESSION_NONE;
+}
+
+IutfCompression iutf_compression_of_fd (int fd)
+{
+  unsigned char magic[4];
+  off_t offset = lseek (fd, 0, SEEK_CUR);
+  ssize_t n = offset < 0 ? -1 : pread (fd, magic, sizeof (magic), offset);
+  return n > 0 ? iutf_compression_detect (magic, (size_t) n) : IUTF_COMPRESSION_NONE;
+}
+
+IutfCompression iutf_compression_of_file (const char* filename)
+{
+  int fd = open (filename, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return IUTF_COMPRESSION_NONE;
+  IutfCompression kind = iutf_compression_of_fd (fd);
+  close (fd);
+  return kind;
+}
+
+// bytes of compressed input read, 0 at EOF, -1 on error
+static ssize_t read_input (IutfDecompressor* d)
+{
+  ssize_t n;
+  do {
+    n = read (d->fd, d->input, INPUT_SIZE);
+  } while (n < 0 && errno == EINTR);
+  if (n < 0) {
+    fprintf (stderr, COL_RED "Cannot read " COL_CYAN "%s" COL_RED ": %s" COL_DEF "\n", d->filename, strerror (errno));
+    return -1;
+  }
+  return n;
+}
+
+static void corrupt (IutfDecompressor* d, const char* what)
+{
+  fprintf (stderr, COL_RED "Corrupt compressed file " COL_CYAN "%s" COL_RED ": %s" COL_DEF "\n", d->filename, what);
+}
+
+// fill `out` up to `cap`: 1 if full, 0 at the end of the data, -1 on error
+static int fill_gzip (IutfDecompressor* d, char* out, size_t cap, size_t* got)
+{
+  z_stream* z = &d->z;
+  z->next_out = (Bytef*) out;
+  z->avail_out = (uInt) cap;
+  while (z->avail_out > 0) {
+    if (z->avail_in == 0) {
+      ssize_t n = read_input (d);
+      if (n < 0) return -1;
+      if (n == 0) {
+        *got = cap - z->avail_out;
+        if (d->member_done) return 0;
+        corrupt (d, "unexpected end of data");
+        return -1;
+      }
+      z->next_in = d->input;
+      z->avail_in = (uInt) n;
+    }
+    int ret = inflate (z, Z_NO_FLUSH);
+    if (ret == Z_STREAM_END) {
+      // `cat a.gz b.gz` is one valid gzip file
+      d->member_done = 1;
+      inflateReset (z);
+    } else if (ret == Z_OK || ret == Z_BUF_ERROR) {
+      d->member_done = 0;
+    } else {
+      corrupt (d, z->msg ? z->msg : "inflate failed");
+      return -1;
+    }
+  }
+  *got = cap;
+  return 1;
+}
+
+#ifdef IUTF_WITH_ZSTD
+static int fill_zstd (IutfDecompressor* d, char* out, size_t cap, size_t* got)
+{
+  ZSTD_outBuffer o = { out, cap, 0 };
+  while (o.pos < o.size) {
+    if (d->zin.pos == d->zin.size) {
+      ssize_t n = read_input (d);
+      if (n < 0) return -1;
+      if (n == 0) {
+        *got = o.pos;
+        if (!d->frame_open) return 0;
+        corrupt (d, "unexpected end of data");
+        return -1;
+      }
+      d->zin.src = d->input;
+      d->zin.size = (size_t) n;
+      d->zin.pos = 0;
+    }
+    size_t ret = ZSTD_decompressStream (d->zstd, &o, &d->zin);
+    if (ZSTD_isError (ret)) {
+      corrupt (d, ZSTD_getErrorName (ret));
+      return -1;
+    }
+    d->frame_open = ret != 0;
+  }
+  *got = cap;
+  return 1;
+}
+#endif
+
+static int fill (IutfDecompressor* d, char* out, size_t cap, size_t* got)
+{
+#ifdef IUTF_WITH_ZSTD
+  if (d->kind == IUTF_COMPRESSION_ZSTD) return fill_zstd (d, out, cap, got);
+#endif
+  return fill_gzip (d, out, cap, got);
+}
+
+static void* producer (void* arg)
+{
+  IutfDecompressor* d = arg;
+  for (;;) {
+    pthread_mutex_lock (&d->lock);
+    while (!d->stop && d->head - d->tail == IUTF_DECOMPRESS_BUFFERS) pthread_cond_wait (&d->space, &d->lock);
+    size_t slot = d->head % IUTF_DECOMPRESS_BUFFERS;
+    int stop = d->stop;
+    pthread_mutex_unlock (&d->lock);
+    if (stop) return NULL;
+
+    size_t got = 0;
+    int result = fill (d, d->blocks[slot], IUTF_DECOMPRESS_BUFFER_SIZE, &got);
+
+    pthread_mutex_lock (&d->lock);
+    if (got > 0 && result >= 0) {
+      d->lens[slot] = got;
+      d->head++;
+    }
+    if (result <= 0) {
+      d->finished = 1;
+      d->error = result < 0;
+    }
+    pthread_cond_signal (&d->ready);
+    pthread_mutex_unlock (&d->lock);
+    if (result <= 0) return NULL;
+  }
+}
+
+static void release (IutfDecompressor* d)
+{
+  if (!d) return;
+  inflateEnd (&d->z);
+#ifdef IUTF_WITH_ZSTD
+  ZSTD_freeDCtx (d->zstd);
+#endif
+  for (int i = 0; i < IUTF_DECOMPRESS_BUFFERS; i++) free (d->blocks[i]);
+  free (d->input);
+  free (d->filename);
+  free (d);
+}
+
+IutfDecompressor* iutf_decompress_open (int fd, IutfCompression kind, const char* filename)
+{
+#ifndef IUTF_WITH_ZSTD
+  if (kind == IUTF_COMPRESSION_ZSTD) {
+    fprintf (stderr, COL_RED "Cannot read " COL_CYAN "%s" COL_RED ": built without zstd (IUTF_WITH_ZSTD)" COL_DEF "\n", filename);
+    return NULL;
+  }
+#endif
+  if (kind == IUTF_COMPRESSION_NONE) return NULL;
+
+  IutfDecompressor* d = calloc (1, sizeof (IutfDecompressor));
+  if (!d) return NULL;
+  d->fd = fd;
+  d->kind = kind;
+  d->filename = strdup (filename ? filename : "<fd>");
+  d->input = malloc (INPUT_SIZE);
+  int ok = d->filename && d->input;
+  for (int i = 0; i < IUTF_DECOMPRESS_BUFFERS && ok; i++) ok = (d->blocks[i] = malloc (IUTF_DECOMPRESS_BUFFER_SIZE)) != NULL;
+
+  // 15 + 32: any window size, gzip or zlib header
+  if (ok && kind == IUTF_COMPRESSION_GZIP) ok = inflateInit2 (&d->z, 15 + 32) == Z_OK;
+#ifdef IUTF_WITH_ZSTD
+  if (ok && kind == IUTF_COMPRESSION_ZSTD) ok = (d->zstd = ZSTD_createDCtx ()) != NULL;
+#endif
+  if (!ok) {
+    fprintf (stderr, COL_RED "Out of memory" COL_DEF "\n");
+    release (d);
+    return NULL;
+  }
+
+  pthread_mutex_init (&d->lock, NULL);
+  pthread_cond_init (&d->ready, NULL);
+  pthread_cond_init (&d->space, NULL);
+  if (pthread_create (&d->thread, NULL, producer, d) != 0) {
+    fprintf (stderr, COL_RED "Cannot start the decompression thread" COL_DEF "\n");
+    pthread_mutex_destroy (&d->lock);
+    pthread_cond_destroy (&d->ready);
+    pthread_cond_destroy (&d->space);
+    release (d);
+    return NULL;
+  }
+  return d;
+}
+
+int iutf_decompress_next (IutfDecompressor* d, const char** data, size_t* len)
+{
+  if (!d) return -1;
+  pthread_mutex_lock (&d->lock);
+  if (d->holding) {
+    d->tail++;
+    d->holding = 0;
+    pthread_cond_signal (&d->space);
+  }
+  while (d->tail == d->head && !d->finished) pthread_cond_wait (&d->ready, &d->lock);
+
+  int result;
+  if (d->tail < d->head) {
+    *data = d->blocks[d->tail % IUTF_DECOMPRESS_BUFFERS];
+    *len = d->lens[d->tail % IUTF_DECOMPRESS_BUFFERS];
+    d->holding = 1;
+    result = 1;
+  } else {
+    *len = 0;
+    result = d->error ? -1 : 0;
+  }
+  pthread_mutex_unlock (&d->lock);
+  return result;
+}
+
+void iutf_decompress_close (IutfDecompressor* d)
+{
+  if (!d) return;
+  pthread_mutex_lock (&d->lock);
+  d->stop = 1;
+  pthread_cond_signal (&d->space);
+  pthread_mutex_unlock (&d->lock);
+  pthread_join (d->thread, NULL);
+  pthread_mutex_destroy (&d->lock);
+  pthread_cond_destroy (&d->ready);
+  pthread_cond_destroy (&d->space);
+  release (d);
+}
+
+char* iutf_decompress_all (IutfDecompressor* d, size_t* len)
+{
+  size_t size = 0;
+  size_t cap = IUTF_DECOMPRESS_BUFFER_SIZE;
+  char* all = malloc (cap + 1);
+  const char* block;
+  size_t block_len;
+  int result = -1;
+  while (all && (result = iutf_decompress_next (d, &block, &block_len)) > 0) {
+    if (size + block_len > cap) {
+      while (size + block_len > cap) cap *= 2;
+      char* grown = realloc (all, cap + 1);
+      if (!grown) break;
+      all = grown;
+    }
+    memcpy (all + size, block, block_len);
+    size += block_len;
+  }
+  if (!all || result != 0) {
+    if (all && result > 0) fprintf (stderr, COL_RED "Out of memory" COL_DEF "\n");
+    free (all);
+    return NULL;
+  }
+  all[size] = '\0';
+  *len = size;
+  return all;
+}
+
+/* ---- lexing through a window ---- */
+
+void iutf_lex_window_init (IutfLexWindow* w, IutfDecompressor* source)
+{
+  memset (w, 0, sizeof (*w));
+  w->source = source;
+}
+
+void iutf_lex_window_free (IutfLexWindow* w)
+{
+  free (w->data);
+  w->data = NULL;
+  w->cap = 0;
+}
+
+// drop what is before `tok` (or before the lexer), then append the next block
+static void window_fill (IutfLexWindow* w, IutfLexer* lexer, IutfToken* tok)
+{
+  if (w->moving) w->moving (w->ctx);
+
+  int has_tok = w->data && tok->start >= w->data && tok->start <= w->data + lexer->len;
+  size_t tok_at = has_tok ? (size_t) (tok->start - w->data) : 0;
+  size_t keep = has_tok && tok_at < lexer->pos ? tok_at : lexer->pos;
+  if (keep > 0) {
+    memmove (w->data, w->data + keep, lexer->len - keep);
+    lexer->len -= keep;
+    lexer->pos -= keep;
+    tok_at -= keep;
+  }
+
+  const char* block;
+  size_t len;
+  int result = iutf_decompress_next (w->source, &block, &len);
+  if (result > 0 && lexer->len + len + 1 > w->cap) {
+    size_t cap = w->cap ? w->cap : IUTF_DECOMPRESS_BUFFER_SIZE;
+    while (cap < lexer->len + len + 1) cap *= 2;
+    char* grown = realloc (w->data, cap);
+    if (grown) {
+      w->data = grown;
+      w->cap = cap;
+    } else {
+      fprintf (stderr, COL_RED "Out of memory" COL_DEF "\n");
+      result = -1;
+    }
+  }
+  if (result > 0) {
+    memcpy (w->data + lexer->len, block, len);
+    lexer->len += len;
+    w->data[lexer->len] = '\0';
+  } else {
+    w->done = 1;
+    w->failed = result < 0;
+  }
+
+  lexer->input = w->data ? w->data : "";
+  if (has_tok) tok->start = w->data + tok_at;
+}
+
+void iutf_lex_window_next (IutfLexWindow* w, IutfLexer* lexer, IutfToken* tok)
+{
+  int quiet = lexer->quiet;
+  lexer->quiet = 1;
+  for (;;) {
+    IutfLexer before = *lexer;
+    IutfToken next = iutf_lexer_scan (lexer);
+    if (w->done || lexer->pos + IUTF_LEX_WINDOW_SLACK <= lexer->len) {
+      *tok = next;
+      break;
+    }
+    *lexer = before;
+    window_fill (w, lexer, tok);
+  }
+  lexer->quiet = quiet;
+
+  IUTF_STAT_ADD (tokens[tok->type], 1);
+  if (tok->type == IUTF_TOK_ERROR && !quiet) {
+    fprintf (stderr, COL_RED "%s at line %d, column %d" COL_DEF "\n", lexer->error, tok->line, tok->col);
+  }
+}
+
+IutfTokenType iutf_lex_window_peek (IutfLexWindow* w, IutfLexer* lexer, IutfToken* tok)
+{
+  for (;;) {
+    IutfLexer ahead = *lexer;
+    ahead.quiet = 1;
+    IutfToken next = iutf_lexer_scan (&ahead);
+    if (w->done || ahead.pos + IUTF_LEX_WINDOW_SLACK <= ahead.len) return next.type;
+    window_fill (w, lexer, tok);
+  }
+}
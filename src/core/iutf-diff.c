@@ -0,0 +1,324 @@
+/* iutf-diff.c
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Diff version 0.1
+ */
+#define _GNU_SOURCE
+
+#include "../includes/iutf-diff.h"
+#include "../includes/iutf-hash.h"
+#include "../includes/colors.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// below this size a linear key scan beats building a table
+#define DIFF_LINEAR_LIMIT 8
+
+typedef struct {
+  char* buf;
+  size_t len;
+  size_t cap;
+} PathBuf;
+
+/*
+ * The cached word is the hash with its two low bits replaced by HASH_VALID and
+ * the mode, one store publishes both: a frozen node hashed in both modes at
+ * once never holds one thread's hash under the other's mode. 0 = not hashed.
+ */
+#define HASH_VALID 1u
+#define HASH_UNORD 2u
+#define HASH_TAGS  3u
+
+uint64_t iutf_node_hash (IutfNode* node, int flags)
+{
+  if (!node) return 0;
+
+  uint64_t tag = HASH_VALID | ((flags & IUTF_HASH_UNORDERED_BRANCHES) ? HASH_UNORD : 0);
+  uint64_t cached = __atomic_load_n (&node->hash, __ATOMIC_RELAXED);
+  if ((cached & HASH_TAGS) == tag) return cached & ~(uint64_t) HASH_TAGS;
+
+  uint64_t h = iutf_hash_mix (0x1F3D5B79u, (uint64_t) node->type);
+  switch (node->type) {
+    case IUTF_NODE_STRING:
+    case IUTF_NODE_BIGSTRING:
+    case IUTF_NODE_PIPESTRING:
+      if (node->data.str_value) h = iutf_hash_mix (h, iutf_hash_str (node->data.str_value));
+      break;
+    case IUTF_NODE_INTEGER:
+    case IUTF_NODE_LONG:
+      h = iutf_hash_mix (h, (uint64_t) node->data.int_value);
+      break;
+    case IUTF_NODE_FLOAT: {
+      uint64_t bits;
+      double value = node->data.float_value == 0.0 ? 0.0 : node->data.float_value;
+      memcpy (&bits, &value, sizeof (bits));
+      h = iutf_hash_mix (h, bits);
+      break;
+    }
+    case IUTF_NODE_CHARACTER:
+      h = iutf_hash_mix (h, (uint64_t)(unsigned char) node->data.char_value);
+      break;
+    case IUTF_NODE_BOOLEAN:
+      h = iutf_hash_mix (h, (uint64_t) (node->data.bool_value != 0));
+      break;
+    case IUTF_NODE_ARRAY:
+      for (size_t i = 0; i < node->data.array.size; i++) {
+        h = iutf_hash_mix (h, iutf_node_hash (node->data.array.items[i], flags));
+      }
+      break;
+    case IUTF_NODE_BRANCH: {
+      uint64_t sum = 0;
+      for (size_t i = 0; i < node->data.branch.size; i++) {
+        IutfNode* item = node->data.branch.items[i];
+        uint64_t entry = iutf_hash_mix (item->key ? iutf_hash_str (item->key) : 0, iutf_node_hash (item, flags));
+        if (flags & IUTF_HASH_UNORDERED_BRANCHES) sum += entry;
+        else h = iutf_hash_mix (h, entry);
+      }
+      if (flags & IUTF_HASH_UNORDERED_BRANCHES) h = iutf_hash_mix (h, sum ^ node->data.branch.size);
+      break;
+    }
+    default:
+      break;
+  }
+
+  h &= ~(uint64_t) HASH_TAGS;
+  __atomic_store_n (&node->hash, h | tag, __ATOMIC_RELAXED);
+  return h;
+}
+
+void iutf_hash_invalidate (IutfNode* node)
+{
+  if (!node) return;
+  node->hash = 0;
+
+  if (node->type == IUTF_NODE_ARRAY) {
+    for (size_t i = 0; i < node->data.array.size; i++) iutf_hash_invalidate (node->data.array.items[i]);
+  } else if (node->type == IUTF_NODE_BRANCH) {
+    for (size_t i = 0; i < node->data.branch.size; i++) iutf_hash_invalidate (node->data.branch.items[i]);
+  }
+}
+
+static int path_push (PathBuf* path, const char* seg, size_t len)
+{
+  size_t need = path->len + len + 2;
+  if (need > path->cap) {
+    size_t cap = path->cap ? path->cap * 2 : 64;
+    while (cap < need) cap *= 2;
+    char* temp = realloc (path->buf, cap);
+    if (!temp) return 0;
+    path->buf = temp;
+    path->cap = cap;
+  }
+  if (path->len > 0) path->buf[path->len++] = '.';
+  memcpy (path->buf + path->len, seg, len);
+  path->len += len;
+  path->buf[path->len] = '\0';
+  return 1;
+}
+
+static int emit (IutfDiff* diff, IutfChangeKind kind, const PathBuf* path, IutfNode* old_node, IutfNode* new_node)
+{
+  if (diff->size == diff->capacity) {
+    size_t cap = diff->capacity ? diff->capacity * 2 : 16;
+    IutfChange* temp = realloc (diff->items, cap * sizeof (IutfChange));
+    if (!temp) return 0;
+    diff->items = temp;
+    diff->capacity = cap;
+  }
+
+  IutfChange* change = &diff->items[diff->size];
+  change->path = strndup (path->buf ? path->buf : "", path->len);
+  if (!change->path) return 0;
+  change->kind = kind;
+  change->old_node = old_node;
+  change->new_node = new_node;
+  diff->size++;
+  return 1;
+}
+
+static int diff_node (IutfDiff* diff, PathBuf* path, IutfNode* a, IutfNode* b, int flags);
+
+static int diff_child (IutfDiff* diff, PathBuf* path, const char* seg, size_t seg_len, IutfNode* a, IutfNode* b, int flags)
+{
+  size_t saved = path->len;
+  if (!path_push (path, seg, seg_len)) return 0;
+
+  int ok;
+  if (!a) ok = emit (diff, IUTF_CHANGE_ADDED, path, NULL, b);
+  else if (!b) ok = emit (diff, IUTF_CHANGE_REMOVED, path, a, NULL);
+  else ok = diff_node (diff, path, a, b, flags);
+
+  path->len = saved;
+  if (path->buf) path->buf[saved] = '\0';
+  return ok;
+}
+
+static int diff_array (IutfDiff* diff, PathBuf* path, IutfNode* a, IutfNode* b, int flags)
+{
+  size_t n = a->data.array.size > b->data.array.size ? a->data.array.size : b->data.array.size;
+  char seg[24];
+
+  for (size_t i = 0; i < n; i++) {
+    IutfNode* x = i < a->data.array.size ? a->data.array.items[i] : NULL;
+    IutfNode* y = i < b->data.array.size ? b->data.array.items[i] : NULL;
+    if (x && y && iutf_node_hash (x, flags) == iutf_node_hash (y, flags)) continue;
+
+    int len = snprintf (seg, sizeof (seg), "%zu", i);
+    if (!diff_child (diff, path, seg, (size_t) len, x, y, flags)) return 0;
+  }
+  return 1;
+}
+
+// index of the first entry with `key`, through the table when there is one
+static long find_key (IutfNode* branch, const size_t* table, size_t cap, const char* key)
+{
+  if (!table) {
+    for (size_t i = 0; i < branch->data.branch.size; i++) {
+      IutfNode* item = branch->data.branch.items[i];
+      if (item->key && strcmp (item->key, key) == 0) return (long) i;
+    }
+    return -1;
+  }
+
+  size_t slot = (size_t) iutf_hash_str (key) & (cap - 1);
+  while (table[slot]) {
+    if (strcmp (branch->data.branch.items[table[slot] - 1]->key, key) == 0) return (long) table[slot] - 1;
+    slot = (slot + 1) & (cap - 1);
+  }
+  return -1;
+}
+
+static int diff_branch (IutfDiff* diff, PathBuf* path, IutfNode* a, IutfNode* b, int flags)
+{
+  size_t a_size = a->data.branch.size;
+  size_t before = diff->size;
+
+  // open addressing table over the old keys, slot = index + 1
+  size_t cap = 0;
+  size_t* table = NULL;
+  unsigned char* matched = calloc (a_size + 1, 1);
+  if (!matched) return 0;
+
+  if (a_size > DIFF_LINEAR_LIMIT) {
+    cap = 16;
+    while (cap < a_size * 2) cap <<= 1;
+    table = calloc (cap, sizeof (size_t));
+    if (!table) {
+      free (matched);
+      return 0;
+    }
+    for (size_t i = 0; i < a_size; i++) {
+      const char* key = a->data.branch.items[i]->key;
+      if (!key) continue;
+      size_t slot = (size_t) iutf_hash_str (key) & (cap - 1);
+      while (table[slot]) {
+        if (strcmp (a->data.branch.items[table[slot] - 1]->key, key) == 0) break; // keep the first duplicate
+        slot = (slot + 1) & (cap - 1);
+      }
+      if (!table[slot]) table[slot] = i + 1;
+    }
+  }
+
+  int ok = 1;
+  for (size_t i = 0; ok && i < b->data.branch.size; i++) {
+    IutfNode* y = b->data.branch.items[i];
+    if (!y->key) continue;
+
+    IutfNode* x = NULL;
+    long idx = find_key (a, table, cap, y->key);
+    if (idx >= 0) {
+      x = a->data.branch.items[idx];
+      matched[idx] = 1;
+    }
+
+    if (x && iutf_node_hash (x, flags) == iutf_node_hash (y, flags)) continue;
+    ok = diff_child (diff, path, y->key, strlen (y->key), x, y, flags);
+  }
+
+  for (size_t i = 0; ok && i < a_size; i++) {
+    IutfNode* x = a->data.branch.items[i];
+    if (matched[i] || !x->key) continue;
+    if (find_key (a, table, cap, x->key) != (long) i) continue; // duplicate key, only the first one counts
+    ok = diff_child (diff, path, x->key, strlen (x->key), x, NULL, flags);
+  }
+
+  // only the order differs, report the branch itself
+  if (ok && diff->size == before && !(flags & IUTF_HASH_UNORDERED_BRANCHES)) {
+    ok = emit (diff, IUTF_CHANGE_MODIFIED, path, a, b);
+  }
+
+  free (table);
+  free (matched);
+  return ok;
+}
+
+static int diff_node (IutfDiff* diff, PathBuf* path, IutfNode* a, IutfNode* b, int flags)
+{
+  if (iutf_node_hash (a, flags) == iutf_node_hash (b, flags)) return 1;
+
+  if (a->type == IUTF_NODE_BRANCH && b->type == IUTF_NODE_BRANCH) return diff_branch (diff, path, a, b, flags);
+  if (a->type == IUTF_NODE_ARRAY && b->type == IUTF_NODE_ARRAY) return diff_array (diff, path, a, b, flags);
+  return emit (diff, IUTF_CHANGE_MODIFIED, path, a, b);
+}
+
+IutfDiff* iutf_diff_ex (IutfNode* old_root, IutfNode* new_root, int flags)
+{
+  IutfDiff* diff = calloc (1, sizeof (IutfDiff));
+  if (!diff) return NULL;
+
+  PathBuf path = { NULL, 0, 0 };
+  int ok;
+  if (!old_root && !new_root) ok = 1;
+  else if (!old_root) ok = emit (diff, IUTF_CHANGE_ADDED, &path, NULL, new_root);
+  else if (!new_root) ok = emit (diff, IUTF_CHANGE_REMOVED, &path, old_root, NULL);
+  else ok = diff_node (diff, &path, old_root, new_root, flags);
+  free (path.buf);
+
+  if (!ok) {
+    fprintf (stderr, COL_RED "Out of memory" COL_DEF "\n");
+    iutf_diff_free (diff);
+    return NULL;
+  }
+  return diff;
+}
+
+IutfDiff* iutf_diff (IutfNode* old_root, IutfNode* new_root)
+{
+  return iutf_diff_ex (old_root, new_root, 0);
+}
+
+void iutf_diff_free (IutfDiff* diff)
+{
+  if (!diff) return;
+  for (size_t i = 0; i < diff->size; i++) {
+    free (diff->items[i].path);
+  }
+  free (diff->items);
+  free (diff);
+}
+
+const char* iutf_change_kind_to_string (IutfChangeKind kind)
+{
+  switch (kind)
+  {
+  case IUTF_CHANGE_ADDED: return "added";
+  case IUTF_CHANGE_REMOVED: return "removed";
+  case IUTF_CHANGE_MODIFIED: return "modified";
+  default: return "unknown";
+  }
+}
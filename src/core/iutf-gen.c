@@ -0,0 +1,614 @@
+/* iutf-gen.c
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Codegen version 0.1
+ */
+
+/*
+ * iutf-gen <schema.iutf> <name> [out_dir]
+ *
+ * Writes <name>.h with one struct per branch of the schema and <name>.c with a
+ * decoder for exactly that schema: keys are dispatched through a perfect hash
+ * per branch, values are read by iutf-decode straight into the fields, the
+ * schema rules are compiled into plain comparisons.
+ */
+#define _GNU_SOURCE
+
+#include "../includes/iutf-schema.h"
+#include "../includes/colors.h"
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum {
+  KIND_STRING,
+  KIND_INT,
+  KIND_FLOAT,
+  KIND_BOOL,
+  KIND_CHAR,
+  KIND_STRUCT,
+  KIND_ARRAY,
+} Kind;
+
+typedef struct {
+  const IutfSchema* s;
+  const char* prefix;
+  FILE* h;
+  FILE* c;
+  int error;
+} Gen;
+
+static int gen_error (Gen* g, const char* fmt, ...)
+{
+  va_list ap;
+  va_start (ap, fmt);
+  fputs (COL_RED "iutf-gen: ", stderr);
+  vfprintf (stderr, fmt, ap);
+  fputs (COL_DEF "\n", stderr);
+  va_end (ap);
+  g->error = 1;
+  return 0;
+}
+
+static const char* key_of (Gen* g, const IutfSchemaField* f)
+{
+  return g->s->pool + f->key;
+}
+
+// fields of a branch rule in declaration order (keys enter the pool in that order)
+static int cmp_field (const void* a, const void* b)
+{
+  const IutfSchemaField* x = *(const IutfSchemaField* const*) a;
+  const IutfSchemaField* y = *(const IutfSchemaField* const*) b;
+  return (x->key > y->key) - (x->key < y->key);
+}
+
+static size_t fields_of (Gen* g, const IutfSchemaRule* rule, const IutfSchemaField*** out)
+{
+  *out = NULL;
+  if (rule->fields == IUTF_SCHEMA_NO_RULE) return 0;
+
+  size_t n = 0;
+  const IutfSchemaField** list = malloc ((rule->field_mask + 1) * sizeof (*list));
+  if (!list) return 0;
+  for (uint32_t i = 0; i <= rule->field_mask; i++) {
+    const IutfSchemaField* f = &g->s->fields[rule->fields + i];
+    if (f->hash) list[n++] = f;
+  }
+  qsort (list, n, sizeof (*list), cmp_field);
+  *out = list;
+  return n;
+}
+
+static int classify (Gen* g, const IutfSchemaRule* rule, const char* where, Kind* kind)
+{
+  uint32_t types = rule->types & ~IUTF_SCHEMA_T_NULL;
+  switch (types) {
+    case IUTF_SCHEMA_T_STRING: *kind = KIND_STRING; return 1;
+    case IUTF_SCHEMA_T_INT: *kind = KIND_INT; return 1;
+    case IUTF_SCHEMA_T_FLOAT:
+    case IUTF_SCHEMA_T_INT | IUTF_SCHEMA_T_FLOAT: *kind = KIND_FLOAT; return 1;
+    case IUTF_SCHEMA_T_BOOL: *kind = KIND_BOOL; return 1;
+    case IUTF_SCHEMA_T_CHAR: *kind = KIND_CHAR; return 1;
+    case IUTF_SCHEMA_T_BRANCH:
+      if (rule->fields == IUTF_SCHEMA_NO_RULE) return gen_error (g, "'%s': a branch needs 'fields'", where);
+      *kind = KIND_STRUCT;
+      return 1;
+    case IUTF_SCHEMA_T_ARRAY:
+      if (rule->items == IUTF_SCHEMA_NO_RULE) return gen_error (g, "'%s': an array needs 'items'", where);
+      *kind = KIND_ARRAY;
+      return 1;
+    default:
+      return gen_error (g, "'%s': needs exactly one type (null may be added)", where);
+  }
+}
+
+// C name of a key: '-' becomes '_', keywords get a trailing '_'
+static void c_name (const char* key, char* out, size_t cap)
+{
+  static const char* keywords[] = {
+    "auto", "break", "case", "char", "const", "continue", "default", "do", "double", "else", "enum",
+    "extern", "float", "for", "goto", "if", "inline", "int", "long", "register", "restrict", "return",
+    "short", "signed", "sizeof", "static", "struct", "switch", "typedef", "union", "unsigned", "void",
+    "volatile", "while", "bool", "true", "false",
+  };
+
+  size_t n = 0;
+  for (; key[n] && n + 2 < cap; n++) out[n] = key[n] == '-' ? '_' : key[n];
+  out[n] = '\0';
+  for (size_t i = 0; i < sizeof (keywords) / sizeof (keywords[0]); i++) {
+    if (strcmp (out, keywords[i]) == 0) {
+      out[n] = '_';
+      out[n + 1] = '\0';
+      break;
+    }
+  }
+}
+
+static void c_string (FILE* fp, const char* str, size_t len)
+{
+  fputc ('"', fp);
+  for (size_t i = 0; i < len; i++) {
+    unsigned char ch = (unsigned char) str[i];
+    if (ch == '"' || ch == '\\') fprintf (fp, "\\%c", ch);
+    else if (ch < 0x20 || ch >= 0x7f) fprintf (fp, "\\%03o", ch);
+    else fputc (ch, fp);
+  }
+  fputc ('"', fp);
+}
+
+static const char* scalar_type (Kind kind)
+{
+  switch (kind) {
+    case KIND_STRING: return "char*";
+    case KIND_INT: return "long long";
+    case KIND_FLOAT: return "double";
+    case KIND_BOOL: return "int";
+    case KIND_CHAR: return "char";
+    default: return NULL;
+  }
+}
+
+/* ---- header: structs, innermost first ---- */
+
+static int emit_struct (Gen* g, uint32_t r, const char* name);
+
+// C type of an array item, emitting its struct first when needed
+static int item_type (Gen* g, uint32_t items, const char* name, char* out, size_t cap)
+{
+  Kind kind;
+  if (!classify (g, &g->s->rules[items], name, &kind)) return 0;
+  if (kind == KIND_ARRAY) return gen_error (g, "'%s': arrays of arrays are not supported", name);
+  if (kind == KIND_STRUCT) {
+    snprintf (out, cap, "%s_item", name);
+    return emit_struct (g, items, out);
+  }
+  snprintf (out, cap, "%s", scalar_type (kind));
+  return 1;
+}
+
+static int emit_struct (Gen* g, uint32_t r, const char* name)
+{
+  const IutfSchemaRule* rule = &g->s->rules[r];
+  const IutfSchemaField** fields;
+  size_t n = fields_of (g, rule, &fields);
+  if (rule->required > 64) {
+    free (fields);
+    return gen_error (g, "'%s': more than 64 required fields", name);
+  }
+
+  // nested types first
+  for (size_t i = 0; i < n; i++) {
+    const IutfSchemaRule* fr = &g->s->rules[fields[i]->rule];
+    char member[128], child[512], type[600];
+    c_name (key_of (g, fields[i]), member, sizeof (member));
+    snprintf (child, sizeof (child), "%s_%s", name, member);
+
+    Kind kind;
+    if (!classify (g, fr, child, &kind)) break;
+    if (kind == KIND_STRUCT && !emit_struct (g, fields[i]->rule, child)) break;
+    if (kind == KIND_ARRAY && !item_type (g, fr->items, child, type, sizeof (type))) break;
+  }
+  if (g->error) {
+    free (fields);
+    return 0;
+  }
+
+  fprintf (g->h, "typedef struct %s {\n", name);
+  for (size_t i = 0; i < n; i++) {
+    const IutfSchemaRule* fr = &g->s->rules[fields[i]->rule];
+    char member[128], child[512], type[600];
+    c_name (key_of (g, fields[i]), member, sizeof (member));
+    snprintf (child, sizeof (child), "%s_%s", name, member);
+
+    Kind kind;
+    classify (g, fr, child, &kind);
+    if (kind == KIND_STRUCT) {
+      fprintf (g->h, "  %s %s;\n", child, member);
+    } else if (kind == KIND_ARRAY) {
+      // the item struct (if any) was written above, here only its name is needed
+      Kind ik;
+      classify (g, &g->s->rules[fr->items], child, &ik);
+      if (ik == KIND_STRUCT) snprintf (type, sizeof (type), "%s_item", child);
+      else snprintf (type, sizeof (type), "%s", scalar_type (ik));
+      fprintf (g->h, "  struct {\n    %s* items;\n    size_t count;\n  } %s;\n", type, member);
+    } else {
+      fprintf (g->h, "  %s %s;\n", scalar_type (kind), member);
+    }
+    fprintf (g->h, "  unsigned char has_%s;\n", member);
+  }
+  if (n == 0) fputs ("  char unused_;\n", g->h);
+  fprintf (g->h, "} %s;\n\n", name);
+  free (fields);
+  return 1;
+}
+
+/* ---- source: perfect hash key tables ---- */
+
+static uint32_t key_hash (const char* key, size_t len, uint32_t seed)
+{
+  uint32_t h = 2166136261u ^ seed;
+  for (size_t i = 0; i < len; i++) {
+    h ^= (unsigned char) key[i];
+    h *= 16777619u;
+  }
+  return h ^ (h >> 15);
+}
+
+// smallest power-of-two table and seed without collisions
+static int find_perfect_hash (Gen* g, const IutfSchemaField** fields, size_t n, uint32_t* size_out, uint32_t* seed_out)
+{
+  uint32_t size = 1;
+  while (size < n) size <<= 1;
+
+  unsigned char* used = malloc (n ? n * 64 : 1);
+  if (!used) return 0;
+  for (; size <= (n ? n * 64 : 1); size <<= 1) {
+    for (uint32_t seed = 0; seed < 4096; seed++) {
+      memset (used, 0, size);
+      size_t i = 0;
+      for (; i < n; i++) {
+        const char* key = key_of (g, fields[i]);
+        uint32_t slot = key_hash (key, strlen (key), seed) & (size - 1);
+        if (used[slot]) break;
+        used[slot] = 1;
+      }
+      if (i == n) {
+        *size_out = size;
+        *seed_out = seed;
+        free (used);
+        return 1;
+      }
+    }
+  }
+  free (used);
+  return 0;
+}
+
+static int emit_key_table (Gen* g, const char* name, const IutfSchemaField** fields, size_t n)
+{
+  uint32_t size, seed;
+  if (!find_perfect_hash (g, fields, n, &size, &seed)) return gen_error (g, "'%s': no perfect hash found", name);
+
+  int* slots = malloc (size * sizeof (int));
+  if (!slots) return 0;
+  for (uint32_t i = 0; i < size; i++) slots[i] = -1;
+  for (size_t i = 0; i < n; i++) {
+    const char* key = key_of (g, fields[i]);
+    slots[key_hash (key, strlen (key), seed) & (size - 1)] = (int) i;
+  }
+
+  fprintf (g->c, "static const KeySlot %s_keys[%u] = {\n", name, size);
+  for (uint32_t i = 0; i < size; i++) {
+    if (slots[i] < 0) {
+      fputs ("  { NULL, 0, -1 },\n", g->c);
+    } else {
+      const char* key = key_of (g, fields[slots[i]]);
+      fputs ("  { ", g->c);
+      c_string (g->c, key, strlen (key));
+      fprintf (g->c, ", %zu, %d },\n", strlen (key), slots[i]);
+    }
+  }
+  fputs ("};\n\n", g->c);
+
+  fprintf (g->c, "static int %s_lookup (const char* key, size_t len)\n{\n", name);
+  fprintf (g->c, "  const KeySlot* slot = &%s_keys[key_hash (key, len, %uu) & %uu];\n", name, seed, size - 1);
+  fputs ("  return slot->len == len && memcmp (slot->name, key, len) == 0 ? slot->field : -1;\n}\n\n", g->c);
+  free (slots);
+  return 1;
+}
+
+/* ---- source: decoders ---- */
+
+static void emit_checks (Gen* g, const IutfSchemaRule* rule, Kind kind, const char* dst, const char* key, const char* ind)
+{
+  char measure[640];
+  switch (kind) {
+    case KIND_INT:
+    case KIND_FLOAT: snprintf (measure, sizeof (measure), "%s", dst); break;
+    case KIND_STRING: snprintf (measure, sizeof (measure), "strlen (%s)", dst); break;
+    case KIND_ARRAY: snprintf (measure, sizeof (measure), "%s.count", dst); break;
+    default: measure[0] = '\0'; break;
+  }
+
+  if (measure[0] && (rule->flags & IUTF_SCHEMA_F_MIN)) {
+    fprintf (g->c, "%sif ((double) %s < %.17g) return iutf_dec_fail (d, \"'%s' is below the minimum\");\n", ind, measure, rule->min, key);
+  }
+  if (measure[0] && (rule->flags & IUTF_SCHEMA_F_MAX)) {
+    fprintf (g->c, "%sif ((double) %s > %.17g) return iutf_dec_fail (d, \"'%s' is above the maximum\");\n", ind, measure, rule->max, key);
+  }
+
+  if (!rule->enum_count || kind == KIND_ARRAY || kind == KIND_STRUCT) return;
+  fprintf (g->c, "%sif (!(", ind);
+  int first = 1;
+  for (uint32_t i = 0; i < rule->enum_count; i++) {
+    const IutfSchemaEnum* e = &g->s->enums[rule->enum_first + i];
+    const char* sep = first ? "" : " || ";
+
+    if (kind == KIND_STRING && e->type == IUTF_NODE_STRING) {
+      fprintf (g->c, "%sstrcmp (%s, ", sep, dst);
+      c_string (g->c, g->s->pool + e->str, e->str_len);
+      fputs (") == 0", g->c);
+    } else if (kind == KIND_INT && e->type == IUTF_NODE_INTEGER) {
+      fprintf (g->c, "%s%s == %lldLL", sep, dst, e->integer);
+    } else if (kind == KIND_FLOAT && (e->type == IUTF_NODE_FLOAT || e->type == IUTF_NODE_INTEGER)) {
+      fprintf (g->c, "%s%s == %.17g", sep, dst, e->number);
+    } else if ((kind == KIND_CHAR && e->type == IUTF_NODE_CHARACTER) || (kind == KIND_BOOL && e->type == IUTF_NODE_BOOLEAN)) {
+      fprintf (g->c, "%s%s == %lld", sep, dst, e->integer);
+    } else {
+      continue;
+    }
+    first = 0;
+  }
+  if (first) fputs ("0", g->c); // no enum value of this type can match
+  fprintf (g->c, ")) return iutf_dec_fail (d, \"'%s' is not in the enum\");\n", key);
+}
+
+// read one scalar or struct into `dst`
+static void emit_read (Gen* g, Kind kind, const char* type, const char* dst, const char* ind)
+{
+  switch (kind) {
+    case KIND_STRING:
+      fprintf (g->c, "%sfree (%s);\n%s%s = NULL;\n", ind, dst, ind, dst);
+      fprintf (g->c, "%sif (!iutf_dec_string (d, &%s)) return 0;\n", ind, dst);
+      break;
+    case KIND_INT: fprintf (g->c, "%sif (!iutf_dec_int (d, &%s)) return 0;\n", ind, dst); break;
+    case KIND_FLOAT: fprintf (g->c, "%sif (!iutf_dec_float (d, &%s)) return 0;\n", ind, dst); break;
+    case KIND_BOOL: fprintf (g->c, "%sif (!iutf_dec_bool (d, &%s)) return 0;\n", ind, dst); break;
+    case KIND_CHAR: fprintf (g->c, "%sif (!iutf_dec_char (d, &%s)) return 0;\n", ind, dst); break;
+    case KIND_STRUCT:
+      fprintf (g->c, "%sfree_%s (&%s);\n%smemset (&%s, 0, sizeof (%s));\n", ind, type, dst, ind, dst, dst);
+      fprintf (g->c, "%sif (!iutf_dec_begin_branch (d) || !decode_%s (d, &%s)) return 0;\n", ind, type, dst);
+      break;
+    default:
+      break;
+  }
+}
+
+static void emit_free_array (Gen* g, Kind item_kind, const char* item_type, const char* dst, const char* ind)
+{
+  if (item_kind == KIND_STRING) {
+    fprintf (g->c, "%sfor (size_t i = 0; i < %s.count; i++) free (%s.items[i]);\n", ind, dst, dst);
+  } else if (item_kind == KIND_STRUCT) {
+    fprintf (g->c, "%sfor (size_t i = 0; i < %s.count; i++) free_%s (&%s.items[i]);\n", ind, dst, item_type, dst);
+  }
+  fprintf (g->c, "%sfree (%s.items);\n", ind, dst);
+}
+
+static int emit_decoder (Gen* g, uint32_t r, const char* name)
+{
+  const IutfSchemaRule* rule = &g->s->rules[r];
+  const IutfSchemaField** fields;
+  size_t n = fields_of (g, rule, &fields);
+
+  // children first, C needs them declared
+  for (size_t i = 0; i < n; i++) {
+    const IutfSchemaRule* fr = &g->s->rules[fields[i]->rule];
+    char member[128], child[512], item[600];
+    c_name (key_of (g, fields[i]), member, sizeof (member));
+    snprintf (child, sizeof (child), "%s_%s", name, member);
+    Kind kind, ik;
+    classify (g, fr, child, &kind);
+    if (kind == KIND_STRUCT && !emit_decoder (g, fields[i]->rule, child)) break;
+    if (kind == KIND_ARRAY) {
+      classify (g, &g->s->rules[fr->items], child, &ik);
+      snprintf (item, sizeof (item), "%s_item", child);
+      if (ik == KIND_STRUCT && !emit_decoder (g, fr->items, item)) break;
+    }
+  }
+  if (g->error || !emit_key_table (g, name, fields, n)) {
+    free (fields);
+    return 0;
+  }
+
+  // free
+  fprintf (g->c, "static void free_%s (%s* v)\n{\n", name, name);
+  long body = ftell (g->c);
+  for (size_t i = 0; i < n; i++) {
+    const IutfSchemaRule* fr = &g->s->rules[fields[i]->rule];
+    char member[128], child[512], dst[256], item[600];
+    c_name (key_of (g, fields[i]), member, sizeof (member));
+    snprintf (child, sizeof (child), "%s_%s", name, member);
+    snprintf (dst, sizeof (dst), "v->%s", member);
+    Kind kind, ik;
+    classify (g, fr, child, &kind);
+    if (kind == KIND_STRING) fprintf (g->c, "  free (%s);\n", dst);
+    else if (kind == KIND_STRUCT) fprintf (g->c, "  free_%s (&%s);\n", child, dst);
+    else if (kind == KIND_ARRAY) {
+      classify (g, &g->s->rules[fr->items], child, &ik);
+      snprintf (item, sizeof (item), "%s_item", child);
+      emit_free_array (g, ik, item, dst, "  ");
+    }
+  }
+  if (ftell (g->c) == body) fputs ("  (void) v;\n", g->c); // nothing owned
+  fputs ("}\n\n", g->c);
+
+  // decode
+  fprintf (g->c, "static int decode_%s (IutfDecoder* d, %s* v)\n{\n", name, name);
+  if (rule->required) fputs ("  uint64_t seen = 0;\n", g->c);
+  fputs ("  const char* key;\n  size_t len;\n\n", g->c);
+  fputs ("  while (iutf_dec_key (d, &key, &len)) {\n", g->c);
+  fprintf (g->c, "    switch (%s_lookup (key, len)) {\n", name);
+
+  for (size_t i = 0; i < n; i++) {
+    const IutfSchemaRule* fr = &g->s->rules[fields[i]->rule];
+    const char* key = key_of (g, fields[i]);
+    char member[128], child[512], dst[256], item[600];
+    c_name (key, member, sizeof (member));
+    snprintf (child, sizeof (child), "%s_%s", name, member);
+    snprintf (dst, sizeof (dst), "v->%s", member);
+    Kind kind, ik;
+    classify (g, fr, child, &kind);
+
+    fprintf (g->c, "      case %zu: // %s\n", i, key);
+    if (fr->types & IUTF_SCHEMA_T_NULL) {
+      fputs ("        if (d->tok.type == IUTF_TOK_NULL) {\n", g->c);
+      fputs ("          if (!iutf_dec_skip (d)) return 0;\n          break;\n        }\n", g->c);
+    }
+
+    if (kind == KIND_ARRAY) {
+      const IutfSchemaRule* ir = &g->s->rules[fr->items];
+      classify (g, ir, child, &ik);
+      if (ik == KIND_STRUCT) snprintf (item, sizeof (item), "%s_item", child);
+      else snprintf (item, sizeof (item), "%s", scalar_type (ik));
+
+      fputs ("        {\n", g->c);
+      emit_free_array (g, ik, item, dst, "          ");
+      fprintf (g->c, "          %s.items = NULL;\n          %s.count = 0;\n", dst, dst);
+      fputs ("          size_t cap = 0;\n", g->c);
+      fputs ("          if (!iutf_dec_begin_array (d)) return 0;\n", g->c);
+      fputs ("          while (iutf_dec_item (d)) {\n", g->c);
+      fprintf (g->c, "            if (%s.count == cap) {\n", dst);
+      fputs ("              cap = cap ? cap * 2 : 8;\n", g->c);
+      fprintf (g->c, "              %s* temp = realloc (%s.items, cap * sizeof (*temp));\n", item, dst);
+      fputs ("              if (!temp) return iutf_dec_fail (d, \"out of memory\");\n", g->c);
+      fprintf (g->c, "              %s.items = temp;\n            }\n", dst);
+      fprintf (g->c, "            %s* item = &%s.items[%s.count++];\n", item, dst, dst);
+      fputs ("            memset (item, 0, sizeof (*item));\n", g->c);
+      emit_read (g, ik, item, "(*item)", "            ");
+      emit_checks (g, ir, ik, "(*item)", key, "            ");
+      fputs ("          }\n          if (d->error) return 0;\n", g->c);
+      emit_checks (g, fr, kind, dst, key, "          ");
+      fputs ("        }\n", g->c);
+    } else {
+      emit_read (g, kind, child, dst, "        ");
+      emit_checks (g, fr, kind, dst, key, "        ");
+    }
+
+    fprintf (g->c, "        v->has_%s = 1;\n", member);
+    if (fields[i]->required_bit != IUTF_SCHEMA_NO_RULE) fprintf (g->c, "        seen |= 1ULL << %u;\n", fields[i]->required_bit);
+    fputs ("        break;\n", g->c);
+  }
+
+  fputs ("      default:\n", g->c);
+  if (rule->flags & IUTF_SCHEMA_F_STRICT) {
+    fputs ("        return iutf_dec_fail (d, \"unknown key '%.*s'\", (int) len, key);\n", g->c);
+  } else {
+    fputs ("        if (!iutf_dec_skip (d)) return 0;\n        break;\n", g->c);
+  }
+  fputs ("    }\n  }\n  if (d->error) return 0;\n", g->c);
+
+  for (size_t i = 0; i < n; i++) {
+    if (fields[i]->required_bit == IUTF_SCHEMA_NO_RULE) continue;
+    fprintf (g->c, "  if (!(seen & (1ULL << %u))) return iutf_dec_fail (d, \"missing required field '%s'\");\n",
+             fields[i]->required_bit, key_of (g, fields[i]));
+  }
+  fputs ("  return 1;\n}\n\n", g->c);
+  free (fields);
+  return 1;
+}
+
+static void emit_license (FILE* fp, const char* file, const char* schema)
+{
+  fprintf (fp, "/* %s\n *\n * Generated by iutf-gen from %s, do not edit.\n */\n", file, schema);
+}
+
+static FILE* open_out (const char* dir, const char* name, const char* ext, char** path)
+{
+  if (asprintf (path, "%s/%s%s", dir, name, ext) < 0) return NULL;
+  FILE* fp = fopen (*path, "w");
+  if (!fp) fprintf (stderr, COL_RED "Cannot open file: " COL_DEF COL_CYAN "%s" COL_DEF "\n", *path);
+  return fp;
+}
+
+int main (int argc, char* argv[])
+{
+  if (argc != 3 && argc != 4) {
+    fprintf (stderr, "Usage: %s <schema.iutf> <name> [out_dir]\n", argv[0]);
+    return 1;
+  }
+  const char* schema_path = argv[1];
+  const char* name = argv[2];
+  const char* dir = argc == 4 ? argv[3] : ".";
+
+  for (const char* p = name; *p; p++) {
+    if (!((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') || *p == '_' || (p > name && *p >= '0' && *p <= '9'))) {
+      fprintf (stderr, COL_RED "iutf-gen: '%s' is not a C identifier" COL_DEF "\n", name);
+      return 1;
+    }
+  }
+
+  IutfSchema* schema = iutf_schema_load (schema_path);
+  if (!schema) return 1;
+
+  Gen g;
+  memset (&g, 0, sizeof (g));
+  g.s = schema;
+  g.prefix = name;
+
+  char* h_path = NULL;
+  char* c_path = NULL;
+  g.h = open_out (dir, name, ".h", &h_path);
+  g.c = g.h ? open_out (dir, name, ".c", &c_path) : NULL;
+  if (!g.h || !g.c) g.error = 1;
+
+  if (!g.error && !(schema->rules[0].types & IUTF_SCHEMA_T_BRANCH && schema->rules[0].fields != IUTF_SCHEMA_NO_RULE)) {
+    gen_error (&g, "the schema root must be a branch with 'fields'");
+  }
+
+  if (!g.error) {
+    emit_license (g.h, strrchr (h_path, '/') + 1, schema_path);
+    char guard[256];
+    size_t i = 0;
+    for (; name[i] && i < sizeof (guard) - 1; i++) guard[i] = (char) toupper ((unsigned char) name[i]);
+    guard[i] = '\0';
+    fprintf (g.h, "#ifndef %s_GENERATED_H\n#define %s_GENERATED_H\n\n#include <stddef.h>\n\n", guard, guard);
+    emit_struct (&g, 0, name);
+  }
+
+  if (!g.error) {
+    fprintf (g.h, "// 1 on success; on failure the error is printed and `out` is left empty\n");
+    fprintf (g.h, "int %s_parse (const char* input, size_t len, %s* out);\n", name, name);
+    fprintf (g.h, "int %s_load (const char* filename, %s* out);\n", name, name);
+    fprintf (g.h, "void %s_free (%s* cfg);\n\n#endif\n", name, name);
+
+    emit_license (g.c, strrchr (c_path, '/') + 1, schema_path);
+    fprintf (g.c, "#define _GNU_SOURCE\n\n#include \"%s.h\"\n#include \"iutf-decode.h\"\n", name);
+    fputs ("#include <stdint.h>\n#include <stdlib.h>\n#include <string.h>\n\n", g.c);
+    fputs ("typedef struct {\n  const char* name;\n  size_t len;\n  int field;\n} KeySlot;\n\n", g.c);
+    fputs ("static inline uint32_t key_hash (const char* key, size_t len, uint32_t seed)\n{\n", g.c);
+    fputs ("  uint32_t h = 2166136261u ^ seed;\n  for (size_t i = 0; i < len; i++) {\n", g.c);
+    fputs ("    h ^= (unsigned char) key[i];\n    h *= 16777619u;\n  }\n  return h ^ (h >> 15);\n}\n\n", g.c);
+    emit_decoder (&g, 0, name);
+  }
+
+  if (!g.error) {
+    fprintf (g.c, "static int decode_root (IutfDecoder* d, void* out)\n{\n  return decode_%s (d, out);\n}\n\n", name);
+    fprintf (g.c, "int %s_parse (const char* input, size_t len, %s* out)\n{\n", name, name);
+    fputs ("  memset (out, 0, sizeof (*out));\n", g.c);
+    fputs ("  if (iutf_dec_run (input, len, decode_root, out)) return 1;\n", g.c);
+    fprintf (g.c, "  %s_free (out);\n  return 0;\n}\n\n", name);
+    fprintf (g.c, "int %s_load (const char* filename, %s* out)\n{\n", name, name);
+    fputs ("  memset (out, 0, sizeof (*out));\n", g.c);
+    fputs ("  if (iutf_dec_run_file (filename, decode_root, out)) return 1;\n", g.c);
+    fprintf (g.c, "  %s_free (out);\n  return 0;\n}\n\n", name);
+    fprintf (g.c, "void %s_free (%s* cfg)\n{\n  free_%s (cfg);\n  memset (cfg, 0, sizeof (*cfg));\n}\n", name, name, name);
+  }
+
+  if (g.h && fclose (g.h) != 0) g.error = 1;
+  if (g.c && fclose (g.c) != 0) g.error = 1;
+  if (g.error) {
+    if (h_path) remove (h_path);
+    if (c_path) remove (c_path);
+  }
+  free (h_path);
+  free (c_path);
+  iutf_schema_free (schema);
+  return g.error ? 1 : 0;
+}
@@ -0,0 +1,58 @@
+/* iutf-hash.c
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Hash version 0.1
+ */
+
+#include "../includes/iutf-hash.h"
+#include <string.h>
+
+uint64_t iutf_hash_bytes (const void* data, size_t len, uint64_t seed)
+{
+  const uint64_t m = 0xC6A4A7935BD1E995ULL;
+  const int r = 47;
+  const unsigned char* p = data;
+  uint64_t h = seed ^ (len * m);
+
+  while (len >= 8) {
+    uint64_t k;
+    memcpy (&k, p, 8);
+    k *= m;
+    k ^= k >> r;
+    k *= m;
+    h ^= k;
+    h *= m;
+    p += 8;
+    len -= 8;
+  }
+
+  switch (len) {
+    case 7: h ^= (uint64_t) p[6] << 48; /* fallthrough */
+    case 6: h ^= (uint64_t) p[5] << 40; /* fallthrough */
+    case 5: h ^= (uint64_t) p[4] << 32; /* fallthrough */
+    case 4: h ^= (uint64_t) p[3] << 24; /* fallthrough */
+    case 3: h ^= (uint64_t) p[2] << 16; /* fallthrough */
+    case 2: h ^= (uint64_t) p[1] << 8; /* fallthrough */
+    case 1: h ^= (uint64_t) p[0];
+            h *= m;
+  }
+
+  h ^= h >> r;
+  h *= m;
+  h ^= h >> r;
+  return h;
+}
@@ -18,7 +18,10 @@
  *
  * IUTF Import version 0.1
  */
+#define _GNU_SOURCE
+
 #include "../includes/iutf-import.h"
+#include "../includes/iutf-alloc.h"
 #include "../includes/colors.h"
 #include <stdlib.h>
 #include <string.h>
@@ -27,6 +30,8 @@
 
 char* iutf_find_imported_file (const char* filename)
 {
+  IUTF_STAT_ADD (import_lookups, 1);
+
   // Провека окружения переменной
   const char* path_env = getenv ("IUTF_INCLUDE_PATH");
   if (!path_env) {
@@ -35,7 +40,8 @@ char* iutf_find_imported_file (const char* filename)
 
   // формирование пути: /usr/include/name/name.utext
   size_t len = strlen (path_env) + strlen (filename) * 2 + 32;
-  char* full_path = malloc (len);
+  char* full_path = iutf_malloc (len);
+  if (!full_path) return NULL;
   snprintf (full_path, len, "%s/%s/%s.utext", path_env, filename, filename);
 
   // проверка на существование файла
@@ -50,6 +56,41 @@ char* iutf_find_imported_file (const char* filename)
     return full_path;
   }
 
-  free (full_path);
+  iutf_free (full_path);
+  IUTF_STAT_ADD (import_misses, 1);
   return NULL;
 }
+
+int iutf_import_list_contains (const IutfImportList* list, const char* path)
+{
+  for (size_t i = 0; i < list->size; i++) {
+    if (strcmp (list->paths[i], path) == 0) return 1;
+  }
+  return 0;
+}
+
+int iutf_import_list_add (IutfImportList* list, const char* path)
+{
+  if (!list || !path) return -1;
+  if (iutf_import_list_contains (list, path)) return 0;
+
+  char** temp = realloc (list->paths, (list->size + 1) * sizeof (char*));
+  if (!temp) return -1;
+  list->paths = temp;
+
+  list->paths[list->size] = strdup (path);
+  if (!list->paths[list->size]) return -1;
+  list->size++;
+  return 1;
+}
+
+void iutf_import_list_clear (IutfImportList* list)
+{
+  if (!list) return;
+  for (size_t i = 0; i < list->size; i++) {
+    free (list->paths[i]);
+  }
+  free (list->paths);
+  list->paths = NULL;
+  list->size = 0;
+}
@@ -0,0 +1,793 @@
+/* iutf-json.c
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF JSON version 0.1
+ */
+#define _GNU_SOURCE
+
+#include "../includes/iutf-json.h"
+#include "../includes/iutf-writer.h"
+#include "../includes/iutf-lexer.h"
+#include "../includes/iutf-decompress.h"
+#include "../includes/colors.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define INDENT_WIDTH 2
+
+static const char hex_digits[] = "0123456789abcdef";
+
+typedef struct {
+  char* data;
+  size_t len;
+  size_t cap;
+} Scratch;
+
+static int scratch_reserve (Scratch* s, size_t extra)
+{
+  if (s->len + extra <= s->cap) return 1;
+  size_t cap = s->cap ? s->cap * 2 : 256;
+  while (cap < s->len + extra) cap *= 2;
+  char* temp = realloc (s->data, cap);
+  if (!temp) return 0;
+  s->data = temp;
+  s->cap = cap;
+  return 1;
+}
+
+static int push_level (IutfWriterLevel** stack, size_t* depth, size_t* cap, char kind)
+{
+  if (*depth == *cap) {
+    size_t cap_new = *cap ? *cap * 2 : 32;
+    IutfWriterLevel* temp = realloc (*stack, cap_new * sizeof (IutfWriterLevel));
+    if (!temp) return 0;
+    *stack = temp;
+    *cap = cap_new;
+  }
+  (*stack)[*depth].kind = kind;
+  (*stack)[*depth].count = 0;
+  (*depth)++;
+  return 1;
+}
+
+static inline int is_digit (char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+static inline int is_alpha (char c)
+{
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+/* ---- JSON -> IUTF ---- */
+
+typedef struct {
+  const char* input;
+  const char* p;
+  const char* end;
+  IutfWriter* writer;
+  Scratch value; // decoded string
+  Scratch key; // mangled key
+  IutfWriterLevel* stack;
+  size_t depth;
+  size_t stack_cap;
+} JsonReader;
+
+static int json_error (JsonReader* r, const char* msg)
+{
+  int line = 1;
+  const char* line_start = r->input;
+  for (const char* q = r->input; q < r->p && q < r->end; q++) {
+    if (*q == '\n') {
+      line++;
+      line_start = q + 1;
+    }
+  }
+  fprintf (stderr, COL_RED "JSON error at line %d, column %d: %s" COL_DEF "\n", line, (int) (r->p - line_start) + 1, msg);
+  return 0;
+}
+
+static inline void skip_ws (JsonReader* r)
+{
+  while (r->p < r->end && (*r->p == ' ' || *r->p == '\n' || *r->p == '\r' || *r->p == '\t')) r->p++;
+}
+
+static int hex4 (const char* p, unsigned* out)
+{
+  unsigned v = 0;
+  for (int i = 0; i < 4; i++) {
+    char c = p[i];
+    v <<= 4;
+    if (c >= '0' && c <= '9') v |= (unsigned) (c - '0');
+    else if (c >= 'a' && c <= 'f') v |= (unsigned) (c - 'a' + 10);
+    else if (c >= 'A' && c <= 'F') v |= (unsigned) (c - 'A' + 10);
+    else return 0;
+  }
+  *out = v;
+  return 1;
+}
+
+static void put_utf8 (Scratch* s, unsigned cp)
+{
+  char* o = s->data + s->len;
+  if (cp < 0x80) {
+    o[0] = (char) cp;
+    s->len += 1;
+  } else if (cp < 0x800) {
+    o[0] = (char) (0xC0 | (cp >> 6));
+    o[1] = (char) (0x80 | (cp & 0x3F));
+    s->len += 2;
+  } else if (cp < 0x10000) {
+    o[0] = (char) (0xE0 | (cp >> 12));
+    o[1] = (char) (0x80 | ((cp >> 6) & 0x3F));
+    o[2] = (char) (0x80 | (cp & 0x3F));
+    s->len += 3;
+  } else {
+    o[0] = (char) (0xF0 | (cp >> 18));
+    o[1] = (char) (0x80 | ((cp >> 12) & 0x3F));
+    o[2] = (char) (0x80 | ((cp >> 6) & 0x3F));
+    o[3] = (char) (0x80 | (cp & 0x3F));
+    s->len += 4;
+  }
+}
+
+/*
+ * Reads the string at r->p (on the opening quote). Without escapes the result
+ * points into the input, otherwise it is decoded into r->value.
+ */
+static int read_json_string (JsonReader* r, const char** out, size_t* out_len)
+{
+  const char* start = ++r->p;
+  const char* p = start;
+  while (p < r->end && *p != '"' && *p != '\\' && (unsigned char) *p >= 0x20) p++;
+
+  if (p < r->end && *p == '"') {
+    *out = start;
+    *out_len = (size_t) (p - start);
+    r->p = p + 1;
+    return 1;
+  }
+
+  Scratch* s = &r->value;
+  s->len = 0;
+  if (!scratch_reserve (s, (size_t) (p - start))) return json_error (r, "out of memory");
+  memcpy (s->data, start, (size_t) (p - start));
+  s->len = (size_t) (p - start);
+
+  while (p < r->end && *p != '"') {
+    const char* run = p;
+    while (p < r->end && *p != '"' && *p != '\\' && (unsigned char) *p >= 0x20) p++;
+    if (!scratch_reserve (s, (size_t) (p - run) + 4)) return json_error (r, "out of memory");
+    memcpy (s->data + s->len, run, (size_t) (p - run));
+    s->len += (size_t) (p - run);
+    if (p >= r->end || *p == '"') break;
+
+    if ((unsigned char) *p < 0x20) {
+      r->p = p;
+      return json_error (r, "control character in string");
+    }
+
+    // escape sequence
+    if (p + 1 >= r->end) {
+      p = r->end;
+      break;
+    }
+    char c = p[1];
+    p += 2;
+    switch (c) {
+      case '"': s->data[s->len++] = '"'; break;
+      case '\\': s->data[s->len++] = '\\'; break;
+      case '/': s->data[s->len++] = '/'; break;
+      case 'b': s->data[s->len++] = '\b'; break;
+      case 'f': s->data[s->len++] = '\f'; break;
+      case 'n': s->data[s->len++] = '\n'; break;
+      case 'r': s->data[s->len++] = '\r'; break;
+      case 't': s->data[s->len++] = '\t'; break;
+      case 'u': {
+        unsigned cp;
+        if (p + 4 > r->end || !hex4 (p, &cp)) {
+          r->p = p;
+          return json_error (r, "invalid \\u escape");
+        }
+        p += 4;
+        if (cp >= 0xD800 && cp <= 0xDBFF) {
+          unsigned low;
+          if (p + 6 <= r->end && p[0] == '\\' && p[1] == 'u' && hex4 (p + 2, &low) && low >= 0xDC00 && low <= 0xDFFF) {
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+            p += 6;
+          } else {
+            cp = 0xFFFD;
+          }
+        } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+          cp = 0xFFFD;
+        }
+        put_utf8 (s, cp);
+        break;
+      }
+      default:
+        r->p = p - 1;
+        return json_error (r, "invalid escape");
+    }
+  }
+
+  if (p >= r->end) {
+    r->p = start - 1;
+    return json_error (r, "unterminated string");
+  }
+  r->p = p + 1;
+  *out = s->data;
+  *out_len = s->len;
+  return 1;
+}
+
+// IUTF identifiers are [A-Za-z_][A-Za-z0-9_-]*, other bytes become _xHH;
+// so does the first letter of true, false and null, which the lexer reads as literals
+static const char* mangle_key (JsonReader* r, const char* key, size_t len)
+{
+  Scratch* s = &r->key;
+  s->len = 0;
+  if (!scratch_reserve (s, len * 4 + 2)) return NULL;
+
+  int reserved = (len == 4 && (memcmp (key, "true", 4) == 0 || memcmp (key, "null", 4) == 0))
+              || (len == 5 && memcmp (key, "false", 5) == 0);
+  if (len == 0) s->data[s->len++] = '_';
+  for (size_t i = 0; i < len; i++) {
+    char c = key[i];
+    if ((i > 0 || !reserved) && (is_alpha (c) || c == '_' || (i > 0 && (is_digit (c) || c == '-')))) {
+      s->data[s->len++] = c;
+    } else {
+      s->data[s->len++] = '_';
+      s->data[s->len++] = 'x';
+      s->data[s->len++] = hex_digits[(unsigned char) c >> 4];
+      s->data[s->len++] = hex_digits[c & 15];
+    }
+  }
+  s->data[s->len] = '\0';
+  return s->data;
+}
+
+static int read_json_number (JsonReader* r, const char* key)
+{
+  const char* start = r->p;
+  const char* p = start;
+  int is_float = 0;
+
+  if (p < r->end && *p == '-') p++;
+  const char* digits = p;
+  if (p < r->end && *p == '0') {
+    p++;
+  } else if (p < r->end && is_digit (*p)) {
+    while (p < r->end && is_digit (*p)) p++;
+  } else {
+    return json_error (r, "invalid number");
+  }
+  size_t int_len = (size_t) (p - digits);
+
+  if (p < r->end && *p == '.') {
+    p++;
+    if (p >= r->end || !is_digit (*p)) {
+      r->p = p;
+      return json_error (r, "invalid number");
+    }
+    while (p < r->end && is_digit (*p)) p++;
+    is_float = 1;
+  }
+  if (p < r->end && (*p == 'e' || *p == 'E')) {
+    p++;
+    if (p < r->end && (*p == '+' || *p == '-')) p++;
+    if (p >= r->end || !is_digit (*p)) {
+      r->p = p;
+      return json_error (r, "invalid number");
+    }
+    while (p < r->end && is_digit (*p)) p++;
+    is_float = 1;
+  }
+  r->p = p;
+
+  size_t len = (size_t) (p - start);
+  if (!is_float) {
+    // beyond 64 bits the IUTF integer would overflow, keep the digits as a float
+    const char* limit = *start == '-' ? "9223372036854775808" : "9223372036854775807";
+    if (int_len > 19 || (int_len == 19 && memcmp (digits, limit, 19) > 0)) {
+      if (!scratch_reserve (&r->value, len + 2)) return json_error (r, "out of memory");
+      memcpy (r->value.data, start, len);
+      memcpy (r->value.data + len, ".0", 2);
+      return iutf_writer_raw (r->writer, key, r->value.data, len + 2);
+    }
+  }
+  return iutf_writer_raw (r->writer, key, start, len);
+}
+
+static int match_literal (JsonReader* r, const char* word, size_t len)
+{
+  if ((size_t) (r->end - r->p) < len || memcmp (r->p, word, len) != 0) return 0;
+  r->p += len;
+  return 1;
+}
+
+// a scalar, or the opening of an object/array (pushed on the stack)
+static int read_json_value (JsonReader* r, const char* key)
+{
+  skip_ws (r);
+  if (r->p >= r->end) return json_error (r, "unexpected end of input");
+
+  const char* str;
+  size_t len;
+  switch (*r->p) {
+    case '{':
+      r->p++;
+      if (!push_level (&r->stack, &r->depth, &r->stack_cap, 'b')) return json_error (r, "out of memory");
+      return iutf_writer_begin_branch (r->writer, key);
+    case '[':
+      r->p++;
+      if (!push_level (&r->stack, &r->depth, &r->stack_cap, 'a')) return json_error (r, "out of memory");
+      return iutf_writer_begin_array (r->writer, key);
+    case '"':
+      if (!read_json_string (r, &str, &len)) return 0;
+      return iutf_writer_string_len (r->writer, key, str, len);
+    case 't':
+      if (match_literal (r, "true", 4)) return iutf_writer_bool (r->writer, key, 1);
+      break;
+    case 'f':
+      if (match_literal (r, "false", 5)) return iutf_writer_bool (r->writer, key, 0);
+      break;
+    case 'n':
+      if (match_literal (r, "null", 4)) return iutf_writer_null (r->writer, key);
+      break;
+    default:
+      if (*r->p == '-' || is_digit (*r->p)) return read_json_number (r, key);
+      break;
+  }
+  return json_error (r, "unexpected character");
+}
+
+static int json_run (JsonReader* r)
+{
+  skip_ws (r);
+  if (r->p < r->end && *r->p == '{') {
+    if (!read_json_value (r, NULL)) return 0;
+  } else {
+    // IUTF documents are branches, wrap anything else
+    if (!iutf_writer_begin_branch (r->writer, NULL)) return 0;
+    if (!read_json_value (r, "value")) return 0;
+    if (r->depth == 0 && !iutf_writer_end (r->writer)) return 0;
+  }
+
+  while (r->depth > 0) {
+    IutfWriterLevel* top = &r->stack[r->depth - 1];
+    char close = top->kind == 'b' ? '}' : ']';
+
+    skip_ws (r);
+    if (r->p < r->end && *r->p == close) {
+      r->p++;
+      r->depth--;
+      if (!iutf_writer_end (r->writer)) return 0;
+      // a wrapped root array needs its main branch closed too
+      if (r->depth == 0 && r->writer->depth > 0 && !iutf_writer_end (r->writer)) return 0;
+      continue;
+    }
+
+    if (top->count > 0) {
+      if (r->p >= r->end || *r->p != ',') return json_error (r, top->kind == 'b' ? "expected ',' or '}'" : "expected ',' or ']'");
+      r->p++;
+      skip_ws (r);
+    }
+    top->count++;
+
+    const char* key = NULL;
+    if (top->kind == 'b') {
+      const char* raw;
+      size_t raw_len;
+      if (r->p >= r->end || *r->p != '"') return json_error (r, "expected a key");
+      if (!read_json_string (r, &raw, &raw_len)) return 0;
+      if (!(key = mangle_key (r, raw, raw_len))) return json_error (r, "out of memory");
+      skip_ws (r);
+      if (r->p >= r->end || *r->p != ':') return json_error (r, "expected ':'");
+      r->p++;
+    }
+    if (!read_json_value (r, key)) return 0;
+  }
+
+  skip_ws (r);
+  if (r->p < r->end) return json_error (r, "unexpected data after the document");
+  return 1;
+}
+
+int iutf_json_to_iutf (const char* input, size_t len, IutfSinkFunc sink, void* ctx, int flags)
+{
+  if (!input || !sink) return 0;
+
+  JsonReader r;
+  memset (&r, 0, sizeof (r));
+  r.input = r.p = input;
+  r.end = input + len;
+  r.writer = iutf_writer_new_sink (sink, ctx, flags);
+  if (!r.writer) return 0;
+
+  int ok = json_run (&r) && iutf_writer_finish (r.writer);
+
+  iutf_writer_free (r.writer);
+  free (r.value.data);
+  free (r.key.data);
+  free (r.stack);
+  return ok;
+}
+
+/* ---- IUTF -> JSON ---- */
+
+typedef struct {
+  IutfLexer* lexer;
+  IutfLexWindow* window; // compressed input, NULL when the text is in memory
+  IutfToken tok;
+  IutfBuffer out;
+  int pretty;
+  IutfWriterLevel* stack;
+  size_t depth;
+  size_t stack_cap;
+  Scratch scratch;
+} IutfReader;
+
+static int iutf_error (IutfReader* r, const char* msg)
+{
+  if (r->tok.type != IUTF_TOK_ERROR) {
+    fprintf (stderr, COL_RED "IUTF error at line %d, column %d: %s, got %s" COL_DEF "\n",
+             r->tok.line, r->tok.col, msg, iutf_token_type_to_string (r->tok.type));
+  }
+  return 0;
+}
+
+static inline void next (IutfReader* r)
+{
+  if (r->window) iutf_lex_window_next (r->window, r->lexer, &r->tok);
+  else r->tok = iutf_lexer_next (r->lexer);
+}
+
+// "..." with JSON escapes, bytes >= 0x80 are passed through as UTF-8
+static void json_quoted (IutfBuffer* buf, const char* str, size_t len)
+{
+  iutf_buffer_putc (buf, '"');
+  size_t run = 0;
+  for (size_t i = 0; i < len; i++) {
+    unsigned char c = (unsigned char) str[i];
+    if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+    iutf_buffer_append (buf, str + run, i - run);
+    run = i + 1;
+    switch (c) {
+      case '"': iutf_buffer_append (buf, "\\\"", 2); break;
+      case '\\': iutf_buffer_append (buf, "\\\\", 2); break;
+      case '\n': iutf_buffer_append (buf, "\\n", 2); break;
+      case '\t': iutf_buffer_append (buf, "\\t", 2); break;
+      case '\r': iutf_buffer_append (buf, "\\r", 2); break;
+      case '\b': iutf_buffer_append (buf, "\\b", 2); break;
+      case '\f': iutf_buffer_append (buf, "\\f", 2); break;
+      default: {
+        char esc[6] = { '\\', 'u', '0', '0', hex_digits[c >> 4], hex_digits[c & 15] };
+        iutf_buffer_append (buf, esc, 6);
+        break;
+      }
+    }
+  }
+  iutf_buffer_append (buf, str + run, len - run);
+  iutf_buffer_putc (buf, '"');
+}
+
+// escapes of a STRING or CHARACTER token body decoded into scratch
+static int decode_iutf (IutfReader* r, const char* src, size_t len, const char** out, size_t* out_len)
+{
+  if (!memchr (src, '\\', len)) {
+    *out = src;
+    *out_len = len;
+    return 1;
+  }
+  r->scratch.len = 0;
+  if (!scratch_reserve (&r->scratch, len + 1)) return 0;
+  *out_len = iutf_unescape (src, len, r->scratch.data);
+  *out = r->scratch.data;
+  return 1;
+}
+
+// IUTF allows leading zeros, JSON doesn't
+static void json_number (IutfBuffer* buf, const char* text, size_t len)
+{
+  size_t i = 0;
+  if (len > 0 && text[0] == '-') {
+    iutf_buffer_putc (buf, '-');
+    i = 1;
+  }
+  while (i + 1 < len && text[i] == '0' && is_digit (text[i + 1])) i++;
+  iutf_buffer_append (buf, text + i, len - i);
+}
+
+static void json_item (IutfReader* r, const char* key, size_t key_len)
+{
+  IutfWriterLevel* top = &r->stack[r->depth - 1];
+  if (top->count++ > 0) iutf_buffer_putc (&r->out, ',');
+  if (r->pretty) {
+    iutf_buffer_putc (&r->out, '\n');
+    iutf_buffer_indent (&r->out, r->depth * INDENT_WIDTH);
+  }
+  if (key) {
+    json_quoted (&r->out, key, key_len);
+    iutf_buffer_append (&r->out, ": ", r->pretty ? 2 : 1);
+  }
+}
+
+static int json_open (IutfReader* r, char kind)
+{
+  iutf_buffer_putc (&r->out, kind == 'b' ? '{' : '[');
+  return push_level (&r->stack, &r->depth, &r->stack_cap, kind);
+}
+
+static void json_close (IutfReader* r)
+{
+  IutfWriterLevel top = r->stack[--r->depth];
+  if (r->pretty && top.count > 0) {
+    iutf_buffer_putc (&r->out, '\n');
+    iutf_buffer_indent (&r->out, r->depth * INDENT_WIDTH);
+  }
+  iutf_buffer_putc (&r->out, top.kind == 'b' ? '}' : ']');
+}
+
+static int iutf_value (IutfReader* r)
+{
+  const IutfToken* t = &r->tok;
+  const char* str;
+  size_t len;
+
+  switch (t->type) {
+    case IUTF_TOK_BRANCH_OPEN:
+      next (r);
+      return json_open (r, 'b');
+    case IUTF_TOK_LBRACKET:
+      next (r);
+      return json_open (r, 'a');
+    case IUTF_TOK_STRING:
+    case IUTF_TOK_CHARACTER:
+      if (!decode_iutf (r, t->start + 1, t->length - 2, &str, &len)) return 0;
+      json_quoted (&r->out, str, len);
+      break;
+    case IUTF_TOK_INTEGER:
+    case IUTF_TOK_FLOAT:
+      json_number (&r->out, t->start, t->length);
+      break;
+    case IUTF_TOK_LONG:
+      json_number (&r->out, t->start, t->length - 1);
+      break;
+    case IUTF_TOK_TRUE: iutf_buffer_append (&r->out, "true", 4); break;
+    case IUTF_TOK_FALSE: iutf_buffer_append (&r->out, "false", 5); break;
+    case IUTF_TOK_NULL: iutf_buffer_append (&r->out, "null", 4); break;
+    case IUTF_TOK_BIGSTRING_START:
+    case IUTF_TOK_PIPE: {
+      size_t len;
+      const char* text = iutf_token_block (t, &len);
+      json_quoted (&r->out, text, len);
+      break;
+    }
+    default:
+      return iutf_error (r, "expected a value");
+  }
+  next (r);
+  return 1;
+}
+
+// `type NAME {` starts a declaration, a key named `type` is followed by ':' or '['
+static int type_decl_ahead (IutfReader* r)
+{
+  if (r->tok.length != 4 || memcmp (r->tok.start, "type", 4) != 0) return 0;
+  if (r->window) return iutf_lex_window_peek (r->window, r->lexer, &r->tok) == IUTF_TOK_IDENTIFIER;
+  IutfLexer ahead = *r->lexer;
+  ahead.quiet = 1;
+  return iutf_lexer_scan (&ahead).type == IUTF_TOK_IDENTIFIER;
+}
+
+// declarations only matter to the parser, the branch is skipped whole
+static int skip_type_decl (IutfReader* r)
+{
+  next (r); // the name
+  next (r);
+  if (r->tok.type != IUTF_TOK_BRANCH_OPEN) return iutf_error (r, "expected '{' after a type name");
+
+  size_t depth = 0;
+  do {
+    switch (r->tok.type) {
+      case IUTF_TOK_BRANCH_OPEN:
+      case IUTF_TOK_LBRACKET:
+        depth++;
+        break;
+      case IUTF_TOK_BRANCH_CLOSE:
+      case IUTF_TOK_RBRACKET:
+        depth--;
+        break;
+      case IUTF_TOK_EOF:
+      case IUTF_TOK_ERROR:
+        return iutf_error (r, "expected '}'");
+      default:
+        break;
+    }
+    next (r);
+  } while (depth > 0);
+  return 1;
+}
+
+static int iutf_run (IutfReader* r)
+{
+  // iutf:init:main {
+  static const IutfTokenType header[] = {
+    IUTF_TOK_IDENTIFIER, IUTF_TOK_COLON, IUTF_TOK_IDENTIFIER, IUTF_TOK_COLON, IUTF_TOK_IDENTIFIER, IUTF_TOK_BRANCH_OPEN
+  };
+  next (r);
+  for (size_t i = 0; i < sizeof (header) / sizeof (header[0]); i++) {
+    if (r->tok.type != header[i]) return iutf_error (r, "expected the iutf:init:main header");
+    next (r);
+  }
+  if (!json_open (r, 'b')) return 0;
+
+  while (r->depth > 0) {
+    IutfWriterLevel* top = &r->stack[r->depth - 1];
+
+    if (r->tok.type == IUTF_TOK_COMMA) {
+      next (r);
+      continue;
+    }
+
+    if (top->kind == 'b') {
+      if (r->tok.type == IUTF_TOK_BRANCH_CLOSE) {
+        json_close (r);
+        if (r->depth > 0) next (r);
+        continue;
+      }
+      if (r->tok.type == IUTF_TOK_IMPORT) {
+        // extensions only matter to the parser
+        next (r);
+        if (r->tok.type == IUTF_TOK_IDENTIFIER && r->tok.length == 4 && memcmp (r->tok.start, "from", 4) == 0) {
+          next (r);
+          if (r->tok.type == IUTF_TOK_STRING || r->tok.type == IUTF_TOK_IDENTIFIER) next (r);
+        }
+        continue;
+      }
+      if (r->tok.type != IUTF_TOK_IDENTIFIER) return iutf_error (r, "expected a key");
+      if (type_decl_ahead (r)) {
+        if (!skip_type_decl (r)) return 0;
+        continue;
+      }
+      json_item (r, r->tok.start, r->tok.length);
+      next (r);
+      if (r->tok.type == IUTF_TOK_LBRACKET) {
+        // key[type]: JSON has no place for the annotation
+        next (r);
+        if (r->tok.type != IUTF_TOK_IDENTIFIER) return iutf_error (r, "expected a type name");
+        next (r);
+        if (r->tok.type != IUTF_TOK_RBRACKET) return iutf_error (r, "expected ']'");
+        next (r);
+      }
+      if (r->tok.type != IUTF_TOK_COLON) return iutf_error (r, "expected ':'");
+      next (r);
+    } else {
+      if (r->tok.type == IUTF_TOK_RBRACKET) {
+        json_close (r);
+        next (r);
+        continue;
+      }
+      json_item (r, NULL, 0);
+    }
+    if (!iutf_value (r)) return 0;
+  }
+
+  if (r->pretty) iutf_buffer_putc (&r->out, '\n');
+  return !r->out.error;
+}
+
+// the text in memory, or through `window` when it is NULL
+static int iutf_read (const char* input, size_t len, IutfLexWindow* window, IutfSinkFunc sink, void* ctx, int flags)
+{
+  IutfReader r;
+  memset (&r, 0, sizeof (r));
+  r.pretty = !(flags & IUTF_WRITE_COMPACT);
+  r.window = window;
+  r.lexer = iutf_lexer_new_len (input ? input : "", len);
+  if (!r.lexer) return 0;
+  iutf_buffer_init_sink (&r.out, sink, ctx);
+
+  int ok = iutf_run (&r) && !(window && window->failed) && iutf_buffer_flush (&r.out);
+
+  iutf_buffer_free (&r.out);
+  iutf_lexer_corrupt (r.lexer);
+  free (r.stack);
+  free (r.scratch.data);
+  return ok;
+}
+
+int iutf_iutf_to_json (const char* input, size_t len, IutfSinkFunc sink, void* ctx, int flags)
+{
+  if (!input || !sink) return 0;
+  return iutf_read (input, len, NULL, sink, ctx, flags);
+}
+
+/* ---- files ---- */
+
+typedef int (*TranscodeFunc) (const char*, size_t, IutfSinkFunc, void*, int);
+
+// gzip/zstd IUTF is read token by token through the decompressor ring
+static int transcode_compressed (const char* path, int fd, IutfCompression compression, int out_fd, int flags)
+{
+  IutfDecompressor* d = iutf_decompress_open (fd, compression, path);
+  if (!d) return 0;
+  IutfLexWindow window;
+  iutf_lex_window_init (&window, d);
+  int ok = iutf_read (NULL, 0, &window, iutf_buffer_fd_sink, (void*)(intptr_t) out_fd, flags);
+  iutf_lex_window_free (&window);
+  iutf_decompress_close (d);
+  return ok;
+}
+
+// `iutf_input`: gzip/zstd is recognized, the JSON reader needs plain text
+static int transcode_file (const char* path, int out_fd, int flags, TranscodeFunc func, int iutf_input)
+{
+  int fd = open (path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    fprintf (stderr, COL_RED "Cannot open file: " COL_DEF COL_CYAN "%s" COL_DEF "\n", path);
+    return 0;
+  }
+
+  IutfCompression compression = iutf_input ? iutf_compression_of_fd (fd) : IUTF_COMPRESSION_NONE;
+  if (compression != IUTF_COMPRESSION_NONE) {
+    int ok = transcode_compressed (path, fd, compression, out_fd, flags);
+    close (fd);
+    return ok;
+  }
+
+  struct stat st;
+  if (fstat (fd, &st) != 0) {
+    close (fd);
+    return 0;
+  }
+
+  size_t size = (size_t) st.st_size;
+  const char* data = "";
+  if (size > 0) {
+    data = mmap (NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      close (fd);
+      fprintf (stderr, COL_RED "Cannot map file: " COL_DEF COL_CYAN "%s" COL_DEF "\n", path);
+      return 0;
+    }
+    madvise ((void*) data, size, MADV_SEQUENTIAL);
+  }
+  close (fd);
+
+  int ok = func (data, size, iutf_buffer_fd_sink, (void*)(intptr_t) out_fd, flags);
+  if (size > 0) munmap ((void*) data, size);
+  return ok;
+}
+
+int iutf_json_file_to_iutf (const char* path, int out_fd, int flags)
+{
+  return transcode_file (path, out_fd, flags, iutf_json_to_iutf, 0);
+}
+
+int iutf_iutf_file_to_json (const char* path, int out_fd, int flags)
+{
+  return transcode_file (path, out_fd, flags, iutf_iutf_to_json, 1);
+}
@@ -19,6 +19,7 @@
  */
 
 #include "../includes/iutf-lexer.h"
+#include "../includes/iutf-alloc.h"
 #include <string.h>
 #include <ctype.h>
 
@@ -119,7 +120,8 @@ static IutfToken make_token (IutfLexer* lexer, IutfTokenType type, size_t start)
 
 static IutfToken error_token (IutfLexer* lexer, const char* msg)
 {
-  print_error_at (lexer->input, lexer->line, lexer->col, msg);
+  lexer->error = msg;
+  if (!lexer->quiet) print_error_at (lexer->input, lexer->line, lexer->col, msg);
   IutfToken tok;
   tok.type = IUTF_TOK_ERROR;
   tok.start = NULL;
@@ -129,19 +131,58 @@ static IutfToken error_token (IutfLexer* lexer, const char* msg)
   return tok;
 }
 
+// 12, -12, 12.5, 1.5e-3, 12L
 static IutfToken read_number (IutfLexer* lexer, size_t start)
 {
-  while (isdigit(current(lexer)) || current(lexer) == '.') {
+  IutfTokenType type = IUTF_TOK_INTEGER;
+
+  while (isdigit(current(lexer))) {
     advance(lexer);
   }
-  return make_token(lexer, IUTF_TOK_INTEGER, start);
+  if (current (lexer) == '.' && isdigit (peek (lexer, 1))) {
+    type = IUTF_TOK_FLOAT;
+    advance (lexer);
+    while (isdigit (current (lexer))) advance (lexer);
+  }
+  if ((current (lexer) == 'e' || current (lexer) == 'E')
+      && (isdigit (peek (lexer, 1)) || ((peek (lexer, 1) == '+' || peek (lexer, 1) == '-') && isdigit (peek (lexer, 2))))) {
+    type = IUTF_TOK_FLOAT;
+    advance (lexer);
+    if (!isdigit (current (lexer))) advance (lexer);
+    while (isdigit (current (lexer))) advance (lexer);
+  }
+  if (type == IUTF_TOK_INTEGER && current (lexer) == 'L') {
+    type = IUTF_TOK_LONG;
+    advance (lexer);
+  }
+  return make_token(lexer, type, start);
 }
 
-static IutfToken read_string (IutfLexer* lexer)
+// 'c', '\n', '\x1b'
+static IutfToken read_character (IutfLexer* lexer, size_t start)
 {
-  size_t start = lexer->pos;
-  advance(lexer);
+  if (current (lexer) == '\\') {
+    advance (lexer);
+    if (current (lexer) == 'x' && isxdigit (peek (lexer, 1)) && isxdigit (peek (lexer, 2))) {
+      advance (lexer);
+      advance (lexer);
+    }
+  }
+  if (current (lexer) == '\0' || current (lexer) == '\n') {
+    return error_token (lexer, "Unterminated character literal");
+  }
+  advance (lexer);
+
+  if (current (lexer) != '\'') {
+    return error_token (lexer, "Unterminated character literal");
+  }
+  advance (lexer);
+  return make_token (lexer, IUTF_TOK_CHARACTER, start);
+}
 
+static IutfToken read_string (IutfLexer* lexer, size_t start)
+{
+  // opening quote is already consumed, the token spans both quotes
   while (current(lexer) != '"' && current (lexer) != '\0') {
     if (current (lexer) == '\\') {
       advance (lexer);
@@ -162,6 +203,143 @@ static IutfToken read_string (IutfLexer* lexer)
   return make_token(lexer, IUTF_TOK_STRING, start);
 }
 
+/*
+ * Raw blocks: BigString[...] and |...| are one token each, the delimiters are
+ * found with memchr over the whole block and the position bookkeeping is done
+ * once for the span instead of per byte.
+ */
+
+// move to `pos`, counting the newlines in between
+static void skip_to (IutfLexer* lexer, size_t pos)
+{
+  const char* p = lexer->input + lexer->pos;
+  const char* end = lexer->input + pos;
+  const char* last = NULL;
+  const char* nl;
+  while (p < end && (nl = memchr (p, '\n', (size_t) (end - p)))) {
+    lexer->line++;
+    last = nl;
+    p = nl + 1;
+  }
+  if (last) lexer->col = (int) (end - last);
+  else lexer->col += (int) (pos - lexer->pos);
+  lexer->pos = pos;
+}
+
+static IutfToken block_token (IutfLexer* lexer, IutfTokenType type, size_t start, int line, int col)
+{
+  IutfToken token;
+  token.type = type;
+  token.start = lexer->input + start;
+  token.length = lexer->pos - start;
+  token.line = line;
+  token.col = col;
+  return token;
+}
+
+// `start` is at 'B', the lexer at the '['; nested brackets must balance
+static IutfToken read_bigstring (IutfLexer* lexer, size_t start)
+{
+  int line = lexer->line;
+  int col = lexer->col - 9;
+  const char* p = lexer->input + lexer->pos + 1;
+  const char* end = lexer->input + lexer->len;
+  int depth = 1;
+  for (;;) {
+    const char* close = memchr (p, ']', (size_t) (end - p));
+    if (!close) return error_token (lexer, "Unterminated BigString");
+    for (const char* open = p; (open = memchr (open, '[', (size_t) (close - open))); open++) depth++;
+    p = close + 1;
+    if (--depth == 0) break;
+  }
+  skip_to (lexer, (size_t) (p - lexer->input));
+  return block_token (lexer, IUTF_TOK_BIGSTRING_START, start, line, col);
+}
+
+// `start` is at the opening '|', the lexer just after it
+static IutfToken read_pipe (IutfLexer* lexer, size_t start)
+{
+  int line = lexer->line;
+  int col = lexer->col - 1;
+  const char* close = memchr (lexer->input + lexer->pos, '|', lexer->len - lexer->pos);
+  if (!close) return error_token (lexer, "Unterminated pipe string");
+  skip_to (lexer, (size_t) (close - lexer->input) + 1);
+  return block_token (lexer, IUTF_TOK_PIPE, start, line, col);
+}
+
+const char* iutf_token_block (const IutfToken* token, size_t* len)
+{
+  size_t open = token->type == IUTF_TOK_BIGSTRING_START ? 10 : 1; // "BigString[" or "|"
+  if (!token->start || token->length < open + 1) {
+    *len = 0;
+    return NULL;
+  }
+  *len = token->length - open - 1;
+  return token->start + open;
+}
+
+static inline int is_blank (char c)
+{
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+size_t iutf_block_text (const char* src, size_t len, int flags, char* dst)
+{
+  const char* end = src + len;
+  if (flags & IUTF_BLOCK_TRIM) {
+    // a line break right after the opener, and one right before the closer with its indentation
+    const char* p = src;
+    while (p < end && is_blank (*p)) p++;
+    if (p < end && *p == '\n') src = p + 1;
+    const char* q = end;
+    while (q > src && is_blank (q[-1])) q--;
+    if (q > src && q[-1] == '\n') end = q - 1;
+    else if (q == src) end = src;
+  }
+
+  // the indentation every non-blank line starts with, as a prefix of the first one's
+  const char* indent = NULL;
+  size_t indent_len = 0;
+  if (flags & IUTF_BLOCK_DEDENT) {
+    for (const char* line = src; line < end;) {
+      const char* nl = memchr (line, '\n', (size_t) (end - line));
+      const char* stop = nl ? nl : end;
+      size_t n = 0;
+      while (line + n < stop && (line[n] == ' ' || line[n] == '\t')) n++;
+      if (line + n < stop && !(line + n + 1 == stop && line[n] == '\r')) {
+        if (!indent) {
+          indent = line;
+          indent_len = n;
+        } else {
+          size_t same = 0;
+          while (same < n && same < indent_len && line[same] == indent[same]) same++;
+          indent_len = same;
+        }
+      }
+      line = nl ? nl + 1 : end;
+    }
+  }
+
+  size_t out = 0;
+  if (!indent_len) {
+    memcpy (dst, src, (size_t) (end - src));
+    out = (size_t) (end - src);
+  } else {
+    for (const char* line = src; line < end;) {
+      const char* nl = memchr (line, '\n', (size_t) (end - line));
+      const char* stop = nl ? nl + 1 : end;
+      // blank lines may be shorter than the indentation
+      size_t cut = 0;
+      while (cut < indent_len && line + cut < stop && (line[cut] == ' ' || line[cut] == '\t')) cut++;
+      memcpy (dst + out, line + cut, (size_t) (stop - line - cut));
+      out += (size_t) (stop - line - cut);
+      line = stop;
+    }
+  }
+  dst[out] = '\0';
+  return out;
+}
+
 static IutfToken read_identifier (IutfLexer* lexer, size_t start)
 {
   while (is_ident_continue (current(lexer))) {
@@ -174,23 +352,27 @@ static IutfToken read_identifier (IutfLexer* lexer, size_t start)
   if (len == 4 && strncmp (str, "true", 4) == 0) return make_token (lexer, IUTF_TOK_TRUE, start);
   if (len == 5 && strncmp (str, "false", 5) == 0) return make_token (lexer, IUTF_TOK_FALSE, start);
   if (len == 4 && strncmp (str, "null", 4) == 0) return make_token (lexer, IUTF_TOK_NULL, start);
+  if (len == 9 && strncmp (str, "BigString", 9) == 0 && current (lexer) == '[') return read_bigstring (lexer, start);
 
   return make_token (lexer, IUTF_TOK_IDENTIFIER, start);
 }
 
-static IutfToken read_bigstring (IutfLexer* lexer)
+static IutfToken read_import (IutfLexer* lexer, size_t start)
 {
-  size_t start = lexer->pos - 9;
-  int depth = 1;
-  while (depth > 0 && current (lexer) != '\0') {
-    if (current (lexer) == '[') depth++;
-    else if (current (lexer) == ']') depth--;
+  // '@' is already consumed, expect import<name>
+  if (lexer->pos + 7 > lexer->len || strncmp (lexer->input + lexer->pos, "import<", 7) != 0) {
+    return error_token (lexer, "Unknown directive");
+  }
+  for (int i = 0; i < 7; i++) advance (lexer);
+
+  while (is_ident_continue (current (lexer))) {
     advance (lexer);
   }
-  if (depth != 0) {
-    return error_token(lexer, "Unterminated BigString");
+  if (current (lexer) != '>') {
+    return error_token (lexer, "Expected '>' after import name");
   }
-  return make_token (lexer, IUTF_TOK_BIGSTRING_START, start);
+  advance (lexer);
+  return make_token (lexer, IUTF_TOK_IMPORT, start);
 }
 
 static void skip_line_comment (IutfLexer* lexer)
@@ -216,14 +398,21 @@ static void skip_block_comment (IutfLexer* lexer)
 
 IutfLexer* iutf_lexer_new (const char* input)
 {
-  IutfLexer* lexer = malloc(sizeof(IutfLexer));
+  return iutf_lexer_new_len (input, strlen (input));
+}
+
+IutfLexer* iutf_lexer_new_len (const char* input, size_t len)
+{
+  IutfLexer* lexer = iutf_malloc(sizeof(IutfLexer));
   if (!lexer) return NULL;
 
   lexer->input = input;
-  lexer->len = strlen(input);
+  lexer->len = len;
   lexer->pos = 0;
   lexer->line = 1;
   lexer->col = 1;
+  lexer->quiet = 0;
+  lexer->error = NULL;
 
   return lexer;
 }
@@ -231,11 +420,11 @@ IutfLexer* iutf_lexer_new (const char* input)
 void iutf_lexer_corrupt (IutfLexer* lexer)
 {
   if (lexer) {
-    free (lexer);
+    iutf_free (lexer);
   }
 }
 
-IutfToken iutf_lexer_next (IutfLexer* lexer) {
+static inline IutfToken lexer_next (IutfLexer* lexer) {
   while (current(lexer) != '\0') {
     size_t start = lexer->pos;
 
@@ -246,16 +435,11 @@ IutfToken iutf_lexer_next (IutfLexer* lexer) {
     {
     case '{': return make_token (lexer, IUTF_TOK_BRANCH_OPEN, start);
     case '}': return make_token (lexer, IUTF_TOK_BRANCH_CLOSE, start);
-    case '[': {
-      if (lexer->pos >= 9 && strncmp(lexer->input + lexer->pos - 9, "BigString", 9) == 0) {
-          return read_bigstring (lexer);
-        }
-        return make_token (lexer, IUTF_TOK_LBRACKET, start);
-    }
+    case '[': return make_token (lexer, IUTF_TOK_LBRACKET, start);
     case ']': return make_token (lexer, IUTF_TOK_RBRACKET, start);
     case ':': return make_token (lexer, IUTF_TOK_COLON, start);
     case '=': return make_token (lexer, IUTF_TOK_EQUALS, start);
-    case '|': return make_token (lexer, IUTF_TOK_PIPE, start);
+    case '|': return read_pipe (lexer, start);
     case ',': return make_token (lexer, IUTF_TOK_COMMA, start);
     case '#':
       if (current (lexer) == '!') {
@@ -277,7 +461,14 @@ IutfToken iutf_lexer_next (IutfLexer* lexer) {
       } else {
         return make_token (lexer, IUTF_TOK_IDENTIFIER, start);
       }
-    case '"': return read_string (lexer);
+    case '"': return read_string (lexer, start);
+    case '\'': return read_character (lexer, start);
+    case '-':
+      if (isdigit (current (lexer))) {
+        return read_number (lexer, start);
+      }
+      return error_token (lexer, "Unexpected character");
+    case '@': return read_import (lexer, start);
     case ' ':
     case '\t':
     case '\r':
@@ -303,6 +494,18 @@ IutfToken iutf_lexer_next (IutfLexer* lexer) {
   return token;
 }
 
+IutfToken iutf_lexer_next (IutfLexer* lexer)
+{
+  IutfToken token = lexer_next (lexer);
+  IUTF_STAT_ADD (tokens[token.type], 1);
+  return token;
+}
+
+IutfToken iutf_lexer_scan (IutfLexer* lexer)
+{
+  return lexer_next (lexer);
+}
+
 const char* iutf_token_type_to_string (IutfTokenType type)
 {
   switch (type)
@@ -331,7 +534,67 @@ const char* iutf_token_type_to_string (IutfTokenType type)
   case IUTF_TOK_COMMENT_CPP: return "COMMENT_CPP";
   case IUTF_TOK_COMMENT_BLOCK_START: return "COMMENT_BLOCK_START";
   case IUTF_TOK_COMMENT_BLOCK_END: return "COMMENT_BLOCK_END";
+  case IUTF_TOK_IMPORT: return "IMPORT";
   default: return "UNKNOWN";
   }
 }
 
+
+static inline int hex_value (char c)
+{
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+size_t iutf_unescape (const char* src, size_t len, char* dst)
+{
+  size_t out = 0;
+  for (size_t i = 0; i < len; i++) {
+    if (src[i] != '\\' || i + 1 >= len) {
+      dst[out++] = src[i];
+      continue;
+    }
+
+    char esc = src[++i];
+    switch (esc)
+    {
+      case 'n': dst[out++] = '\n'; break;
+      case 't': dst[out++] = '\t'; break;
+      case 'r': dst[out++] = '\r'; break;
+      case '0': dst[out++] = '\0'; break;
+      case 'x':
+        if (i + 2 < len && hex_value (src[i + 1]) >= 0 && hex_value (src[i + 2]) >= 0) {
+          dst[out++] = (char)(hex_value (src[i + 1]) * 16 + hex_value (src[i + 2]));
+          i += 2;
+        } else {
+          dst[out++] = esc;
+        }
+        break;
+      default:
+        dst[out++] = esc; // \\, \", \' and unknown escapes are literal
+        break;
+    }
+  }
+  dst[out] = '\0';
+  return out;
+}
+
+char* iutf_token_string (const IutfToken* token)
+{
+  if (!token->start || token->length < 2) return NULL;
+
+  const char* src = token->start + 1;
+  size_t len = token->length - 2;
+  char* str = iutf_malloc (len + 1);
+  if (!str) return NULL;
+
+  if (!memchr (src, '\\', len)) {
+    memcpy (str, src, len);
+    str[len] = '\0';
+    return str;
+  }
+  iutf_unescape (src, len, str);
+  return str;
+}
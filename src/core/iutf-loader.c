@@ -0,0 +1,562 @@
+/* iutf-loader.c
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Loader version 0.1
+ */
+#define _GNU_SOURCE
+
+#include "../includes/iutf-loader.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// a file whose size stat reports as 0 (procfs, pipes) is read in growing steps
+#define UNKNOWN_SIZE_STEP 4096
+
+struct IutfLoader {
+  const char* const* paths;
+  size_t count;
+  IutfIoEngine engine;
+
+  // loaded files not taken yet, a ring of IUTF_LOADER_AHEAD
+  IutfLoadedFile ready[IUTF_LOADER_AHEAD];
+  size_t ready_head;
+  size_t ready_tail;
+  size_t taken;
+  size_t next; // pread pool: next path to load
+  int stop;
+  pthread_mutex_t lock;
+  pthread_cond_t filled;
+  pthread_cond_t space;
+
+  pthread_t* threads;
+  int started;
+};
+
+const char* iutf_io_engine_name (IutfIoEngine engine)
+{
+  switch (engine) {
+    case IUTF_IO_AUTO: return "auto";
+    case IUTF_IO_URING: return "uring";
+    case IUTF_IO_PREAD: return "pread";
+  }
+  return "?";
+}
+
+int iutf_io_engine_parse (const char* name)
+{
+  if (strcmp (name, "auto") == 0) return IUTF_IO_AUTO;
+  if (strcmp (name, "uring") == 0 || strcmp (name, "io_uring") == 0) return IUTF_IO_URING;
+  if (strcmp (name, "pread") == 0) return IUTF_IO_PREAD;
+  return -1;
+}
+
+// hand a file to the workers; 0 if the loader is being freed and the file was dropped
+static int publish (IutfLoader* l, IutfLoadedFile* file)
+{
+  pthread_mutex_lock (&l->lock);
+  while (!l->stop && l->ready_tail - l->ready_head == IUTF_LOADER_AHEAD) pthread_cond_wait (&l->space, &l->lock);
+  int stop = l->stop;
+  if (!stop) {
+    l->ready[l->ready_tail++ % IUTF_LOADER_AHEAD] = *file;
+    pthread_cond_signal (&l->filled);
+  }
+  pthread_mutex_unlock (&l->lock);
+  if (stop) free (file->data);
+  return !stop;
+}
+
+/* ---- pread ---- */
+
+static void load_sync (const char* path, IutfLoadedFile* file)
+{
+  file->data = NULL;
+  file->len = 0;
+  file->error = 0;
+
+  int fd = open (path, O_RDONLY | O_CLOEXEC);
+  struct stat st;
+  if (fd < 0 || fstat (fd, &st) != 0) {
+    file->error = errno;
+    if (fd >= 0) close (fd);
+    return;
+  }
+
+  size_t cap = st.st_size > 0 ? (size_t) st.st_size + 1 : UNKNOWN_SIZE_STEP;
+  size_t got = 0;
+  char* data = malloc (cap);
+  while (data) {
+    ssize_t n = pread (fd, data + got, cap - 1 - got, got);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0) {
+      file->error = errno;
+      break;
+    }
+    got += (size_t) n;
+    // stat's size is all we read, a file growing meanwhile is cut there
+    if (n == 0 || (st.st_size > 0 && got == cap - 1)) {
+      data[got] = '\0';
+      file->data = data;
+      file->len = got;
+      close (fd);
+      return;
+    }
+    if (got == cap - 1) {
+      char* grown = realloc (data, cap * 2);
+      if (!grown) break;
+      data = grown;
+      cap *= 2;
+    }
+  }
+  if (!file->error) file->error = ENOMEM;
+  free (data);
+  close (fd);
+}
+
+static void* pread_worker (void* arg)
+{
+  IutfLoader* l = arg;
+  for (;;) {
+    pthread_mutex_lock (&l->lock);
+    size_t i = l->next++;
+    int stop = l->stop;
+    pthread_mutex_unlock (&l->lock);
+    if (stop || i >= l->count) return NULL;
+
+    IutfLoadedFile file;
+    load_sync (l->paths[i], &file);
+    file.index = i;
+    if (!publish (l, &file)) return NULL;
+  }
+}
+
+/* ---- io_uring ---- */
+
+typedef struct {
+  int fd;
+  unsigned* sq_head;
+  unsigned* sq_tail;
+  unsigned* sq_mask;
+  unsigned* sq_array;
+  unsigned sq_entries;
+  struct io_uring_sqe* sqes;
+  unsigned* cq_head;
+  unsigned* cq_tail;
+  unsigned* cq_mask;
+  struct io_uring_cqe* cqes;
+  void* sq_map;
+  size_t sq_map_len;
+  void* cq_map;
+  size_t cq_map_len;
+  size_t sqes_len;
+  unsigned to_submit;
+} Ring;
+
+enum { OP_OPEN, OP_STATX, OP_READ, OP_CLOSE };
+
+// one file in flight
+typedef struct {
+  size_t index;
+  int busy;
+  int fd;
+  int waiting; // operations submitted and not completed
+  int error;
+  int unsupported; // the kernel refused an operation (-EINVAL, -EOPNOTSUPP), the file is loaded with pread
+  int sized; // statx answered
+  struct statx stx;
+  char* data;
+  size_t cap;
+  size_t got;
+} Slot;
+
+static int ring_setup (Ring* r, unsigned entries)
+{
+  struct io_uring_params p;
+  memset (&p, 0, sizeof (p));
+  memset (r, 0, sizeof (*r));
+  r->fd = (int) syscall (__NR_io_uring_setup, entries, &p);
+  if (r->fd < 0) return 0;
+
+  r->sq_map_len = p.sq_off.array + p.sq_entries * sizeof (unsigned);
+  r->cq_map_len = p.cq_off.cqes + p.cq_entries * sizeof (struct io_uring_cqe);
+  int single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single && r->cq_map_len > r->sq_map_len) r->sq_map_len = r->cq_map_len;
+
+  r->sq_map = mmap (NULL, r->sq_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+  if (r->sq_map == MAP_FAILED) {
+    close (r->fd);
+    return 0;
+  }
+  r->cq_map = single ? r->sq_map : mmap (NULL, r->cq_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_CQ_RING);
+  r->sqes_len = p.sq_entries * sizeof (struct io_uring_sqe);
+  r->sqes = r->cq_map == MAP_FAILED ? MAP_FAILED : mmap (NULL, r->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+  if (r->sqes == MAP_FAILED) {
+    if (!single && r->cq_map != MAP_FAILED) munmap (r->cq_map, r->cq_map_len);
+    munmap (r->sq_map, r->sq_map_len);
+    close (r->fd);
+    return 0;
+  }
+
+  char* sq = r->sq_map;
+  char* cq = r->cq_map;
+  r->sq_head = (unsigned*) (sq + p.sq_off.head);
+  r->sq_tail = (unsigned*) (sq + p.sq_off.tail);
+  r->sq_mask = (unsigned*) (sq + p.sq_off.ring_mask);
+  r->sq_array = (unsigned*) (sq + p.sq_off.array);
+  r->sq_entries = p.sq_entries;
+  r->cq_head = (unsigned*) (cq + p.cq_off.head);
+  r->cq_tail = (unsigned*) (cq + p.cq_off.tail);
+  r->cq_mask = (unsigned*) (cq + p.cq_off.ring_mask);
+  r->cqes = (struct io_uring_cqe*) (cq + p.cq_off.cqes);
+  return 1;
+}
+
+// the operations a load needs came with Linux 5.6, as did the probe; without them every
+// submission fails with -EINVAL
+static int ring_probe (Ring* r)
+{
+  static const unsigned ops[] = { IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_CLOSE };
+  unsigned len = 256;
+  struct io_uring_probe* probe = calloc (1, sizeof (struct io_uring_probe) + len * sizeof (struct io_uring_probe_op));
+  if (!probe) return 0;
+  int ok = syscall (__NR_io_uring_register, r->fd, IORING_REGISTER_PROBE, probe, len) == 0;
+  for (size_t i = 0; ok && i < sizeof (ops) / sizeof (ops[0]); i++) {
+    ok = ops[i] <= probe->last_op && (probe->ops[ops[i]].flags & IO_URING_OP_SUPPORTED);
+  }
+  free (probe);
+  return ok;
+}
+
+static void ring_free (Ring* r)
+{
+  munmap (r->sqes, r->sqes_len);
+  if (r->cq_map != r->sq_map) munmap (r->cq_map, r->cq_map_len);
+  munmap (r->sq_map, r->sq_map_len);
+  close (r->fd);
+}
+
+// the caller keeps at most sq_entries operations in flight, so there is always room
+static struct io_uring_sqe* ring_sqe (Ring* r, int op, size_t slot)
+{
+  unsigned tail = *r->sq_tail;
+  unsigned i = tail & *r->sq_mask;
+  struct io_uring_sqe* sqe = &r->sqes[i];
+  memset (sqe, 0, sizeof (*sqe));
+  sqe->user_data = ((uint64_t) slot << 2) | (uint64_t) op;
+  r->sq_array[i] = i;
+  __atomic_store_n (r->sq_tail, tail + 1, __ATOMIC_RELEASE);
+  r->to_submit++;
+  return sqe;
+}
+
+// submit what is queued and wait for at least one completion
+static int ring_enter (Ring* r)
+{
+  for (;;) {
+    long n = syscall (__NR_io_uring_enter, r->fd, r->to_submit, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+    if (n >= 0) {
+      r->to_submit -= (unsigned) n < r->to_submit ? (unsigned) n : r->to_submit;
+      return 1;
+    }
+    if (errno != EINTR && errno != EAGAIN && errno != EBUSY) return 0;
+  }
+}
+
+static void submit_read (Ring* r, Slot* s, size_t slot)
+{
+  struct io_uring_sqe* sqe = ring_sqe (r, OP_READ, slot);
+  sqe->opcode = IORING_OP_READ;
+  sqe->fd = s->fd;
+  sqe->addr = (uint64_t) (uintptr_t) (s->data + s->got);
+  sqe->len = (unsigned) (s->cap - 1 - s->got);
+  sqe->off = s->got;
+  s->waiting++;
+}
+
+static void submit_close (Ring* r, Slot* s, size_t slot)
+{
+  struct io_uring_sqe* sqe = ring_sqe (r, OP_CLOSE, slot);
+  sqe->opcode = IORING_OP_CLOSE;
+  sqe->fd = s->fd;
+  s->fd = -1;
+  s->waiting++;
+}
+
+static void start_file (Ring* r, Slot* s, size_t slot, size_t index, const char* path)
+{
+  memset (s, 0, sizeof (*s));
+  s->index = index;
+  s->busy = 1;
+  s->fd = -1;
+
+  // both by path, so they run side by side
+  struct io_uring_sqe* sqe = ring_sqe (r, OP_OPEN, slot);
+  sqe->opcode = IORING_OP_OPENAT;
+  sqe->fd = AT_FDCWD;
+  sqe->addr = (uint64_t) (uintptr_t) path;
+  sqe->open_flags = O_RDONLY | O_CLOEXEC;
+
+  sqe = ring_sqe (r, OP_STATX, slot);
+  sqe->opcode = IORING_OP_STATX;
+  sqe->fd = AT_FDCWD;
+  sqe->addr = (uint64_t) (uintptr_t) path;
+  sqe->len = STATX_SIZE;
+  sqe->off = (uint64_t) (uintptr_t) &s->stx;
+  s->waiting = 2;
+}
+
+static void op_failed (Slot* s, int res)
+{
+  if (res == -EINVAL || res == -EOPNOTSUPP) s->unsupported = 1;
+  if (!s->error) s->error = -res;
+}
+
+// the file's next step after a completion; 1 once it is finished and can be published
+static int step (Ring* r, Slot* s, size_t slot, int op, int res)
+{
+  s->waiting--;
+  switch (op) {
+    case OP_OPEN:
+      if (res < 0) op_failed (s, res);
+      if (res >= 0) s->fd = res;
+      break;
+    case OP_STATX:
+      if (res < 0) op_failed (s, res);
+      if (res >= 0) s->sized = 1;
+      break;
+    case OP_READ:
+      if (res < 0) {
+        if (res == -EINTR || res == -EAGAIN) {
+          submit_read (r, s, slot);
+          return 0;
+        }
+        op_failed (s, res);
+        break;
+      }
+      s->got += (size_t) res;
+      if (res == 0 || (s->stx.stx_size > 0 && s->got == s->cap - 1)) break;
+      if (s->got == s->cap - 1) {
+        char* grown = realloc (s->data, s->cap * 2);
+        if (!grown) {
+          s->error = ENOMEM;
+          break;
+        }
+        s->data = grown;
+        s->cap *= 2;
+      }
+      submit_read (r, s, slot); // short read
+      return 0;
+    case OP_CLOSE:
+      break;
+  }
+  if (s->waiting > 0) return 0;
+
+  // open and statx are both back: read it all at once
+  if (op == OP_OPEN || op == OP_STATX) {
+    if (!s->error) {
+      s->cap = s->stx.stx_size > 0 ? (size_t) s->stx.stx_size + 1 : UNKNOWN_SIZE_STEP;
+      s->data = malloc (s->cap);
+      if (s->data) {
+        submit_read (r, s, slot);
+        return 0;
+      }
+      s->error = ENOMEM;
+    }
+  }
+  if (s->fd >= 0) {
+    submit_close (r, s, slot);
+    return 0;
+  }
+  return 1;
+}
+
+typedef struct {
+  IutfLoader* loader;
+  Ring ring;
+} UringJob;
+
+static void* uring_worker (void* arg)
+{
+  UringJob* job = arg;
+  IutfLoader* l = job->loader;
+  Ring* r = &job->ring;
+
+  Slot* slots = calloc (IUTF_LOADER_IN_FLIGHT, sizeof (Slot));
+  size_t* free_slots = malloc (IUTF_LOADER_IN_FLIGHT * sizeof (size_t));
+  size_t free_count = 0;
+  for (size_t i = 0; slots && free_slots && i < IUTF_LOADER_IN_FLIGHT; i++) free_slots[free_count++] = IUTF_LOADER_IN_FLIGHT - 1 - i;
+
+  size_t next = 0;
+  size_t in_flight = 0;
+  int stop = 0;
+  int broken = !slots || !free_slots;
+  int unsupported = 0; // drain what is in flight, then load the rest with pread
+  while (!broken && (in_flight > 0 || (next < l->count && !stop && !unsupported))) {
+    // two operations per new file, at most sq_entries queued
+    while (free_count > 0 && next < l->count && !stop && !unsupported && r->to_submit + 2 <= r->sq_entries) {
+      size_t slot = free_slots[--free_count];
+      start_file (r, &slots[slot], slot, next, l->paths[next]);
+      next++;
+      in_flight++;
+    }
+    if (!ring_enter (r)) {
+      broken = 1;
+      break;
+    }
+
+    unsigned head = *r->cq_head;
+    unsigned tail = __atomic_load_n (r->cq_tail, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++) {
+      struct io_uring_cqe* cqe = &r->cqes[head & *r->cq_mask];
+      size_t slot = (size_t) (cqe->user_data >> 2);
+      int op = (int) (cqe->user_data & 3);
+      Slot* s = &slots[slot];
+      if (!step (r, s, slot, op, cqe->res)) continue;
+
+      IutfLoadedFile file;
+      if (s->unsupported) {
+        unsupported = 1;
+        free (s->data);
+        load_sync (l->paths[s->index], &file);
+      } else {
+        file.error = s->error;
+        file.data = s->error ? NULL : s->data;
+        file.len = s->error ? 0 : s->got;
+        if (s->error) free (s->data);
+        else file.data[file.len] = '\0';
+      }
+      file.index = s->index;
+      s->busy = 0;
+      free_slots[free_count++] = slot;
+      in_flight--;
+      // keep reaping while stopping, the fds and buffers in flight still need closing
+      if (!stop && !publish (l, &file)) stop = 1;
+      else if (stop) free (file.data);
+    }
+    __atomic_store_n (r->cq_head, head, __ATOMIC_RELEASE);
+  }
+
+  ring_free (r);
+  if (broken || unsupported) {
+    // the ring gave up: what it did not finish is loaded the plain way
+    for (size_t i = 0; slots && i < IUTF_LOADER_IN_FLIGHT; i++) {
+      if (!slots[i].busy) continue;
+      if (slots[i].fd >= 0) close (slots[i].fd);
+      free (slots[i].data);
+      IutfLoadedFile file;
+      load_sync (l->paths[slots[i].index], &file);
+      file.index = slots[i].index;
+      if (!stop && !publish (l, &file)) stop = 1;
+    }
+    for (; next < l->count && !stop; next++) {
+      IutfLoadedFile file;
+      load_sync (l->paths[next], &file);
+      file.index = next;
+      if (!publish (l, &file)) stop = 1;
+    }
+  }
+
+  free (slots);
+  free (free_slots);
+  free (job);
+  return NULL;
+}
+
+IutfLoader* iutf_loader_new (const char* const* paths, size_t count, IutfIoEngine engine, int threads)
+{
+  IutfLoader* l = calloc (1, sizeof (IutfLoader));
+  if (!l) return NULL;
+  l->paths = paths;
+  l->count = count;
+  pthread_mutex_init (&l->lock, NULL);
+  pthread_cond_init (&l->filled, NULL);
+  pthread_cond_init (&l->space, NULL);
+  if (threads <= 0) threads = 4;
+  if ((size_t) threads > count) threads = count ? (int) count : 1;
+  l->threads = calloc (threads, sizeof (pthread_t));
+  if (!l->threads) {
+    iutf_loader_free (l);
+    return NULL;
+  }
+
+  if (count > 0 && engine != IUTF_IO_PREAD) {
+    UringJob* job = calloc (1, sizeof (UringJob));
+    if (job && ring_setup (&job->ring, IUTF_LOADER_IN_FLIGHT * 2)) {
+      job->loader = l;
+      if (ring_probe (&job->ring) && pthread_create (&l->threads[0], NULL, uring_worker, job) == 0) {
+        l->started = 1;
+        l->engine = IUTF_IO_URING;
+        return l;
+      }
+      ring_free (&job->ring);
+    }
+    free (job);
+  }
+
+  // no io_uring here (old kernel, seccomp), no file operations in it, or not asked for
+  l->engine = IUTF_IO_PREAD;
+  while (l->started < threads && pthread_create (&l->threads[l->started], NULL, pread_worker, l) == 0) l->started++;
+  if (l->started == 0 && count > 0) {
+    iutf_loader_free (l);
+    return NULL;
+  }
+  return l;
+}
+
+int iutf_loader_next (IutfLoader* l, IutfLoadedFile* file)
+{
+  pthread_mutex_lock (&l->lock);
+  while (l->ready_head == l->ready_tail && l->taken < l->count) pthread_cond_wait (&l->filled, &l->lock);
+  int got = l->ready_head < l->ready_tail;
+  if (got) {
+    *file = l->ready[l->ready_head++ % IUTF_LOADER_AHEAD];
+    l->taken++;
+    pthread_cond_signal (&l->space);
+  }
+  pthread_mutex_unlock (&l->lock);
+  return got;
+}
+
+IutfIoEngine iutf_loader_engine (const IutfLoader* l)
+{
+  return l->engine;
+}
+
+void iutf_loader_free (IutfLoader* l)
+{
+  if (!l) return;
+  pthread_mutex_lock (&l->lock);
+  l->stop = 1;
+  pthread_cond_broadcast (&l->space);
+  pthread_mutex_unlock (&l->lock);
+  for (int i = 0; i < l->started; i++) pthread_join (l->threads[i], NULL);
+
+  for (; l->ready_head < l->ready_tail; l->ready_head++) free (l->ready[l->ready_head % IUTF_LOADER_AHEAD].data);
+  pthread_mutex_destroy (&l->lock);
+  pthread_cond_destroy (&l->filled);
+  pthread_cond_destroy (&l->space);
+  free (l->threads);
+  free (l);
+}
@@ -0,0 +1,423 @@
+/* iutf-log.c
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Log version 0.1
+ */
+#define _GNU_SOURCE
+
+#include "../includes/iutf-log.h"
+#include "../includes/iutf-scan.h"
+#include "../includes/iutf-parser.h"
+#include "../includes/iutf-serialize.h"
+#include "../includes/iutf-alloc.h"
+#include "../includes/iutf-decompress.h"
+#include "../includes/colors.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// records a worker takes at once, and how far ahead of the callback each one may be
+#define LOG_BATCH 16
+#define LOG_WINDOW_PER_JOB (4 * LOG_BATCH)
+
+static int is_space (char c)
+{
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static int push_record (IutfLogRecord** records, size_t* count, size_t* cap, const char* data, size_t len, size_t line)
+{
+  if (*count == *cap) {
+    size_t grown_cap = *cap ? *cap * 2 : 16;
+    IutfLogRecord* grown = realloc (*records, grown_cap * sizeof (IutfLogRecord));
+    if (!grown) return 0;
+    *records = grown;
+    *cap = grown_cap;
+  }
+  IutfLogRecord* r = &(*records)[(*count)++];
+  r->data = data;
+  r->len = len;
+  r->line = line;
+  return 1;
+}
+
+size_t iutf_log_split (const char* data, size_t len, size_t line, IutfLogRecord** records, size_t* count, size_t* cap)
+{
+  IutfScan scan = IUTF_SCAN_INIT;
+  size_t used = 0;
+  size_t start = 0;
+  size_t start_line = 0;
+  int depth = 0;
+  int in_record = 0;
+
+  for (size_t i = 0; i < len; i++) {
+    char c = data[i];
+    if (iutf_scan_byte (&scan, c)) {
+      if (!in_record && !is_space (c)) {
+        in_record = 1;
+        start = i;
+        start_line = line;
+      }
+      if (in_record) {
+        if (c == '{' || c == '[') {
+          depth++;
+        } else if ((c == '}' || c == ']') && --depth <= 0) {
+          // a stray closing bracket ends a record too, which then fails to parse
+          if (!push_record (records, count, cap, data + start, i + 1 - start, start_line)) return (size_t) -1;
+          in_record = 0;
+          depth = 0;
+          used = i + 1;
+        }
+      }
+    }
+    if (c == '\n') line++;
+  }
+  return used;
+}
+
+// line of the first code after `used`, 0 if only whitespace and comments are left
+static size_t tail_line (const char* data, size_t len, size_t used)
+{
+  size_t line = 1;
+  for (const char* p = data; (p = memchr (p, '\n', data + used - p)); p++) line++;
+
+  IutfScan scan = IUTF_SCAN_INIT;
+  for (size_t i = used; i < len; i++) {
+    if (iutf_scan_byte (&scan, data[i]) && !is_space (data[i])) return line;
+    if (data[i] == '\n') line++;
+  }
+  return 0;
+}
+
+static char* read_all (int fd, size_t* len)
+{
+  size_t cap = 64 * 1024;
+  size_t size = 0;
+  char* data = malloc (cap);
+  while (data) {
+    if (size == cap) {
+      char* grown = realloc (data, cap * 2);
+      if (!grown) break;
+      data = grown;
+      cap *= 2;
+    }
+    ssize_t n = read (fd, data + size, cap - size);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0) break;
+    if (n == 0) {
+      *len = size;
+      return data;
+    }
+    size += (size_t) n;
+  }
+  free (data);
+  return NULL;
+}
+
+IutfLog* iutf_log_open (const char* filename)
+{
+  int is_stdin = strcmp (filename, "-") == 0;
+  int fd = is_stdin ? 0 : open (filename, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    fprintf (stderr, COL_RED "Cannot open file: " COL_DEF COL_CYAN "%s" COL_DEF "\n", filename);
+    return NULL;
+  }
+
+  IutfLog* log = calloc (1, sizeof (IutfLog));
+  if (!log) {
+    if (!is_stdin) close (fd);
+    return NULL;
+  }
+  // imports are resolved next to the log; stdin has no directory
+  log->filename = is_stdin ? NULL : strdup (filename);
+
+  // records point into the text, so a compressed log is inflated into memory
+  IutfCompression compression = is_stdin ? IUTF_COMPRESSION_NONE : iutf_compression_of_fd (fd);
+  struct stat st;
+  if (compression != IUTF_COMPRESSION_NONE) {
+    IutfDecompressor* d = iutf_decompress_open (fd, compression, filename);
+    if (d) log->data = iutf_decompress_all (d, &log->len);
+    iutf_decompress_close (d);
+  } else {
+    if (!is_stdin && fstat (fd, &st) == 0 && S_ISREG (st.st_mode) && st.st_size > 0) {
+      void* map = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (map != MAP_FAILED) {
+        madvise (map, st.st_size, MADV_SEQUENTIAL);
+        log->data = map;
+        log->len = st.st_size;
+        log->mapped = 1;
+      }
+    }
+    if (!log->mapped) log->data = read_all (fd, &log->len);
+  }
+  if (!is_stdin) close (fd);
+
+  if (!log->data || (!is_stdin && !log->filename)) {
+    fprintf (stderr, COL_RED "Cannot read " COL_CYAN "%s" COL_DEF "\n", filename);
+    iutf_log_close (log);
+    return NULL;
+  }
+
+  size_t cap = 0;
+  size_t used = iutf_log_split (log->data, log->len, 1, &log->records, &log->count, &cap);
+  if (used == (size_t) -1) {
+    fprintf (stderr, COL_RED "Out of memory" COL_DEF "\n");
+    iutf_log_close (log);
+    return NULL;
+  }
+  log->tail_line = tail_line (log->data, log->len, used);
+  return log;
+}
+
+void iutf_log_close (IutfLog* log)
+{
+  if (!log) return;
+  if (log->mapped) munmap (log->data, log->len);
+  else free (log->data);
+  free (log->records);
+  free (log->filename);
+  free (log);
+}
+
+static IutfNode* parse_record (const IutfLog* log, size_t index, const IutfAllocator* allocator)
+{
+  const IutfLogRecord* r = &log->records[index];
+  IutfParser* parser = iutf_parser_new_len (r->data, r->len, allocator);
+  if (!parser) return NULL;
+  parser->filename = log->filename;
+  IutfNode* root = iutf_parse (parser);
+  iutf_parser_free (parser);
+  return root;
+}
+
+IutfNode* iutf_log_parse_record (const IutfLog* log, size_t index)
+{
+  if (!log || index >= log->count) return NULL;
+  return parse_record (log, index, iutf_allocator_current ());
+}
+
+/*
+ * Workers take up to LOG_BATCH records at a time, never more than `window`
+ * ahead of the callback, and leave the trees in their slots; the caller's
+ * thread takes the slots in order. Memory stays at `window` trees however
+ * long the log is.
+ */
+
+typedef struct {
+  IutfNode* root;
+  int done;
+} LogSlot;
+
+typedef struct {
+  const IutfLog* log;
+  const IutfAllocator* allocator; // the caller's, the trees are freed under it
+  LogSlot* slots;
+  size_t window;
+  size_t next; // record to parse next
+  size_t delivered; // records given to the callback
+  int stop;
+  pthread_mutex_t lock;
+  pthread_cond_t ready; // a slot is done
+  pthread_cond_t space; // the window moved
+} LogPool;
+
+static void* log_worker (void* arg)
+{
+  LogPool* p = arg;
+  for (;;) {
+    pthread_mutex_lock (&p->lock);
+    while (!p->stop && p->next < p->log->count && p->next >= p->delivered + p->window) pthread_cond_wait (&p->space, &p->lock);
+    if (p->stop || p->next >= p->log->count) {
+      pthread_mutex_unlock (&p->lock);
+      return NULL;
+    }
+    size_t first = p->next;
+    size_t end = first + LOG_BATCH;
+    if (end > p->log->count) end = p->log->count;
+    if (end > p->delivered + p->window) end = p->delivered + p->window;
+    p->next = end;
+    pthread_mutex_unlock (&p->lock);
+
+    // slots of taken records are only touched by their worker until done is set
+    IutfNode* roots[LOG_BATCH];
+    for (size_t i = first; i < end; i++) roots[i - first] = parse_record (p->log, i, p->allocator);
+
+    pthread_mutex_lock (&p->lock);
+    for (size_t i = first; i < end; i++) {
+      p->slots[i % p->window].root = roots[i - first];
+      p->slots[i % p->window].done = 1;
+    }
+    pthread_cond_signal (&p->ready);
+    pthread_mutex_unlock (&p->lock);
+  }
+}
+
+int iutf_log_each (IutfLog* log, int jobs, IutfLogFunc func, void* ctx)
+{
+  if (!log || !func) return 0;
+  if (jobs <= 0) {
+    long cores = sysconf (_SC_NPROCESSORS_ONLN);
+    jobs = cores > 0 ? (int) cores : 1;
+  }
+  if ((size_t) jobs > log->count) jobs = log->count ? (int) log->count : 1;
+
+  LogPool p;
+  memset (&p, 0, sizeof (p));
+  p.log = log;
+  p.allocator = iutf_allocator_current ();
+  p.window = (size_t) jobs * LOG_WINDOW_PER_JOB;
+
+  pthread_t* threads = NULL;
+  int started = 0;
+  if (jobs > 1) {
+    p.slots = calloc (p.window, sizeof (LogSlot));
+    threads = calloc (jobs, sizeof (pthread_t));
+  }
+  if (p.slots && threads) {
+    pthread_mutex_init (&p.lock, NULL);
+    pthread_cond_init (&p.ready, NULL);
+    pthread_cond_init (&p.space, NULL);
+    while (started < jobs && pthread_create (&threads[started], NULL, log_worker, &p) == 0) started++;
+  }
+
+  int ok = 1;
+  if (started == 0) {
+    // one job, or no threads: parse right here
+    for (size_t i = 0; i < log->count && ok; i++) ok = func (ctx, i, &log->records[i], parse_record (log, i, p.allocator));
+  } else {
+    for (size_t i = 0; i < log->count && ok; i++) {
+      LogSlot* slot = &p.slots[i % p.window];
+      pthread_mutex_lock (&p.lock);
+      while (!slot->done) pthread_cond_wait (&p.ready, &p.lock);
+      IutfNode* root = slot->root;
+      slot->done = 0;
+      p.delivered = i + 1;
+      pthread_cond_broadcast (&p.space);
+      pthread_mutex_unlock (&p.lock);
+
+      ok = func (ctx, i, &log->records[i], root);
+    }
+
+    pthread_mutex_lock (&p.lock);
+    p.stop = 1;
+    pthread_cond_broadcast (&p.space);
+    pthread_mutex_unlock (&p.lock);
+    for (int i = 0; i < started; i++) pthread_join (threads[i], NULL);
+
+    // parsed after a callback stopped it
+    for (size_t i = p.delivered; i < p.next; i++) {
+      if (p.slots[i % p.window].done) iutf_node_free_with (p.slots[i % p.window].root, p.allocator);
+    }
+    pthread_mutex_destroy (&p.lock);
+    pthread_cond_destroy (&p.ready);
+    pthread_cond_destroy (&p.space);
+  }
+
+  free (p.slots);
+  free (threads);
+  return ok;
+}
+
+IutfLogWriter* iutf_log_writer_open (const char* filename)
+{
+  int fd = open (filename, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    fprintf (stderr, COL_RED "Cannot open file: " COL_DEF COL_CYAN "%s" COL_DEF "\n", filename);
+    return NULL;
+  }
+  IutfLogWriter* writer = calloc (1, sizeof (IutfLogWriter));
+  if (!writer) {
+    close (fd);
+    return NULL;
+  }
+  writer->fd = fd;
+  pthread_mutex_init (&writer->lock, NULL);
+  return writer;
+}
+
+// `text` and a newline in one writev, retried on short writes
+static int append_record (IutfLogWriter* writer, const char* text, size_t len)
+{
+  struct iovec iov[2] = { { (void*) text, len }, { "\n", 1 } };
+  struct iovec* next = iov;
+  int left = 2;
+  int ok = 1;
+
+  pthread_mutex_lock (&writer->lock);
+  off_t start = lseek (writer->fd, 0, SEEK_END);
+  while (left > 0) {
+    ssize_t n = writev (writer->fd, next, left);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) {
+      ok = 0;
+      break;
+    }
+    while (left > 0 && (size_t) n >= next->iov_len) {
+      n -= next->iov_len;
+      next++;
+      left--;
+    }
+    if (left > 0) {
+      next->iov_base = (char*) next->iov_base + n;
+      next->iov_len -= n;
+    }
+  }
+  if (!ok) {
+    fprintf (stderr, COL_RED "Cannot append to the log: %s" COL_DEF "\n", strerror (errno));
+    // a torn record would swallow the ones after it
+    if (start >= 0 && ftruncate (writer->fd, start) != 0) fprintf (stderr, COL_RED "Cannot cut the torn record off the log" COL_DEF "\n");
+  }
+  pthread_mutex_unlock (&writer->lock);
+  return ok;
+}
+
+int iutf_log_append (IutfLogWriter* writer, IutfNode* root)
+{
+  if (!writer || !root || root->type != IUTF_NODE_BRANCH) return 0;
+
+  // serialized outside the lock, producers only wait for each other's write
+  IutfBuffer buf;
+  iutf_buffer_init (&buf);
+  int ok = iutf_serialize_to_buffer (root, IUTF_WRITE_COMPACT, &buf) && append_record (writer, buf.data, buf.len);
+  iutf_buffer_free (&buf);
+  return ok;
+}
+
+int iutf_log_append_text (IutfLogWriter* writer, const char* text, size_t len)
+{
+  if (!writer || !text) return 0;
+  return append_record (writer, text, len);
+}
+
+int iutf_log_writer_sync (IutfLogWriter* writer)
+{
+  return writer && fsync (writer->fd) == 0;
+}
+
+int iutf_log_writer_close (IutfLogWriter* writer)
+{
+  if (!writer) return 1;
+  int ok = close (writer->fd) == 0;
+  pthread_mutex_destroy (&writer->lock);
+  free (writer);
+  return ok;
+}
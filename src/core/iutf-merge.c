@@ -0,0 +1,247 @@
+/* iutf-merge.c
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Merge version 0.1
+ */
+#define _GNU_SOURCE
+
+#include "../includes/iutf-merge.h"
+#include "../includes/iutf-alloc.h"
+#include "../includes/iutf-persist.h"
+#include "../includes/iutf-diff.h"
+#include "../includes/iutf-hash.h"
+#include "../includes/colors.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// one value a layer contributes to a key, chained per key
+typedef struct {
+  IutfNode* node;
+  size_t next; // index + 1, 0 ends the chain
+} Contrib;
+
+typedef struct {
+  const char* key;
+  uint64_t hash;
+  size_t head;
+  size_t tail;
+  size_t count;
+} Entry;
+
+typedef struct {
+  char* buf;
+  size_t len;
+  size_t cap;
+} PathBuf;
+
+static IutfNode* resolve (IutfNode** values, size_t n, const IutfMergeOptions* opt, PathBuf* path);
+
+static int path_push (PathBuf* path, const char* seg)
+{
+  size_t len = strlen (seg);
+  size_t need = path->len + len + 2;
+  if (need > path->cap) {
+    size_t cap = path->cap ? path->cap * 2 : 64;
+    while (cap < need) cap *= 2;
+    char* temp = realloc (path->buf, cap);
+    if (!temp) return 0;
+    path->buf = temp;
+    path->cap = cap;
+  }
+  if (path->len > 0) path->buf[path->len++] = '.';
+  memcpy (path->buf + path->len, seg, len + 1);
+  path->len += len;
+  return 1;
+}
+
+static inline int mergeable (const IutfNode* a, const IutfNode* b, const IutfMergeOptions* opt)
+{
+  if (a->type == IUTF_NODE_BRANCH && b->type == IUTF_NODE_BRANCH) return opt->policy != IUTF_MERGE_LAST_WINS;
+  if (a->type == IUTF_NODE_ARRAY && b->type == IUTF_NODE_ARRAY) return opt->arrays == IUTF_MERGE_ARRAY_APPEND;
+  return 0;
+}
+
+static IutfNode* concat_arrays (IutfNode** arrays, size_t n)
+{
+  size_t total = 0;
+  for (size_t i = 0; i < n; i++) total += arrays[i]->data.array.size;
+
+  IutfNode* node = iutf_node_new (IUTF_NODE_ARRAY);
+  if (!node) return NULL;
+  node->refcount = 1;
+  if (total == 0) return node;
+
+  node->data.array.items = iutf_malloc (total * sizeof (IutfNode*));
+  if (!node->data.array.items) {
+    iutf_node_free (node);
+    return NULL;
+  }
+  for (size_t i = 0; i < n; i++) {
+    for (size_t j = 0; j < arrays[i]->data.array.size; j++) {
+      node->data.array.items[node->data.array.size++] = iutf_persist_retain (arrays[i]->data.array.items[j]);
+    }
+  }
+  return node;
+}
+
+static IutfNode* merge_branches (IutfNode** branches, size_t n, const IutfMergeOptions* opt, PathBuf* path)
+{
+  size_t total = 0;
+  for (size_t i = 0; i < n; i++) total += branches[i]->data.branch.size;
+
+  size_t cap = 16;
+  while (cap < total * 2) cap <<= 1;
+
+  Contrib* contribs = malloc ((total + 1) * sizeof (Contrib));
+  Entry* entries = malloc ((total + 1) * sizeof (Entry));
+  size_t* table = calloc (cap, sizeof (size_t)); // entry index + 1
+  size_t values_cap = n + 1;
+  IutfNode** values = malloc (values_cap * sizeof (IutfNode*));
+  IutfNode* node = iutf_node_new (IUTF_NODE_BRANCH);
+  if (!contribs || !entries || !table || !values || !node) goto fail;
+  node->refcount = 1;
+
+  // single pass over all layers: every key is hashed once and chained to its entry
+  size_t entry_count = 0;
+  size_t contrib_count = 0;
+  for (size_t l = 0; l < n; l++) {
+    for (size_t i = 0; i < branches[l]->data.branch.size; i++) {
+      IutfNode* item = branches[l]->data.branch.items[i];
+      if (!item->key) continue;
+
+      uint64_t h = iutf_hash_str (item->key);
+      size_t slot = (size_t) h & (cap - 1);
+      while (table[slot]) {
+        Entry* e = &entries[table[slot] - 1];
+        if (e->hash == h && strcmp (e->key, item->key) == 0) break;
+        slot = (slot + 1) & (cap - 1);
+      }
+
+      contribs[contrib_count].node = item;
+      contribs[contrib_count].next = 0;
+      contrib_count++;
+
+      if (!table[slot]) {
+        Entry* e = &entries[entry_count++];
+        e->key = item->key;
+        e->hash = h;
+        e->head = e->tail = contrib_count;
+        e->count = 1;
+        table[slot] = entry_count;
+      } else {
+        Entry* e = &entries[table[slot] - 1];
+        contribs[e->tail - 1].next = contrib_count;
+        e->tail = contrib_count;
+        e->count++;
+      }
+    }
+  }
+
+  if (entry_count > 0) {
+    node->data.branch.items = iutf_malloc (entry_count * sizeof (IutfNode*));
+    if (!node->data.branch.items) goto fail;
+  }
+
+  for (size_t i = 0; i < entry_count; i++) {
+    Entry* e = &entries[i];
+    IutfNode* child;
+
+    if (e->count == 1) {
+      child = iutf_persist_retain (contribs[e->head - 1].node);
+    } else {
+      if (e->count > values_cap) {
+        // duplicate keys inside one layer
+        IutfNode** temp = realloc (values, e->count * sizeof (IutfNode*));
+        if (!temp) goto fail;
+        values = temp;
+        values_cap = e->count;
+      }
+      size_t k = 0;
+      for (size_t c = e->head; c; c = contribs[c - 1].next) values[k++] = contribs[c - 1].node;
+
+      size_t saved = path->len;
+      if (!path_push (path, e->key)) goto fail;
+      child = resolve (values, k, opt, path);
+      path->len = saved;
+      if (path->buf) path->buf[saved] = '\0';
+      if (!child) goto fail;
+    }
+
+    // retained nodes already carry this key, merged ones are fresh
+    if (!child->key) {
+      child->key = iutf_strdup (e->key);
+      if (!child->key) {
+        iutf_node_free (child);
+        goto fail;
+      }
+    }
+    node->data.branch.items[node->data.branch.size++] = child;
+  }
+
+  free (contribs);
+  free (entries);
+  free (table);
+  free (values);
+  return node;
+
+fail:
+  free (contribs);
+  free (entries);
+  free (table);
+  free (values);
+  iutf_node_free (node);
+  return NULL;
+}
+
+static IutfNode* resolve (IutfNode** values, size_t n, const IutfMergeOptions* opt, PathBuf* path)
+{
+  if (opt->policy == IUTF_MERGE_ERROR) {
+    for (size_t i = 1; i < n; i++) {
+      if (mergeable (values[i - 1], values[i], opt)) continue;
+      if (iutf_node_hash (values[i - 1], 0) == iutf_node_hash (values[i], 0)) continue;
+      fprintf (stderr, COL_RED "Merge conflict at " COL_CYAN "%s" COL_RED " (layers disagree)" COL_DEF "\n",
+               path->len ? path->buf : "<root>");
+      return NULL;
+    }
+  }
+
+  // only the last run of mergeable values survives, earlier ones are replaced
+  size_t start = n - 1;
+  while (start > 0 && mergeable (values[start - 1], values[start], opt)) start--;
+
+  if (start == n - 1) return iutf_persist_retain (values[n - 1]);
+  if (values[start]->type == IUTF_NODE_BRANCH) return merge_branches (values + start, n - start, opt, path);
+  return concat_arrays (values + start, n - start);
+}
+
+IutfNode* iutf_merge (IutfNode** layers, size_t count, const IutfMergeOptions* options)
+{
+  IutfMergeOptions defaults = { IUTF_MERGE_DEEP, IUTF_MERGE_ARRAY_REPLACE };
+  if (!options) options = &defaults;
+  if (!layers || count == 0) return NULL;
+
+  for (size_t i = 0; i < count; i++) {
+    if (!layers[i]) return NULL;
+    iutf_persist_freeze (layers[i]);
+  }
+
+  PathBuf path = { NULL, 0, 0 };
+  IutfNode* result = resolve (layers, count, options, &path);
+  free (path.buf);
+  return result;
+}
@@ -23,6 +23,10 @@
 #include "../includes/iutf-parser.h"
 #include "../includes/iutf-lexer.h"
 #include "../includes/iutf-import.h"
+#include "../includes/iutf-cache.h"
+#include "../includes/iutf-alloc.h"
+#include "../includes/iutf-stream.h"
+#include "../includes/iutf-decompress.h"
 #include <assert.h>
 
 static void advance(IutfParser* parser)
@@ -33,8 +37,48 @@ static void advance(IutfParser* parser)
 static IutfNode* parse_value(IutfParser* parser);
 static IutfNode* parse_branch(IutfParser* parser);
 
-IutfNode* iutf_parse_from_file (const char* filename)
+// gzip/zstd: entry by entry through the stream, the text is never in memory as a whole
+static IutfNode* parse_compressed (const char* filename, IutfImportList* imports, IutfTypeTable* types)
 {
+  IutfStream* stream = stream_open (filename);
+  if (!stream) return NULL;
+
+  // the header alone declared nothing, take over the caller's imports and types
+  iutf_import_list_clear (&stream->imports);
+  stream->imports = *imports;
+  if (types) {
+    iutf_type_table_clear (&stream->types);
+    stream->types = *types;
+  }
+
+  IutfNode* root = iutf_node_new (IUTF_NODE_BRANCH);
+  IutfNode* entry;
+  while (root && (entry = stream_entry_next (stream))) {
+    if (!iutf_node_append (root, entry)) {
+      iutf_node_free (entry);
+      iutf_node_free (root);
+      root = NULL;
+    }
+  }
+  if (stream->error) {
+    iutf_node_free (root);
+    root = NULL;
+  }
+
+  *imports = stream->imports;
+  memset (&stream->imports, 0, sizeof (stream->imports));
+  if (types) {
+    *types = stream->types;
+    memset (&stream->types, 0, sizeof (stream->types));
+  }
+  stream_corrupt (stream);
+  return root;
+}
+
+static IutfNode* parse_file (const char* filename, IutfImportList* imports, IutfTypeTable* types)
+{
+  if (iutf_compression_of_file (filename) != IUTF_COMPRESSION_NONE) return parse_compressed (filename, imports, types);
+
   FILE* fp = fopen (filename, "r");
   if (!fp) {
     fprintf (stderr, COL_RED "Cannot open file: " COL_DEF COL_CYAN "%s" COL_DEF "\n", filename);
@@ -45,7 +89,7 @@ IutfNode* iutf_parse_from_file (const char* filename)
   long len = ftell (fp);
   fseek (fp, 0, SEEK_SET);
 
-  char* buffer = malloc (len + 1);
+  char* buffer = iutf_malloc (len + 1);
   if (!buffer) {
     fclose (fp);
     return NULL;
@@ -57,20 +101,47 @@ IutfNode* iutf_parse_from_file (const char* filename)
 
   IutfParser* parser = iutf_parser_new (buffer);
   if (!parser) {
-    free (buffer);
+    iutf_free (buffer);
     return NULL;
   }
 
+  // share one list with nested imports so every file is parsed once,
+  // and one type table so types declared in extensions reach the importer
+  parser->filename = filename;
+  parser->imports = *imports;
+  if (types) parser->types = *types;
   IutfNode* result = iutf_parse (parser);
+  *imports = parser->imports;
+  parser->imports.paths = NULL;
+  parser->imports.size = 0;
+  if (types) {
+    *types = parser->types;
+    memset (&parser->types, 0, sizeof (parser->types));
+  }
 
   iutf_parser_free (parser);
-  free (buffer);
+  iutf_free (buffer);
+
+  return result;
+}
+
+IutfNode* iutf_parse_from_file (const char* filename)
+{
+  if (iutf_cache_enabled ()) return iutf_cache_parse (filename);
 
+  IutfImportList imports = { NULL, 0 };
+  IutfNode* result = parse_file (filename, &imports, NULL);
+  iutf_import_list_clear (&imports);
   return result;
 }
 
+IutfNode* iutf_parse_from_file_imports (const char* filename, IutfImportList* imports)
+{
+  return parse_file (filename, imports, NULL);
+}
+
 static char* safe_strndup(const char* s, size_t n) { // я ебал блять этот ебучий сегфолт
-    char* dup = malloc(n + 1);
+    char* dup = iutf_malloc(n + 1);
     if (!dup) return NULL;
     memcpy(dup, s, n);
     dup[n] = '\0';
@@ -82,7 +153,7 @@ static IutfNode* parse_string(IutfParser* parser)
     IutfNode* node = iutf_node_new(IUTF_NODE_STRING);
     if (!node) return NULL;
 
-    node->data.str_value = safe_strndup(parser->current.start, parser->current.length);
+    node->data.str_value = iutf_token_string(&parser->current);
     if (!node->data.str_value) {
       fprintf(stderr, COL_RED "Failed to allocate string!!" COL_DEF "/n");
       iutf_node_free (node);
@@ -134,6 +205,13 @@ static IutfNode* parse_character(IutfParser* parser)
           case '\\': node->data.char_value = '\\'; break;
           case '\'': node->data.char_value = '\''; break;
           case '\"': node->data.char_value = '\"'; break;
+          case '0': node->data.char_value = '\0'; break;
+          case 'x': {
+            char decoded[2];
+            iutf_unescape (parser->current.start + 1, parser->current.length - 2, decoded);
+            node->data.char_value = decoded[0];
+            break;
+          }
         default:
             node->data.char_value = esc; // treat as literal
             break;
@@ -162,16 +240,12 @@ static IutfNode* parse_array(IutfParser* parser) {
         IutfNode* item = parse_value(parser);
         if (!item) break;
 
-        struct IutfNode** temp = realloc(node->data.array.items, (node->data.array.size + 1) * sizeof(struct IutfNode*));
-        if (!temp) {
+        if (!iutf_node_append(node, item)) {
             fprintf(stderr, COL_RED "Out of memory" COL_DEF "\n");
             iutf_node_free(item);
             iutf_node_free(node);
             return NULL;
         }
-        node->data.array.items = temp;
-        node->data.array.items[node->data.array.size] = item;
-        node->data.array.size++;
 
         if (parser->current.type == IUTF_TOK_COMMA) {
             advance(parser);
@@ -187,77 +261,20 @@ static IutfNode* parse_array(IutfParser* parser) {
     return node;
 }
 
-static IutfNode* parse_bigstring(IutfParser* parser) {
-    IutfNode* node = iutf_node_new(IUTF_NODE_BIGSTRING);
+// BigString[...] and |...|: the lexer hands over the whole block as one token
+static IutfNode* parse_block(IutfParser* parser, IutfNodeType type) {
+    IutfNode* node = iutf_node_new(type);
     if (!node) return NULL;
 
-    // skip "BigString["
-    size_t start = (parser->current.start - parser->lexer->input) + 9; // "BigString" length
-    if (start >= parser->lexer->len) {
-        fprintf(stderr, "Invalid BigString start\n");
-        iutf_node_free(node);
-        return NULL;
-    }
-
-    int depth = 1;
-    size_t pos = start;
-    while (depth > 0 && pos < parser->lexer->len) {
-        if (parser->lexer->input[pos] == '[') depth++;
-        else if (parser->lexer->input[pos] == ']') depth--;
-        pos++;
-    }
-
-    if (depth != 0) {
-        fprintf(stderr, "Unterminated BigString\n");
-        iutf_node_free(node);
-        return NULL;
-    }
-
-    size_t end = pos - 1;
-    if (end < start) {
-        fprintf(stderr, "Invalid BigString range\n");
-        iutf_node_free(node);
-        return NULL;
-    }
-
-    node->data.str_value = safe_strndup(parser->lexer->input + start, end - start);
+    size_t len;
+    const char* text = iutf_token_block(&parser->current, &len);
+    node->data.str_value = safe_strndup(text ? text : "", len);
     if (!node->data.str_value) {
-        fprintf(stderr, "Failed to allocate BigString\n");
+        fprintf(stderr, "Failed to allocate %s\n", type == IUTF_NODE_BIGSTRING ? "BigString" : "pipe string");
         iutf_node_free(node);
         return NULL;
     }
-
-    while (parser->current.type != IUTF_TOK_BIGSTRING_START && parser->current.type != IUTF_TOK_EOF) {
-        advance(parser);
-    }
-    advance(parser); // skip ']'
-    return node;
-}
-static IutfNode* parse_pipe_string(IutfParser* parser) {
-    IutfNode* node = iutf_node_new(IUTF_NODE_PIPESTRING);
-    if (!node) return NULL;
-
-    advance(parser); // skip opening |
-
-    size_t start = parser->lexer->pos;
-    while (parser->current.type != IUTF_TOK_PIPE && parser->current.type != IUTF_TOK_EOF) {
-        advance(parser);
-    }
-
-    if (parser->current.type != IUTF_TOK_PIPE) {
-        fprintf(stderr, "Unterminated pipe string\n");
-        iutf_node_free(node);
-        return NULL;
-    }
-
-    node->data.str_value = safe_strndup(parser->lexer->input + start, parser->lexer->pos - start);
-    if (!node->data.str_value) {
-        fprintf(stderr, "Failed to allocate pipe string\n");
-        iutf_node_free(node);
-        return NULL;
-    }
-
-    advance(parser); // skip closing |
+    advance(parser);
     return node;
 }
 
@@ -280,18 +297,198 @@ static IutfNode* parse_value(IutfParser* parser) {
         case IUTF_TOK_LBRACKET:
             return parse_array(parser);
         case IUTF_TOK_BIGSTRING_START:
-            return parse_bigstring(parser);
+            return parse_block(parser, IUTF_NODE_BIGSTRING);
         case IUTF_TOK_PIPE:
-            return parse_pipe_string(parser);
+            return parse_block(parser, IUTF_NODE_PIPESTRING);
         case IUTF_TOK_BRANCH_OPEN:
             return parse_branch(parser);
+        case IUTF_TOK_IDENTIFIER:
+            if (parser->decl_values) {
+                // validator: is_valid_color_code
+                IutfNode* node = iutf_node_new(IUTF_NODE_STRING);
+                if (!node) return NULL;
+                node->data.str_value = safe_strndup(parser->current.start, parser->current.length);
+                if (!node->data.str_value) {
+                    iutf_node_free(node);
+                    return NULL;
+                }
+                advance(parser);
+                return node;
+            }
+            /* fallthrough */
         default:
             fprintf(stderr, "Unexpected token: %s\n", iutf_token_type_to_string(parser->current.type));
             return NULL;
     }
 }
 
-static IutfNode* parse_branch(IutfParser* parser) {
+// @import<name> [from "source"]
+static int parse_import (IutfParser* parser)
+{
+  // token is "@import<name>"
+  char* ext_name = safe_strndup (parser->current.start + 8, parser->current.length - 9);
+  if (!ext_name) {
+    fprintf (stderr, "Failed to allocate import name\n");
+    return 0;
+  }
+  advance (parser);
+
+  if (parser->current.type == IUTF_TOK_IDENTIFIER && parser->current.length == 4
+      && strncmp (parser->current.start, "from", 4) == 0) {
+    advance (parser);
+    // the source is informational, lookup always goes through IUTF_INCLUDE_PATH
+    if (parser->current.type == IUTF_TOK_STRING || parser->current.type == IUTF_TOK_IDENTIFIER) {
+      advance (parser);
+    }
+  }
+
+  // Looking for a file
+  uint64_t started = iutf_stats_phase_begin ();
+  char* file_path = iutf_find_imported_file (ext_name);
+  if (file_path) {
+    if (iutf_import_list_add (&parser->imports, file_path) == 1) {
+      IutfNode* ext = parse_file (file_path, &parser->imports, &parser->types);
+      if (ext) {
+        // only its types are kept, they are already in parser->types
+        iutf_node_free (ext);
+      } else {
+        fprintf (stderr, COL_RED "Failed to parse extension: " COL_CYAN "%s" COL_DEF "\n", file_path);
+      }
+    }
+    iutf_free (file_path);
+  } else {
+    fprintf(stderr, COL_YLW "Extension '" COL_CYAN "%s" COL_YLW "' not found" COL_DEF "\n", ext_name);
+  }
+  iutf_stats_phase_end (IUTF_PHASE_IMPORT, started);
+  iutf_free (ext_name);
+  return 1;
+}
+
+// type <name> { validator: ..., converter: ... }
+static int parse_type_decl (IutfParser* parser)
+{
+  IutfToken name = parser->current;
+  advance (parser);
+  if (parser->current.type != IUTF_TOK_BRANCH_OPEN) {
+    fprintf (stderr, "Expected '{' after type '%.*s', got %s\n", (int) name.length, name.start, iutf_token_type_to_string (parser->current.type));
+    return 0;
+  }
+
+  parser->decl_values++;
+  IutfNode* decl = parse_branch (parser);
+  parser->decl_values--;
+  if (!decl) return 0;
+
+  // the validator and converter are looked up here, not per value
+  return iutf_type_table_declare (&parser->types, name.start, name.length, decl);
+}
+
+// key[type]: resolved to the declared type
+static const IutfType* parse_annotation (IutfParser* parser)
+{
+  advance (parser); // skip '['
+  if (parser->current.type != IUTF_TOK_IDENTIFIER) {
+    fprintf (stderr, "Expected a type name, got %s\n", iutf_token_type_to_string (parser->current.type));
+    return NULL;
+  }
+
+  IutfToken name = parser->current;
+  const IutfType* type = iutf_type_table_find (&parser->types, name.start, name.length);
+  if (!type) {
+    fprintf (stderr, COL_RED "Unknown type '" COL_CYAN "%.*s" COL_RED "'" COL_DEF "\n", (int) name.length, name.start);
+    print_error_at (parser->lexer->input, name.line, name.col, "Unknown type");
+    return NULL;
+  }
+
+  advance (parser);
+  if (parser->current.type != IUTF_TOK_RBRACKET) {
+    fprintf (stderr, "Expected ']', got %s\n", iutf_token_type_to_string (parser->current.type));
+    return NULL;
+  }
+  advance (parser);
+  return type;
+}
+
+// plugin: "libcolors.so" (or an array) at the top of an extension, relative to its file
+static int load_plugins (IutfParser* parser, const IutfNode* value)
+{
+  if (value->type == IUTF_NODE_ARRAY) {
+    for (size_t i = 0; i < value->data.array.size; i++) {
+      if (!load_plugins (parser, value->data.array.items[i])) return 0;
+    }
+    return 1;
+  }
+  if (value->type != IUTF_NODE_STRING || !value->data.str_value) {
+    fprintf (stderr, "Extension 'plugin' must be a string\n");
+    return 0;
+  }
+
+  const char* path = value->data.str_value;
+  const char* slash = parser->filename ? strrchr (parser->filename, '/') : NULL;
+  if (path[0] == '/' || !slash) return iutf_types_load_plugin (path);
+
+  char* full = NULL;
+  if (asprintf (&full, "%.*s/%s", (int) (slash - parser->filename), parser->filename, path) < 0) return 0;
+  int ok = iutf_types_load_plugin (full);
+  free (full);
+  return ok;
+}
+
+// key: value, key[type]: value or a type declaration
+static int parse_entry (IutfParser* parser, IutfNode* node)
+{
+  IutfToken key_tok = parser->current;
+  advance (parser);
+
+  if (parser->current.type == IUTF_TOK_IDENTIFIER && key_tok.length == 4 && strncmp (key_tok.start, "type", 4) == 0) {
+    return parse_type_decl (parser);
+  }
+
+  const IutfType* type = NULL;
+  if (parser->current.type == IUTF_TOK_LBRACKET) {
+    type = parse_annotation (parser);
+    if (!type) return 0;
+  }
+
+  if (parser->current.type != IUTF_TOK_COLON) {
+    fprintf (stderr, "Expected ':', got %s\n", iutf_token_type_to_string (parser->current.type));
+    return 0;
+  }
+  advance (parser);
+
+  IutfNode* value = parse_value (parser);
+  if (!value) return 0;
+
+  if (type) {
+    value = iutf_type_apply (type, value);
+    if (!value) {
+      fprintf (stderr, COL_RED "Value of '" COL_CYAN "%.*s" COL_RED "' is not a valid '%s'" COL_DEF "\n", (int) key_tok.length, key_tok.start, type->name);
+      print_error_at (parser->lexer->input, key_tok.line, key_tok.col, "Invalid value");
+      return 0;
+    }
+  }
+
+  value->key = safe_strndup (key_tok.start, key_tok.length);
+  if (!value->key) {
+    fprintf (stderr, "Failed to allocate key\n");
+    iutf_node_free (value);
+    return 0;
+  }
+
+  if (parser->extension && parser->depth == 1 && strcmp (value->key, "plugin") == 0 && !load_plugins (parser, value)) {
+    iutf_node_free (value);
+    return 0;
+  }
+
+  if (!iutf_node_append (node, value)) {
+    fprintf (stderr, "Out of memory\n");
+    iutf_node_free (value);
+    return 0;
+  }
+  return 1;
+}
+
+static IutfNode* parse_branch_items(IutfParser* parser) {
     IutfNode* node = iutf_node_new(IUTF_NODE_BRANCH);
     if (!node) return NULL;
 
@@ -299,65 +496,13 @@ static IutfNode* parse_branch(IutfParser* parser) {
     advance(parser); // skip '{'
 
     while (parser->current.type != IUTF_TOK_BRANCH_CLOSE && parser->current.type != IUTF_TOK_EOF) {
-        if (parser->current.type == IUTF_TOK_IDENTIFIER) {
-            char* key = safe_strndup(parser->current.start, parser->current.length);
-            if (!key) {
-                fprintf(stderr, "Failed to allocate key\n");
+        if (parser->current.type == IUTF_TOK_IMPORT) {
+            if (!parse_import (parser)) {
                 iutf_node_free(node);
                 return NULL;
             }
-            advance(parser);
-
-          if (strncmp (parser->current.start, "@import", 7) == 0) {
-            // skip @import<
-            advance (parser);
-            // read name
-            if (parser->current.type == IUTF_TOK_IDENTIFIER) {
-              char* ext_name = safe_strndup (parser->current.start, parser->current.length);
-              advance (parser); // >
-              advance (parser); // from
-              // Looking for a file
-              char* file_path = iutf_find_imported_file (ext_name);
-              if (file_path) {
-                IutfNode* ext = iutf_parse_from_file (file_path);
-                if (ext) {
-                  // TODO: Объединить типы из ext в текущий контекст
-                  iutf_node_free (ext);
-                } else {
-                  fprintf (stderr, COL_RED "Failed to parse extension: " COL_CYAN "%s" COL_DEF "\n", file_path);
-                }
-                free (file_path);
-              } else {
-                  fprintf(stderr, COL_YLW "Extension '" COL_CYAN "%s" COL_YLW "' not found" COL_DEF "\n", ext_name);
-              }
-              free (ext_name);
-            }
-          }
-
-            if (parser->current.type == IUTF_TOK_COLON) {
-                advance(parser);
-                IutfNode* value = parse_value(parser);
-                if (!value) {
-                    free(key);
-                    iutf_node_free(node);
-                    return NULL;
-                }
-                value->key = key;
-
-                struct IutfNode** temp = realloc(node->data.branch.items, (node->data.branch.size + 1) * sizeof(struct IutfNode*));
-                if (!temp) {
-                    fprintf(stderr, "Out of memory\n");
-                    free(key);
-                    iutf_node_free(value);
-                    iutf_node_free(node);
-                    return NULL;
-                }
-                node->data.branch.items = temp;
-                node->data.branch.items[node->data.branch.size] = value;
-                node->data.branch.size++;
-            } else {
-                fprintf(stderr, "Expected ':', got %s\n", iutf_token_type_to_string(parser->current.type));
-                free(key);
+        } else if (parser->current.type == IUTF_TOK_IDENTIFIER) {
+            if (!parse_entry (parser, node)) {
                 iutf_node_free(node);
                 return NULL;
             }
@@ -382,15 +527,39 @@ static IutfNode* parse_branch(IutfParser* parser) {
     return node;
 }
 
+static IutfNode* parse_branch(IutfParser* parser) {
+    parser->depth++;
+    IutfNode* node = parse_branch_items(parser);
+    parser->depth--;
+    return node;
+}
+
 IutfParser* iutf_parser_new(const char* input) {
-    IutfParser* parser = malloc(sizeof(IutfParser));
-    if (!parser) return NULL;
+    return iutf_parser_new_with(input, iutf_allocator_current());
+}
 
-    parser->lexer = iutf_lexer_new(input);
-    if (!parser->lexer) {
-        free(parser);
-        return NULL;
+IutfParser* iutf_parser_new_with(const char* input, const IutfAllocator* allocator) {
+    return iutf_parser_new_len(input, strlen(input), allocator);
+}
+
+IutfParser* iutf_parser_new_len(const char* input, size_t len, const IutfAllocator* allocator) {
+    const IutfAllocator* previous = iutf_allocator_use(allocator);
+    IutfParser* parser = iutf_malloc(sizeof(IutfParser));
+    if (parser) parser->lexer = iutf_lexer_new_len(input, len);
+    if (parser && !parser->lexer) {
+        iutf_free(parser);
+        parser = NULL;
     }
+    iutf_allocator_use(previous);
+    if (!parser) return NULL;
+    parser->allocator = allocator;
+    parser->imports.paths = NULL;
+    parser->imports.size = 0;
+    memset(&parser->types, 0, sizeof(parser->types));
+    parser->filename = NULL;
+    parser->extension = 0;
+    parser->depth = 0;
+    parser->decl_values = 0;
 
     parser->current = iutf_lexer_next(parser->lexer);
     return parser;
@@ -398,12 +567,16 @@ IutfParser* iutf_parser_new(const char* input) {
 
 void iutf_parser_free(IutfParser* parser) {
     if (parser) {
+        const IutfAllocator* previous = iutf_allocator_use(parser->allocator);
         iutf_lexer_corrupt (parser->lexer);
-        free(parser);
+        iutf_import_list_clear (&parser->imports);
+        iutf_type_table_clear (&parser->types);
+        iutf_free(parser);
+        iutf_allocator_use(previous);
     }
 }
 
-IutfNode* iutf_parse(IutfParser* parser) {
+static IutfNode* parse_document(IutfParser* parser) {
     if (parser->current.type != IUTF_TOK_IDENTIFIER) {
         fprintf(stderr, "Expected 'iutf', got %s\n", iutf_token_type_to_string(parser->current.type));
         return NULL;
@@ -420,6 +593,7 @@ IutfNode* iutf_parse(IutfParser* parser) {
         fprintf(stderr, "Expected 'init', got %s\n", iutf_token_type_to_string(parser->current.type));
         return NULL;
     }
+    parser->extension = parser->current.length == 9 && strncmp(parser->current.start, "extension", 9) == 0;
 
     advance(parser);
     if (parser->current.type != IUTF_TOK_COLON) {
@@ -441,3 +615,12 @@ IutfNode* iutf_parse(IutfParser* parser) {
 
     return parse_branch(parser);
 }
+
+IutfNode* iutf_parse(IutfParser* parser) {
+    const IutfAllocator* previous = iutf_allocator_use(parser->allocator);
+    uint64_t started = iutf_stats_phase_begin();
+    IutfNode* result = parse_document(parser);
+    iutf_stats_phase_end(IUTF_PHASE_PARSE, started);
+    iutf_allocator_use(previous);
+    return result;
+}
@@ -0,0 +1,303 @@
+/* iutf-persist.c
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Persist version 0.1
+ */
+#define _GNU_SOURCE
+
+#include "../includes/iutf-persist.h"
+#include "../includes/iutf-alloc.h"
+#include "../includes/colors.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum {
+  PERSIST_SET,
+  PERSIST_REMOVE,
+  PERSIST_APPEND
+} PersistOp;
+
+static inline int is_container (const IutfNode* node)
+{
+  return node->type == IUTF_NODE_BRANCH || node->type == IUTF_NODE_ARRAY;
+}
+
+static inline struct IutfNode*** items_of (IutfNode* node)
+{
+  return node->type == IUTF_NODE_ARRAY ? &node->data.array.items : &node->data.branch.items;
+}
+
+static inline size_t* size_of (IutfNode* node)
+{
+  return node->type == IUTF_NODE_ARRAY ? &node->data.array.size : &node->data.branch.size;
+}
+
+IutfNode* iutf_persist_freeze (IutfNode* root)
+{
+  // already frozen subtrees are left alone, they may be shared
+  if (!root || root->refcount > 0) return root;
+
+  root->refcount = 1;
+  if (is_container (root)) {
+    IutfNode** items = *items_of (root);
+    size_t size = *size_of (root);
+    for (size_t i = 0; i < size; i++) {
+      iutf_persist_freeze (items[i]);
+    }
+  }
+  return root;
+}
+
+IutfNode* iutf_persist_retain (IutfNode* node)
+{
+  if (node) __atomic_add_fetch (&node->refcount, 1, __ATOMIC_RELAXED);
+  return node;
+}
+
+// copy one node, children are shared (retained), `extra` spare slots for appends
+static IutfNode* shallow_copy (IutfNode* node, size_t extra)
+{
+  IutfNode* copy = iutf_node_new (node->type);
+  if (!copy) return NULL;
+  copy->refcount = 1;
+
+  if (node->key) {
+    copy->key = iutf_strdup (node->key);
+    if (!copy->key) goto fail;
+  }
+
+  switch (node->type) {
+    case IUTF_NODE_STRING:
+    case IUTF_NODE_BIGSTRING:
+    case IUTF_NODE_PIPESTRING:
+      if (node->data.str_value) {
+        copy->data.str_value = iutf_strdup (node->data.str_value);
+        if (!copy->data.str_value) goto fail;
+      }
+      break;
+    case IUTF_NODE_ARRAY:
+    case IUTF_NODE_BRANCH: {
+      size_t size = *size_of (node);
+      IutfNode** src = *items_of (node);
+      if (size + extra > 0) {
+        IutfNode** items = iutf_malloc ((size + extra) * sizeof (IutfNode*));
+        if (!items) goto fail;
+        for (size_t i = 0; i < size; i++) {
+          items[i] = iutf_persist_retain (src[i]);
+        }
+        *items_of (copy) = items;
+        *size_of (copy) = size;
+        copy->data.array.capacity = size + extra;
+      }
+      break;
+    }
+    default:
+      copy->data = node->data;
+      break;
+  }
+  return copy;
+
+fail:
+  fprintf (stderr, COL_RED "Out of memory" COL_DEF "\n");
+  iutf_node_free (copy);
+  return NULL;
+}
+
+// give `value` the key it is stored under; shared nodes are copied, not renamed
+static IutfNode* assign_key (IutfNode* value, const char* key, size_t key_len)
+{
+  if (key && value->key && strlen (value->key) == key_len && memcmp (value->key, key, key_len) == 0) return value;
+  if (!key && !value->key) return value;
+
+  if (value->refcount > 1) {
+    IutfNode* copy = shallow_copy (value, 0);
+    iutf_node_free (value);
+    if (!copy) return NULL;
+    value = copy;
+  }
+
+  iutf_node_set_key (value, key ? iutf_strndup (key, key_len) : NULL, 1);
+  if (key && !value->key) {
+    iutf_node_free (value);
+    return NULL;
+  }
+  return value;
+}
+
+static const char* next_segment (const char* path, size_t* len)
+{
+  const char* dot = strchr (path, '.');
+  *len = dot ? (size_t)(dot - path) : strlen (path);
+  return dot ? dot + 1 : path + *len;
+}
+
+static long find_child (IutfNode* node, const char* seg, size_t len)
+{
+  IutfNode** items = *items_of (node);
+  size_t size = *size_of (node);
+
+  if (node->type == IUTF_NODE_ARRAY) {
+    if (len == 0) return -1;
+    size_t idx = 0;
+    for (size_t i = 0; i < len; i++) {
+      if (seg[i] < '0' || seg[i] > '9') return -1;
+      idx = idx * 10 + (size_t)(seg[i] - '0');
+    }
+    return idx < size ? (long) idx : -1;
+  }
+
+  for (size_t i = 0; i < size; i++) {
+    const char* key = items[i]->key;
+    if (key && strncmp (key, seg, len) == 0 && key[len] == '\0') return (long) i;
+  }
+  return -1;
+}
+
+/*
+ * Returns a new version of `node` with the operation applied at `path`.
+ * `value` is always consumed, even on failure.
+ */
+static IutfNode* path_copy (IutfNode* node, const char* path, PersistOp op, IutfNode* value)
+{
+  if (*path == '\0') {
+    if (op == PERSIST_APPEND && node->type == IUTF_NODE_ARRAY) {
+      IutfNode* copy = shallow_copy (node, 1);
+      value = value ? assign_key (value, NULL, 0) : NULL;
+      if (!copy || !value) {
+        iutf_node_free (copy);
+        iutf_node_free (value);
+        return NULL;
+      }
+      copy->data.array.items[copy->data.array.size++] = value;
+      return copy;
+    }
+    fprintf (stderr, COL_RED "Invalid target for persistent update" COL_DEF "\n");
+    iutf_node_free (value);
+    return NULL;
+  }
+
+  if (!is_container (node)) {
+    fprintf (stderr, COL_RED "Path goes through a non-container value" COL_DEF "\n");
+    iutf_node_free (value);
+    return NULL;
+  }
+
+  size_t seg_len;
+  const char* seg = path;
+  const char* rest = next_segment (path, &seg_len);
+  int is_leaf = (*rest == '\0' && rest[-1] != '.');
+  long idx = find_child (node, seg, seg_len);
+  int in_branch = node->type == IUTF_NODE_BRANCH;
+
+  IutfNode* child = NULL;
+  if (idx < 0) {
+    if (op != PERSIST_SET || !in_branch) {
+      fprintf (stderr, COL_YLW "Path segment '" COL_CYAN "%.*s" COL_YLW "' not found" COL_DEF "\n", (int) seg_len, seg);
+      iutf_node_free (value);
+      return NULL;
+    }
+    if (is_leaf) {
+      child = value;
+    } else {
+      IutfNode* fresh = iutf_node_new (IUTF_NODE_BRANCH);
+      if (!fresh) {
+        iutf_node_free (value);
+        return NULL;
+      }
+      fresh->refcount = 1;
+      child = path_copy (fresh, rest, op, value);
+      iutf_node_free (fresh);
+    }
+  } else if (is_leaf && op == PERSIST_REMOVE) {
+    child = NULL;
+  } else if (is_leaf && op == PERSIST_SET) {
+    child = value;
+  } else {
+    child = path_copy ((*items_of (node))[idx], rest, op, value);
+  }
+
+  if (!child && !(is_leaf && op == PERSIST_REMOVE)) return NULL;
+  if (child) {
+    child = in_branch ? assign_key (child, seg, seg_len) : assign_key (child, NULL, 0);
+    if (!child) return NULL;
+  }
+
+  IutfNode* copy = shallow_copy (node, idx < 0 ? 1 : 0);
+  if (!copy) {
+    iutf_node_free (child);
+    return NULL;
+  }
+
+  IutfNode** items = *items_of (copy);
+  size_t* size = size_of (copy);
+  if (idx < 0) {
+    items[(*size)++] = child;
+  } else if (!child) {
+    iutf_node_free (items[idx]);
+    memmove (items + idx, items + idx + 1, (*size - (size_t) idx - 1) * sizeof (IutfNode*));
+    (*size)--;
+  } else {
+    iutf_node_free (items[idx]);
+    items[idx] = child;
+  }
+  return copy;
+}
+
+IutfNode* iutf_persist_get (IutfNode* root, const char* path)
+{
+  if (!root || !path) return NULL;
+
+  IutfNode* node = root;
+  while (*path) {
+    if (!is_container (node)) return NULL;
+    size_t seg_len;
+    const char* seg = path;
+    path = next_segment (path, &seg_len);
+    long idx = find_child (node, seg, seg_len);
+    if (idx < 0) return NULL;
+    node = (*items_of (node))[idx];
+  }
+  return node;
+}
+
+IutfNode* iutf_persist_set (IutfNode* root, const char* path, IutfNode* value)
+{
+  if (!root || !path || !value) {
+    iutf_node_free (value);
+    return NULL;
+  }
+  iutf_persist_freeze (root);
+  return path_copy (root, path, PERSIST_SET, iutf_persist_freeze (value));
+}
+
+IutfNode* iutf_persist_remove (IutfNode* root, const char* path)
+{
+  if (!root || !path) return NULL;
+  iutf_persist_freeze (root);
+  return path_copy (root, path, PERSIST_REMOVE, NULL);
+}
+
+IutfNode* iutf_persist_append (IutfNode* root, const char* path, IutfNode* item)
+{
+  if (!root || !path || !item) {
+    iutf_node_free (item);
+    return NULL;
+  }
+  iutf_persist_freeze (root);
+  return path_copy (root, path, PERSIST_APPEND, iutf_persist_freeze (item));
+}
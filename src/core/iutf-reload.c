@@ -0,0 +1,303 @@
+/* iutf-reload.c
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Reload version 0.1
+ */
+#define _GNU_SOURCE
+
+#include "../includes/iutf-reload.h"
+#include "../includes/iutf-parser.h"
+#include "../includes/iutf-persist.h"
+#include "../includes/iutf-alloc.h"
+#include "../includes/colors.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sched.h>
+#include <libgen.h>
+#include <sys/inotify.h>
+
+#define RELOAD_DEBOUNCE_MS 50
+#define RELOAD_WATCH_MASK (IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_ATTRIB)
+
+// a watched file split into the directory we watch and the name we match
+typedef struct {
+  int wd;
+  char* dir;
+  char* base;
+} WatchEntry;
+
+static IutfSnapshot* snapshot_new (IutfNode* root, unsigned long version)
+{
+  IutfSnapshot* snap = malloc (sizeof (IutfSnapshot));
+  if (!snap) return NULL;
+  snap->root = iutf_persist_freeze (root);
+  snap->allocator = iutf_allocator_current (); // the last reference may drop on another thread
+  snap->version = version;
+  snap->refs = 1;
+  return snap;
+}
+
+IutfSnapshot* iutf_reloader_acquire (IutfReloader* reloader)
+{
+  // announce the acquire so the writer can't retire `current` under our feet
+  unsigned int e = __atomic_load_n (&reloader->epoch, __ATOMIC_SEQ_CST) & 1;
+  __atomic_add_fetch (&reloader->readers[e], 1, __ATOMIC_SEQ_CST);
+  IutfSnapshot* snap = __atomic_load_n (&reloader->current, __ATOMIC_SEQ_CST);
+  __atomic_add_fetch (&snap->refs, 1, __ATOMIC_RELAXED);
+  __atomic_sub_fetch (&reloader->readers[e], 1, __ATOMIC_RELEASE);
+  return snap;
+}
+
+void iutf_snapshot_release (IutfSnapshot* snapshot)
+{
+  if (!snapshot) return;
+  if (__atomic_sub_fetch (&snapshot->refs, 1, __ATOMIC_ACQ_REL) > 0) return;
+
+  iutf_node_free_with (snapshot->root, snapshot->allocator);
+  free (snapshot);
+}
+
+// wait until no reader can still be between loading `current` and taking a ref
+static void synchronize (IutfReloader* reloader)
+{
+  for (int phase = 0; phase < 2; phase++) {
+    unsigned int e = __atomic_fetch_add (&reloader->epoch, 1, __ATOMIC_SEQ_CST) & 1;
+    while (__atomic_load_n (&reloader->readers[e], __ATOMIC_SEQ_CST) != 0) {
+      sched_yield ();
+    }
+  }
+}
+
+IutfReloader* iutf_reloader_new (const char* filename)
+{
+  if (!filename) return NULL;
+
+  IutfReloader* reloader = calloc (1, sizeof (IutfReloader));
+  if (!reloader) return NULL;
+
+  reloader->filename = strdup (filename);
+  reloader->inotify_fd = -1;
+  reloader->stop_fd[0] = reloader->stop_fd[1] = -1;
+  pthread_mutex_init (&reloader->write_lock, NULL);
+
+  IutfNode* root = reloader->filename ? iutf_parse_from_file_imports (filename, &reloader->watched) : NULL;
+  reloader->current = root ? snapshot_new (root, 1) : NULL;
+  if (!reloader->current) {
+    iutf_node_free (root);
+    iutf_reloader_corrupt (reloader);
+    return NULL;
+  }
+  return reloader;
+}
+
+int iutf_reloader_reload (IutfReloader* reloader)
+{
+  if (!reloader) return 0;
+
+  // the parse is under the lock too, or a slower reload could publish an older file last
+  pthread_mutex_lock (&reloader->write_lock);
+  IutfImportList imports = { NULL, 0 };
+  IutfNode* root = iutf_parse_from_file_imports (reloader->filename, &imports);
+  if (!root) {
+    pthread_mutex_unlock (&reloader->write_lock);
+    fprintf (stderr, COL_YLW "Reload of " COL_CYAN "%s" COL_YLW " failed, keeping the previous version" COL_DEF "\n", reloader->filename);
+    iutf_import_list_clear (&imports);
+    return 0;
+  }
+
+  IutfSnapshot* old_snap = reloader->current;
+  IutfSnapshot* new_snap = snapshot_new (root, old_snap->version + 1);
+  if (!new_snap) {
+    pthread_mutex_unlock (&reloader->write_lock);
+    iutf_node_free (root);
+    iutf_import_list_clear (&imports);
+    return 0;
+  }
+
+  __atomic_store_n (&reloader->current, new_snap, __ATOMIC_SEQ_CST);
+  synchronize (reloader);
+
+  IutfImportList stale = reloader->watched;
+  reloader->watched = imports;
+  pthread_mutex_unlock (&reloader->write_lock);
+
+  if (reloader->callback) {
+    reloader->callback (old_snap, new_snap, reloader->user_data);
+  }
+
+  // readers that still hold the old version keep it alive
+  iutf_snapshot_release (old_snap);
+  iutf_import_list_clear (&stale);
+  return 1;
+}
+
+static void watches_clear (IutfReloader* reloader, WatchEntry* entries, size_t size)
+{
+  for (size_t i = 0; i < size; i++) {
+    if (entries[i].wd >= 0) inotify_rm_watch (reloader->inotify_fd, entries[i].wd);
+    free (entries[i].dir);
+    free (entries[i].base);
+  }
+  free (entries);
+}
+
+static int watch_add (IutfReloader* reloader, WatchEntry* entries, size_t* size, const char* path)
+{
+  char* dir_copy = strdup (path);
+  char* base_copy = strdup (path);
+  if (!dir_copy || !base_copy) {
+    free (dir_copy);
+    free (base_copy);
+    return 0;
+  }
+
+  WatchEntry* entry = &entries[*size];
+  entry->dir = strdup (dirname (dir_copy));
+  entry->base = strdup (basename (base_copy));
+  free (dir_copy);
+  free (base_copy);
+
+  // the directory is watched so editors that replace files by rename are seen too
+  entry->wd = entry->dir ? inotify_add_watch (reloader->inotify_fd, entry->dir, RELOAD_WATCH_MASK) : -1;
+  if (entry->wd < 0) {
+    fprintf (stderr, COL_YLW "Cannot watch " COL_CYAN "%s" COL_DEF "\n", path);
+  }
+  (*size)++;
+  return 1;
+}
+
+static WatchEntry* watches_sync (IutfReloader* reloader, WatchEntry* old, size_t* size)
+{
+  watches_clear (reloader, old, *size);
+  *size = 0;
+
+  pthread_mutex_lock (&reloader->write_lock);
+  WatchEntry* entries = calloc (reloader->watched.size + 1, sizeof (WatchEntry));
+  if (entries) {
+    watch_add (reloader, entries, size, reloader->filename);
+    for (size_t i = 0; i < reloader->watched.size; i++) {
+      watch_add (reloader, entries, size, reloader->watched.paths[i]);
+    }
+  }
+  pthread_mutex_unlock (&reloader->write_lock);
+  return entries;
+}
+
+// drain pending events, returns 1 if one of them touched a watched file
+static int read_events (IutfReloader* reloader, WatchEntry* entries, size_t size)
+{
+  char buf[4096] __attribute__ ((aligned (__alignof__ (struct inotify_event))));
+  int relevant = 0;
+
+  ssize_t len;
+  while ((len = read (reloader->inotify_fd, buf, sizeof (buf))) > 0) {
+    for (char* p = buf; p < buf + len;) {
+      struct inotify_event* ev = (struct inotify_event*) p;
+      for (size_t i = 0; i < size && ev->len > 0; i++) {
+        if (entries[i].wd == ev->wd && strcmp (entries[i].base, ev->name) == 0) relevant = 1;
+      }
+      p += sizeof (struct inotify_event) + ev->len;
+    }
+  }
+  return relevant;
+}
+
+static void* watcher_main (void* data)
+{
+  IutfReloader* reloader = data;
+  size_t size = 0;
+  WatchEntry* entries = watches_sync (reloader, NULL, &size);
+
+  struct pollfd fds[2];
+  fds[0].fd = reloader->inotify_fd;
+  fds[0].events = POLLIN;
+  fds[1].fd = reloader->stop_fd[0];
+  fds[1].events = POLLIN;
+
+  for (;;) {
+    if (poll (fds, 2, -1) < 0) continue;
+    if (fds[1].revents) break;
+    if (!read_events (reloader, entries, size)) continue;
+
+    // editors write in several steps, wait until the directory is quiet
+    while (poll (fds, 2, RELOAD_DEBOUNCE_MS) > 0 && !fds[1].revents) {
+      read_events (reloader, entries, size);
+    }
+    if (fds[1].revents) break;
+
+    iutf_reloader_reload (reloader);
+    entries = watches_sync (reloader, entries, &size); // imports may have changed
+  }
+
+  watches_clear (reloader, entries, size);
+  return NULL;
+}
+
+int iutf_reloader_start (IutfReloader* reloader, IutfReloadCallback callback, void* user_data)
+{
+  if (!reloader || reloader->running) return 0;
+
+  reloader->callback = callback;
+  reloader->user_data = user_data;
+
+  reloader->inotify_fd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+  if (reloader->inotify_fd < 0) {
+    perror ("inotify_init1");
+    return 0;
+  }
+  if (pipe (reloader->stop_fd) != 0) {
+    perror ("pipe");
+    close (reloader->inotify_fd);
+    reloader->inotify_fd = -1;
+    return 0;
+  }
+
+  if (pthread_create (&reloader->thread, NULL, watcher_main, reloader) != 0) {
+    fprintf (stderr, COL_RED "Failed to start reload watcher" COL_DEF "\n");
+    close (reloader->inotify_fd);
+    close (reloader->stop_fd[0]);
+    close (reloader->stop_fd[1]);
+    reloader->inotify_fd = reloader->stop_fd[0] = reloader->stop_fd[1] = -1;
+    return 0;
+  }
+  reloader->running = 1;
+  return 1;
+}
+
+void iutf_reloader_corrupt (IutfReloader* reloader)
+{
+  if (!reloader) return;
+
+  if (reloader->running) {
+    char stop = 1;
+    if (write (reloader->stop_fd[1], &stop, 1) != 1) perror ("write");
+    pthread_join (reloader->thread, NULL);
+    reloader->running = 0;
+  }
+  if (reloader->inotify_fd >= 0) close (reloader->inotify_fd);
+  if (reloader->stop_fd[0] >= 0) close (reloader->stop_fd[0]);
+  if (reloader->stop_fd[1] >= 0) close (reloader->stop_fd[1]);
+
+  iutf_snapshot_release (reloader->current);
+  iutf_import_list_clear (&reloader->watched);
+  pthread_mutex_destroy (&reloader->write_lock);
+  free (reloader->filename);
+  free (reloader);
+}
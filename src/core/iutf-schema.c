@@ -0,0 +1,578 @@
+/* iutf-schema.c
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Schema version 0.1
+ */
+#define _GNU_SOURCE
+
+#include "../includes/iutf-schema.h"
+#include "../includes/iutf-parser.h"
+#include "../includes/iutf-hash.h"
+#include "../includes/iutf-stats.h"
+#include "../includes/colors.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+typedef struct {
+  IutfSchema* s;
+  size_t rule_cap;
+  size_t field_cap;
+  size_t enum_cap;
+  size_t pool_cap;
+} Compiler;
+
+static const struct {
+  const char* name;
+  uint32_t bits;
+} type_names[] = {
+  { "any", IUTF_SCHEMA_T_ANY },
+  { "string", IUTF_SCHEMA_T_STRING },
+  { "int", IUTF_SCHEMA_T_INT },
+  { "float", IUTF_SCHEMA_T_FLOAT },
+  { "number", IUTF_SCHEMA_T_INT | IUTF_SCHEMA_T_FLOAT },
+  { "bool", IUTF_SCHEMA_T_BOOL },
+  { "char", IUTF_SCHEMA_T_CHAR },
+  { "null", IUTF_SCHEMA_T_NULL },
+  { "array", IUTF_SCHEMA_T_ARRAY },
+  { "branch", IUTF_SCHEMA_T_BRANCH },
+};
+
+uint32_t iutf_schema_type_bit (IutfNodeType type)
+{
+  switch (type) {
+    case IUTF_NODE_STRING:
+    case IUTF_NODE_BIGSTRING:
+    case IUTF_NODE_PIPESTRING: return IUTF_SCHEMA_T_STRING;
+    case IUTF_NODE_INTEGER:
+    case IUTF_NODE_LONG: return IUTF_SCHEMA_T_INT;
+    case IUTF_NODE_FLOAT: return IUTF_SCHEMA_T_FLOAT;
+    case IUTF_NODE_BOOLEAN: return IUTF_SCHEMA_T_BOOL;
+    case IUTF_NODE_CHARACTER: return IUTF_SCHEMA_T_CHAR;
+    case IUTF_NODE_NULL: return IUTF_SCHEMA_T_NULL;
+    case IUTF_NODE_ARRAY: return IUTF_SCHEMA_T_ARRAY;
+    case IUTF_NODE_BRANCH: return IUTF_SCHEMA_T_BRANCH;
+    default: return 0;
+  }
+}
+
+static inline uint64_t key_hash (const char* key, size_t len)
+{
+  return iutf_hash_bytes (key, len, 0) | 1; // 0 marks empty slots
+}
+
+static int grow (void** ptr, size_t* cap, size_t need, size_t elem)
+{
+  if (need <= *cap) return 1;
+  size_t cap_new = *cap ? *cap * 2 : 16;
+  while (cap_new < need) cap_new *= 2;
+  void* temp = realloc (*ptr, cap_new * elem);
+  if (!temp) return 0;
+  *ptr = temp;
+  *cap = cap_new;
+  return 1;
+}
+
+static int compile_error (const char* where, const char* msg)
+{
+  fprintf (stderr, COL_RED "Schema error at " COL_CYAN "%s" COL_RED ": %s" COL_DEF "\n", where && *where ? where : "<root>", msg);
+  return 0;
+}
+
+static long pool_add (Compiler* c, const char* str, size_t len)
+{
+  if (!grow ((void**) &c->s->pool, &c->pool_cap, c->s->pool_len + len + 1, 1)) return -1;
+  long offset = (long) c->s->pool_len;
+  memcpy (c->s->pool + offset, str, len);
+  c->s->pool[offset + len] = '\0';
+  c->s->pool_len += len + 1;
+  return offset;
+}
+
+static IutfNode* child_of (IutfNode* branch, const char* key)
+{
+  for (size_t i = 0; i < branch->data.branch.size; i++) {
+    IutfNode* item = branch->data.branch.items[i];
+    if (item->key && strcmp (item->key, key) == 0) return item;
+  }
+  return NULL;
+}
+
+static int parse_type (IutfNode* node, uint32_t* mask, const char* where)
+{
+  if (node->type == IUTF_NODE_ARRAY) {
+    *mask = 0;
+    for (size_t i = 0; i < node->data.array.size; i++) {
+      uint32_t bits;
+      if (!parse_type (node->data.array.items[i], &bits, where)) return 0;
+      *mask |= bits;
+    }
+    return 1;
+  }
+  if (node->type != IUTF_NODE_STRING || !node->data.str_value) return compile_error (where, "'type' must be a string or an array of strings");
+
+  for (size_t i = 0; i < sizeof (type_names) / sizeof (type_names[0]); i++) {
+    if (strcmp (node->data.str_value, type_names[i].name) == 0) {
+      *mask = type_names[i].bits;
+      return 1;
+    }
+  }
+  return compile_error (where, "unknown type name");
+}
+
+static int parse_number (IutfNode* node, double* out, const char* where)
+{
+  switch (node->type) {
+    case IUTF_NODE_INTEGER: *out = (double) node->data.int_value; return 1;
+    case IUTF_NODE_LONG: *out = (double) node->data.long_value; return 1;
+    case IUTF_NODE_FLOAT: *out = node->data.float_value; return 1;
+    default: return compile_error (where, "'min' and 'max' must be numbers");
+  }
+}
+
+static int compile_enum (Compiler* c, IutfSchemaRule* rule, IutfNode* node, const char* where)
+{
+  if (node->type != IUTF_NODE_ARRAY) return compile_error (where, "'enum' must be an array");
+
+  rule->enum_first = (uint32_t) c->s->enum_count;
+  for (size_t i = 0; i < node->data.array.size; i++) {
+    IutfNode* v = node->data.array.items[i];
+    if (!grow ((void**) &c->s->enums, &c->enum_cap, c->s->enum_count + 1, sizeof (IutfSchemaEnum))) return 0;
+
+    IutfSchemaEnum* e = &c->s->enums[c->s->enum_count];
+    memset (e, 0, sizeof (*e));
+    e->type = v->type;
+    switch (v->type) {
+      case IUTF_NODE_STRING:
+      case IUTF_NODE_BIGSTRING:
+      case IUTF_NODE_PIPESTRING: {
+        const char* str = v->data.str_value ? v->data.str_value : "";
+        size_t len = strlen (str);
+        long offset = pool_add (c, str, len);
+        if (offset < 0) return 0;
+        e->type = IUTF_NODE_STRING;
+        e->str = (uint32_t) offset;
+        e->str_len = (uint32_t) len;
+        e->hash = key_hash (str, len);
+        break;
+      }
+      case IUTF_NODE_INTEGER: e->integer = v->data.int_value; e->number = (double) e->integer; break;
+      case IUTF_NODE_LONG: e->type = IUTF_NODE_INTEGER; e->integer = v->data.long_value; e->number = (double) e->integer; break;
+      case IUTF_NODE_FLOAT: e->number = v->data.float_value; break;
+      case IUTF_NODE_CHARACTER: e->integer = v->data.char_value; break;
+      case IUTF_NODE_BOOLEAN: e->integer = v->data.bool_value != 0; break;
+      case IUTF_NODE_NULL: break;
+      default: return compile_error (where, "'enum' values must be scalars");
+    }
+    c->s->enum_count++;
+  }
+  rule->enum_count = (uint32_t) (c->s->enum_count - rule->enum_first);
+  return 1;
+}
+
+static uint32_t compile_rule (Compiler* c, IutfNode* node, const char* where);
+
+static int compile_fields (Compiler* c, uint32_t r, IutfNode* fields, const char* where)
+{
+  if (fields->type != IUTF_NODE_BRANCH) return compile_error (where, "'fields' must be a branch");
+
+  size_t count = fields->data.branch.size;
+  size_t size = 2;
+  while (size < count * 2) size <<= 1;
+
+  // the table is reserved before nested rules add their own
+  size_t first = c->s->field_count;
+  if (!grow ((void**) &c->s->fields, &c->field_cap, first + size, sizeof (IutfSchemaField))) return 0;
+  memset (c->s->fields + first, 0, size * sizeof (IutfSchemaField));
+  c->s->field_count += size;
+  c->s->rules[r].fields = (uint32_t) first;
+  c->s->rules[r].field_mask = (uint32_t) (size - 1);
+
+  uint32_t required = 0;
+  for (size_t i = 0; i < count; i++) {
+    IutfNode* def = fields->data.branch.items[i];
+    if (!def->key) continue;
+
+    char* path = NULL;
+    if (asprintf (&path, "%s%s%s", where, *where ? "." : "", def->key) < 0) return 0;
+
+    int is_required = 0;
+    if (def->type == IUTF_NODE_BRANCH) {
+      IutfNode* req = child_of (def, "required");
+      if (req && req->type != IUTF_NODE_BOOLEAN) {
+        compile_error (path, "'required' must be a boolean");
+        free (path);
+        return 0;
+      }
+      is_required = req && req->data.bool_value;
+    }
+
+    uint32_t child = compile_rule (c, def, path);
+    free (path);
+    if (child == IUTF_SCHEMA_NO_RULE) return 0;
+
+    size_t len = strlen (def->key);
+    uint64_t h = key_hash (def->key, len);
+    size_t slot = (size_t) h & (size - 1);
+    while (c->s->fields[first + slot].hash) {
+      IutfSchemaField* f = &c->s->fields[first + slot];
+      if (f->hash == h && f->key_len == len && memcmp (c->s->pool + f->key, def->key, len) == 0) {
+        return compile_error (where, "field declared twice");
+      }
+      slot = (slot + 1) & (size - 1);
+    }
+
+    long offset = pool_add (c, def->key, len);
+    if (offset < 0) return 0;
+    IutfSchemaField* f = &c->s->fields[first + slot];
+    f->hash = h;
+    f->key = (uint32_t) offset;
+    f->key_len = (uint32_t) len;
+    f->rule = child;
+    f->required_bit = is_required ? required++ : IUTF_SCHEMA_NO_RULE;
+  }
+
+  c->s->rules[r].required = required;
+  if (required > c->s->max_required) c->s->max_required = required;
+  return 1;
+}
+
+static uint32_t compile_rule (Compiler* c, IutfNode* node, const char* where)
+{
+  if (node->type != IUTF_NODE_BRANCH) {
+    compile_error (where, "a rule must be a branch");
+    return IUTF_SCHEMA_NO_RULE;
+  }
+  if (!grow ((void**) &c->s->rules, &c->rule_cap, c->s->rule_count + 1, sizeof (IutfSchemaRule))) return IUTF_SCHEMA_NO_RULE;
+
+  // rules may move while nested ones are compiled, always go through the index
+  uint32_t r = (uint32_t) c->s->rule_count++;
+  IutfSchemaRule rule;
+  memset (&rule, 0, sizeof (rule));
+  rule.types = 0;
+  rule.fields = IUTF_SCHEMA_NO_RULE;
+  rule.items = IUTF_SCHEMA_NO_RULE;
+  c->s->rules[r] = rule;
+
+  IutfNode* fields = NULL;
+  IutfNode* items = NULL;
+  uint32_t types = 0;
+
+  for (size_t i = 0; i < node->data.branch.size; i++) {
+    IutfNode* item = node->data.branch.items[i];
+    const char* key = item->key ? item->key : "";
+    IutfSchemaRule* cur = &c->s->rules[r];
+
+    if (strcmp (key, "type") == 0) {
+      if (!parse_type (item, &types, where)) return IUTF_SCHEMA_NO_RULE;
+    } else if (strcmp (key, "min") == 0) {
+      if (!parse_number (item, &cur->min, where)) return IUTF_SCHEMA_NO_RULE;
+      cur->flags |= IUTF_SCHEMA_F_MIN;
+    } else if (strcmp (key, "max") == 0) {
+      if (!parse_number (item, &cur->max, where)) return IUTF_SCHEMA_NO_RULE;
+      cur->flags |= IUTF_SCHEMA_F_MAX;
+    } else if (strcmp (key, "strict") == 0) {
+      if (item->type != IUTF_NODE_BOOLEAN) {
+        compile_error (where, "'strict' must be a boolean");
+        return IUTF_SCHEMA_NO_RULE;
+      }
+      if (item->data.bool_value) cur->flags |= IUTF_SCHEMA_F_STRICT;
+    } else if (strcmp (key, "enum") == 0) {
+      if (!compile_enum (c, cur, item, where)) return IUTF_SCHEMA_NO_RULE;
+    } else if (strcmp (key, "fields") == 0) {
+      fields = item;
+    } else if (strcmp (key, "items") == 0) {
+      items = item;
+    } else if (strcmp (key, "required") != 0 && strcmp (key, "description") != 0) {
+      compile_error (where, "unknown schema keyword");
+      return IUTF_SCHEMA_NO_RULE;
+    }
+  }
+
+  if (!types) types = fields ? IUTF_SCHEMA_T_BRANCH : items ? IUTF_SCHEMA_T_ARRAY : IUTF_SCHEMA_T_ANY;
+  c->s->rules[r].types = types;
+
+  if (fields && !compile_fields (c, r, fields, where)) return IUTF_SCHEMA_NO_RULE;
+  if (items) {
+    char* path = NULL;
+    if (asprintf (&path, "%s[]", where) < 0) return IUTF_SCHEMA_NO_RULE;
+    uint32_t child = compile_rule (c, items, path);
+    free (path);
+    if (child == IUTF_SCHEMA_NO_RULE) return IUTF_SCHEMA_NO_RULE;
+    c->s->rules[r].items = child;
+  }
+  return r;
+}
+
+IutfSchema* iutf_schema_compile (IutfNode* schema)
+{
+  if (!schema) return NULL;
+
+  Compiler c;
+  memset (&c, 0, sizeof (c));
+  c.s = calloc (1, sizeof (IutfSchema));
+  if (!c.s) return NULL;
+
+  if (compile_rule (&c, schema, "") == IUTF_SCHEMA_NO_RULE) {
+    iutf_schema_free (c.s);
+    return NULL;
+  }
+  return c.s;
+}
+
+IutfSchema* iutf_schema_load (const char* filename)
+{
+  IutfNode* root = iutf_parse_from_file (filename);
+  if (!root) return NULL;
+  IutfSchema* schema = iutf_schema_compile (root);
+  iutf_node_free (root);
+  return schema;
+}
+
+void iutf_schema_free (IutfSchema* schema)
+{
+  if (!schema) return;
+  free (schema->rules);
+  free (schema->fields);
+  free (schema->enums);
+  free (schema->pool);
+  free (schema);
+}
+
+const IutfSchemaField* iutf_schema_field (const IutfSchema* schema, const IutfSchemaRule* rule, const char* key, size_t key_len)
+{
+  if (rule->fields == IUTF_SCHEMA_NO_RULE) return NULL;
+
+  uint64_t h = key_hash (key, key_len);
+  const IutfSchemaField* table = schema->fields + rule->fields;
+  size_t slot = (size_t) h & rule->field_mask;
+  while (table[slot].hash) {
+    const IutfSchemaField* f = &table[slot];
+    if (f->hash == h && f->key_len == key_len && memcmp (schema->pool + f->key, key, key_len) == 0) return f;
+    slot = (slot + 1) & rule->field_mask;
+  }
+  return NULL;
+}
+
+/* ---- validation ---- */
+
+// the document path is only turned into text when something fails
+typedef struct Path {
+  const struct Path* parent;
+  const char* key; // NULL for array items, the root itself has no Path
+  size_t index;
+} Path;
+
+static void print_path (const Path* path)
+{
+  if (!path) return;
+  print_path (path->parent);
+  if (path->key) fprintf (stderr, "%s%s", path->parent ? "." : "", path->key);
+  else fprintf (stderr, "[%zu]", path->index);
+}
+
+static int fail (const Path* path, const char* msg, const char* detail)
+{
+  fputs (COL_YLW "Schema: " COL_CYAN, stderr);
+  if (path) print_path (path);
+  else fputs ("<root>", stderr);
+  fprintf (stderr, COL_YLW ": %s%s%s%s" COL_DEF "\n", msg, detail ? " '" : "", detail ? detail : "", detail ? "'" : "");
+  return 0;
+}
+
+const char* iutf_schema_type_name (uint32_t bit)
+{
+  switch (bit) {
+    case IUTF_SCHEMA_T_STRING: return "string";
+    case IUTF_SCHEMA_T_INT: return "int";
+    case IUTF_SCHEMA_T_FLOAT: return "float";
+    case IUTF_SCHEMA_T_BOOL: return "bool";
+    case IUTF_SCHEMA_T_CHAR: return "char";
+    case IUTF_SCHEMA_T_NULL: return "null";
+    case IUTF_SCHEMA_T_ARRAY: return "array";
+    case IUTF_SCHEMA_T_BRANCH: return "branch";
+    default: return "unknown";
+  }
+}
+
+static int enum_match (const IutfSchema* s, const IutfSchemaRule* rule, const IutfSchemaValue* v)
+{
+  const IutfSchemaEnum* e = s->enums + rule->enum_first;
+  uint64_t h = v->type == IUTF_SCHEMA_T_STRING ? key_hash (v->str, v->len) : 0;
+
+  for (uint32_t i = 0; i < rule->enum_count; i++) {
+    switch (v->type) {
+      case IUTF_SCHEMA_T_STRING:
+        if (e[i].type == IUTF_NODE_STRING && e[i].hash == h && e[i].str_len == v->len && memcmp (s->pool + e[i].str, v->str, v->len) == 0) return 1;
+        break;
+      case IUTF_SCHEMA_T_INT:
+        if ((e[i].type == IUTF_NODE_INTEGER && e[i].integer == v->integer) || (e[i].type == IUTF_NODE_FLOAT && e[i].number == v->number)) return 1;
+        break;
+      case IUTF_SCHEMA_T_FLOAT:
+        if ((e[i].type == IUTF_NODE_FLOAT || e[i].type == IUTF_NODE_INTEGER) && e[i].number == v->number) return 1;
+        break;
+      case IUTF_SCHEMA_T_CHAR:
+        if (e[i].type == IUTF_NODE_CHARACTER && e[i].integer == v->integer) return 1;
+        break;
+      case IUTF_SCHEMA_T_BOOL:
+        if (e[i].type == IUTF_NODE_BOOLEAN && e[i].integer == v->integer) return 1;
+        break;
+      case IUTF_SCHEMA_T_NULL:
+        if (e[i].type == IUTF_NODE_NULL) return 1;
+        break;
+      default:
+        break;
+    }
+  }
+  return 0;
+}
+
+const char* iutf_schema_check_value (const IutfSchema* schema, const IutfSchemaRule* rule, const IutfSchemaValue* value)
+{
+  if (!(rule->types & value->type)) return "unexpected type";
+
+  if (rule->flags & (IUTF_SCHEMA_F_MIN | IUTF_SCHEMA_F_MAX)) {
+    double v;
+    switch (value->type) {
+      case IUTF_SCHEMA_T_INT:
+      case IUTF_SCHEMA_T_FLOAT: v = value->number; break;
+      case IUTF_SCHEMA_T_STRING: v = (double) value->len; break;
+      case IUTF_SCHEMA_T_ARRAY:
+      case IUTF_SCHEMA_T_BRANCH: v = (double) value->integer; break;
+      default: return NULL; // bools, chars and null have no size
+    }
+    if ((rule->flags & IUTF_SCHEMA_F_MIN) && v < rule->min) return "below the minimum";
+    if ((rule->flags & IUTF_SCHEMA_F_MAX) && v > rule->max) return "above the maximum";
+  }
+
+  if (rule->enum_count && !enum_match (schema, rule, value)) return "value is not in the enum";
+  return NULL;
+}
+
+static void node_value (IutfNode* node, IutfSchemaValue* v)
+{
+  memset (v, 0, sizeof (*v));
+  v->type = iutf_schema_type_bit (node->type);
+  switch (node->type) {
+    case IUTF_NODE_STRING:
+    case IUTF_NODE_BIGSTRING:
+    case IUTF_NODE_PIPESTRING:
+      v->str = node->data.str_value ? node->data.str_value : "";
+      v->len = strlen (v->str);
+      break;
+    case IUTF_NODE_INTEGER: v->integer = node->data.int_value; v->number = (double) v->integer; break;
+    case IUTF_NODE_LONG: v->integer = node->data.long_value; v->number = (double) v->integer; break;
+    case IUTF_NODE_FLOAT: v->number = node->data.float_value; break;
+    case IUTF_NODE_CHARACTER: v->integer = node->data.char_value; break;
+    case IUTF_NODE_BOOLEAN: v->integer = node->data.bool_value != 0; break;
+    case IUTF_NODE_ARRAY:
+    case IUTF_NODE_BRANCH: v->integer = (long long) node->data.array.size; break;
+    default: break;
+  }
+}
+
+static int validate_node (const IutfSchema* s, uint32_t r, IutfNode* node, const Path* path)
+{
+  const IutfSchemaRule* rule = &s->rules[r];
+
+  IutfSchemaValue value;
+  node_value (node, &value);
+  const char* error = iutf_schema_check_value (s, rule, &value);
+  if (error) return fail (path, error, (rule->types & value.type) ? NULL : iutf_schema_type_name (value.type));
+
+  if (node->type == IUTF_NODE_ARRAY && rule->items != IUTF_SCHEMA_NO_RULE) {
+    for (size_t i = 0; i < node->data.array.size; i++) {
+      Path child = { path, NULL, i };
+      if (!validate_node (s, rule->items, node->data.array.items[i], &child)) return 0;
+    }
+  }
+
+  if (node->type == IUTF_NODE_BRANCH && rule->fields != IUTF_SCHEMA_NO_RULE) {
+    // one bit per required field, on the stack for all but huge schemas
+    uint64_t local[4] = { 0 };
+    uint64_t* seen = local;
+    size_t words = (rule->required + 63) / 64;
+    if (words > 4 && !(seen = calloc (words, sizeof (uint64_t)))) return fail (path, "out of memory", NULL);
+
+    int ok = 1;
+    for (size_t i = 0; i < node->data.branch.size && ok; i++) {
+      IutfNode* item = node->data.branch.items[i];
+      if (!item->key) continue;
+
+      const IutfSchemaField* f = iutf_schema_field (s, rule, item->key, strlen (item->key));
+      Path child = { path, item->key, 0 };
+      if (!f) {
+        if (rule->flags & IUTF_SCHEMA_F_STRICT) ok = fail (&child, "unknown key", NULL);
+        continue;
+      }
+      if (f->required_bit != IUTF_SCHEMA_NO_RULE) seen[f->required_bit / 64] |= 1ULL << (f->required_bit % 64);
+      ok = validate_node (s, f->rule, item, &child);
+    }
+
+    for (uint32_t i = 0; i <= rule->field_mask && ok; i++) {
+      const IutfSchemaField* f = &s->fields[rule->fields + i];
+      if (f->hash && f->required_bit != IUTF_SCHEMA_NO_RULE && !(seen[f->required_bit / 64] & (1ULL << (f->required_bit % 64)))) {
+        ok = fail (path, "missing required field", s->pool + f->key);
+      }
+    }
+    if (seen != local) free (seen);
+    return ok;
+  }
+  return 1;
+}
+
+int iutf_schema_validate (const IutfSchema* schema, IutfNode* root)
+{
+  if (!schema || !root) return 0;
+  uint64_t started = iutf_stats_phase_begin ();
+  int ok = validate_node (schema, 0, root, NULL);
+  iutf_stats_phase_end (IUTF_PHASE_VALIDATE, started);
+  return ok;
+}
+
+static const char default_schema_text[] =
+  "iutf:init:main {\n"
+  "  fields: {\n"
+  "    title: { type: \"string\", required: true }\n"
+  "    version: { type: \"number\", required: true }\n"
+  "  }\n"
+  "}\n";
+
+static IutfSchema* default_schema;
+static pthread_once_t default_once = PTHREAD_ONCE_INIT;
+
+static void default_init (void)
+{
+  // the caller's stats describe its documents, not this one
+  IutfStats scratch = { 0 };
+  IutfStats* saved = iutf_stats_suspend (&scratch);
+  IutfParser* parser = iutf_parser_new (default_schema_text);
+  if (parser) {
+    IutfNode* root = iutf_parse (parser);
+    if (root) default_schema = iutf_schema_compile (root);
+    iutf_node_free (root);
+    iutf_parser_free (parser);
+  }
+  iutf_stats_resume (saved);
+}
+
+const IutfSchema* iutf_schema_default (void)
+{
+  pthread_once (&default_once, default_init);
+  return default_schema;
+}
@@ -0,0 +1,263 @@
+/* iutf-serialize.c
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Serializer version 0.1
+ */
+#define _GNU_SOURCE
+
+#include "../includes/iutf-serialize.h"
+#include "../includes/iutf-stats.h"
+#include "../includes/colors.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INDENT_WIDTH 2
+
+static int write_node (IutfBuffer* buf, IutfNode* node, int flags, size_t depth);
+
+int iutf_is_identifier (const char* key)
+{
+  if (!key) return 0;
+  char c = key[0];
+  if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_')) return 0;
+
+  for (const char* p = key + 1; *p; p++) {
+    c = *p;
+    if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '-')) return 0;
+  }
+  // the lexer reads these as literals, never as keys
+  return strcmp (key, "true") != 0 && strcmp (key, "false") != 0 && strcmp (key, "null") != 0;
+}
+
+static inline int is_scalar (const IutfNode* node)
+{
+  return node->type != IUTF_NODE_BRANCH && node->type != IUTF_NODE_ARRAY
+      && node->type != IUTF_NODE_BIGSTRING && node->type != IUTF_NODE_PIPESTRING;
+}
+
+// BigString[...] ends at the first unbalanced ']'
+static int bigstring_safe (const char* str)
+{
+  int depth = 1;
+  for (const char* p = str; *p; p++) {
+    if (*p == '[') depth++;
+    else if (*p == ']' && --depth == 0) return 0;
+  }
+  return depth == 1;
+}
+
+static void write_char (IutfBuffer* buf, char c)
+{
+  static const char hex[] = "0123456789abcdef";
+  iutf_buffer_putc (buf, '\'');
+  switch (c) {
+    case '\n': iutf_buffer_append (buf, "\\n", 2); break;
+    case '\t': iutf_buffer_append (buf, "\\t", 2); break;
+    case '\r': iutf_buffer_append (buf, "\\r", 2); break;
+    case '\0': iutf_buffer_append (buf, "\\0", 2); break;
+    case '\\': iutf_buffer_append (buf, "\\\\", 2); break;
+    case '\'': iutf_buffer_append (buf, "\\'", 2); break;
+    default:
+      if ((unsigned char) c < 0x20 || (unsigned char) c >= 0x7f) {
+        char esc[4] = { '\\', 'x', hex[(unsigned char) c >> 4], hex[c & 15] };
+        iutf_buffer_append (buf, esc, 4);
+      } else {
+        iutf_buffer_putc (buf, c);
+      }
+      break;
+  }
+  iutf_buffer_putc (buf, '\'');
+}
+
+static int write_entries (IutfBuffer* buf, IutfNode** items, size_t size, int flags, size_t depth)
+{
+  int compact = flags & IUTF_WRITE_COMPACT;
+
+  for (size_t i = 0; i < size; i++) {
+    IutfNode* item = items[i];
+    if (!iutf_is_identifier (item->key)) {
+      fprintf (stderr, COL_RED "Cannot write key '" COL_CYAN "%s" COL_RED "' as IUTF" COL_DEF "\n", item->key ? item->key : "(null)");
+      return 0;
+    }
+
+    if (compact) {
+      if (i > 0) iutf_buffer_putc (buf, ',');
+    } else {
+      iutf_buffer_indent (buf, depth * INDENT_WIDTH);
+    }
+    iutf_buffer_puts (buf, item->key);
+    iutf_buffer_append (buf, ": ", compact ? 1 : 2);
+    if (!write_node (buf, item, flags, depth)) return 0;
+    if (!compact) iutf_buffer_putc (buf, '\n');
+  }
+  return 1;
+}
+
+static int write_array (IutfBuffer* buf, IutfNode* node, int flags, size_t depth)
+{
+  int compact = flags & IUTF_WRITE_COMPACT;
+  size_t size = node->data.array.size;
+
+  int inline_items = compact;
+  if (!inline_items) {
+    inline_items = 1;
+    for (size_t i = 0; i < size && inline_items; i++) inline_items = is_scalar (node->data.array.items[i]);
+  }
+
+  iutf_buffer_putc (buf, '[');
+  for (size_t i = 0; i < size; i++) {
+    if (inline_items) {
+      if (i > 0) iutf_buffer_append (buf, ", ", compact ? 1 : 2);
+    } else {
+      iutf_buffer_append (buf, i > 0 ? ",\n" : "\n", i > 0 ? 2 : 1);
+      iutf_buffer_indent (buf, (depth + 1) * INDENT_WIDTH);
+    }
+    if (!write_node (buf, node->data.array.items[i], flags, depth + 1)) return 0;
+  }
+  if (!inline_items && size > 0) {
+    iutf_buffer_putc (buf, '\n');
+    iutf_buffer_indent (buf, depth * INDENT_WIDTH);
+  }
+  iutf_buffer_putc (buf, ']');
+  return 1;
+}
+
+static int write_node (IutfBuffer* buf, IutfNode* node, int flags, size_t depth)
+{
+  const char* str;
+
+  switch (node->type) {
+    case IUTF_NODE_BRANCH:
+      iutf_buffer_putc (buf, '{');
+      if (!(flags & IUTF_WRITE_COMPACT) && node->data.branch.size > 0) iutf_buffer_putc (buf, '\n');
+      if (!write_entries (buf, node->data.branch.items, node->data.branch.size, flags, depth + 1)) return 0;
+      if (!(flags & IUTF_WRITE_COMPACT) && node->data.branch.size > 0) iutf_buffer_indent (buf, depth * INDENT_WIDTH);
+      iutf_buffer_putc (buf, '}');
+      break;
+
+    case IUTF_NODE_ARRAY:
+      return write_array (buf, node, flags, depth);
+
+    case IUTF_NODE_STRING:
+      str = node->data.str_value ? node->data.str_value : "";
+      iutf_buffer_quoted (buf, str, strlen (str));
+      break;
+
+    case IUTF_NODE_BIGSTRING:
+      str = node->data.str_value ? node->data.str_value : "";
+      if (bigstring_safe (str)) {
+        iutf_buffer_append (buf, "BigString[", 10);
+        iutf_buffer_puts (buf, str);
+        iutf_buffer_putc (buf, ']');
+      } else {
+        iutf_buffer_quoted (buf, str, strlen (str));
+      }
+      break;
+
+    case IUTF_NODE_PIPESTRING:
+      str = node->data.str_value ? node->data.str_value : "";
+      if (!strchr (str, '|')) {
+        iutf_buffer_putc (buf, '|');
+        iutf_buffer_puts (buf, str);
+        iutf_buffer_putc (buf, '|');
+      } else {
+        iutf_buffer_quoted (buf, str, strlen (str));
+      }
+      break;
+
+    case IUTF_NODE_INTEGER:
+      iutf_buffer_ll (buf, node->data.int_value);
+      break;
+
+    case IUTF_NODE_LONG:
+      iutf_buffer_ll (buf, node->data.long_value);
+      iutf_buffer_putc (buf, 'L');
+      break;
+
+    case IUTF_NODE_FLOAT:
+      iutf_buffer_double (buf, node->data.float_value);
+      break;
+
+    case IUTF_NODE_CHARACTER:
+      write_char (buf, node->data.char_value);
+      break;
+
+    case IUTF_NODE_BOOLEAN:
+      if (node->data.bool_value) iutf_buffer_append (buf, "true", 4);
+      else iutf_buffer_append (buf, "false", 5);
+      break;
+
+    case IUTF_NODE_NULL:
+      iutf_buffer_append (buf, "null", 4);
+      break;
+
+    default:
+      fprintf (stderr, COL_RED "Cannot serialize node type %d" COL_DEF "\n", (int) node->type);
+      return 0;
+  }
+  return !buf->error;
+}
+
+int iutf_serialize_value (IutfBuffer* buf, IutfNode* node, int flags, size_t depth)
+{
+  if (!buf || !node) return 0;
+  return write_node (buf, node, flags, depth);
+}
+
+int iutf_serialize_to_buffer (IutfNode* root, int flags, IutfBuffer* buf)
+{
+  if (!root || !buf) return 0;
+
+  uint64_t started = iutf_stats_phase_begin ();
+  if (root->type == IUTF_NODE_BRANCH) {
+    iutf_buffer_append (buf, "iutf:init:main ", (flags & IUTF_WRITE_COMPACT) ? 14 : 15);
+  }
+  int ok = write_node (buf, root, flags, 0);
+  if (ok && !(flags & IUTF_WRITE_COMPACT)) iutf_buffer_putc (buf, '\n');
+  iutf_stats_phase_end (IUTF_PHASE_SERIALIZE, started);
+  return ok && !buf->error;
+}
+
+char* iutf_serialize (IutfNode* root, int flags, size_t* len)
+{
+  IutfBuffer buf;
+  iutf_buffer_init (&buf);
+  if (!iutf_serialize_to_buffer (root, flags, &buf)) {
+    iutf_buffer_free (&buf);
+    return NULL;
+  }
+  return iutf_buffer_steal (&buf, len);
+}
+
+int iutf_serialize_to_fd (IutfNode* root, int flags, int fd)
+{
+  IutfBuffer buf;
+  iutf_buffer_init_fd (&buf, fd);
+  int ok = iutf_serialize_to_buffer (root, flags, &buf) && iutf_buffer_flush (&buf);
+  iutf_buffer_free (&buf);
+  return ok;
+}
+
+int iutf_serialize_to_file (IutfNode* root, int flags, FILE* fp)
+{
+  IutfBuffer buf;
+  iutf_buffer_init_file (&buf, fp);
+  int ok = iutf_serialize_to_buffer (root, flags, &buf) && iutf_buffer_flush (&buf);
+  iutf_buffer_free (&buf);
+  return ok;
+}
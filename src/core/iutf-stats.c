@@ -0,0 +1,344 @@
+/* iutf-stats.c
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Stats version 0.1
+ */
+#define _GNU_SOURCE
+
+#include "../includes/iutf-stats.h"
+#include "../includes/iutf-alloc.h"
+#include <malloc.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// IutfStats is read as a flat array of counters
+#define COUNTERS (sizeof (IutfStats) / sizeof (uint64_t))
+
+typedef struct StatsBlock {
+  IutfStats stats; // first, iutf_stats_tls points here
+  struct StatsBlock* next;
+} StatsBlock;
+
+int iutf_stats_active = -1;
+__thread IutfStats* iutf_stats_tls;
+
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static StatsBlock* stats_blocks; // live threads
+static IutfStats stats_retired; // threads that have exited
+static pthread_key_t stats_key;
+static pthread_once_t stats_once = PTHREAD_ONCE_INIT;
+
+static void add_counters (IutfStats* to, const IutfStats* from)
+{
+  uint64_t* dst = (uint64_t*) to;
+  const uint64_t* src = (const uint64_t*) from;
+  for (size_t i = 0; i < COUNTERS; i++) dst[i] += __atomic_load_n (&src[i], __ATOMIC_RELAXED);
+}
+
+// a thread exits: keep its counts, drop its block
+static void block_retire (void* ptr)
+{
+  StatsBlock* block = ptr;
+  pthread_mutex_lock (&stats_lock);
+  add_counters (&stats_retired, &block->stats);
+  for (StatsBlock** link = &stats_blocks; *link; link = &(*link)->next) {
+    if (*link == block) {
+      *link = block->next;
+      break;
+    }
+  }
+  pthread_mutex_unlock (&stats_lock);
+  iutf_stats_tls = NULL;
+  free (block);
+}
+
+static void key_init (void)
+{
+  pthread_key_create (&stats_key, block_retire);
+}
+
+static int resolve_active (void)
+{
+  int active = __atomic_load_n (&iutf_stats_active, __ATOMIC_RELAXED);
+  if (active >= 0) return active;
+
+  const char* env = getenv ("IUTF_STATS");
+  int on = env && *env && strcmp (env, "0") != 0;
+  int expected = -1;
+  __atomic_compare_exchange_n (&iutf_stats_active, &expected, on, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+  return __atomic_load_n (&iutf_stats_active, __ATOMIC_RELAXED);
+}
+
+IutfStats* iutf_stats_thread_slow (void)
+{
+  if (!resolve_active ()) return NULL;
+  if (iutf_stats_tls) return iutf_stats_tls;
+
+  // plain calloc: the iutf_* wrappers would count this allocation and recurse
+  StatsBlock* block = calloc (1, sizeof (StatsBlock));
+  if (!block) return NULL;
+  pthread_once (&stats_once, key_init);
+  pthread_mutex_lock (&stats_lock);
+  block->next = stats_blocks;
+  stats_blocks = block;
+  pthread_mutex_unlock (&stats_lock);
+  pthread_setspecific (stats_key, block);
+  iutf_stats_tls = &block->stats;
+  return iutf_stats_tls;
+}
+
+IutfStats* iutf_stats_suspend (IutfStats* scratch)
+{
+  IutfStats* saved = iutf_stats_tls;
+  iutf_stats_tls = scratch;
+  return saved;
+}
+
+void iutf_stats_resume (IutfStats* saved)
+{
+  iutf_stats_tls = saved;
+}
+
+void iutf_stats_enable (int on)
+{
+  __atomic_store_n (&iutf_stats_active, on ? 1 : 0, __ATOMIC_RELAXED);
+}
+
+int iutf_stats_enabled (void)
+{
+  return resolve_active ();
+}
+
+void iutf_stats_snapshot (IutfStats* out)
+{
+  memset (out, 0, sizeof (*out));
+  pthread_mutex_lock (&stats_lock);
+  add_counters (out, &stats_retired);
+  for (StatsBlock* block = stats_blocks; block; block = block->next) add_counters (out, &block->stats);
+  pthread_mutex_unlock (&stats_lock);
+}
+
+// counts that other threads add while this runs may survive the reset
+void iutf_stats_reset (void)
+{
+  pthread_mutex_lock (&stats_lock);
+  memset (&stats_retired, 0, sizeof (stats_retired));
+  for (StatsBlock* block = stats_blocks; block; block = block->next) {
+    uint64_t* counters = (uint64_t*) &block->stats;
+    for (size_t i = 0; i < COUNTERS; i++) __atomic_store_n (&counters[i], 0, __ATOMIC_RELAXED);
+  }
+  pthread_mutex_unlock (&stats_lock);
+}
+
+static uint64_t now_ns (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+uint64_t iutf_stats_phase_begin (void)
+{
+  return iutf_stats_thread () ? now_ns () : 0;
+}
+
+void iutf_stats_phase_end (IutfPhase phase, uint64_t start)
+{
+  if (!start || phase >= IUTF_STATS_PHASES) return;
+  IUTF_STAT_ADD (phase_calls[phase], 1);
+  IUTF_STAT_ADD (phase_ns[phase], now_ns () - start);
+}
+
+static const char* phase_names[IUTF_STATS_PHASES] = { "parse", "import", "validate", "check", "serialize" };
+
+const char* iutf_phase_name (IutfPhase phase)
+{
+  return phase < IUTF_STATS_PHASES ? phase_names[phase] : "?";
+}
+
+static const char* token_names[IUTF_STATS_TOKEN_TYPES] = {
+  "eof", "error", "branch_open", "branch_close", "lbracket", "rbracket", "colon", "equals",
+  "pipe", "comma", "string", "integer", "character", "float", "long", "true", "false", "null",
+  "identifier", "bigstring_start", "comment_line", "comment_cpp", "comment_block_start",
+  "comment_block_end", "import",
+};
+
+static const char* node_names[IUTF_STATS_NODE_TYPES] = {
+  "branch", "key_value", "string", "integer", "float", "long", "character", "boolean", "null",
+  "array", "bigstring", "pipestring",
+};
+
+void iutf_stats_print_json (FILE* fp, const IutfStats* s)
+{
+  fputs ("{\"tokens\":{", fp);
+  for (size_t i = 0; i < IUTF_STATS_TOKEN_TYPES; i++) {
+    fprintf (fp, "%s\"%s\":%llu", i ? "," : "", token_names[i], (unsigned long long) s->tokens[i]);
+  }
+  fputs ("},\"nodes\":{", fp);
+  for (size_t i = 0; i < IUTF_STATS_NODE_TYPES; i++) {
+    fprintf (fp, "%s\"%s\":%llu", i ? "," : "", node_names[i], (unsigned long long) s->nodes[i]);
+  }
+  fprintf (fp, "},\"alloc_calls\":%llu,\"alloc_bytes\":%llu,\"realloc_calls\":%llu,\"realloc_bytes\":%llu,\"free_calls\":%llu,"
+           "\"import_lookups\":%llu,\"import_misses\":%llu,\"cache_hits\":%llu,\"cache_misses\":%llu,\"phases\":{",
+           (unsigned long long) s->alloc_calls, (unsigned long long) s->alloc_bytes,
+           (unsigned long long) s->realloc_calls, (unsigned long long) s->realloc_bytes,
+           (unsigned long long) s->free_calls, (unsigned long long) s->import_lookups,
+           (unsigned long long) s->import_misses, (unsigned long long) s->cache_hits,
+           (unsigned long long) s->cache_misses);
+  for (int p = 0; p < IUTF_STATS_PHASES; p++) {
+    fprintf (fp, "%s\"%s\":{\"calls\":%llu,\"ms\":%.3f}", p ? "," : "", phase_names[p],
+             (unsigned long long) s->phase_calls[p], s->phase_ns[p] / 1e6);
+  }
+  fputs ("}}\n", fp);
+}
+
+/* ---- memory of a tree ---- */
+
+// the active allocator's idea of the block, `asked` (what was allocated) if it has none
+static size_t block_size (const void* ptr, size_t asked)
+{
+  const IutfAllocator* a = iutf_allocator_active ();
+  if (!a) return malloc_usable_size ((void*) ptr);
+  return a->size ? a->size (a->ctx, ptr) : asked;
+}
+
+static void usage_add (const IutfNode* node, IutfMemoryUsage* out)
+{
+  out->nodes++;
+  out->blocks++;
+  out->node_bytes += block_size (node, sizeof (IutfNode));
+
+  if (node->key && !(node->flags & IUTF_NODE_FLAG_KEY_BORROWED)) {
+    out->blocks++;
+    out->key_bytes += block_size (node->key, strlen (node->key) + 1);
+  }
+
+  switch (node->type) {
+    case IUTF_NODE_STRING:
+    case IUTF_NODE_BIGSTRING:
+    case IUTF_NODE_PIPESTRING:
+      if (node->data.str_value && !(node->flags & IUTF_NODE_FLAG_STR_BORROWED)) {
+        out->blocks++;
+        out->string_bytes += block_size (node->data.str_value, strlen (node->data.str_value) + 1);
+      }
+      break;
+    case IUTF_NODE_BRANCH:
+    case IUTF_NODE_ARRAY:
+      if (node->data.branch.items) {
+        size_t slots = node->data.branch.capacity > node->data.branch.size ? node->data.branch.capacity : node->data.branch.size;
+        out->blocks++;
+        out->item_bytes += block_size (node->data.branch.items, slots * sizeof (IutfNode*));
+      }
+      for (size_t i = 0; i < node->data.branch.size; i++) usage_add (node->data.branch.items[i], out);
+      break;
+    default:
+      break;
+  }
+}
+
+void iutf_doc_memory_usage (const IutfNode* node, IutfMemoryUsage* out)
+{
+  memset (out, 0, sizeof (*out));
+  if (!node) return;
+  usage_add (node, out);
+  out->bytes = out->node_bytes + out->key_bytes + out->string_bytes + out->item_bytes;
+}
+
+#define REPORT_CHILDREN 20 // per level, the rest is summed up in one line
+
+typedef struct {
+  const IutfNode* node;
+  size_t index;
+  IutfMemoryUsage usage;
+} ReportEntry;
+
+static int compare_entries (const void* a, const void* b)
+{
+  size_t x = ((const ReportEntry*) a)->usage.bytes, y = ((const ReportEntry*) b)->usage.bytes;
+  return (x < y) - (x > y);
+}
+
+static void report_line (FILE* fp, const IutfMemoryUsage* usage, size_t total, size_t indent, const char* name, size_t index)
+{
+  double pct = total ? 100.0 * usage->bytes / total : 100.0;
+  fprintf (fp, "%10.1f KB %6.1f%% %9zu nodes  %*s", usage->bytes / 1024.0, pct, usage->nodes, (int) indent * 2, "");
+  if (name) fprintf (fp, "%s\n", name);
+  else fprintf (fp, "[%zu]\n", index);
+}
+
+static void report_children (FILE* fp, const IutfNode* node, size_t total, size_t level, size_t depth)
+{
+  if (level > depth || (node->type != IUTF_NODE_BRANCH && node->type != IUTF_NODE_ARRAY)) return;
+  size_t count = node->data.branch.size;
+  if (!count) return;
+
+  ReportEntry* entries = calloc (count, sizeof (ReportEntry));
+  if (!entries) return;
+  for (size_t i = 0; i < count; i++) {
+    entries[i].node = node->data.branch.items[i];
+    entries[i].index = i;
+    iutf_doc_memory_usage (entries[i].node, &entries[i].usage);
+  }
+  qsort (entries, count, sizeof (ReportEntry), compare_entries);
+
+  size_t shown = count < REPORT_CHILDREN ? count : REPORT_CHILDREN;
+  for (size_t i = 0; i < shown; i++) {
+    const IutfNode* child = entries[i].node;
+    report_line (fp, &entries[i].usage, total, level, node->type == IUTF_NODE_BRANCH ? child->key : NULL, entries[i].index);
+    report_children (fp, child, total, level + 1, depth);
+  }
+  if (shown < count) {
+    IutfMemoryUsage rest;
+    memset (&rest, 0, sizeof (rest));
+    for (size_t i = shown; i < count; i++) {
+      rest.nodes += entries[i].usage.nodes;
+      rest.bytes += entries[i].usage.bytes;
+    }
+    char name[64];
+    snprintf (name, sizeof (name), "... %zu more", count - shown);
+    report_line (fp, &rest, total, level, name, 0);
+  }
+  free (entries);
+}
+
+void iutf_doc_memory_report (FILE* fp, const IutfNode* node, size_t depth)
+{
+  if (!node) return;
+  IutfMemoryUsage usage;
+  memset (&usage, 0, sizeof (usage));
+  iutf_doc_memory_usage (node, &usage);
+  fprintf (fp, "%zu blocks: nodes %zu, keys %zu, strings %zu, item arrays %zu bytes\n",
+           usage.blocks, usage.node_bytes, usage.key_bytes, usage.string_bytes, usage.item_bytes);
+  report_line (fp, &usage, usage.bytes, 0, node->key ? node->key : "<root>", 0);
+  report_children (fp, node, usage.bytes, 1, depth);
+}
+
+void iutf_doc_memory_usage_with (const IutfNode* node, const IutfAllocator* allocator, IutfMemoryUsage* out)
+{
+  const IutfAllocator* previous = iutf_allocator_use (allocator);
+  iutf_doc_memory_usage (node, out);
+  iutf_allocator_use (previous);
+}
+
+void iutf_doc_memory_report_with (FILE* fp, const IutfNode* node, const IutfAllocator* allocator, size_t depth)
+{
+  const IutfAllocator* previous = iutf_allocator_use (allocator);
+  iutf_doc_memory_report (fp, node, depth);
+  iutf_allocator_use (previous);
+}
@@ -1,18 +1,272 @@
+/* iutf-stream.c
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Stream version 0.1
+ */
+#define _GNU_SOURCE
+
 #include "../includes/iutf-stream.h"
+#include "../includes/iutf-parser.h"
+#include "../includes/iutf-decompress.h"
+#include "../includes/colors.h"
+#include <errno.h>
+#include <fcntl.h>
 #include <string.h>
 #include <stdlib.h>
+#include <unistd.h>
+
+/*
+ * The scanner sees the bytes once, in chunks. iutf-scan.h skips what the
+ * lexer would: inside a string, a character literal, a comment, a BigString
+ * or a pipe string no bracket, newline or comma counts. Outside, an entry of
+ * the main branch ends at a newline or ',' on its level once it has a value
+ * (`key: value`, an @import, a `type` block).
+ */
+
+enum { SCAN_MORE, SCAN_HEADER, SCAN_ENTRY, SCAN_END };
+
+// a byte outside strings and comments
+static int scan_code (IutfStream* s, char c)
+{
+  if (s->depth < 0) {
+    // header, up to the '{' of the main branch
+    if (c != '{') return SCAN_MORE;
+    s->depth = 0;
+    return SCAN_HEADER;
+  }
+
+  switch (c) {
+    case ' ':
+    case '\t':
+    case '\r':
+      return SCAN_MORE;
+    case '\n':
+    case ',':
+      return s->depth == 0 && s->value ? SCAN_ENTRY : SCAN_MORE;
+    case '{':
+    case '[':
+      if (s->depth == 0) s->outer = c;
+      s->depth++;
+      break;
+    case '}':
+    case ']':
+      if (s->depth == 0) return c == '}' ? SCAN_END : SCAN_MORE;
+      // `key: {...}` or `type name {...}`, not the `[type]` of `key[type]:`
+      if (--s->depth == 0 && (s->colon || s->outer == '{')) s->value = 1;
+      return SCAN_MORE;
+    case ':':
+      if (s->depth == 0) {
+        s->colon = 1;
+        s->significant = 1;
+        return SCAN_MORE;
+      }
+      break;
+    case '@':
+      if (s->depth == 0) s->value = 1;
+      break;
+  }
+
+  if (s->depth == 0 || (s->depth == 1 && (c == '{' || c == '['))) {
+    s->significant = 1;
+    if (s->colon) s->value = 1;
+  }
+  return SCAN_MORE;
+}
+
+static int scan_byte (IutfStream* s, char c)
+{
+  return iutf_scan_byte (&s->scan, c) ? scan_code (s, c) : SCAN_MORE;
+}
+
+// scan the rest of the chunk into the entry buffer, up to the end of an entry
+static int scan (IutfStream* s)
+{
+  size_t start = s->chunk_pos;
+  int result = SCAN_MORE;
+  while (s->chunk_pos < s->chunk_len && result == SCAN_MORE) {
+    char c = s->chunk[s->chunk_pos++];
+    int was_significant = s->significant;
+    result = scan_byte (s, c);
+    if (!was_significant && s->significant) s->entry_line = s->line;
+    if (c == '\n') s->line++;
+  }
+  // the closing '}' of the main branch is added back by parse_pending
+  size_t end = result == SCAN_END ? s->chunk_pos - 1 : s->chunk_pos;
+  iutf_buffer_append (&s->entry, s->chunk + start, end - start);
+  return result;
+}
+
+// 1 = more bytes in the chunk, 0 = end of file, -1 = error
+static int refill (IutfStream* s)
+{
+  if (s->decompress) {
+    s->chunk_pos = 0;
+    return iutf_decompress_next (s->decompress, &s->chunk, &s->chunk_len);
+  }
+
+  ssize_t n;
+  do {
+    n = read (s->fd, s->buffer, IUTF_STREAM_CHUNK);
+  } while (n < 0 && errno == EINTR);
+  if (n < 0) {
+    fprintf (stderr, COL_RED "Cannot read " COL_CYAN "%s" COL_RED ": %s" COL_DEF "\n", s->filename, strerror (errno));
+    return -1;
+  }
+  s->chunk_len = (size_t) n;
+  s->chunk_pos = 0;
+  return n > 0;
+}
+
+// parse the header and the collected entry as a document of their own
+static int parse_pending (IutfStream* s)
+{
+  iutf_buffer_append (&s->entry, "\n}", 3); // with the NUL
+  if (s->entry.error) {
+    fprintf (stderr, COL_RED "Out of memory" COL_DEF "\n");
+    return 0;
+  }
+
+  IutfParser* parser = iutf_parser_new (s->entry.data);
+  if (!parser) return 0;
+  parser->filename = s->filename;
+  parser->imports = s->imports;
+  parser->types = s->types;
+  IutfNode* root = iutf_parse (parser);
+  s->imports = parser->imports;
+  s->types = parser->types;
+  memset (&parser->imports, 0, sizeof (parser->imports));
+  memset (&parser->types, 0, sizeof (parser->types));
+  iutf_parser_free (parser);
+
+  s->entry.len = s->header_len;
+  if (!root) {
+    fprintf (stderr, COL_RED "Cannot parse the entry at " COL_CYAN "%s:%zu" COL_DEF "\n", s->filename, s->entry_line);
+    return 0;
+  }
+  s->pending = root;
+  s->pending_next = 0;
+  return 1;
+}
+
+static IutfNode* take_pending (IutfStream* s)
+{
+  if (!s->pending) return NULL;
+  if (s->pending_next < s->pending->data.branch.size) {
+    IutfNode* entry = s->pending->data.branch.items[s->pending_next];
+    s->pending->data.branch.items[s->pending_next++] = NULL;
+    return entry;
+  }
+  iutf_node_free (s->pending);
+  s->pending = NULL;
+  return NULL;
+}
 
 IutfStream* stream_open (const char* filename)
 {
-  FILE* fp = fopen (filename, "r");
-  if (!fp) return NULL;
+  int fd = open (filename, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    fprintf (stderr, COL_RED "Cannot open file: " COL_DEF COL_CYAN "%s" COL_DEF "\n", filename);
+    return NULL;
+  }
+
+  IutfStream* s = calloc (1, sizeof (IutfStream));
+  if (!s) {
+    close (fd);
+    return NULL;
+  }
+  s->fd = fd;
+  s->filename = strdup (filename);
+  s->line = 1;
+  s->depth = -1;
+  iutf_buffer_init (&s->entry);
+  IutfCompression compression = iutf_compression_of_fd (fd);
+  if (compression != IUTF_COMPRESSION_NONE) {
+    s->decompress = s->filename ? iutf_decompress_open (fd, compression, filename) : NULL;
+    if (!s->decompress) {
+      stream_corrupt (s);
+      return NULL;
+    }
+  } else {
+    s->chunk = s->buffer = malloc (IUTF_STREAM_CHUNK);
+  }
+  if (!s->filename || (!s->decompress && !s->buffer)) {
+    stream_corrupt (s);
+    return NULL;
+  }
 
-  IutfStream* stream = malloc (sizeof(IutfStream));
-  if (!stream) {
-    fclose (fp);
+  int result = SCAN_MORE;
+  while (result != SCAN_HEADER) {
+    result = scan (s);
+    if (result == SCAN_MORE) {
+      int got = refill (s);
+      if (got <= 0) {
+        if (got == 0) fprintf (stderr, COL_RED "No main branch in " COL_CYAN "%s" COL_DEF "\n", filename);
+        stream_corrupt (s);
+        return NULL;
+      }
+    }
+  }
+  s->header_len = s->entry.len;
+
+  // an empty document checks the header
+  if (!parse_pending (s)) {
+    stream_corrupt (s);
     return NULL;
   }
+  take_pending (s);
+  return s;
+}
 
-  // читаем весь файл в память
-  fseek (fp, 0, SEEK_END)
+IutfNode* stream_entry_next (IutfStream* s)
+{
+  if (!s) return NULL;
+  for (;;) {
+    IutfNode* entry = take_pending (s);
+    if (entry) return entry;
+    if (s->finished || s->error) return NULL;
+
+    int result = scan (s);
+    if (result == SCAN_MORE) {
+      int got = refill (s);
+      if (got < 0) s->error = 1;
+      if (got == 0) {
+        fprintf (stderr, COL_RED "Unexpected end of " COL_CYAN "%s" COL_RED ", '}' of the main branch is missing" COL_DEF "\n", s->filename);
+        s->error = 1;
+      }
+      continue;
+    }
+
+    if (result == SCAN_END) s->finished = 1;
+    if (s->significant && !parse_pending (s)) s->error = 1;
+    s->entry.len = s->header_len; // blank or failed
+    s->colon = s->value = s->significant = 0;
+  }
+}
+
+void stream_corrupt (IutfStream* s)
+{
+  if (!s) return;
+  iutf_decompress_close (s->decompress); // before its fd is closed
+  if (s->fd >= 0) close (s->fd);
+  iutf_node_free (s->pending);
+  iutf_import_list_clear (&s->imports);
+  iutf_type_table_clear (&s->types);
+  iutf_buffer_free (&s->entry);
+  free (s->buffer);
+  free (s->filename);
+  free (s);
 }
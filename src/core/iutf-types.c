@@ -0,0 +1,275 @@
+/* iutf-types.c
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Types version 0.1
+ */
+#define _GNU_SOURCE
+
+#include "../includes/iutf-types.h"
+#include "../includes/iutf-hash.h"
+#include "../includes/colors.h"
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  char* name;
+  uint64_t hash;
+  int converter; // 0 validator, 1 converter
+  union {
+    IutfTypeValidator validate;
+    IutfTypeConverter convert;
+  } func;
+  void* user;
+} RegistryEntry;
+
+static RegistryEntry* registry;
+static size_t registry_size;
+static size_t registry_cap;
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static char** plugins; // paths already loaded
+static size_t plugin_count;
+static pthread_mutex_t plugin_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int register_entry (const char* name, int converter, void* func_ptr_holder, void* user)
+{
+  if (!name || !func_ptr_holder) return 0;
+  size_t len = strlen (name);
+  uint64_t h = iutf_hash_bytes (name, len, 0);
+
+  pthread_mutex_lock (&registry_lock);
+  RegistryEntry* e = NULL;
+  for (size_t i = 0; i < registry_size; i++) {
+    if (registry[i].hash == h && registry[i].converter == converter && strcmp (registry[i].name, name) == 0) {
+      e = &registry[i];
+      break;
+    }
+  }
+
+  if (!e) {
+    if (registry_size == registry_cap) {
+      size_t cap = registry_cap ? registry_cap * 2 : 16;
+      RegistryEntry* temp = realloc (registry, cap * sizeof (RegistryEntry));
+      if (!temp) {
+        pthread_mutex_unlock (&registry_lock);
+        return 0;
+      }
+      registry = temp;
+      registry_cap = cap;
+    }
+    char* copy = strdup (name);
+    if (!copy) {
+      pthread_mutex_unlock (&registry_lock);
+      return 0;
+    }
+    e = &registry[registry_size++];
+    e->name = copy;
+    e->hash = h;
+    e->converter = converter;
+  }
+
+  if (converter) e->func.convert = *(IutfTypeConverter*) func_ptr_holder;
+  else e->func.validate = *(IutfTypeValidator*) func_ptr_holder;
+  e->user = user;
+  pthread_mutex_unlock (&registry_lock);
+  return 1;
+}
+
+int iutf_types_register_validator (const char* name, IutfTypeValidator func, void* user)
+{
+  return func ? register_entry (name, 0, &func, user) : 0;
+}
+
+int iutf_types_register_converter (const char* name, IutfTypeConverter func, void* user)
+{
+  return func ? register_entry (name, 1, &func, user) : 0;
+}
+
+// copies the entry out, the registry may grow afterwards
+static int lookup (const char* name, int converter, RegistryEntry* out)
+{
+  uint64_t h = iutf_hash_bytes (name, strlen (name), 0);
+  int found = 0;
+
+  pthread_mutex_lock (&registry_lock);
+  for (size_t i = 0; i < registry_size; i++) {
+    if (registry[i].hash == h && registry[i].converter == converter && strcmp (registry[i].name, name) == 0) {
+      *out = registry[i];
+      found = 1;
+      break;
+    }
+  }
+  pthread_mutex_unlock (&registry_lock);
+  return found;
+}
+
+static const IutfPluginHost plugin_host = {
+  IUTF_PLUGIN_API_VERSION,
+  iutf_types_register_validator,
+  iutf_types_register_converter,
+};
+
+int iutf_types_load_plugin (const char* path)
+{
+  if (!path) return 0;
+
+  pthread_mutex_lock (&plugin_lock);
+  for (size_t i = 0; i < plugin_count; i++) {
+    if (strcmp (plugins[i], path) == 0) {
+      pthread_mutex_unlock (&plugin_lock);
+      return 1;
+    }
+  }
+
+  int ok = 0;
+  void* handle = dlopen (path, RTLD_NOW | RTLD_LOCAL);
+  if (!handle) {
+    fprintf (stderr, COL_RED "Cannot load plugin " COL_CYAN "%s" COL_RED ": %s" COL_DEF "\n", path, dlerror ());
+    goto out;
+  }
+
+  IutfPluginInit init;
+  *(void**) (&init) = dlsym (handle, IUTF_PLUGIN_INIT_SYMBOL);
+  if (!init) {
+    fprintf (stderr, COL_RED "Plugin " COL_CYAN "%s" COL_RED " has no " IUTF_PLUGIN_INIT_SYMBOL COL_DEF "\n", path);
+    dlclose (handle);
+    goto out;
+  }
+  if (!init (&plugin_host)) {
+    fprintf (stderr, COL_RED "Plugin " COL_CYAN "%s" COL_RED " failed to initialize" COL_DEF "\n", path);
+    dlclose (handle);
+    goto out;
+  }
+
+  // the handle stays open, registered functions live in it
+  char** temp = realloc (plugins, (plugin_count + 1) * sizeof (char*));
+  if (temp) {
+    plugins = temp;
+    plugins[plugin_count] = strdup (path);
+    if (plugins[plugin_count]) plugin_count++;
+  }
+  ok = 1;
+
+out:
+  pthread_mutex_unlock (&plugin_lock);
+  return ok;
+}
+
+/* ---- per-parse type table ---- */
+
+static const char* decl_string (const IutfNode* decl, const char* key)
+{
+  for (size_t i = 0; i < decl->data.branch.size; i++) {
+    const IutfNode* item = decl->data.branch.items[i];
+    if (item->key && strcmp (item->key, key) == 0 && item->type == IUTF_NODE_STRING) return item->data.str_value;
+  }
+  return NULL;
+}
+
+int iutf_type_table_declare (IutfTypeTable* table, const char* name, size_t name_len, IutfNode* decl)
+{
+  if (!table || !name || !decl || decl->type != IUTF_NODE_BRANCH) {
+    iutf_node_free (decl);
+    return 0;
+  }
+
+  const char* validator = decl_string (decl, "validator");
+  const char* converter = decl_string (decl, "converter");
+  RegistryEntry v, c;
+  if (validator && !lookup (validator, 0, &v)) {
+    fprintf (stderr, COL_RED "Unknown validator '" COL_CYAN "%s" COL_RED "' for type '%.*s'" COL_DEF "\n", validator, (int) name_len, name);
+    iutf_node_free (decl);
+    return 0;
+  }
+  if (converter && !lookup (converter, 1, &c)) {
+    fprintf (stderr, COL_RED "Unknown converter '" COL_CYAN "%s" COL_RED "' for type '%.*s'" COL_DEF "\n", converter, (int) name_len, name);
+    iutf_node_free (decl);
+    return 0;
+  }
+
+  // a later declaration of the same name wins, like later imports do
+  IutfType* type = (IutfType*) iutf_type_table_find (table, name, name_len);
+  if (type) {
+    iutf_node_free (type->decl);
+  } else {
+    if (table->size == table->capacity) {
+      size_t cap = table->capacity ? table->capacity * 2 : 8;
+      IutfType* temp = realloc (table->items, cap * sizeof (IutfType));
+      if (!temp) {
+        iutf_node_free (decl);
+        return 0;
+      }
+      table->items = temp;
+      table->capacity = cap;
+    }
+    type = &table->items[table->size];
+    type->name = strndup (name, name_len);
+    if (!type->name) {
+      iutf_node_free (decl);
+      return 0;
+    }
+    type->hash = iutf_hash_bytes (name, name_len, 0);
+    table->size++;
+  }
+
+  type->validate = validator ? v.func.validate : NULL;
+  type->validate_user = validator ? v.user : NULL;
+  type->convert = converter ? c.func.convert : NULL;
+  type->convert_user = converter ? c.user : NULL;
+  type->decl = decl;
+  return 1;
+}
+
+const IutfType* iutf_type_table_find (const IutfTypeTable* table, const char* name, size_t name_len)
+{
+  if (!table) return NULL;
+  uint64_t h = iutf_hash_bytes (name, name_len, 0);
+  for (size_t i = 0; i < table->size; i++) {
+    const IutfType* type = &table->items[i];
+    if (type->hash == h && strncmp (type->name, name, name_len) == 0 && type->name[name_len] == '\0') return type;
+  }
+  return NULL;
+}
+
+void iutf_type_table_clear (IutfTypeTable* table)
+{
+  if (!table) return;
+  for (size_t i = 0; i < table->size; i++) {
+    free (table->items[i].name);
+    iutf_node_free (table->items[i].decl);
+  }
+  free (table->items);
+  table->items = NULL;
+  table->size = 0;
+  table->capacity = 0;
+}
+
+IutfNode* iutf_type_apply (const IutfType* type, IutfNode* value)
+{
+  if (type->validate && !type->validate (value, type->decl, type->validate_user)) {
+    iutf_node_free (value);
+    return NULL;
+  }
+  if (!type->convert) return value;
+
+  IutfNode* out = type->convert (value, type->decl, type->convert_user);
+  if (out != value) iutf_node_free (value);
+  return out;
+}
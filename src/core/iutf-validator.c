@@ -19,6 +19,7 @@
  */
 
 #include "../includes/iutf-validator.h"
+#include "../includes/iutf-schema.h"
 #include <stdio.h>
 
 int iutf_validate(IutfNode* root) {
@@ -27,36 +28,11 @@ int iutf_validate(IutfNode* root) {
         return 0;
     }
 
-    if (root->type != IUTF_NODE_BRANCH) {
-        fprintf(stderr, "\033[33mRoot must be a branch\033[0m\n");
+    // title (string) and version (number) are the built-in schema, see iutf-schema.c
+    const IutfSchema* schema = iutf_schema_default();
+    if (!schema) {
+        fprintf(stderr, "\033[31mDefault schema is unavailable\033[0m\n");
         return 0;
     }
-
-    // Validation: Check that the root contains the required keys
-    int has_title = 0;
-    int has_version = 0;
-
-    for (size_t i = 0; i < root->data.branch.size; i++) {
-        IutfNode* item = root->data.branch.items[i];
-        if (item->key && strcmp(item->key, "title") == 0) {
-            if (item->type != IUTF_NODE_STRING) {
-                fprintf(stderr, "\033[33mField 'title' must be a string\033[0m\n");
-                return 0;
-            }
-            has_title = 1;
-        } else if (item->key && strcmp(item->key, "version") == 0) {
-            if (item->type != IUTF_NODE_FLOAT && item->type != IUTF_NODE_INTEGER) {
-                fprintf(stderr, "\033[31mField 'version' must be a number\033[0m\n");
-                return 0;
-            }
-            has_version = 1;
-        }
-    }
-
-    if (!has_title || !has_version) {
-        fprintf(stderr, "\033[33mMissing required fields: 'title' and 'version'\033[0m\n");
-        return 0;
-    }
-
-    return 1; // Validation complete
+    return iutf_schema_validate(schema, root);
 }
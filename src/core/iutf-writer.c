@@ -0,0 +1,285 @@
+/* iutf-writer.c
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Writer version 0.1
+ */
+#define _GNU_SOURCE
+
+#include "../includes/iutf-writer.h"
+#include "../includes/colors.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INDENT_WIDTH 2
+
+static IutfWriter* writer_new (int flags)
+{
+  IutfWriter* writer = calloc (1, sizeof (IutfWriter));
+  if (!writer) return NULL;
+  writer->flags = flags;
+  return writer;
+}
+
+IutfWriter* iutf_writer_new_fd (int fd, int flags)
+{
+  IutfWriter* writer = writer_new (flags);
+  if (writer) iutf_buffer_init_fd (&writer->buf, fd);
+  return writer;
+}
+
+IutfWriter* iutf_writer_new_file (FILE* fp, int flags)
+{
+  IutfWriter* writer = writer_new (flags);
+  if (writer) iutf_buffer_init_file (&writer->buf, fp);
+  return writer;
+}
+
+IutfWriter* iutf_writer_new_sink (IutfSinkFunc sink, void* ctx, int flags)
+{
+  IutfWriter* writer = writer_new (flags);
+  if (writer) iutf_buffer_init_sink (&writer->buf, sink, ctx);
+  return writer;
+}
+
+static int fail (IutfWriter* writer, const char* msg, const char* key)
+{
+  if (!writer->error) {
+    if (key) fprintf (stderr, COL_RED "IUTF writer: %s" COL_CYAN " '%s'" COL_DEF "\n", msg, key);
+    else fprintf (stderr, COL_RED "IUTF writer: %s" COL_DEF "\n", msg);
+  }
+  writer->error = 1;
+  return 0;
+}
+
+// separator, indentation and key before a value
+static int begin_item (IutfWriter* writer, const char* key)
+{
+  if (writer->error) return 0;
+  if (writer->depth == 0) return fail (writer, "value outside of the main branch", key);
+
+  IutfBuffer* buf = &writer->buf;
+  IutfWriterLevel* top = &writer->stack[writer->depth - 1];
+  int compact = writer->flags & IUTF_WRITE_COMPACT;
+
+  if (top->kind == 'b') {
+    if (!key) return fail (writer, "branch entries need a key", NULL);
+    if (!iutf_is_identifier (key)) return fail (writer, "invalid key", key);
+    if (compact) {
+      if (top->count > 0) iutf_buffer_putc (buf, ',');
+    } else {
+      if (top->count == 0) iutf_buffer_putc (buf, '\n');
+      iutf_buffer_indent (buf, writer->depth * INDENT_WIDTH);
+    }
+    iutf_buffer_puts (buf, key);
+    iutf_buffer_append (buf, ": ", compact ? 1 : 2);
+  } else {
+    if (key) return fail (writer, "array items can't have a key", key);
+    if (compact) {
+      if (top->count > 0) iutf_buffer_putc (buf, ',');
+    } else {
+      iutf_buffer_append (buf, top->count > 0 ? ",\n" : "\n", top->count > 0 ? 2 : 1);
+      iutf_buffer_indent (buf, writer->depth * INDENT_WIDTH);
+    }
+  }
+  top->count++;
+  return 1;
+}
+
+// a finished value inside a pretty branch ends its line
+static int end_item (IutfWriter* writer)
+{
+  if (writer->depth > 0 && writer->stack[writer->depth - 1].kind == 'b' && !(writer->flags & IUTF_WRITE_COMPACT)) {
+    iutf_buffer_putc (&writer->buf, '\n');
+  }
+  if (writer->buf.error) return fail (writer, "write failed", NULL);
+  return 1;
+}
+
+static int push (IutfWriter* writer, char kind)
+{
+  if (writer->depth == writer->stack_cap) {
+    size_t cap = writer->stack_cap ? writer->stack_cap * 2 : 16;
+    IutfWriterLevel* temp = realloc (writer->stack, cap * sizeof (IutfWriterLevel));
+    if (!temp) return fail (writer, "out of memory", NULL);
+    writer->stack = temp;
+    writer->stack_cap = cap;
+  }
+  writer->stack[writer->depth].kind = kind;
+  writer->stack[writer->depth].count = 0;
+  writer->depth++;
+  return 1;
+}
+
+int iutf_writer_begin_branch (IutfWriter* writer, const char* key)
+{
+  if (!writer || writer->error) return 0;
+
+  if (writer->depth == 0) {
+    if (writer->root_done) return fail (writer, "the main branch is already closed", key);
+    if (key) return fail (writer, "the main branch has no key", key);
+    iutf_buffer_append (&writer->buf, "iutf:init:main ", (writer->flags & IUTF_WRITE_COMPACT) ? 14 : 15);
+    iutf_buffer_putc (&writer->buf, '{');
+    return push (writer, 'b');
+  }
+
+  if (!begin_item (writer, key)) return 0;
+  iutf_buffer_putc (&writer->buf, '{');
+  return push (writer, 'b');
+}
+
+int iutf_writer_begin_array (IutfWriter* writer, const char* key)
+{
+  if (!writer || !begin_item (writer, key)) return 0;
+  iutf_buffer_putc (&writer->buf, '[');
+  return push (writer, 'a');
+}
+
+int iutf_writer_end (IutfWriter* writer)
+{
+  if (!writer || writer->error) return 0;
+  if (writer->depth == 0) return fail (writer, "end without an open branch or array", NULL);
+
+  IutfWriterLevel top = writer->stack[--writer->depth];
+  if (!(writer->flags & IUTF_WRITE_COMPACT) && top.count > 0) {
+    if (top.kind == 'a') iutf_buffer_putc (&writer->buf, '\n');
+    iutf_buffer_indent (&writer->buf, writer->depth * INDENT_WIDTH);
+  }
+  iutf_buffer_putc (&writer->buf, top.kind == 'b' ? '}' : ']');
+
+  if (writer->depth == 0) {
+    writer->root_done = 1;
+    if (!(writer->flags & IUTF_WRITE_COMPACT)) iutf_buffer_putc (&writer->buf, '\n');
+    return writer->buf.error ? fail (writer, "write failed", NULL) : 1;
+  }
+  return end_item (writer);
+}
+
+int iutf_writer_string_len (IutfWriter* writer, const char* key, const char* value, size_t len)
+{
+  if (!writer || !begin_item (writer, key)) return 0;
+  iutf_buffer_quoted (&writer->buf, value ? value : "", value ? len : 0);
+  return end_item (writer);
+}
+
+int iutf_writer_string (IutfWriter* writer, const char* key, const char* value)
+{
+  return iutf_writer_string_len (writer, key, value, value ? strlen (value) : 0);
+}
+
+static int write_block (IutfWriter* writer, const char* key, IutfNodeType type, const char* value)
+{
+  if (!writer || !begin_item (writer, key)) return 0;
+
+  // borrowed stack node, the serializer picks BigString/|...| or a quoted fallback
+  IutfNode node;
+  memset (&node, 0, sizeof (node));
+  node.type = type;
+  node.data.str_value = (char*) (value ? value : "");
+  if (!iutf_serialize_value (&writer->buf, &node, writer->flags, writer->depth)) return fail (writer, "write failed", key);
+  return end_item (writer);
+}
+
+int iutf_writer_bigstring (IutfWriter* writer, const char* key, const char* value)
+{
+  return write_block (writer, key, IUTF_NODE_BIGSTRING, value);
+}
+
+int iutf_writer_pipestring (IutfWriter* writer, const char* key, const char* value)
+{
+  return write_block (writer, key, IUTF_NODE_PIPESTRING, value);
+}
+
+int iutf_writer_int (IutfWriter* writer, const char* key, long long value)
+{
+  if (!writer || !begin_item (writer, key)) return 0;
+  iutf_buffer_ll (&writer->buf, value);
+  return end_item (writer);
+}
+
+int iutf_writer_long (IutfWriter* writer, const char* key, long long value)
+{
+  if (!writer || !begin_item (writer, key)) return 0;
+  iutf_buffer_ll (&writer->buf, value);
+  iutf_buffer_putc (&writer->buf, 'L');
+  return end_item (writer);
+}
+
+int iutf_writer_float (IutfWriter* writer, const char* key, double value)
+{
+  if (!writer || !begin_item (writer, key)) return 0;
+  iutf_buffer_double (&writer->buf, value);
+  return end_item (writer);
+}
+
+int iutf_writer_char (IutfWriter* writer, const char* key, char value)
+{
+  if (!writer || !begin_item (writer, key)) return 0;
+  IutfNode node;
+  memset (&node, 0, sizeof (node));
+  node.type = IUTF_NODE_CHARACTER;
+  node.data.char_value = value;
+  iutf_serialize_value (&writer->buf, &node, writer->flags, writer->depth);
+  return end_item (writer);
+}
+
+int iutf_writer_bool (IutfWriter* writer, const char* key, int value)
+{
+  if (!writer || !begin_item (writer, key)) return 0;
+  if (value) iutf_buffer_append (&writer->buf, "true", 4);
+  else iutf_buffer_append (&writer->buf, "false", 5);
+  return end_item (writer);
+}
+
+int iutf_writer_null (IutfWriter* writer, const char* key)
+{
+  if (!writer || !begin_item (writer, key)) return 0;
+  iutf_buffer_append (&writer->buf, "null", 4);
+  return end_item (writer);
+}
+
+int iutf_writer_raw (IutfWriter* writer, const char* key, const char* text, size_t len)
+{
+  if (!writer || !begin_item (writer, key)) return 0;
+  iutf_buffer_append (&writer->buf, text, len);
+  return end_item (writer);
+}
+
+int iutf_writer_node (IutfWriter* writer, const char* key, IutfNode* node)
+{
+  if (!writer || !node) return 0;
+  if (!begin_item (writer, key)) return 0;
+  if (!iutf_serialize_value (&writer->buf, node, writer->flags, writer->depth)) return fail (writer, "write failed", key);
+  return end_item (writer);
+}
+
+int iutf_writer_finish (IutfWriter* writer)
+{
+  if (!writer || writer->error) return 0;
+  if (writer->depth > 0) return fail (writer, "unclosed branch or array", NULL);
+  if (!writer->root_done) return fail (writer, "empty document", NULL);
+  if (!iutf_buffer_flush (&writer->buf)) return fail (writer, "write failed", NULL);
+  return 1;
+}
+
+void iutf_writer_free (IutfWriter* writer)
+{
+  if (!writer) return;
+  iutf_buffer_free (&writer->buf);
+  free (writer->stack);
+  free (writer);
+}
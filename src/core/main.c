@@ -17,17 +17,657 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#define _GNU_SOURCE
+
 #include "../includes/iutf-parser.h"
 #include "../includes/iutf-validator.h"
+#include "../includes/iutf-binary.h"
+#include "../includes/iutf-serialize.h"
+#include "../includes/iutf-cache.h"
+#include "../includes/iutf-json.h"
+#include "../includes/iutf-schema.h"
+#include "../includes/iutf-check.h"
+#include "../includes/iutf-bench.h"
+#include "../includes/iutf-stats.h"
+#include "../includes/iutf-log.h"
+#include "../includes/iutf-decompress.h"
+#include "../includes/iutf-loader.h"
+#include "../includes/iutf-alloc.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void usage(const char* prog) {
+    fprintf(stderr, "Usage: %s [--cache] [--stats] [--schema <schema.iutf>] <file.iutf>\n", prog);
+    fprintf(stderr, "       %s [--schema <schema.iutf>] [--check] [-j N] [--io auto|uring|pread] [--summary <file.json>] <file|dir|->...\n", prog);
+    fprintf(stderr, "       %s [--schema <schema.iutf>] bench [-n N] [--warmup N] [--json] <file.iutf>...\n", prog);
+    fprintf(stderr, "       %s [--schema <schema.iutf>] log [-j N] [--print|--json] <file.ilog|->\n", prog);
+    fprintf(stderr, "           (a gzip/zstd log is decompressed into memory whole, other modes read it block by block)\n");
+    fprintf(stderr, "       %s --to-binary <file.iutf> <file.iutb>\n", prog);
+    fprintf(stderr, "       %s --from-binary <file.iutb> [file.iutf]\n", prog);
+    fprintf(stderr, "       %s --to-json <file.iutf> [file.json]\n", prog);
+    fprintf(stderr, "       %s --from-json <file.json> [file.iutf]\n", prog);
+}
+
+static int to_binary(const char* in, const char* out) {
+    IutfNode* ast = iutf_parse_from_file(in);
+    if (!ast) {
+        fprintf(stderr, "\033[31mParse failed\033[0m\n");
+        return 1;
+    }
+    int ok = iutf_bin_write_file(ast, out);
+    iutf_node_free(ast);
+    return ok ? 0 : 1;
+}
+
+static int from_binary(const char* in, const char* out) {
+    IutfBinary bin;
+    if (!iutf_bin_open(&bin, in)) return 1;
+
+    IutfNode* ast = iutf_bin_to_node(&bin, iutf_bin_root(&bin));
+    iutf_bin_close(&bin);
+    if (!ast) return 1;
+
+    int ok;
+    if (out) {
+        FILE* fp = fopen(out, "w");
+        if (!fp) {
+            perror("Cannot open file");
+            iutf_node_free(ast);
+            return 1;
+        }
+        ok = iutf_serialize_to_file(ast, IUTF_WRITE_PRETTY, fp);
+        if (fclose(fp) != 0) ok = 0;
+    } else {
+        ok = iutf_serialize_to_file(ast, IUTF_WRITE_PRETTY, stdout);
+    }
+    iutf_node_free(ast);
+    return ok ? 0 : 1;
+}
+
+// JSON output is compact for other tools, IUTF output is indented for people
+static int transcode(const char* in, const char* out, int to_json) {
+    int fd = 1;
+    if (out) {
+        fd = open(out, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            perror("Cannot open file");
+            return 1;
+        }
+    }
+
+    int ok = to_json ? iutf_iutf_file_to_json(in, fd, IUTF_WRITE_COMPACT)
+                     : iutf_json_file_to_iutf(in, fd, IUTF_WRITE_PRETTY);
+    if (to_json && ok) ok = write(fd, "\n", 1) == 1;
+    if (out && close(fd) != 0) ok = 0;
+    return ok ? 0 : 1;
+}
+
+static IutfSchema* schema = NULL; // --schema, NULL means the built-in one
+static int show_stats = 0; // --stats: memory of the tree, counters as JSON on stderr at exit
+
+static void report(IutfNode* ast) {
+    printf("\033[32mParse successful!\033[0m\n");
+
+    if (schema ? iutf_schema_validate(schema, ast) : iutf_validate(ast)) {
+        printf("\033[32mValidation passed!\033[0m\n");
+    } else {
+        printf("\033[31mValidation failed!\033[0m\n");
+    }
+    if (show_stats) {
+        fflush(stdout);
+        iutf_doc_memory_report(stderr, ast, 2);
+    }
+}
+
+static void print_stats(void) {
+    IutfStats stats;
+    iutf_stats_snapshot(&stats);
+    iutf_stats_print_json(stderr, &stats);
+}
+
+/*
+ * Batch mode: many files, directories (recursive, *.iutf) or "-" for a list
+ * of paths on stdin. Files are checked on a pool of threads; results are
+ * printed in input order, so the output doesn't depend on scheduling.
+ *
+ * Every file goes through the token checker first (quiet, no tree). Files with
+ * @import or key[type] need the real parser to resolve them, that parse runs
+ * on the worker too unless --check asks for the token check only.
+ *
+ * The files are read ahead of the workers by an IutfLoader (iutf-loader.h),
+ * through io_uring where the kernel allows it (--io picks the engine), so a
+ * worker gets a file already in memory instead of opening and reading it.
+ *
+ * Exit code: 0 all files valid, 1 some file invalid, 2 a file or directory
+ * could not be read.
+ */
+
+enum { FILE_OK, FILE_INVALID, FILE_UNREADABLE };
+
+typedef struct {
+    char* path;
+    int status; // FILE_*
+    int done;
+    double ms;
+    IutfCheckResult result;
+} BatchFile;
+
+typedef struct {
+    BatchFile* files;
+    size_t count;
+    size_t cap;
+    size_t next; // next file for a worker
+    int tokens_only; // --check
+    const IutfSchema* rules;
+    IutfLoader* loader;
+    pthread_mutex_t lock;
+    pthread_cond_t done;
+} Batch;
+
+static int batch_add(Batch* b, const char* path) {
+    if (b->count == b->cap) {
+        size_t cap = b->cap ? b->cap * 2 : 64;
+        BatchFile* temp = realloc(b->files, cap * sizeof(BatchFile));
+        if (!temp) return 0;
+        b->files = temp;
+        b->cap = cap;
+    }
+    BatchFile* f = &b->files[b->count];
+    memset(f, 0, sizeof(*f));
+    f->path = strdup(path);
+    if (!f->path) return 0;
+    b->count++;
+    return 1;
+}
+
+static int compare_names(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+// *.iutf below `dir`, sorted by name so the order is the same on every run
+// compressed files are recognized by their content, the suffix only picks them from a directory
+static int is_iutf_name(const char* path) {
+    static const char* suffixes[] = { ".iutf", ".iutf.gz", ".iutf.zst" };
+    size_t len = strlen(path);
+    for (size_t i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); i++) {
+        size_t n = strlen(suffixes[i]);
+        if (len > n && strcmp(path + len - n, suffixes[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+static int batch_add_dir(Batch* b, const char* dir) {
+    DIR* d = opendir(dir);
+    if (!d) {
+        fprintf(stderr, "\033[31mCannot open directory '%s': %s\033[0m\n", dir, strerror(errno));
+        return 0;
+    }
+
+    char** names = NULL;
+    size_t count = 0, cap = 0;
+    int ok = 1;
+    struct dirent* entry;
+    while ((entry = readdir(d))) {
+        if (entry->d_name[0] == '.') continue; // ".", ".." and hidden files
+        if (count == cap) {
+            cap = cap ? cap * 2 : 32;
+            char** temp = realloc(names, cap * sizeof(char*));
+            if (!temp) {
+                ok = 0;
+                break;
+            }
+            names = temp;
+        }
+        names[count] = strdup(entry->d_name);
+        if (!names[count]) {
+            ok = 0;
+            break;
+        }
+        count++;
+    }
+    closedir(d);
+    qsort(names, count, sizeof(char*), compare_names);
+
+    for (size_t i = 0; i < count; i++) {
+        char* path = NULL;
+        struct stat st;
+        if (ok && asprintf(&path, "%s/%s", dir, names[i]) >= 0 && stat(path, &st) == 0) {
+            if (S_ISDIR(st.st_mode)) {
+                if (!batch_add_dir(b, path)) ok = 0;
+            } else {
+                if (is_iutf_name(path) && !batch_add(b, path)) ok = 0;
+            }
+        }
+        free(path);
+        free(names[i]);
+    }
+    free(names);
+    return ok;
+}
+
+static int batch_add_path(Batch* b, const char* path) {
+    if (strcmp(path, "-") == 0) {
+        char* line = NULL;
+        size_t cap = 0;
+        ssize_t len;
+        int ok = 1;
+        while (ok && (len = getline(&line, &cap, stdin)) >= 0) {
+            while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) line[--len] = '\0';
+            if (len > 0) ok = batch_add_path(b, line);
+        }
+        free(line);
+        return ok;
+    }
+
+    struct stat st;
+    if (stat(path, &st) == 0 && S_ISDIR(st.st_mode)) return batch_add_dir(b, path);
+    return batch_add(b, path); // a missing file is reported in order with the rest
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static void batch_run_file(Batch* b, BatchFile* f, const IutfLoadedFile* loaded) {
+    double start = now_ms();
+    int ok;
+    if (loaded && loaded->error) {
+        memset(&f->result, 0, sizeof(f->result));
+        snprintf(f->result.message, sizeof(f->result.message), "cannot open file");
+        f->ms = now_ms() - start;
+        f->status = FILE_UNREADABLE;
+        return;
+    }
+    // a compressed file is inflated by iutf_check_file
+    int plain = loaded && iutf_compression_detect(loaded->data, loaded->len) == IUTF_COMPRESSION_NONE;
+    if (plain) {
+        ok = iutf_check(loaded->data, loaded->len, b->rules, &f->result);
+    } else {
+        ok = iutf_check_file(f->path, b->rules, &f->result);
+    }
+
+    if (ok && f->result.unresolved && !b->tokens_only) {
+        // imports and types: only the parser knows them
+        IutfNode* ast = NULL;
+        if (plain) {
+            // the loader already read it, imports are still resolved from f->path
+            IutfParser* parser = iutf_parser_new_len(loaded->data, loaded->len, iutf_allocator_current());
+            if (parser) {
+                parser->filename = f->path;
+                ast = iutf_parse(parser);
+                iutf_parser_free(parser);
+            }
+        } else {
+            ast = iutf_parse_from_file(f->path);
+        }
+        if (!ast) {
+            ok = 0;
+            snprintf(f->result.message, sizeof(f->result.message), "parse failed");
+        } else {
+            ok = iutf_schema_validate(b->rules, ast);
+            if (!ok) snprintf(f->result.message, sizeof(f->result.message), "validation failed");
+            iutf_node_free(ast);
+        }
+    }
+
+    f->ms = now_ms() - start;
+    // line 0 without a message from the parser means the file itself is the problem
+    if (ok) f->status = FILE_OK;
+    else f->status = f->result.line == 0 && access(f->path, R_OK) != 0 ? FILE_UNREADABLE : FILE_INVALID;
+}
+
+static void* batch_worker(void* arg) {
+    Batch* b = arg;
+    for (;;) {
+        IutfLoadedFile loaded;
+        size_t i;
+        if (b->loader) {
+            // in the order the reads complete
+            if (!iutf_loader_next(b->loader, &loaded)) return NULL;
+            i = loaded.index;
+        } else {
+            pthread_mutex_lock(&b->lock);
+            i = b->next++;
+            pthread_mutex_unlock(&b->lock);
+            if (i >= b->count) return NULL;
+        }
+
+        batch_run_file(b, &b->files[i], b->loader ? &loaded : NULL);
+        if (b->loader) free(loaded.data);
+
+        pthread_mutex_lock(&b->lock);
+        b->files[i].done = 1;
+        pthread_cond_broadcast(&b->done);
+        pthread_mutex_unlock(&b->lock);
+    }
+}
+
+static void json_string(FILE* fp, const char* str) {
+    fputc('"', fp);
+    for (const unsigned char* p = (const unsigned char*)str; *p; p++) {
+        if (*p == '"' || *p == '\\') fprintf(fp, "\\%c", *p);
+        else if (*p < 0x20) fprintf(fp, "\\u%04x", *p);
+        else fputc(*p, fp);
+    }
+    fputc('"', fp);
+}
+
+static int write_summary(const char* out, const Batch* b, int jobs, double wall_ms, size_t counts[3]) {
+    FILE* fp = strcmp(out, "-") == 0 ? stdout : fopen(out, "w");
+    if (!fp) {
+        perror("Cannot open file");
+        return 0;
+    }
+
+    fprintf(fp, "{\"files\":%zu,\"passed\":%zu,\"failed\":%zu,\"unreadable\":%zu,\"jobs\":%d,\"io\":\"%s\",\"wall_ms\":%.3f,\"failures\":[",
+            b->count, counts[FILE_OK], counts[FILE_INVALID], counts[FILE_UNREADABLE], jobs,
+            b->loader ? iutf_io_engine_name(iutf_loader_engine(b->loader)) : "none", wall_ms);
+    int first = 1;
+    for (size_t i = 0; i < b->count; i++) {
+        const BatchFile* f = &b->files[i];
+        if (f->status == FILE_OK) continue;
+        fputs(first ? "{\"file\":" : ",{\"file\":", fp);
+        json_string(fp, f->path);
+        fprintf(fp, ",\"line\":%d,\"col\":%d,\"message\":", f->result.line, f->result.col);
+        json_string(fp, f->result.message);
+        fputs(",\"path\":", fp);
+        json_string(fp, f->result.path);
+        fputc('}', fp);
+        first = 0;
+    }
+    fputs("],\"timings\":[", fp);
+    for (size_t i = 0; i < b->count; i++) {
+        fputs(i ? ",{\"file\":" : "{\"file\":", fp);
+        json_string(fp, b->files[i].path);
+        fprintf(fp, ",\"ms\":%.3f}", b->files[i].ms);
+    }
+    fputs("]}\n", fp);
+    return fp == stdout ? fflush(fp) == 0 : fclose(fp) == 0;
+}
+
+static int batch_files(int count, char** paths, int tokens_only, int jobs, IutfIoEngine io, const char* summary) {
+    Batch b;
+    memset(&b, 0, sizeof(b));
+    b.tokens_only = tokens_only;
+    b.rules = schema ? schema : iutf_schema_default();
+    pthread_mutex_init(&b.lock, NULL);
+    pthread_cond_init(&b.done, NULL);
+
+    int status = 0;
+    for (int i = 0; i < count; i++) {
+        if (!batch_add_path(&b, paths[i])) status = 2;
+    }
+
+    if (jobs <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        jobs = cores > 0 ? (int)cores : 1;
+    }
+    if ((size_t)jobs > b.count) jobs = b.count ? (int)b.count : 1;
+
+    double start = now_ms();
+    // NULL (out of memory) is fine, the workers then read the files themselves
+    char** names = malloc((b.count ? b.count : 1) * sizeof(char*));
+    for (size_t i = 0; names && i < b.count; i++) names[i] = b.files[i].path;
+    if (names) b.loader = iutf_loader_new((const char* const*)names, b.count, io, 0);
+    pthread_t* threads = calloc(jobs, sizeof(pthread_t));
+    int started = 0;
+    while (threads && started < jobs && pthread_create(&threads[started], NULL, batch_worker, &b) == 0) started++;
+    if (started == 0) batch_worker(&b); // no threads, do it here
+
+    // print in input order as soon as each file is done
+    size_t counts[3] = { 0, 0, 0 };
+    for (size_t i = 0; i < b.count; i++) {
+        BatchFile* f = &b.files[i];
+        pthread_mutex_lock(&b.lock);
+        while (!f->done) pthread_cond_wait(&b.done, &b.lock);
+        pthread_mutex_unlock(&b.lock);
+
+        counts[f->status]++;
+        if (f->status != FILE_OK) fflush(stdout); // keep the order when both streams go to one place
+        iutf_check_report(f->status == FILE_OK ? stdout : stderr, f->path, f->status == FILE_OK, &f->result);
+        if (f->status == FILE_INVALID && status == 0) status = 1;
+        if (f->status == FILE_UNREADABLE) status = 2;
+    }
+    for (int i = 0; i < started; i++) pthread_join(threads[i], NULL);
+    double wall_ms = now_ms() - start;
+
+    if (summary && !write_summary(summary, &b, jobs, wall_ms, counts)) status = 2;
+
+    iutf_loader_free(b.loader);
+    free(names);
+
+    for (size_t i = 0; i < b.count; i++) free(b.files[i].path);
+    free(b.files);
+    free(threads);
+    pthread_mutex_destroy(&b.lock);
+    pthread_cond_destroy(&b.done);
+    return status;
+}
+
+// bench [-n N] [--warmup N] [--json] files...: exit 1 if any file couldn't be measured
+static int bench_files(int argc, char** argv) {
+    IutfBenchOptions options = { 0, -1, schema };
+    int json = 0;
+    int i = 0;
+    for (; i < argc; i++) {
+        if (i + 1 < argc && strcmp(argv[i], "-n") == 0) {
+            options.iterations = atoi(argv[++i]);
+        } else if (i + 1 < argc && strcmp(argv[i], "--warmup") == 0) {
+            options.warmup = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--json") == 0) {
+            json = 1;
+        } else {
+            break;
+        }
+    }
+    if (i == argc) return 2;
+
+    IutfBenchResult* results = calloc(argc - i, sizeof(IutfBenchResult));
+    if (!results) return 1;
+    size_t count = 0;
+    int status = 0;
+    for (; i < argc; i++) {
+        if (iutf_bench_file(argv[i], &options, &results[count])) count++;
+        else status = 1;
+    }
+
+    if (json) iutf_bench_report_json(stdout, results, count);
+    else iutf_bench_report(stdout, results, count);
+    free(results);
+    return status;
+}
+
+/*
+ * log: a file of concatenated documents (iutf-log.h), parsed on -j threads.
+ * Records that don't parse (or fail --schema) are reported on stderr in file
+ * order; --print writes each good one as a compact line, --json as NDJSON.
+ */
+enum { LOG_CHECK, LOG_PRINT, LOG_JSON };
+
+typedef struct {
+    const char* filename;
+    int mode;
+    size_t failed;
+} LogRun;
+
+static int stdout_sink(void* ctx, const char* data, size_t len) {
+    (void)ctx;
+    return fwrite(data, 1, len, stdout) == len ? 0 : -1;
+}
+
+static int log_record(void* ctx, size_t index, const IutfLogRecord* record, IutfNode* root) {
+    LogRun* state = ctx;
+    const char* problem = !root ? "parse failed" : schema && !iutf_schema_validate(schema, root) ? "validation failed" : NULL;
+    if (problem) {
+        fflush(stdout);
+        fprintf(stderr, "\033[31mRecord %zu at %s:%zu: %s\033[0m\n", index + 1, state->filename, record->line, problem);
+        state->failed++;
+    } else if (state->mode == LOG_PRINT) {
+        iutf_serialize_to_file(root, IUTF_WRITE_COMPACT, stdout);
+        putchar('\n');
+    } else if (state->mode == LOG_JSON) {
+        iutf_iutf_to_json(record->data, record->len, stdout_sink, NULL, IUTF_WRITE_COMPACT);
+        putchar('\n');
+    }
+    iutf_node_free(root);
+    return 1;
+}
+
+// exit 1 if a record failed or the log ends in an unfinished one, 2 on usage errors
+static int log_file(int argc, char** argv, int jobs) {
+    LogRun state = { NULL, LOG_CHECK, 0 };
+    int i = 0;
+    for (; i < argc; i++) {
+        if (i + 1 < argc && (strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--jobs") == 0)) {
+            jobs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--print") == 0) {
+            state.mode = LOG_PRINT;
+        } else if (strcmp(argv[i], "--json") == 0) {
+            state.mode = LOG_JSON;
+        } else {
+            break;
+        }
+    }
+    if (i + 1 != argc) return 2;
+    state.filename = argv[i];
+
+    IutfLog* log = iutf_log_open(state.filename);
+    if (!log) return 1;
+    iutf_log_each(log, jobs, log_record, &state);
+    fflush(stdout);
+
+    int status = state.failed ? 1 : 0;
+    if (log->tail_line) {
+        fprintf(stderr, "\033[31mUnfinished record at %s:%zu\033[0m\n", state.filename, log->tail_line);
+        status = 1;
+    }
+    if (state.mode == LOG_CHECK) {
+        printf("%s%zu records, %zu failed\033[0m\n", status ? "\033[31m" : "\033[32m", log->count, state.failed);
+    }
+    iutf_log_close(log);
+    return status;
+}
+
+static int run(const char* filename);
 
 int main(int argc, char *argv[]) {
+    // leading options, in any order
+    int check = 0;
+    int jobs = 0;
+    const char* summary = NULL;
+    IutfIoEngine io = IUTF_IO_AUTO;
+    while (argc > 1) {
+        int shift;
+        if (argc > 2 && (strcmp(argv[1], "-j") == 0 || strcmp(argv[1], "--jobs") == 0)) {
+            jobs = atoi(argv[2]);
+            shift = 2;
+        } else if (argc > 2 && strcmp(argv[1], "--io") == 0) {
+            int engine = iutf_io_engine_parse(argv[2]);
+            if (engine < 0) {
+                fprintf(stderr, "\033[31mUnknown I/O engine '%s' (auto, uring, pread)\033[0m\n", argv[2]);
+                return 2;
+            }
+            io = (IutfIoEngine)engine;
+            shift = 2;
+        } else if (argc > 2 && strcmp(argv[1], "--summary") == 0) {
+            summary = argv[2];
+            shift = 2;
+        } else if (strcmp(argv[1], "--cache") == 0) {
+            iutf_cache_set_enabled(1); // same as IUTF_CACHE=1
+            shift = 1;
+        } else if (strcmp(argv[1], "--check") == 0) {
+            check = 1;
+            shift = 1;
+        } else if (strcmp(argv[1], "--stats") == 0) {
+            iutf_stats_enable(1); // same as IUTF_STATS=1
+            if (!show_stats) atexit(print_stats);
+            show_stats = 1;
+            shift = 1;
+        } else if (argc > 2 && strcmp(argv[1], "--schema") == 0) {
+            iutf_schema_free(schema);
+            schema = iutf_schema_load(argv[2]);
+            if (!schema) {
+                fprintf(stderr, "\033[31mCannot load schema '%s'\033[0m\n", argv[2]);
+                return 1;
+            }
+            shift = 2;
+        } else {
+            break;
+        }
+        argv[shift] = argv[0];
+        argv += shift;
+        argc -= shift;
+    }
+
+    if (argc == 4 && strcmp(argv[1], "--to-binary") == 0) return to_binary(argv[2], argv[3]);
+    if ((argc == 3 || argc == 4) && strcmp(argv[1], "--from-binary") == 0) return from_binary(argv[2], argc == 4 ? argv[3] : NULL);
+    if ((argc == 3 || argc == 4) && strcmp(argv[1], "--to-json") == 0) return transcode(argv[2], argc == 4 ? argv[3] : NULL, 1);
+    if ((argc == 3 || argc == 4) && strcmp(argv[1], "--from-json") == 0) return transcode(argv[2], argc == 4 ? argv[3] : NULL, 0);
+
+    if (argc >= 2 && strcmp(argv[1], "bench") == 0) {
+        int status = bench_files(argc - 2, argv + 2);
+        if (status == 2) usage(argv[0]);
+        iutf_schema_free(schema);
+        return status ? 1 : 0;
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "log") == 0) {
+        int status = log_file(argc - 2, argv + 2, jobs);
+        if (status == 2) usage(argv[0]);
+        iutf_schema_free(schema);
+        return status;
+    }
+
+    // several paths, a directory, "-" or batch options: batch mode
+    struct stat st;
+    int batch = check || summary || jobs || io != IUTF_IO_AUTO || argc > 2
+             || (argc == 2 && (strcmp(argv[1], "-") == 0 || (stat(argv[1], &st) == 0 && S_ISDIR(st.st_mode))));
+    if (batch) {
+        if (argc < 2) {
+            usage(argv[0]);
+            iutf_schema_free(schema);
+            return 2;
+        }
+        int status = batch_files(argc - 1, argv + 1, check, jobs, io, summary);
+        iutf_schema_free(schema);
+        return status;
+    }
+
     if (argc != 2) {
-        fprintf(stderr, "Usage: %s <file.iutf>\n", argv[0]);
+        usage(argv[0]);
         return 1;
     }
 
-    FILE* file = fopen(argv[1], "r");
+    int status = run(argv[1]);
+    iutf_schema_free(schema);
+    return status;
+}
+
+static int run(const char* filename) {
+
+    // compressed files go through the stream, see iutf-decompress.h
+    if (iutf_cache_enabled() || iutf_compression_of_file(filename) != IUTF_COMPRESSION_NONE) {
+        IutfNode* ast = iutf_parse_from_file(filename);
+        if (!ast) {
+            fprintf(stderr, "\033[31mParse failed\033[0m\n");
+            return 1;
+        }
+        report(ast);
+        iutf_node_free(ast);
+        return 0;
+    }
+
+    FILE* file = fopen(filename, "r");
     if (!file) {
         perror("Cannot open file");
         return 1;
@@ -63,13 +703,7 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
-    printf("\033[32mParse successful!\033[0m\n");
-
-    if (iutf_validate(ast)) {
-        printf("\033[32mValidation passed!\033[0m\n");
-    } else {
-        printf("\033[31mValidation failed!\033[0m\n");
-    }
+    report(ast);
 
     iutf_node_free(ast);
     iutf_parser_free(parser);
@@ -0,0 +1,123 @@
+/* iutf-alloc.h
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Alloc version 0.1
+ */
+#ifndef IUTF_ALLOC_H
+#define IUTF_ALLOC_H
+
+#include "iutf-ast.h"
+#include "iutf-stats.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Every allocation of a document tree, the parser and the lexer goes through
+ * an IutfAllocator: the calling thread's (iutf_allocator_use, or a parser's
+ * while iutf_parse runs), else the process default, else libc.
+ *
+ * A tree has to be modified and freed under the allocator it was built with,
+ * e.g. with iutf_node_free_with. Shared frozen subtrees (iutf-persist.h) must
+ * not cross allocators. Strings given to the *_take builders come from
+ * iutf_malloc / iutf_strdup. Counted by iutf-stats when it is enabled.
+ */
+
+typedef struct IutfAllocator {
+  void* (*alloc) (void* ctx, size_t size);
+  void* (*realloc) (void* ctx, void* ptr, size_t size);
+  void (*free) (void* ctx, void* ptr);
+  void* ctx;
+  // optional: usable size of a block, for iutf_doc_memory_usage (iutf-stats.h);
+  // without it the sizes that were asked for are counted
+  size_t (*size) (void* ctx, const void* ptr);
+} IutfAllocator;
+
+// malloc, realloc and free
+extern const IutfAllocator iutf_allocator_libc;
+
+// process default, NULL restores libc; set it before the library allocates anything
+void iutf_allocator_set_default (const IutfAllocator* allocator);
+
+// this thread's allocator, NULL = the default; returns the previous one to restore
+const IutfAllocator* iutf_allocator_use (const IutfAllocator* allocator);
+
+// what iutf_malloc uses now, NULL = libc
+const IutfAllocator* iutf_allocator_current (void);
+
+// iutf_node_free with `allocator` as this thread's allocator
+void iutf_node_free_with (IutfNode* node, const IutfAllocator* allocator);
+
+extern const IutfAllocator* iutf_allocator_default;
+extern __thread const IutfAllocator* iutf_allocator_tls;
+
+static inline const IutfAllocator* iutf_allocator_active (void)
+{
+  return iutf_allocator_tls ? iutf_allocator_tls : iutf_allocator_default;
+}
+
+static inline void* iutf_malloc (size_t size)
+{
+  IUTF_STAT_ADD (alloc_calls, 1);
+  IUTF_STAT_ADD (alloc_bytes, size);
+  const IutfAllocator* a = iutf_allocator_active ();
+  return a ? a->alloc (a->ctx, size) : malloc (size);
+}
+
+static inline void* iutf_calloc (size_t count, size_t size)
+{
+  IUTF_STAT_ADD (alloc_calls, 1);
+  IUTF_STAT_ADD (alloc_bytes, count * size);
+  const IutfAllocator* a = iutf_allocator_active ();
+  if (!a) return calloc (count, size);
+  if (size && count > SIZE_MAX / size) return NULL;
+  void* ptr = a->alloc (a->ctx, count * size);
+  if (ptr) memset (ptr, 0, count * size);
+  return ptr;
+}
+
+static inline void* iutf_realloc (void* ptr, size_t size)
+{
+  IUTF_STAT_ADD (realloc_calls, 1);
+  IUTF_STAT_ADD (realloc_bytes, size);
+  const IutfAllocator* a = iutf_allocator_active ();
+  return a ? a->realloc (a->ctx, ptr, size) : realloc (ptr, size);
+}
+
+static inline void iutf_free (void* ptr)
+{
+  if (!ptr) return;
+  IUTF_STAT_ADD (free_calls, 1);
+  const IutfAllocator* a = iutf_allocator_active ();
+  if (a) a->free (a->ctx, ptr);
+  else free (ptr);
+}
+static inline char* iutf_strndup (const char* str, size_t len)
+{
+  char* copy = (char*) iutf_malloc (len + 1);
+  if (!copy) return NULL;
+  memcpy (copy, str, len);
+  copy[len] = '\0';
+  return copy;
+}
+
+static inline char* iutf_strdup (const char* str)
+{
+  return iutf_strndup (str, strlen (str));
+}
+
+#endif
@@ -29,9 +29,25 @@ void to_branch (IutfNode   *branch,
                       const char *key,
                       IutfNode   *value);
 
+// same without copying the key: a literal or a string that outlives the node
+void to_branch_static (IutfNode   *branch,
+                       const char *key,
+                       IutfNode   *value);
+
+// same with a key from iutf_malloc / iutf_strdup the node takes over (freed on failure)
+void to_branch_take (IutfNode *branch,
+                     char     *key,
+                     IutfNode *value);
+
 // create string
 IutfNode* iutf_new_str (const char* value);
 
+// string from an iutf_malloc / iutf_strdup buffer, the node frees it (also on failure)
+IutfNode* iutf_new_str_take (char* value);
+
+// string that is not copied: a literal or a buffer that outlives the node
+IutfNode* iutf_new_str_static (const char* value);
+
 // create Integer number
 IutfNode* iutf_new_int (long long value);
 
@@ -57,16 +73,27 @@ IutfNode* iutf_new_array (void);
 void add_to_array (IutfNode *array,
                    IutfNode *item);
 
+// room for `count` more items in a branch or array, returns 0 on error
+int iutf_reserve (IutfNode *node,
+                  size_t    count);
+
+// append many scalars at once, returns 0 on error (the array is left unchanged)
+int iutf_array_append_ints (IutfNode *array, const long long *values, size_t count);
+int iutf_array_append_floats (IutfNode *array, const double *values, size_t count);
+int iutf_array_append_strs (IutfNode *array, const char **values, size_t count);
+int iutf_array_append_strs_static (IutfNode *array, const char **values, size_t count);
+
 // create bigstring
 IutfNode* iutf_new_BigString (const char* value);
 
 // create PipeString
 IutfNode* iutf_new_PipeStr (const char* value);
 
-// Print IUTF to string (for debugging)
-char* debug_print_string (IutfNode* node);
+// text of a BigString or PipeString with IUTF_BLOCK_TRIM / IUTF_BLOCK_DEDENT (iutf-lexer.h) applied,
+// malloc'd for the caller to free; NULL for other nodes
+char* iutf_get_block (const IutfNode* node, int flags);
 
-// recursive function-helper
-static void debug_print_recursive (IutfNode* node, char** buf, size_t* size, int indent);
+// Print IUTF to string (for debugging), see iutf-serialize.h for real IUTF output
+char* debug_print_string (IutfNode* node);
 
 #endif
@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 
 typedef enum {
     IUTF_NODE_BRANCH,
@@ -42,6 +43,7 @@ typedef enum {
 typedef struct IutfNode {
     IutfNodeType type;
     char* key; // for key-value pairs
+    unsigned int refcount; // 0 = mutable tree, >0 = frozen/shared (see iutf-persist.h)
     union {
         char* str_value;
         long long int_value;
@@ -52,17 +54,32 @@ typedef struct IutfNode {
         struct {
             struct IutfNode** items;
             size_t size;
+            size_t capacity; // allocated slots, may be below size for exact-size arrays
         } array;
         struct {
             struct IutfNode** items;
             size_t size;
+            size_t capacity;
         } branch;
         char* bigstring_value;
         char* pipestring_value;
     } data;
+    uint64_t hash; // cached structural hash tagged with its mode, 0 if none; see iutf-diff.h
+    unsigned int flags; // IUTF_NODE_FLAG_*
 } IutfNode;
 
+#define IUTF_NODE_FLAG_KEY_BORROWED (1u << 2) // `key` is not owned by the node and never freed
+#define IUTF_NODE_FLAG_STR_BORROWED (1u << 3) // same for `data.str_value`
+
 IutfNode* iutf_node_new(IutfNodeType type);
 void iutf_node_free(IutfNode* node);
 
+// room for `extra` more items in an array or branch, grows geometrically; 0 on error
+int iutf_node_reserve(IutfNode* node, size_t extra);
+// append to an array or branch (the key is left as is), 0 on error; drops the
+// node's cached hash, not its ancestors' (iutf_hash_invalidate in iutf-diff.h)
+int iutf_node_append(IutfNode* node, IutfNode* item);
+// replace the key, `owned` = the node frees it
+void iutf_node_set_key(IutfNode* node, char* key, int owned);
+
 #endif /* IUTF_AST_H */
@@ -0,0 +1,82 @@
+/* iutf-bench.h
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Bench version 0.1
+ */
+#ifndef IUTF_BENCH_H
+#define IUTF_BENCH_H
+
+#include "iutf-schema.h"
+#include <stddef.h>
+#include <stdio.h>
+
+/*
+ * Per-phase timing of the library on one file. Each iteration lexes the
+ * whole input (iutf_lexer_next loop), parses it (iutf_parse), validates the
+ * tree, serializes it (compact writer) and frees it; every phase is timed on
+ * its own with CLOCK_MONOTONIC. Warm-up iterations are run first and dropped.
+ */
+
+typedef enum {
+  IUTF_BENCH_LEX,
+  IUTF_BENCH_PARSE,
+  IUTF_BENCH_VALIDATE,
+  IUTF_BENCH_SERIALIZE,
+  IUTF_BENCH_FREE,
+  IUTF_BENCH_PHASES
+} IutfBenchPhase;
+
+typedef struct {
+  int iterations; // timed runs, default 20
+  int warmup; // dropped runs, default 3
+  const IutfSchema* schema; // NULL = the built-in one
+} IutfBenchOptions;
+
+typedef struct {
+  int timed; // 0 when the phase was skipped (e.g. the file fails validation)
+  double min_ms;
+  double mean_ms;
+  double p50_ms;
+  double p90_ms;
+  double p99_ms;
+  double max_ms;
+  double mb_per_s; // input size / mean
+  double tokens_per_s;
+} IutfBenchStats;
+
+typedef struct {
+  const char* file;
+  size_t bytes;
+  size_t tokens;
+  size_t nodes;
+  size_t allocations; // heap blocks owned by one parsed tree
+  size_t tree_bytes; // their usable sizes, see iutf_doc_memory_usage
+  int valid; // passed validation
+  int iterations;
+  IutfBenchStats phases[IUTF_BENCH_PHASES];
+} IutfBenchResult;
+
+// 1 on success, 0 if the file can't be read or parsed
+int iutf_bench_file (const char* filename, const IutfBenchOptions* options, IutfBenchResult* result);
+
+const char* iutf_bench_phase_name (IutfBenchPhase phase);
+
+// table for people, one JSON object for dashboards (peak RSS of the process included)
+void iutf_bench_report (FILE* fp, const IutfBenchResult* results, size_t count);
+void iutf_bench_report_json (FILE* fp, const IutfBenchResult* results, size_t count);
+
+#endif
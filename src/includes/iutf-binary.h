@@ -0,0 +1,122 @@
+/* iutf-binary.h
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Binary version 0.1
+ */
+#ifndef IUTF_BINARY_H
+#define IUTF_BINARY_H
+
+#include "iutf-ast.h"
+#include "iutf-buffer.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Binary IUTF (.iutb), read in place from an mmap'd file:
+ *
+ *   header    IutfBinHeader, 64 bytes
+ *   nodes     IutfBinNode[node_count], 16 bytes each, node 0 is the root;
+ *             the children of a branch/array are stored next to each other
+ *   keys      IutfBinKey[key_count], sorted by name, a key id is its index
+ *   strings   string pool, every string is NUL-terminated and deduplicated
+ *
+ * Values are in host byte order, files from a different byte order are rejected.
+ */
+
+#define IUTF_BIN_MAGIC   "IUTB"
+#define IUTF_BIN_VERSION 1
+#define IUTF_BIN_NO_KEY  UINT32_MAX
+
+typedef struct {
+  char magic[4];
+  uint16_t version;
+  uint16_t header_size;
+  uint32_t byte_order; // 0x01020304 as written
+  uint32_t node_count;
+  uint32_t key_count;
+  uint32_t reserved;
+  uint64_t nodes_offset;
+  uint64_t keys_offset;
+  uint64_t strings_offset;
+  uint64_t strings_size;
+  uint64_t file_size;
+} IutfBinHeader;
+
+typedef struct {
+  uint32_t offset; // into the string pool
+  uint32_t len;
+} IutfBinKey;
+
+typedef struct {
+  uint8_t type; // IutfNodeType
+  uint8_t pad[3];
+  uint32_t key; // key id, IUTF_BIN_NO_KEY for array items and the root
+  union {
+    int64_t i; // integer, long, character, boolean
+    double f;
+    struct {
+      uint32_t first; // index of the first child
+      uint32_t count;
+    } children;
+    IutfBinKey str; // string, BigString, PipeString
+  } v;
+} IutfBinNode;
+
+// an open binary document, usually on the caller's stack
+typedef struct {
+  const uint8_t* data;
+  size_t size;
+  void* map; // mapping released by iutf_bin_close, NULL for memory
+  size_t map_size;
+  const IutfBinHeader* header;
+  const IutfBinNode* nodes;
+  const IutfBinKey* keys;
+  const char* strings;
+} IutfBinary;
+
+/* writing */
+int iutf_bin_write (IutfNode* root, IutfBuffer* buf);
+int iutf_bin_write_file (IutfNode* root, const char* path);
+
+/* reading: open validates the header only, accessors are bounds checked */
+int iutf_bin_open (IutfBinary* bin, const char* path);
+int iutf_bin_open_mem (IutfBinary* bin, const void* data, size_t size);
+void iutf_bin_close (IutfBinary* bin);
+
+const IutfBinNode* iutf_bin_root (const IutfBinary* bin);
+const char* iutf_bin_key (const IutfBinary* bin, const IutfBinNode* node);
+size_t iutf_bin_size (const IutfBinNode* node);
+const IutfBinNode* iutf_bin_child (const IutfBinary* bin, const IutfBinNode* node, size_t index);
+
+// key name -> id by binary search, resolve once and reuse the id for repeated lookups
+uint32_t iutf_bin_key_id (const IutfBinary* bin, const char* key);
+const IutfBinNode* iutf_bin_get_id (const IutfBinary* bin, const IutfBinNode* branch, uint32_t key_id);
+const IutfBinNode* iutf_bin_get (const IutfBinary* bin, const IutfBinNode* branch, const char* key);
+
+static inline IutfNodeType iutf_bin_type (const IutfBinNode* node) { return (IutfNodeType) node->type; }
+static inline long long iutf_bin_int (const IutfBinNode* node) { return node->v.i; }
+static inline double iutf_bin_float (const IutfBinNode* node) { return node->v.f; }
+static inline int iutf_bin_bool (const IutfBinNode* node) { return node->v.i != 0; }
+static inline char iutf_bin_char (const IutfBinNode* node) { return (char) node->v.i; }
+
+// string, BigString or PipeString, `len` may be NULL
+const char* iutf_bin_str (const IutfBinary* bin, const IutfBinNode* node, size_t* len);
+
+/* converting back to a tree */
+IutfNode* iutf_bin_to_node (const IutfBinary* bin, const IutfBinNode* node);
+
+#endif
@@ -0,0 +1,112 @@
+/* iutf-bind.h
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Bind version 0.1
+ */
+#ifndef IUTF_BIND_H
+#define IUTF_BIND_H
+
+#include <stddef.h>
+
+/*
+ * Runtime binding of a document to a C struct described by a field table,
+ * for when iutf-gen is not an option. Values are read from the token stream
+ * straight into the struct, no IutfNode is built.
+ *
+ *   typedef struct { char* name; long long port; IutfBindArray hosts; } Cfg;
+ *
+ *   static const IutfBindField cfg_fields[] = {
+ *     { .key = "name", .type = IUTF_BIND_STRING, .offset = offsetof (Cfg, name), .flags = IUTF_BIND_REQUIRED },
+ *     { .key = "port", .type = IUTF_BIND_INT, .offset = offsetof (Cfg, port) },
+ *     { .key = "hosts", .type = IUTF_BIND_ARRAY, .item = IUTF_BIND_STRING, .offset = offsetof (Cfg, hosts) },
+ *   };
+ *   static const IutfBindDesc cfg_desc = IUTF_BIND_DESC (Cfg, cfg_fields);
+ *
+ *   Cfg cfg;
+ *   if (!iutf_bind (input, len, &cfg_desc, &cfg)) ...
+ *   iutf_bind_free (&cfg_desc, &cfg);
+ *
+ * A descriptor is compiled into a hashed field table on first use and cached,
+ * descriptors must stay alive (usually they are static const).
+ */
+
+typedef enum {
+  IUTF_BIND_INT,     // long long
+  IUTF_BIND_INT32,   // int, range-checked
+  IUTF_BIND_DOUBLE,  // double, integers too
+  IUTF_BIND_BOOL,    // int
+  IUTF_BIND_CHAR,    // char
+  IUTF_BIND_STRING,  // see IutfBindStringMode
+  IUTF_BIND_STRUCT,  // nested struct described by `nested`
+  IUTF_BIND_ARRAY,   // items of type `item`, see `capacity`
+} IutfBindType;
+
+typedef enum {
+  IUTF_BIND_DUP,   // char*, malloc'd, freed by iutf_bind_free
+  IUTF_BIND_SPAN,  // IutfBindSpan into the input, which must outlive the struct
+  IUTF_BIND_FIXED, // char[size] inside the struct, too long is an error
+} IutfBindStringMode;
+
+// flags
+#define IUTF_BIND_REQUIRED (1u << 0)
+
+typedef struct {
+  const char* ptr; // not NUL-terminated
+  size_t len;
+} IutfBindSpan;
+
+// a dynamic array field
+typedef struct {
+  void* items;
+  size_t count;
+} IutfBindArray;
+
+typedef struct IutfBindDesc IutfBindDesc;
+
+typedef struct {
+  const char* key;
+  IutfBindType type;
+  size_t offset; // offsetof the member
+  unsigned flags; // IUTF_BIND_*
+  IutfBindStringMode mode; // strings and string items
+  size_t size; // IUTF_BIND_FIXED buffer size
+  const IutfBindDesc* nested; // structs and struct items
+  IutfBindType item; // arrays
+  // arrays: 0 for an IutfBindArray, otherwise items are stored inline
+  // (item[capacity]) and their number goes to a size_t at count_offset
+  size_t capacity;
+  size_t count_offset;
+} IutfBindField;
+
+struct IutfBindDesc {
+  const IutfBindField* fields;
+  size_t count;
+  size_t size; // sizeof the struct, for arrays of structs
+  int strict; // unknown keys are errors
+};
+
+#define IUTF_BIND_DESC(type, fields) { fields, sizeof (fields) / sizeof ((fields)[0]), sizeof (type), 0 }
+
+// fill `out` from a document, 1 on success; on failure the error is printed
+// and `out` is left zeroed
+int iutf_bind (const char* input, size_t len, const IutfBindDesc* desc, void* out);
+// the file is mapped only while binding, IUTF_BIND_SPAN is refused here
+int iutf_bind_file (const char* filename, const IutfBindDesc* desc, void* out);
+// free what iutf_bind allocated and zero the struct
+void iutf_bind_free (const IutfBindDesc* desc, void* out);
+
+#endif
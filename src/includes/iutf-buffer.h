@@ -0,0 +1,83 @@
+/* iutf-buffer.h
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Buffer version 0.1
+ */
+#ifndef IUTF_BUFFER_H
+#define IUTF_BUFFER_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+
+// receives flushed output, returns 0 on success
+typedef int (*IutfSinkFunc) (void* ctx, const char* data, size_t len);
+
+/*
+ * Output buffer shared by the writers.
+ * Without a sink it grows geometrically and keeps everything in memory.
+ * With a sink (fd, FILE* or callback) it stays at a fixed size and is flushed
+ * whenever it fills up.
+ */
+typedef struct {
+  char* data;
+  size_t len;
+  size_t cap;
+  IutfSinkFunc sink;
+  void* sink_ctx;
+  int error;
+} IutfBuffer;
+
+#define IUTF_BUFFER_SINK_SIZE (64 * 1024)
+
+void iutf_buffer_init (IutfBuffer* buf);
+void iutf_buffer_init_sink (IutfBuffer* buf, IutfSinkFunc sink, void* ctx);
+void iutf_buffer_init_fd (IutfBuffer* buf, int fd);
+
+// the sink of iutf_buffer_init_fd, `ctx` is the fd cast with (void*)(intptr_t)
+int iutf_buffer_fd_sink (void* ctx, const char* data, size_t len);
+void iutf_buffer_init_file (IutfBuffer* buf, FILE* fp);
+
+// make room for `extra` bytes (flushes in sink mode), returns 0 on error
+int iutf_buffer_reserve (IutfBuffer* buf, size_t extra);
+int iutf_buffer_flush (IutfBuffer* buf);
+
+// memory mode: hand over the NUL-terminated contents, the buffer is reset
+char* iutf_buffer_steal (IutfBuffer* buf, size_t* len);
+void iutf_buffer_free (IutfBuffer* buf);
+
+void iutf_buffer_append (IutfBuffer* buf, const char* data, size_t len);
+void iutf_buffer_indent (IutfBuffer* buf, size_t spaces);
+
+// numbers are formatted by hand, without printf
+void iutf_buffer_ll (IutfBuffer* buf, long long value);
+void iutf_buffer_double (IutfBuffer* buf, double value);
+
+// "..." with IUTF escapes
+void iutf_buffer_quoted (IutfBuffer* buf, const char* str, size_t len);
+
+static inline void iutf_buffer_putc (IutfBuffer* buf, char c)
+{
+  if (buf->len + 1 < buf->cap || iutf_buffer_reserve (buf, 1)) buf->data[buf->len++] = c;
+}
+
+static inline void iutf_buffer_puts (IutfBuffer* buf, const char* str)
+{
+  iutf_buffer_append (buf, str, strlen (str));
+}
+
+#endif
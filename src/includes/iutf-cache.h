@@ -0,0 +1,54 @@
+/* iutf-cache.h
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Cache version 0.1
+ */
+#ifndef IUTF_CACHE_H
+#define IUTF_CACHE_H
+
+#include "iutf-ast.h"
+#include "iutf-binary.h"
+#include "iutf-import.h"
+
+/*
+ * Compiled-config cache: the binary form (iutf-binary.h) of a parsed file is kept
+ * in $IUTF_CACHE_DIR, $XDG_CACHE_HOME/iutf or ~/.cache/iutf.
+ *
+ * An entry is valid while the source has the same content hash and every
+ * @import file has the same mtime and size. Entries are written to a temporary
+ * file and renamed into place, so concurrent processes never see a partial one.
+ *
+ * iutf_parse_from_file goes through the cache when IUTF_CACHE=1 is set in the
+ * environment or after iutf_cache_set_enabled (1).
+ */
+
+int iutf_cache_enabled (void);
+void iutf_cache_set_enabled (int enabled);
+
+// malloc'd cache directory, created if missing
+char* iutf_cache_dir (void);
+
+// maps the cached binary of `filename` when it is still valid, returns 1 on a hit
+int iutf_cache_open (const char* filename, IutfBinary* bin);
+
+// stores `root`, parsed from `filename` with the given imports
+int iutf_cache_store (const char* filename, IutfNode* root, const IutfImportList* imports);
+
+// tree from the cache on a hit, otherwise parses the file and stores it
+IutfNode* iutf_cache_parse (const char* filename);
+
+#endif
@@ -0,0 +1,54 @@
+/* iutf-check.h
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Check version 0.1
+ */
+#ifndef IUTF_CHECK_H
+#define IUTF_CHECK_H
+
+#include "iutf-schema.h"
+#include <stdio.h>
+
+typedef struct {
+  int line; // position of the first error, 0 when the document is valid
+  int col;
+  char message[128];
+  char path[256]; // e.g. "server.hosts[2]", empty for the root
+  size_t values; // values seen before stopping
+  size_t max_depth;
+  size_t unresolved; // @import lines, type declarations and key[type] annotations, only a full parse resolves them
+} IutfCheckResult;
+
+/*
+ * Checks syntax and, with a schema, the rules of a document straight on the
+ * token stream: no IutfNode is built and nothing is allocated per value, memory
+ * is a stack of open branches/arrays (plus their required-field bits).
+ * Accepts what iutf_parse accepts; @import lines and type declarations are
+ * skipped, not resolved.
+ *
+ * `schema` may be NULL for a syntax-only check. `input` needs no terminating NUL.
+ * Returns 1 if the document is valid, `result` (optional) tells where it is not.
+ */
+int iutf_check (const char* input, size_t len, const IutfSchema* schema, IutfCheckResult* result);
+
+// same on a memory-mapped file; a gzip/zstd one is decompressed through a window (iutf-decompress.h)
+int iutf_check_file (const char* filename, const IutfSchema* schema, IutfCheckResult* result);
+
+// "file:line:col: message (at path)" or "file: OK"
+void iutf_check_report (FILE* fp, const char* filename, int ok, const IutfCheckResult* result);
+
+#endif
@@ -0,0 +1,79 @@
+/* iutf-decode.h
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Decode version 0.1
+ */
+#ifndef IUTF_DECODE_H
+#define IUTF_DECODE_H
+
+#include "iutf-lexer.h"
+#include <stddef.h>
+
+/*
+ * Pull decoder over the token stream, the runtime of code generated by
+ * iutf-gen: values go straight into C variables, no IutfNode is built.
+ *
+ *   if (!iutf_dec_open (&d, input, len)) ...        // header and root '{'
+ *   while (iutf_dec_key (&d, &key, &key_len)) {     // 0 at '}' or on error
+ *     ... iutf_dec_int (&d, &value) / iutf_dec_skip (&d) ...
+ *   }
+ *   if (d.error) ...
+ *
+ * The first error is latched, printed once and every later call returns 0.
+ */
+typedef struct {
+  IutfLexer* lexer;
+  IutfToken tok;
+  int error;
+  int line; // where the error is
+  int col;
+  char message[128];
+} IutfDecoder;
+
+typedef int (*IutfDecodeFunc) (IutfDecoder* decoder, void* out);
+
+int iutf_dec_open (IutfDecoder* decoder, const char* input, size_t len);
+void iutf_dec_close (IutfDecoder* decoder);
+
+// run `func` on a string or a memory-mapped file, 1 on success
+int iutf_dec_run (const char* input, size_t len, IutfDecodeFunc func, void* out);
+int iutf_dec_run_file (const char* filename, IutfDecodeFunc func, void* out);
+
+// next key of the current branch (key[type] annotations are skipped),
+// 0 after its closing '}' or on error
+int iutf_dec_key (IutfDecoder* decoder, const char** key, size_t* len);
+// expect '{' or '[', then use iutf_dec_key / iutf_dec_item
+int iutf_dec_begin_branch (IutfDecoder* decoder);
+int iutf_dec_begin_array (IutfDecoder* decoder);
+// 1 if another array item follows, 0 after the closing ']' or on error
+int iutf_dec_item (IutfDecoder* decoder);
+
+int iutf_dec_int (IutfDecoder* decoder, long long* out); // 12 and 12L
+int iutf_dec_float (IutfDecoder* decoder, double* out); // integers too
+int iutf_dec_bool (IutfDecoder* decoder, int* out);
+int iutf_dec_char (IutfDecoder* decoder, char* out);
+// "...", BigString[...] or |...|, malloc'd and NUL-terminated
+int iutf_dec_string (IutfDecoder* decoder, char** out);
+// the same text in place, no copy; fails on "..." with escapes
+int iutf_dec_span (IutfDecoder* decoder, const char** start, size_t* len);
+// any value, nested ones included
+int iutf_dec_skip (IutfDecoder* decoder);
+
+// latch an error at the current token, printf-style, always returns 0
+int iutf_dec_fail (IutfDecoder* decoder, const char* fmt, ...) __attribute__ ((format (printf, 2, 3)));
+
+#endif
@@ -0,0 +1,100 @@
+/* iutf-decompress.h
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Decompress version 0.1
+ */
+#ifndef IUTF_DECOMPRESS_H
+#define IUTF_DECOMPRESS_H
+
+#include "iutf-lexer.h"
+#include <stddef.h>
+
+/*
+ * Compressed inputs, recognized by their magic bytes: gzip (zlib) and, when
+ * built with IUTF_WITH_ZSTD (make ZSTD=1), zstd.
+ *
+ * A thread of its own reads and decompresses the file into a ring of
+ * IUTF_DECOMPRESS_BUFFERS blocks while the consumer works on the block before,
+ * so decompression and scanning/parsing overlap and only the ring is in
+ * memory. iutf_parse_from_file, stream_open (iutf-stream.h), iutf_check_file
+ * and iutf_iutf_file_to_json (iutf-json.h) use it by themselves; iutf_log_open
+ * inflates a compressed log whole, its records point into the text.
+ */
+
+#define IUTF_DECOMPRESS_BUFFERS 4
+#define IUTF_DECOMPRESS_BUFFER_SIZE (256 * 1024)
+
+typedef enum {
+  IUTF_COMPRESSION_NONE,
+  IUTF_COMPRESSION_GZIP, // 1f 8b
+  IUTF_COMPRESSION_ZSTD, // 28 b5 2f fd
+} IutfCompression;
+
+IutfCompression iutf_compression_detect (const void* data, size_t len);
+
+// of an open file, read with pread so the offset stays where it was
+IutfCompression iutf_compression_of_fd (int fd);
+
+// of a file by name, IUTF_COMPRESSION_NONE if it cannot be read
+IutfCompression iutf_compression_of_file (const char* filename);
+
+typedef struct IutfDecompressor IutfDecompressor;
+
+// starts decompressing `fd` from its current offset; the caller closes `fd` after iutf_decompress_close
+IutfDecompressor* iutf_decompress_open (int fd, IutfCompression kind, const char* filename);
+
+// the next block, valid until the next call: 1, 0 at the end, -1 on an error (already printed)
+int iutf_decompress_next (IutfDecompressor* d, const char** data, size_t* len);
+
+// stops the thread, also before the end
+void iutf_decompress_close (IutfDecompressor* d);
+
+// everything left in one malloc'd NUL-terminated buffer, for consumers that need it whole; NULL on error
+char* iutf_decompress_all (IutfDecompressor* d, size_t* len);
+
+/*
+ * Token by token over decompressed text: the lexer's input is a window that
+ * holds the current token, what follows it and the newest block. A token is
+ * taken once IUTF_LEX_WINDOW_SLACK bytes follow it, the lexer looks a little
+ * past a token (1.5, 21L, BigString[); one closer to the end is read again
+ * after the next block is in. Lexing errors are printed unless the lexer is
+ * quiet, without the source line the window may no longer hold.
+ */
+
+#define IUTF_LEX_WINDOW_SLACK 64
+
+typedef struct {
+  IutfDecompressor* source;
+  char* data;
+  size_t cap;
+  int done; // no more blocks
+  int failed; // the source broke off (already printed) or out of memory
+  void (*moving) (void* ctx); // called before the text moves, pointers into it go stale
+  void* ctx;
+} IutfLexWindow;
+
+// `lexer` starts empty (iutf_lexer_new_len ("", 0)), the window becomes its input
+void iutf_lex_window_init (IutfLexWindow* w, IutfDecompressor* source);
+void iutf_lex_window_free (IutfLexWindow* w);
+
+// replaces `*tok` with the next token, the text of the old one is readable until then
+void iutf_lex_window_next (IutfLexWindow* w, IutfLexer* lexer, IutfToken* tok);
+
+// the type of the token after `*tok`, which stays readable (its start is moved with the window)
+IutfTokenType iutf_lex_window_peek (IutfLexWindow* w, IutfLexer* lexer, IutfToken* tok);
+
+#endif
@@ -0,0 +1,67 @@
+/* iutf-diff.h
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Diff version 0.1
+ */
+#ifndef IUTF_DIFF_H
+#define IUTF_DIFF_H
+
+#include "iutf-ast.h"
+
+// branch hashes ignore the order of their entries
+#define IUTF_HASH_UNORDERED_BRANCHES (1 << 0)
+
+typedef enum {
+  IUTF_CHANGE_ADDED,
+  IUTF_CHANGE_REMOVED,
+  IUTF_CHANGE_MODIFIED
+} IutfChangeKind;
+
+typedef struct {
+  IutfChangeKind kind;
+  char* path;         // dotted key path, array items by index, "" is the root
+  IutfNode* old_node; // borrowed, NULL for ADDED
+  IutfNode* new_node; // borrowed, NULL for REMOVED
+} IutfChange;
+
+typedef struct {
+  IutfChange* items;
+  size_t size;
+  size_t capacity;
+} IutfDiff;
+
+/*
+ * Structural (Merkle) hash of a subtree, the node's own key is not included.
+ * Hashes are computed lazily and cached in the nodes, so a second diff against
+ * a tree that shares subtrees (iutf-persist.h) only hashes the new parts; the
+ * two modes share the cache, a node hashed in the other one is hashed again.
+ *
+ * After changing a hashed tree in place, call iutf_hash_invalidate() on its
+ * root: nodes don't link to their parents, so an edit (iutf_node_append
+ * included) can't reach the ancestors, which would keep the old hashes.
+ */
+uint64_t iutf_node_hash (IutfNode* node, int flags);
+void iutf_hash_invalidate (IutfNode* node);
+
+// change list between two versions, identical subtrees are skipped by hash
+IutfDiff* iutf_diff (IutfNode* old_root, IutfNode* new_root);
+IutfDiff* iutf_diff_ex (IutfNode* old_root, IutfNode* new_root, int flags);
+void iutf_diff_free (IutfDiff* diff);
+
+const char* iutf_change_kind_to_string (IutfChangeKind kind);
+
+#endif
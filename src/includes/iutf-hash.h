@@ -0,0 +1,46 @@
+/* iutf-hash.h
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Hash version 0.1
+ */
+#ifndef IUTF_HASH_H
+#define IUTF_HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 64-bit non-cryptographic hash (MurmurHash64A), used for keys and structure
+uint64_t iutf_hash_bytes (const void* data, size_t len, uint64_t seed);
+
+// combine two hashes, order matters
+static inline uint64_t iutf_hash_mix (uint64_t a, uint64_t b)
+{
+  uint64_t h = (a ^ b) * 0x9E3779B97F4A7C15ULL;
+  h ^= h >> 32;
+  h *= 0xD6E8FEB86659FD93ULL;
+  h ^= h >> 32;
+  return h ^ (a << 1);
+}
+
+static inline uint64_t iutf_hash_str (const char* str)
+{
+  size_t len = 0;
+  while (str[len]) len++;
+  return iutf_hash_bytes (str, len, 0);
+}
+
+#endif
@@ -20,6 +20,20 @@
 #ifndef IUTF_IMPORT_H
 #define IUTF_IMPORT_H
 
+#include <stddef.h>
+
+// resolved import paths of a document, in the order they were first seen
+typedef struct {
+  char** paths;
+  size_t size;
+} IutfImportList;
+
+// $IUTF_INCLUDE_PATH/<name>/<name>.utext (or pst.utext), iutf_free it; NULL if missing
 char* iutf_find_imported_file(const char* filename);
 
+// returns 1 if added, 0 if already present, -1 on error
+int iutf_import_list_add (IutfImportList* list, const char* path);
+int iutf_import_list_contains (const IutfImportList* list, const char* path);
+void iutf_import_list_clear (IutfImportList* list);
+
 #endif
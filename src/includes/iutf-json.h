@@ -0,0 +1,54 @@
+/* iutf-json.h
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF JSON version 0.1
+ */
+#ifndef IUTF_JSON_H
+#define IUTF_JSON_H
+
+#include "iutf-buffer.h"
+#include "iutf-serialize.h"
+
+/*
+ * Streaming JSON <-> IUTF transcoding: one pass over the tokens, output goes
+ * through a fixed-size buffer to the sink, no IutfNode tree is built.
+ * `flags` is IUTF_WRITE_PRETTY or IUTF_WRITE_COMPACT for the output side.
+ *
+ * Numbers are copied as text, so 64-bit integers and floats keep every digit.
+ * JSON integers outside the 64-bit range become IUTF floats.
+ *
+ * IUTF -> JSON:
+ *   long 5L                      -> 5
+ *   character 'c'                -> "c"
+ *   BigString[...], |...|        -> "..."
+ *   @import lines                -> dropped
+ *
+ * JSON -> IUTF:
+ *   the root object becomes `iutf:init:main`, any other root is stored as `value`
+ *   key bytes that are not valid in an IUTF identifier are written as _xHH, and so is
+ *   the first letter of the keys true, false and null (`_x74rue`)
+ *
+ * Inputs must be readable up to `len`, errors are printed and return 0.
+ */
+int iutf_json_to_iutf (const char* input, size_t len, IutfSinkFunc sink, void* ctx, int flags);
+int iutf_iutf_to_json (const char* input, size_t len, IutfSinkFunc sink, void* ctx, int flags);
+
+// file to file descriptor, the input is mapped; gzip/zstd IUTF is decompressed through a window (iutf-decompress.h)
+int iutf_json_file_to_iutf (const char* path, int out_fd, int flags);
+int iutf_iutf_file_to_json (const char* path, int out_fd, int flags);
+
+#endif
@@ -39,7 +39,7 @@ typedef enum {
   IUTF_TOK_RBRACKET, // ]
   IUTF_TOK_COLON, // :
   IUTF_TOK_EQUALS, // =
-  IUTF_TOK_PIPE, // |
+  IUTF_TOK_PIPE, // |...|, the whole block
   IUTF_TOK_COMMA, // ,
   IUTF_TOK_STRING,
   IUTF_TOK_INTEGER, // 123
@@ -50,11 +50,12 @@ typedef enum {
   IUTF_TOK_FALSE,
   IUTF_TOK_NULL,
   IUTF_TOK_IDENTIFIER,
-  IUTF_TOK_BIGSTRING_START, // BigString[
+  IUTF_TOK_BIGSTRING_START, // BigString[...], the whole block
   IUTF_TOK_COMMENT_LINE, // #!
   IUTF_TOK_COMMENT_CPP, // //
   IUTF_TOK_COMMENT_BLOCK_START, // /*
   IUTF_TOK_COMMENT_BLOCK_END, // */
+  IUTF_TOK_IMPORT, // @import<name>
 } IutfTokenType;
 
 typedef struct {
@@ -71,14 +72,36 @@ typedef struct {
   size_t len;
   int line;
   int col;
+  int quiet; // don't print errors, only record them
+  const char* error; // message of the last lexing error, NULL if none
 } IutfLexer;
 
 IutfLexer* iutf_lexer_new (const char* input);
+// `input` does not have to end at `len` (e.g. a mapped file)
+IutfLexer* iutf_lexer_new_len (const char* input, size_t len);
 void iutf_lexer_corrupt (IutfLexer* lexer);
 IutfToken iutf_lexer_next (IutfLexer* lexer);
+// the same without counting the token in the stats (iutf-stats.h), for lexing ahead on a copy
+IutfToken iutf_lexer_scan (IutfLexer* lexer);
 
 const char* iutf_token_type_to_string (IutfTokenType type);
 
+// decode escapes (\n \t \r \0 \xHH, anything else literal), dst needs len + 1 bytes
+size_t iutf_unescape (const char* src, size_t len, char* dst);
+
+// contents of a STRING token without quotes, escapes decoded (iutf_malloc, iutf-alloc.h)
+char* iutf_token_string (const IutfToken* token);
+
+// the text of a BIGSTRING or PIPE token between its delimiters, as it is in the input
+const char* iutf_token_block (const IutfToken* token, size_t* len);
+
+#define IUTF_BLOCK_TRIM   1 // drop the line break after the opener and the last line if it is only indentation
+#define IUTF_BLOCK_DEDENT 2 // remove the indentation all non-blank lines share
+
+// block text with IUTF_BLOCK_* applied, dst needs len + 1 bytes; the parser keeps blocks raw,
+// this is for when the text is used (iutf_get_block in iutf-api.h for nodes)
+size_t iutf_block_text (const char* src, size_t len, int flags, char* dst);
+
 void print_error_at (const char* input, int line, int col, const char* msg);
 
 char* iutf_find_imported_file (const char* filename);
@@ -0,0 +1,80 @@
+/* iutf-loader.h
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Loader version 0.1
+ */
+#ifndef IUTF_LOADER_H
+#define IUTF_LOADER_H
+
+#include <stddef.h>
+
+/*
+ * Loads many (small) files into memory ahead of the workers that parse them.
+ *
+ * IUTF_IO_URING keeps up to IUTF_LOADER_IN_FLIGHT files in flight on one
+ * io_uring (raw syscalls, no liburing): openat and statx together, then one
+ * read of the whole file, then close, all without a syscall per file.
+ * IUTF_IO_PREAD is a pool of threads doing open/fstat/pread/close, also what
+ * IUTF_IO_AUTO falls back to when io_uring is missing, not allowed or older
+ * than these operations (Linux 5.6). If the kernel still refuses one with
+ * -EINVAL or -EOPNOTSUPP, that file and the rest are read with pread.
+ *
+ * Files come out in completion order, at most IUTF_LOADER_AHEAD of them
+ * waiting, and iutf_loader_next can be called from any number of workers:
+ *
+ *   IutfLoader* loader = iutf_loader_new (paths, count, IUTF_IO_AUTO, 0);
+ *   IutfLoadedFile file;
+ *   while (iutf_loader_next (loader, &file)) { ...paths[file.index]...; free (file.data); }
+ *   iutf_loader_free (loader);
+ */
+
+#define IUTF_LOADER_IN_FLIGHT 128
+#define IUTF_LOADER_AHEAD 512
+
+typedef enum {
+  IUTF_IO_AUTO,
+  IUTF_IO_URING,
+  IUTF_IO_PREAD,
+} IutfIoEngine;
+
+typedef struct {
+  size_t index; // into the paths given to iutf_loader_new
+  char* data; // malloc'd and NUL-terminated, the caller frees it; NULL on error
+  size_t len;
+  int error; // errno of the open, stat or read that failed, 0 on success
+} IutfLoadedFile;
+
+typedef struct IutfLoader IutfLoader;
+
+// starts loading right away; `paths` must outlive the loader; `threads` is for the pread pool, 0 = 4
+IutfLoader* iutf_loader_new (const char* const* paths, size_t count, IutfIoEngine engine, int threads);
+
+// the next loaded file, blocks until one is there: 1, or 0 once every file was handed out
+int iutf_loader_next (IutfLoader* loader, IutfLoadedFile* file);
+
+// the engine in use, never IUTF_IO_AUTO
+IutfIoEngine iutf_loader_engine (const IutfLoader* loader);
+
+const char* iutf_io_engine_name (IutfIoEngine engine);
+
+// "auto", "uring" or "pread", -1 if unknown
+int iutf_io_engine_parse (const char* name);
+
+// waits for the I/O threads; files not taken are freed
+void iutf_loader_free (IutfLoader* loader);
+
+#endif
@@ -0,0 +1,107 @@
+/* iutf-log.h
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Log version 0.1
+ */
+#ifndef IUTF_LOG_H
+#define IUTF_LOG_H
+
+#include "iutf-ast.h"
+#include <pthread.h>
+#include <stddef.h>
+
+/*
+ * Event logs: complete documents one after another, like NDJSON
+ *
+ *   iutf:init:main{event:"login",user:"ann"}
+ *   iutf:init:main{event:"logout",user:"ann"}
+ *
+ * Records are split with the iutf-scan.h scanner (a record ends with the '}'
+ * of its main branch), without tokenizing, then parsed on up to `jobs`
+ * threads and handed to the caller in file order. Whitespace and comments
+ * between records are skipped; an unfinished last record (a writer that
+ * died mid-append) is left out and reported in `tail_line`.
+ */
+
+typedef struct {
+  const char* data; // from the header to the closing '}'
+  size_t len;
+  size_t line; // of the header
+} IutfLogRecord;
+
+typedef struct {
+  char* filename;
+  char* data; // the file, mapped or read
+  size_t len;
+  int mapped;
+  IutfLogRecord* records;
+  size_t count;
+  size_t tail_line; // where an unfinished last record starts, 0 if none
+} IutfLog;
+
+/*
+ * Appends the complete records of `data` to `*records`, which holds `*count`
+ * of `*cap` slots and is grown with realloc (NULL, 0, 0 to start a new one);
+ * `line` is the line `data` starts on. Returns the bytes used, up to the end
+ * of the last complete record; with more data to come, keep the rest and
+ * scan it again. (size_t) -1 when out of memory.
+ */
+size_t iutf_log_split (const char* data, size_t len, size_t line, IutfLogRecord** records, size_t* count, size_t* cap);
+
+// map and split a log file, "-" reads stdin; NULL on error
+IutfLog* iutf_log_open (const char* filename);
+void iutf_log_close (IutfLog* log);
+
+// parse one record, NULL on a parse error
+IutfNode* iutf_log_parse_record (const IutfLog* log, size_t index);
+
+/*
+ * Called on the calling thread in record order. `root` belongs to the callback
+ * and is NULL if the record did not parse. Return 0 to stop.
+ */
+typedef int (*IutfLogFunc) (void* ctx, size_t index, const IutfLogRecord* record, IutfNode* root);
+
+// parse every record on `jobs` threads (0 = one per core); 0 if a callback stopped it
+int iutf_log_each (IutfLog* log, int jobs, IutfLogFunc func, void* ctx);
+
+/*
+ * Appending writer. Each record is serialized compact, then written with one
+ * write(2) on an O_APPEND descriptor under a mutex, so producer threads of
+ * one process never interleave. A failed write is cut back off the file.
+ */
+
+typedef struct {
+  int fd;
+  pthread_mutex_t lock;
+} IutfLogWriter;
+
+// creates the file if needed; NULL on error
+IutfLogWriter* iutf_log_writer_open (const char* filename);
+
+// `root` must be a branch whose keys iutf_is_identifier accepts; 1 on success, safe to call from several threads
+int iutf_log_append (IutfLogWriter* writer, IutfNode* root);
+
+// a record that is already text, a newline is added; it is not checked
+int iutf_log_append_text (IutfLogWriter* writer, const char* text, size_t len);
+
+// fsync, 1 on success
+int iutf_log_writer_sync (IutfLogWriter* writer);
+
+// returns 0 if closing failed
+int iutf_log_writer_close (IutfLogWriter* writer);
+
+#endif
@@ -0,0 +1,51 @@
+/* iutf-merge.h
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Merge version 0.1
+ */
+#ifndef IUTF_MERGE_H
+#define IUTF_MERGE_H
+
+#include "iutf-ast.h"
+
+typedef enum {
+  IUTF_MERGE_LAST_WINS, // a later layer replaces the whole value, branches too
+  IUTF_MERGE_DEEP,      // branches are merged key by key, other values last-wins
+  IUTF_MERGE_ERROR      // like DEEP, but two different non-branch values are an error
+} IutfMergePolicy;
+
+typedef enum {
+  IUTF_MERGE_ARRAY_REPLACE,
+  IUTF_MERGE_ARRAY_APPEND
+} IutfMergeArrayPolicy;
+
+typedef struct {
+  IutfMergePolicy policy;
+  IutfMergeArrayPolicy arrays;
+} IutfMergeOptions;
+
+/*
+ * Merge `count` layers, later layers override earlier ones (base, region, host...).
+ * Every branch is merged in one pass with a hash table over its keys.
+ *
+ * The layers are frozen (see iutf-persist.h) but not consumed. The result is a
+ * frozen tree that shares every subtree only one layer contributed to, free it
+ * with iutf_node_free(). NULL options mean DEEP + REPLACE. Returns NULL on conflict.
+ */
+IutfNode* iutf_merge (IutfNode** layers, size_t count, const IutfMergeOptions* options);
+
+#endif
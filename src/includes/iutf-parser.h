@@ -23,16 +23,33 @@
 
 #include "iutf-lexer.h"
 #include "iutf-ast.h"
+#include "iutf-import.h"
+#include "iutf-types.h"
 #include "colors.h"
 
 typedef struct {
     IutfLexer* lexer;
     IutfToken current;
+    IutfImportList imports; // files pulled in by @import, including nested ones
+    IutfTypeTable types; // `type` declarations of this file and its imports
+    const char* filename; // NULL when parsing a string
+    int extension; // header is iutf:extension:<name>
+    int depth; // open branches
+    int decl_values; // bare identifiers are string values (inside `type` declarations)
+    const struct IutfAllocator* allocator; // the parser, its tree and imports, NULL = libc (iutf-alloc.h)
 } IutfParser;
 
 IutfParser* iutf_parser_new (const char* input);
+// same with an allocator for the parser and everything it builds;
+// free the tree with iutf_node_free_with (root, allocator)
+IutfParser* iutf_parser_new_with (const char* input, const struct IutfAllocator* allocator);
+// the first `len` bytes of `input`, which need no NUL (e.g. a slice of a mapped file)
+IutfParser* iutf_parser_new_len (const char* input, size_t len, const struct IutfAllocator* allocator);
 void iutf_parser_free (IutfParser* parser);
 IutfNode* iutf_parse (IutfParser* parser);
+// gzip/zstd files (iutf-decompress.h) are parsed entry by entry through iutf-stream.h
 IutfNode* iutf_parse_from_file (const char* filename);
+// same as iutf_parse_from_file, resolved import paths are appended to `imports`
+IutfNode* iutf_parse_from_file_imports (const char* filename, IutfImportList* imports);
 
 #endif /* IUTF_PARSER_H */
@@ -0,0 +1,56 @@
+/* iutf-persist.h
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Persist version 0.1
+ */
+#ifndef IUTF_PERSIST_H
+#define IUTF_PERSIST_H
+
+#include "iutf-ast.h"
+
+/*
+ * Immutable documents with structural sharing.
+ *
+ * A frozen tree is never modified in place. Every update returns a new root
+ * that copies only the nodes on the path to the change and shares all other
+ * subtrees with the old version. Nodes are refcounted, iutf_node_free() drops
+ * one reference, so every version is released with iutf_node_free() as usual.
+ *
+ * Paths are dotted keys ("server.ports.0"), a numeric segment indexes an array.
+ * The old root is never consumed, `value`/`item` arguments are consumed.
+ * Do not use to_branch()/add_to_array() on frozen nodes.
+ */
+
+// turn a regular tree into an immutable one (in place), returns root
+IutfNode* iutf_persist_freeze (IutfNode* root);
+
+// take one more reference on a frozen node
+IutfNode* iutf_persist_retain (IutfNode* node);
+
+// look up a node by path, returns a borrowed pointer or NULL
+IutfNode* iutf_persist_get (IutfNode* root, const char* path);
+
+// new version with `value` stored at path (missing branches are created)
+IutfNode* iutf_persist_set (IutfNode* root, const char* path, IutfNode* value);
+
+// new version without the entry at path
+IutfNode* iutf_persist_remove (IutfNode* root, const char* path);
+
+// new version with `item` appended to the array at path
+IutfNode* iutf_persist_append (IutfNode* root, const char* path, IutfNode* item);
+
+#endif
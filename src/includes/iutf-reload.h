@@ -0,0 +1,79 @@
+/* iutf-reload.h
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Reload version 0.1
+ */
+#ifndef IUTF_RELOAD_H
+#define IUTF_RELOAD_H
+
+#include "iutf-ast.h"
+#include "iutf-import.h"
+#include <pthread.h>
+
+// one published version of the document, root is frozen (see iutf-persist.h)
+typedef struct {
+  IutfNode* root;
+  const struct IutfAllocator* allocator; // root was built with it, NULL = libc (iutf-alloc.h)
+  unsigned long version;
+  unsigned int refs;
+} IutfSnapshot;
+
+// called on the watcher thread after a new snapshot was published
+typedef void (*IutfReloadCallback) (IutfSnapshot* old_snap, IutfSnapshot* new_snap, void* user_data);
+
+/*
+ * Watches a file and everything it imports, reparses on change and publishes
+ * the new document with an atomic pointer swap.
+ *
+ * Readers never lock: iutf_reloader_acquire() is two atomic loads and three
+ * atomic increments/decrements, iutf_snapshot_release() one decrement. Reloads (parse
+ * included) are serialized by write_lock. The old snapshot is freed by
+ * whoever drops the last reference.
+ */
+typedef struct {
+  char* filename;
+  IutfSnapshot* current;
+  unsigned int epoch;
+  unsigned int readers[2]; // acquires in flight, per epoch parity
+  pthread_mutex_t write_lock;
+
+  IutfImportList watched;
+  int inotify_fd;
+  int stop_fd[2];
+  int running;
+  pthread_t thread;
+  IutfReloadCallback callback;
+  void* user_data;
+} IutfReloader;
+
+// parses the file once, NULL if the first parse fails
+IutfReloader* iutf_reloader_new (const char* filename);
+
+// start the background watcher thread, returns 1 on success
+int iutf_reloader_start (IutfReloader* reloader, IutfReloadCallback callback, void* user_data);
+
+// reparse right now on the calling thread, returns 1 if a new snapshot was published
+int iutf_reloader_reload (IutfReloader* reloader);
+
+// stop the watcher and drop the reloader's reference on the current snapshot
+void iutf_reloader_corrupt (IutfReloader* reloader);
+
+// get the current snapshot, must be paired with iutf_snapshot_release
+IutfSnapshot* iutf_reloader_acquire (IutfReloader* reloader);
+void iutf_snapshot_release (IutfSnapshot* snapshot);
+
+#endif
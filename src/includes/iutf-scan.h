@@ -0,0 +1,131 @@
+/* iutf-scan.h
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Scan version 0.1
+ */
+#ifndef IUTF_SCAN_H
+#define IUTF_SCAN_H
+
+/*
+ * Byte-at-a-time scanner that follows the lexer's rules for everything it
+ * skips: strings, character literals, comments, BigString[...] and |...|.
+ * Used to find where entries (iutf-stream.h) and documents (iutf-log.h) end
+ * without tokenizing. The state carries across buffers.
+ */
+
+enum {
+  IUTF_SCAN_CODE,
+  IUTF_SCAN_STRING,
+  IUTF_SCAN_STRING_ESC,
+  IUTF_SCAN_CHAR,
+  IUTF_SCAN_CHAR_ESC,
+  IUTF_SCAN_SLASH, // '/', the next byte decides
+  IUTF_SCAN_HASH, // '#', a comment if '!' follows
+  IUTF_SCAN_LINE_COMMENT,
+  IUTF_SCAN_BLOCK_SKIP, // the lexer skips one byte after "/*" before looking for "*/"
+  IUTF_SCAN_BLOCK_COMMENT,
+  IUTF_SCAN_BLOCK_STAR,
+  IUTF_SCAN_BIGSTRING,
+  IUTF_SCAN_PIPE,
+};
+
+typedef struct {
+  int state;
+  int bigstring; // characters of a "BigString" identifier just seen (-1 in another one), then open '[' inside the block
+} IutfScan;
+
+#define IUTF_SCAN_INIT { IUTF_SCAN_CODE, 0 }
+
+/*
+ * 1 if `c` is code: outside anything the lexer skips. The quote or '|' that
+ * opens a string is code, its contents and the closing one are not; neither
+ * are '/', '#' and the '[' of a BigString. A newline that ends a line comment
+ * is code.
+ */
+static inline int iutf_scan_ident (char c)
+{
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '-';
+}
+
+static inline int iutf_scan_byte (IutfScan* s, char c)
+{
+  switch (s->state) {
+    case IUTF_SCAN_CODE:
+      if (c == '[' && s->bigstring == 9) {
+        s->bigstring = 1;
+        s->state = IUTF_SCAN_BIGSTRING;
+        return 0;
+      }
+      // the lexer only opens a block for the whole identifier, "xBigString[" is not one
+      if (s->bigstring >= 0 && s->bigstring < 9 && c == "BigString"[s->bigstring]) s->bigstring++;
+      else s->bigstring = iutf_scan_ident (c) ? -1 : 0;
+      switch (c) {
+        case '"': s->state = IUTF_SCAN_STRING; break;
+        case '\'': s->state = IUTF_SCAN_CHAR; break;
+        case '|': s->state = IUTF_SCAN_PIPE; break;
+        case '/': s->state = IUTF_SCAN_SLASH; return 0;
+        case '#': s->state = IUTF_SCAN_HASH; return 0;
+      }
+      return 1;
+    case IUTF_SCAN_STRING:
+      if (c == '\\') s->state = IUTF_SCAN_STRING_ESC;
+      else if (c == '"') s->state = IUTF_SCAN_CODE;
+      return 0;
+    case IUTF_SCAN_STRING_ESC:
+      s->state = IUTF_SCAN_STRING;
+      return 0;
+    case IUTF_SCAN_CHAR:
+      if (c == '\\') s->state = IUTF_SCAN_CHAR_ESC;
+      else if (c == '\'' || c == '\n') s->state = IUTF_SCAN_CODE;
+      return 0;
+    case IUTF_SCAN_CHAR_ESC:
+      s->state = IUTF_SCAN_CHAR;
+      return 0;
+    case IUTF_SCAN_SLASH:
+      s->state = c == '/' ? IUTF_SCAN_LINE_COMMENT : IUTF_SCAN_BLOCK_SKIP;
+      return 0;
+    case IUTF_SCAN_HASH:
+      if (c == '!') {
+        s->state = IUTF_SCAN_LINE_COMMENT;
+        return 0;
+      }
+      s->state = IUTF_SCAN_CODE;
+      return iutf_scan_byte (s, c);
+    case IUTF_SCAN_LINE_COMMENT:
+      if (c != '\n') return 0;
+      s->state = IUTF_SCAN_CODE;
+      return 1;
+    case IUTF_SCAN_BLOCK_SKIP:
+      s->state = IUTF_SCAN_BLOCK_COMMENT;
+      return 0;
+    case IUTF_SCAN_BLOCK_COMMENT:
+    case IUTF_SCAN_BLOCK_STAR:
+      if (s->state == IUTF_SCAN_BLOCK_STAR && c == '/') s->state = IUTF_SCAN_CODE;
+      else s->state = c == '*' ? IUTF_SCAN_BLOCK_STAR : IUTF_SCAN_BLOCK_COMMENT;
+      return 0;
+    case IUTF_SCAN_BIGSTRING:
+      if (c == '[') s->bigstring++;
+      else if (c == ']' && --s->bigstring == 0) s->state = IUTF_SCAN_CODE;
+      return 0;
+    case IUTF_SCAN_PIPE:
+      if (c == '|') s->state = IUTF_SCAN_CODE;
+      return 0;
+  }
+  return 0;
+}
+
+#endif
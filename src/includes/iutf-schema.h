@@ -0,0 +1,138 @@
+/* iutf-schema.h
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Schema version 0.1
+ */
+#ifndef IUTF_SCHEMA_H
+#define IUTF_SCHEMA_H
+
+#include "iutf-ast.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Schemas are IUTF documents, every rule is a branch:
+ *
+ *   iutf:init:main {
+ *     strict: true                        // unknown keys are errors
+ *     fields: {
+ *       title: { type: "string", required: true }
+ *       port: { type: "int", min: 1, max: 65535 }
+ *       mode: { enum: ["fast", "safe"] }
+ *       hosts: { type: "array", min: 1, items: { type: "string" } }
+ *       limits: { fields: { rps: { type: "number" } } }
+ *     }
+ *   }
+ *
+ * type: any, string, int, float, number, bool, char, null, array, branch,
+ *       or an array of these. Without `type` a rule with `fields` is a branch,
+ *       one with `items` an array, anything else accepts any value.
+ * min/max: value for numbers, length for strings, item count for arrays/branches.
+ *
+ * Compiling turns the tree into flat rule and field tables (fields of a branch
+ * are an open-addressing hash table), validation is one pass over the document.
+ */
+
+#define IUTF_SCHEMA_NO_RULE UINT32_MAX
+
+typedef struct {
+  uint32_t types; // IUTF_SCHEMA_T_* mask
+  uint32_t flags; // IUTF_SCHEMA_F_*
+  double min;
+  double max;
+  uint32_t fields; // first slot of the field table
+  uint32_t field_mask; // table size - 1, tables are powers of two
+  uint32_t required; // number of required fields
+  uint32_t items; // rule for array items or IUTF_SCHEMA_NO_RULE
+  uint32_t enum_first;
+  uint32_t enum_count;
+} IutfSchemaRule;
+
+typedef struct {
+  uint64_t hash; // 0 = empty slot
+  uint32_t key; // offset in the string pool
+  uint32_t key_len;
+  uint32_t rule;
+  uint32_t required_bit; // IUTF_SCHEMA_NO_RULE when optional
+} IutfSchemaField;
+
+typedef struct {
+  IutfNodeType type;
+  uint32_t str; // pool offset for strings
+  uint32_t str_len;
+  uint64_t hash;
+  double number;
+  long long integer; // integers, characters and booleans
+} IutfSchemaEnum;
+
+typedef struct {
+  IutfSchemaRule* rules; // rule 0 is the document root
+  size_t rule_count;
+  IutfSchemaField* fields;
+  size_t field_count;
+  IutfSchemaEnum* enums;
+  size_t enum_count;
+  char* pool;
+  size_t pool_len;
+  uint32_t max_required; // most required fields in one branch
+} IutfSchema;
+
+#define IUTF_SCHEMA_T_STRING (1u << 0)
+#define IUTF_SCHEMA_T_INT    (1u << 1)
+#define IUTF_SCHEMA_T_FLOAT  (1u << 2)
+#define IUTF_SCHEMA_T_BOOL   (1u << 3)
+#define IUTF_SCHEMA_T_CHAR   (1u << 4)
+#define IUTF_SCHEMA_T_NULL   (1u << 5)
+#define IUTF_SCHEMA_T_ARRAY  (1u << 6)
+#define IUTF_SCHEMA_T_BRANCH (1u << 7)
+#define IUTF_SCHEMA_T_ANY    0xFFu
+
+#define IUTF_SCHEMA_F_MIN    (1u << 0)
+#define IUTF_SCHEMA_F_MAX    (1u << 1)
+#define IUTF_SCHEMA_F_STRICT (1u << 2)
+
+IutfSchema* iutf_schema_compile (IutfNode* schema);
+IutfSchema* iutf_schema_load (const char* filename);
+void iutf_schema_free (IutfSchema* schema);
+
+// 1 if `root` matches, otherwise prints the first error with its path and returns 0
+int iutf_schema_validate (const IutfSchema* schema, IutfNode* root);
+
+// the schema behind iutf_validate: a string `title` and a number `version`
+const IutfSchema* iutf_schema_default (void);
+
+// IUTF_SCHEMA_T_* bit of a node type
+uint32_t iutf_schema_type_bit (IutfNodeType type);
+
+// a value as both the tree walk and the token checker see it
+typedef struct {
+  uint32_t type; // IUTF_SCHEMA_T_* bit
+  const char* str; // strings, decoded, not NUL-terminated
+  size_t len;
+  long long integer; // ints, chars, bools and item counts
+  double number; // ints and floats
+} IutfSchemaValue;
+
+// NULL if `value` passes the type, min/max and enum of `rule`, otherwise the reason
+const char* iutf_schema_check_value (const IutfSchema* schema, const IutfSchemaRule* rule, const IutfSchemaValue* value);
+
+const char* iutf_schema_type_name (uint32_t bit);
+
+// field of a branch rule by key, NULL when the rule doesn't declare it
+const IutfSchemaField* iutf_schema_field (const IutfSchema* schema, const IutfSchemaRule* rule, const char* key, size_t key_len);
+
+#endif
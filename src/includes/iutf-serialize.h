@@ -0,0 +1,52 @@
+/* iutf-serialize.h
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Serializer version 0.1
+ */
+#ifndef IUTF_SERIALIZE_H
+#define IUTF_SERIALIZE_H
+
+#include "iutf-ast.h"
+#include "iutf-buffer.h"
+
+#define IUTF_WRITE_PRETTY  0
+#define IUTF_WRITE_COMPACT (1 << 0) // no newlines or indentation
+
+/*
+ * Writes a tree back as IUTF text. A branch root becomes `iutf:init:main { ... }`,
+ * any other node is written as a bare value.
+ *
+ * BigString and PipeString keep their form when their text allows it (balanced
+ * brackets, no '|'), otherwise they are written as regular strings.
+ * Floats that are NaN or infinite are written as null.
+ */
+int iutf_serialize_to_buffer (IutfNode* root, int flags, IutfBuffer* buf);
+
+// one value without key or header, `depth` is the indentation level
+int iutf_serialize_value (IutfBuffer* buf, IutfNode* node, int flags, size_t depth);
+
+// returns a malloc'd string, `len` may be NULL
+char* iutf_serialize (IutfNode* root, int flags, size_t* len);
+
+// stream straight to a file descriptor or FILE*, returns 1 on success
+int iutf_serialize_to_fd (IutfNode* root, int flags, int fd);
+int iutf_serialize_to_file (IutfNode* root, int flags, FILE* fp);
+
+// 1 if `key` reads back as a key: an identifier other than true, false and null
+int iutf_is_identifier (const char* key);
+
+#endif
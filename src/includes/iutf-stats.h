@@ -0,0 +1,139 @@
+/* iutf-stats.h
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Stats version 0.1
+ */
+#ifndef IUTF_STATS_H
+#define IUTF_STATS_H
+
+#include "iutf-ast.h"
+#include "iutf-lexer.h"
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Opt-in runtime counters: iutf_stats_enable (1) or IUTF_STATS=1.
+ *
+ * Every thread counts into its own block, so the hot path is a branch and
+ * plain loads/stores (relaxed, no locked instructions). iutf_stats_snapshot
+ * adds up the blocks of all threads, including ones that have exited.
+ * Disabled, each counting site costs one predictable branch.
+ */
+
+#define IUTF_STATS_TOKEN_TYPES (IUTF_TOK_IMPORT + 1)
+#define IUTF_STATS_NODE_TYPES (IUTF_NODE_PIPESTRING + 1)
+
+typedef enum {
+  IUTF_PHASE_PARSE, // iutf_parse, imports included
+  IUTF_PHASE_IMPORT, // resolving and parsing one @import
+  IUTF_PHASE_VALIDATE, // iutf_schema_validate
+  IUTF_PHASE_CHECK, // iutf_check
+  IUTF_PHASE_SERIALIZE, // iutf_serialize_to_buffer
+  IUTF_STATS_PHASES
+} IutfPhase;
+
+typedef struct {
+  uint64_t tokens[IUTF_STATS_TOKEN_TYPES]; // by IutfTokenType
+  uint64_t nodes[IUTF_STATS_NODE_TYPES]; // created, by IutfNodeType
+  uint64_t alloc_calls; // iutf_malloc / iutf_calloc / iutf_strdup...
+  uint64_t alloc_bytes;
+  uint64_t realloc_calls;
+  uint64_t realloc_bytes; // new sizes
+  uint64_t free_calls;
+  uint64_t import_lookups; // @import name resolutions
+  uint64_t import_misses; // ... that found no file
+  uint64_t cache_hits; // iutf-cache.h
+  uint64_t cache_misses;
+  uint64_t phase_calls[IUTF_STATS_PHASES];
+  uint64_t phase_ns[IUTF_STATS_PHASES];
+} IutfStats;
+
+void iutf_stats_enable (int on);
+int iutf_stats_enabled (void);
+
+// sum over all threads; reset zeroes every block
+void iutf_stats_snapshot (IutfStats* out);
+void iutf_stats_reset (void);
+
+const char* iutf_phase_name (IutfPhase phase);
+
+// one JSON object (tokens and nodes keyed by type name), e.g. for a metrics exporter
+void iutf_stats_print_json (FILE* fp, const IutfStats* stats);
+
+/* ---- counting, used inside the library ---- */
+
+extern int iutf_stats_active; // -1 until IUTF_STATS is read
+extern __thread IutfStats* iutf_stats_tls;
+
+// this thread's block, NULL when stats are off
+IutfStats* iutf_stats_thread_slow (void);
+
+static inline IutfStats* iutf_stats_thread (void)
+{
+  if (__builtin_expect (__atomic_load_n (&iutf_stats_active, __ATOMIC_RELAXED) == 0, 1)) return NULL;
+  return iutf_stats_tls ? iutf_stats_tls : iutf_stats_thread_slow ();
+}
+
+// the library's own work (e.g. a built-in parse) counts into `scratch` until the resume;
+// only this thread is affected
+IutfStats* iutf_stats_suspend (IutfStats* scratch);
+void iutf_stats_resume (IutfStats* saved);
+
+// only the owning thread writes its block, the snapshot reads it concurrently
+#define IUTF_STAT_ADD(field, n) \
+  do { \
+    IutfStats* stats_ = iutf_stats_thread (); \
+    if (stats_) __atomic_store_n (&stats_->field, __atomic_load_n (&stats_->field, __ATOMIC_RELAXED) + (n), __ATOMIC_RELAXED); \
+  } while (0)
+
+// phase timing: uint64_t t = iutf_stats_phase_begin (); ... iutf_stats_phase_end (IUTF_PHASE_X, t);
+uint64_t iutf_stats_phase_begin (void);
+void iutf_stats_phase_end (IutfPhase phase, uint64_t start);
+
+/* ---- memory of a tree ---- */
+
+struct IutfAllocator;
+
+typedef struct {
+  size_t nodes;
+  size_t blocks; // heap blocks owned by the subtree
+  size_t bytes; // their usable sizes, i.e. what the heap really spends (see below)
+  size_t node_bytes; // IutfNode structs
+  size_t key_bytes;
+  size_t string_bytes; // string, BigString and pipe values
+  size_t item_bytes; // item arrays of branches and arrays
+} IutfMemoryUsage;
+
+/*
+ * Sizes come from the active allocator (iutf-alloc.h), which has to be the one
+ * the tree was built with: malloc_usable_size for libc, the allocator's `size`
+ * hook if it has one, else what was asked for (sizeof (IutfNode), strlen + 1,
+ * capacity * sizeof (IutfNode*)). The *_with variants make `allocator` active
+ * for the call, like iutf_node_free_with.
+ */
+
+// totals of a subtree; borrowed keys and strings are not counted
+void iutf_doc_memory_usage (const IutfNode* node, IutfMemoryUsage* out);
+void iutf_doc_memory_usage_with (const IutfNode* node, const struct IutfAllocator* allocator, IutfMemoryUsage* out);
+
+// the subtree's total, then its children down to `depth` levels, largest first:
+//   1.2 MB  100.0%  40213 nodes  <root>
+//   0.9 MB   75.0%  30001 nodes    services
+void iutf_doc_memory_report (FILE* fp, const IutfNode* node, size_t depth);
+void iutf_doc_memory_report_with (FILE* fp, const IutfNode* node, const struct IutfAllocator* allocator, size_t depth);
+
+#endif
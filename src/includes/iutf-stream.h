@@ -20,23 +20,70 @@
 #define IUTF_STREAM_H
 
 #include "iutf-ast.h"
-#include "iutf-lexer.h"
+#include "iutf-buffer.h"
+#include "iutf-import.h"
+#include "iutf-scan.h"
+#include "iutf-types.h"
 #include <stdio.h>
 
-// read files by one entry
+/*
+ * Reads a document one top-level entry of the main branch at a time, e.g.
+ *
+ *   IutfStream* stream = stream_open ("huge.iutf");
+ *   IutfNode* entry;
+ *   while ((entry = stream_entry_next (stream))) { ...; iutf_node_free (entry); }
+ *   if (stream && stream->error) ...
+ *   stream_corrupt (stream);
+ *
+ * The file is read in IUTF_STREAM_CHUNK pieces. A scanner that follows the
+ * lexer's rules (strings, comments, BigString[...] and |...| blocks, nesting)
+ * finds where each entry ends, even across chunks, and only that entry is
+ * kept and parsed. Memory is a chunk plus the largest entry and its tree.
+ * @import and type declarations apply to the entries after them.
+ * Compressed files are decompressed on a thread of their own, the chunks are
+ * then its blocks.
+ */
+
+#define IUTF_STREAM_CHUNK (64 * 1024)
+
 typedef struct {
-  FILE* fp;
-  IutfLexer* lexer;
+  int fd;
+  char* filename;
+  const char* chunk; // `buffer`, or a block of `decompress`
+  char* buffer; // refillable read buffer
+  struct IutfDecompressor* decompress; // gzip/zstd input (iutf-decompress.h), else NULL
+  size_t chunk_len;
+  size_t chunk_pos;
+  IutfBuffer entry; // the file's header ("iutf:init:main {"), then the entry being collected
+  size_t header_len;
+  size_t line; // of the next byte
+  size_t entry_line; // where the entry's first token is
+
+  // scanner, carried across chunks
+  IutfScan scan;
+  int depth; // open brackets inside the main branch, -1 in the header
+  int outer; // bracket that opened depth 1
+  int colon; // the entry has its ':'
+  int value; // ... and a complete value, a newline or ',' ends it
+  int significant; // the entry has more than whitespace and comments
+
+  // shared by the entries, as for one parser
+  IutfImportList imports;
+  IutfTypeTable types;
+
+  IutfNode* pending; // one parse can give several entries ("a: 1 b: 2")
+  size_t pending_next;
   int finished;
+  int error; // stream_entry_next returned NULL because of an error, not at the end
 } IutfStream;
 
-// open the stream
+// open the stream, reads and checks the header; NULL on error
 IutfStream* stream_open (const char* filename);
 
 // close the stream
 void stream_corrupt (IutfStream* stream);
 
-// read the next entry
+// the next entry with its key, a standalone tree the caller frees; NULL at the end or on error
 IutfNode* stream_entry_next (IutfStream* stream);
 
 #endif
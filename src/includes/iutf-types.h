@@ -0,0 +1,101 @@
+/* iutf-types.h
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Types version 0.1
+ */
+#ifndef IUTF_TYPES_H
+#define IUTF_TYPES_H
+
+#include "iutf-ast.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Extension types:
+ *
+ *   iutf:extension:colors {              // colors.utext
+ *     plugin: "libcolors.so"             // optional, next to the .utext
+ *     type col {
+ *       validator: is_valid_color_code
+ *       converter: color_to_rgb          // optional
+ *     }
+ *   }
+ *
+ *   iutf:init:main {
+ *     @import<colors>
+ *     primary_color[col]: 'R'
+ *   }
+ *
+ * `validator` and `converter` name native functions from the registry. They are
+ * looked up once, when `type` is declared; every annotated value is then one
+ * direct call. `decl` is the declaration branch, so types can carry parameters.
+ */
+
+// 1 if `value` is a valid instance of the type
+typedef int (*IutfTypeValidator) (const IutfNode* value, const IutfNode* decl, void* user);
+
+// the node that replaces `value` (may be `value` itself), NULL on error;
+// `value` is freed by the parser when something else is returned
+typedef IutfNode* (*IutfTypeConverter) (IutfNode* value, const IutfNode* decl, void* user);
+
+// what a plugin gets in iutf_plugin_init, it doesn't have to link against libiutf
+typedef struct {
+  int version; // IUTF_PLUGIN_API_VERSION
+  int (*register_validator) (const char* name, IutfTypeValidator func, void* user);
+  int (*register_converter) (const char* name, IutfTypeConverter func, void* user);
+} IutfPluginHost;
+
+#define IUTF_PLUGIN_API_VERSION 1
+
+// the symbol every plugin exports, returns 1 on success
+typedef int (*IutfPluginInit) (const IutfPluginHost* host);
+#define IUTF_PLUGIN_INIT_SYMBOL "iutf_plugin_init"
+
+// process-wide registry, thread-safe, a later registration replaces an earlier one
+int iutf_types_register_validator (const char* name, IutfTypeValidator func, void* user);
+int iutf_types_register_converter (const char* name, IutfTypeConverter func, void* user);
+
+// dlopen a plugin and run its init, every path is loaded once and never unloaded
+int iutf_types_load_plugin (const char* path);
+
+// a declared type, function pointers already resolved
+typedef struct {
+  char* name;
+  uint64_t hash;
+  IutfTypeValidator validate;
+  void* validate_user;
+  IutfTypeConverter convert;
+  void* convert_user;
+  IutfNode* decl;
+} IutfType;
+
+// types visible to one parse, shared with the files it imports
+typedef struct {
+  IutfType* items;
+  size_t size;
+  size_t capacity;
+} IutfTypeTable;
+
+// `decl` is taken over; fails when a named function is not registered
+int iutf_type_table_declare (IutfTypeTable* table, const char* name, size_t name_len, IutfNode* decl);
+const IutfType* iutf_type_table_find (const IutfTypeTable* table, const char* name, size_t name_len);
+void iutf_type_table_clear (IutfTypeTable* table);
+
+// run validator and converter, returns the node to keep or NULL (value is freed then)
+IutfNode* iutf_type_apply (const IutfType* type, IutfNode* value);
+
+#endif
@@ -0,0 +1,79 @@
+/* iutf-writer.h
+ *
+ * Copyright 2026 Int Software, Aleksandr Silaev
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ * IUTF Writer version 0.1
+ */
+#ifndef IUTF_WRITER_H
+#define IUTF_WRITER_H
+
+#include "iutf-buffer.h"
+#include "iutf-serialize.h"
+
+typedef struct {
+  char kind; // 'b' branch, 'a' array
+  size_t count;
+} IutfWriterLevel;
+
+/*
+ * Streaming IUTF writer, no IutfNode tree is built.
+ *
+ * The first call must be iutf_writer_begin_branch (w, NULL), it writes the
+ * `iutf:init:main` header. Inside branches every value needs a key, inside
+ * arrays keys must be NULL. Output goes through a fixed-size buffer to the
+ * sink, memory only grows with the nesting depth.
+ * Every call returns 1 on success and 0 once the writer is in error.
+ */
+typedef struct {
+  IutfBuffer buf;
+  int flags; // IUTF_WRITE_PRETTY / IUTF_WRITE_COMPACT
+  IutfWriterLevel* stack;
+  size_t depth;
+  size_t stack_cap;
+  int root_done;
+  int error;
+} IutfWriter;
+
+IutfWriter* iutf_writer_new_fd (int fd, int flags);
+IutfWriter* iutf_writer_new_file (FILE* fp, int flags);
+IutfWriter* iutf_writer_new_sink (IutfSinkFunc sink, void* ctx, int flags);
+
+int iutf_writer_begin_branch (IutfWriter* writer, const char* key);
+int iutf_writer_begin_array (IutfWriter* writer, const char* key);
+int iutf_writer_end (IutfWriter* writer);
+
+int iutf_writer_string (IutfWriter* writer, const char* key, const char* value);
+int iutf_writer_string_len (IutfWriter* writer, const char* key, const char* value, size_t len);
+int iutf_writer_bigstring (IutfWriter* writer, const char* key, const char* value);
+int iutf_writer_pipestring (IutfWriter* writer, const char* key, const char* value);
+int iutf_writer_int (IutfWriter* writer, const char* key, long long value);
+int iutf_writer_long (IutfWriter* writer, const char* key, long long value);
+int iutf_writer_float (IutfWriter* writer, const char* key, double value);
+int iutf_writer_char (IutfWriter* writer, const char* key, char value);
+int iutf_writer_bool (IutfWriter* writer, const char* key, int value);
+int iutf_writer_null (IutfWriter* writer, const char* key);
+
+// an already formatted literal (e.g. a number kept as text), written as is
+int iutf_writer_raw (IutfWriter* writer, const char* key, const char* text, size_t len);
+
+// write a whole subtree at the current position
+int iutf_writer_node (IutfWriter* writer, const char* key, IutfNode* node);
+
+// check that everything is closed and flush, 1 if the document is complete
+int iutf_writer_finish (IutfWriter* writer);
+void iutf_writer_free (IutfWriter* writer);
+
+#endif